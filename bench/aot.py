@@ -0,0 +1,78 @@
+#!/usr/bin/env python3
+# Compara el intérprete con el ejecutable de `gldvm aot` en un programa de
+# cálculo (criba, sumas enteras y en double).
+# Uso: bench/aot.py [ruta/a/gld] [ruta/a/gldvm] [N]
+import os
+import subprocess
+import sys
+import tempfile
+import time
+
+RUNTIME = os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "vm", "src")
+
+
+def generate(project, n):
+    os.makedirs(os.path.join(project, "src"), exist_ok=True)
+    with open(os.path.join(project, "project.conf"), "w") as f:
+        f.write("[project]\nname = aot\nrenderer = none\n")
+    with open(os.path.join(project, "src", "main.gsf"), "w") as f:
+        f.write(f"int sieve[{n}];\n")
+        f.write("int main() {\n")
+        f.write("    int primes = 0;\n")
+        f.write(f"    for (int i = 2; i < {n}; i++) {{\n")
+        f.write("        if (sieve[i] == 0) {\n")
+        f.write("            primes++;\n")
+        f.write(f"            for (int j = i * 2; j < {n}; j += i) {{\n")
+        f.write("                sieve[j] = 1;\n")
+        f.write("            }\n")
+        f.write("        }\n")
+        f.write("    }\n")
+        f.write("    println(primes);\n")
+        f.write("    int acc = 0;\n")
+        f.write("    double x = 0;\n")
+        f.write("    for (int r = 0; r < 200; r++) {\n")
+        f.write(f"        for (int k = 0; k < {n}; k++) {{\n")
+        f.write("            acc = (acc * 31 + k) % 1000003;\n")
+        f.write("            x = x * 0.5 + k;\n")
+        f.write("        }\n")
+        f.write("    }\n")
+        f.write("    println(acc);\n")
+        f.write("    println(x);\n")
+        f.write("    return 0;\n}\n")
+
+
+def timed(cmd):
+    start = time.perf_counter()
+    out = subprocess.run(cmd, check=True, capture_output=True, text=True).stdout
+    return time.perf_counter() - start, out
+
+
+def main():
+    gld = sys.argv[1] if len(sys.argv) > 1 else "gld"
+    gldvm = sys.argv[2] if len(sys.argv) > 2 else "gldvm"
+    n = int(sys.argv[3]) if len(sys.argv) > 3 else 100000
+    cc = os.environ.get("CC", "cc")
+    with tempfile.TemporaryDirectory() as tmp:
+        project = os.path.join(tmp, "aot")
+        generate(project, n)
+        subprocess.run([gld, "build", project, "-O"], check=True, stdout=subprocess.DEVNULL)
+        image = os.path.join(project, "aot.gld")
+        source = os.path.join(tmp, "aot.c")
+        binary = os.path.join(tmp, "aot.bin")
+        subprocess.run([gldvm, "aot", image, "-o", source], check=True, stdout=subprocess.DEVNULL)
+        subprocess.run([cc, "-O2", "-I", RUNTIME, source, os.path.join(RUNTIME, "runtime.c"),
+                        os.path.join(RUNTIME, "output.c"), os.path.join(RUNTIME, "format.c"),
+                        os.path.join(RUNTIME, "simd.c"), os.path.join(RUNTIME, "sort.c"),
+                        os.path.join(RUNTIME, "parallel.c"),
+                        "-lm", "-lpthread", "-o", binary], check=True)
+
+        interpreted, expected = timed([gldvm, "run", image])
+        native, output = timed([binary])
+        if output != expected:
+            sys.exit("La salida del ejecutable AOT no coincide con la del intérprete")
+        print(f"intérprete: {interpreted:.3f} s")
+        print(f"aot:        {native:.3f} s  ({interpreted / native:.1f}x)")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,91 @@
+// Microbenchmark de la conversión de números a texto de PRINTLN: format.c
+// frente a snprintf, sobre 10M valores. Para los double se compara con %.17g,
+// lo mínimo con printf para que el texto se lea como el mismo double.
+//
+//     cc -O2 -I vm/src bench/format.c vm/src/format.c -o format_bench
+//     ./format_bench [N]
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "format.h"
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// xorshift64: mismos valores en cada ejecución
+static uint64_t next_random(uint64_t *state) {
+    uint64_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    return *state = x;
+}
+
+typedef int (*FormatInt)(char *dst, int64_t value);
+typedef int (*FormatDouble)(char *dst, double value);
+
+static int snprintf_int(char *dst, int64_t value) {
+    return snprintf(dst, FORMAT_NUMBER_MAX, "%lld", (long long)value);
+}
+
+static int snprintf_round_trip(char *dst, double value) {
+    return snprintf(dst, FORMAT_NUMBER_MAX, "%.17g", value);
+}
+
+// Bytes escritos: evita que el compilador descarte el trabajo
+static size_t sink = 0;
+
+static void run_int(const char *name, FormatInt format, const int64_t *values, int n) {
+    char text[FORMAT_NUMBER_MAX];
+    double start = now();
+    for (int i = 0; i < n; i++) sink += format(text, values[i]);
+    double elapsed = now() - start;
+    printf("  %-24s %7.3f s  %6.1f ns/valor\n", name, elapsed, elapsed * 1e9 / n);
+}
+
+static void run_double(const char *name, FormatDouble format, const double *values, int n) {
+    char text[FORMAT_NUMBER_MAX];
+    double start = now();
+    for (int i = 0; i < n; i++) sink += format(text, values[i]);
+    double elapsed = now() - start;
+    printf("  %-24s %7.3f s  %6.1f ns/valor\n", name, elapsed, elapsed * 1e9 / n);
+}
+
+int main(int argc, char *argv[]) {
+    int n = argc > 1 ? atoi(argv[1]) : 10000000;
+    int64_t *ints = (int64_t*)malloc(n * sizeof(int64_t));
+    double *doubles = (double*)malloc(n * sizeof(double));
+    if (!ints || !doubles || n <= 0) {
+        fprintf(stderr, "Error: No hay memoria suficiente\n");
+        return EXIT_FAILURE;
+    }
+
+    // Enteros de todas las longitudes; doubles con decimales y de cualquier
+    // magnitud, mitad de cada
+    uint64_t state = 88172645463325252ull;
+    for (int i = 0; i < n; i++) {
+        uint64_t r = next_random(&state);
+        ints[i] = (int64_t)(r >> (r % 64));
+        if (i % 2 == 0) {
+            doubles[i] = (double)(int64_t)(next_random(&state) % 2000000) / 1000.0 - 1000.0;
+        } else {
+            uint64_t bits = next_random(&state) & 0x7FEFFFFFFFFFFFFFull;  // Finito
+            memcpy(&doubles[i], &bits, sizeof(double));
+        }
+    }
+
+    printf("%d enteros:\n", n);
+    run_int("snprintf %lld", snprintf_int, ints, n);
+    run_int("format_int64", format_int64, ints, n);
+    printf("%d doubles:\n", n);
+    run_double("snprintf %.17g", snprintf_round_trip, doubles, n);
+    run_double("format_double", format_double, doubles, n);
+
+    free(ints);
+    free(doubles);
+    return sink == 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+}
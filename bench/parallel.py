@@ -0,0 +1,74 @@
+#!/usr/bin/env python3
+# Escalado de `parallel for`: el mismo programa (pasos de Collatz de cada
+# índice, un coste por índice muy desigual) con --threads 1, 2, 4, ... hasta
+# 32 o los núcleos disponibles, con el intérprete y con --jit. Comprueba que
+# todas las ejecuciones dan la salida del bucle `for` en serie.
+# Uso: bench/parallel.py [ruta/a/gld] [ruta/a/gldvm] [N]
+import os
+import subprocess
+import sys
+import tempfile
+import time
+
+
+def generate(project, n, parallel):
+    os.makedirs(os.path.join(project, "src"), exist_ok=True)
+    name = os.path.basename(project)
+    with open(os.path.join(project, "project.conf"), "w") as f:
+        f.write(f"[project]\nname = {name}\nrenderer = none\n")
+    with open(os.path.join(project, "src", "main.gsf"), "w") as f:
+        f.write(f"long steps[{n}];\n")
+        f.write("int main() {\n")
+        f.write(f"    {'parallel for' if parallel else 'for'} (int i = 0; i < {n}; i++) {{\n")
+        f.write("        long n = i + 1;\n")
+        f.write("        long c = 0;\n")
+        f.write("        while (n != 1) {\n")
+        f.write("            if (n % 2 == 0) {\n")
+        f.write("                n = n / 2;\n")
+        f.write("            } else {\n")
+        f.write("                n = 3 * n + 1;\n")
+        f.write("            }\n")
+        f.write("            c++;\n")
+        f.write("        }\n")
+        f.write("        steps[i] = c;\n")
+        f.write("    }\n")
+        f.write("    println(steps.sum());\n")
+        f.write("    println(steps.max());\n")
+        f.write("    return 0;\n}\n")
+
+
+def build(gld, project, n, parallel):
+    generate(project, n, parallel)
+    subprocess.run([gld, "build", project, "-O"], check=True, stdout=subprocess.DEVNULL)
+    return os.path.join(project, os.path.basename(project) + ".gld")
+
+
+def timed(cmd):
+    start = time.perf_counter()
+    out = subprocess.run(cmd, check=True, capture_output=True, text=True).stdout
+    return time.perf_counter() - start, out
+
+
+def main():
+    gld = sys.argv[1] if len(sys.argv) > 1 else "gld"
+    gldvm = sys.argv[2] if len(sys.argv) > 2 else "gldvm"
+    n = int(sys.argv[3]) if len(sys.argv) > 3 else 300000
+    cores = os.cpu_count() or 1
+    threads = [t for t in (1, 2, 4, 8, 16, 32) if t <= max(cores, 1)]
+    with tempfile.TemporaryDirectory() as tmp:
+        serial = build(gld, os.path.join(tmp, "serial"), n, False)
+        parallel = build(gld, os.path.join(tmp, "parallel"), n, True)
+        print(f"{n} índices, {cores} núcleos")
+        for mode in ([], ["--jit"]):
+            label = "jit" if mode else "intérprete"
+            base, expected = timed([gldvm, "run", serial] + mode)
+            print(f"{label:10s} for en serie:  {base:.3f} s")
+            for t in threads:
+                elapsed, output = timed([gldvm, "run", parallel, "--threads", str(t)] + mode)
+                if output != expected:
+                    sys.exit(f"La salida con --threads {t} no coincide con la del bucle en serie")
+                print(f"{label:10s} {t:2d} hilos:      {elapsed:.3f} s  ({base / elapsed:.1f}x)")
+
+
+if __name__ == "__main__":
+    main()
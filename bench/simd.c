@@ -0,0 +1,126 @@
+// Microbenchmark de los núcleos de simd.c: cada operación en las variantes
+// escalar, SSE2 y AVX2 (las que admita la CPU) sobre arrays de N elementos,
+// comprobando que todas dan el resultado de la escalar. Por variante: ms por
+// pasada y ns por elemento.
+//
+//     cc -O2 -I vm/src bench/simd.c vm/src/simd.c -o simd_bench
+//     ./simd_bench [N] [repeticiones]
+#include <float.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "simd.h"
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+typedef struct {
+    double *a, *b;
+    int32_t *ia, *ib;
+    size_t n;
+    double result;      // De la última repetición, para comparar variantes
+} Data;
+
+typedef void (*Run)(const SimdKernels *k, Data *d);
+
+static void run_fill(const SimdKernels *k, Data *d)  { k->fill_f64(d->a, 1.25, d->n); d->result = d->a[d->n - 1]; }
+static void run_add(const SimdKernels *k, Data *d)   { k->add_f64(d->a, d->b, d->n); d->result = d->a[d->n - 1]; }
+static void run_mul(const SimdKernels *k, Data *d)   { k->mul_f64(d->a, d->b, d->n); d->result = d->a[d->n - 1]; }
+static void run_scale(const SimdKernels *k, Data *d) { k->scale_f64(d->a, 0.999, d->n); d->result = d->a[d->n - 1]; }
+static void run_axpy(const SimdKernels *k, Data *d)  { k->axpy_f64(d->a, 0.5, d->b, d->n); d->result = d->a[d->n - 1]; }
+static void run_sum(const SimdKernels *k, Data *d)   { d->result = k->sum_f64(d->b, d->n); }
+static void run_min(const SimdKernels *k, Data *d)   { d->result = k->min_f64(d->b, d->n); }
+static void run_max(const SimdKernels *k, Data *d)   { d->result = k->max_f64(d->b, d->n); }
+static void run_dot(const SimdKernels *k, Data *d)   { d->result = k->dot_f64(d->a, d->b, d->n); }
+static void run_fill_i32(const SimdKernels *k, Data *d) { k->fill_i32(d->ia, 3, d->n); d->result = d->ia[d->n - 1]; }
+static void run_add_i32(const SimdKernels *k, Data *d)  { k->add_i32(d->ia, d->ib, d->n); d->result = d->ia[d->n - 1]; }
+static void run_mul_i32(const SimdKernels *k, Data *d)  { k->mul_i32(d->ia, d->ib, d->n); d->result = d->ia[d->n - 1]; }
+static void run_axpy_i32(const SimdKernels *k, Data *d) { k->axpy_i32(d->ia, 7, d->ib, d->n); d->result = d->ia[d->n - 1]; }
+static void run_sum_i32(const SimdKernels *k, Data *d)  { d->result = (double)k->sum_i32(d->ib, d->n); }
+static void run_min_i32(const SimdKernels *k, Data *d)  { d->result = k->min_i32(d->ib, d->n); }
+static void run_dot_i32(const SimdKernels *k, Data *d)  { d->result = (double)k->dot_i32(d->ia, d->ib, d->n); }
+
+static const struct {
+    const char *name;
+    Run run;
+    int reduction;      // sum/dot de double: se admite N * épsilon de diferencia
+} benchmarks[] = {
+    {"fill f64", run_fill, 0}, {"add f64", run_add, 0}, {"mul f64", run_mul, 0},
+    {"scale f64", run_scale, 0}, {"axpy f64", run_axpy, 0}, {"sum f64", run_sum, 1},
+    {"min f64", run_min, 0}, {"max f64", run_max, 0}, {"dot f64", run_dot, 1},
+    {"fill i32", run_fill_i32, 0}, {"add i32", run_add_i32, 0}, {"mul i32", run_mul_i32, 0},
+    {"axpy i32", run_axpy_i32, 0}, {"sum i32", run_sum_i32, 0}, {"min i32", run_min_i32, 0},
+    {"dot i32", run_dot_i32, 0}
+};
+
+// Mismos datos de partida para cada variante
+static void reset(Data *d) {
+    for (size_t i = 0; i < d->n; i++) {
+        d->a[i] = (double)(i % 1000) * 0.001;
+        d->b[i] = 1.0 + (double)((i * 7919) % 1000) * 0.0001;
+        d->ia[i] = (int32_t)(i % 1000) - 500;
+        d->ib[i] = (int32_t)((i * 7919) % 2001) - 1000;
+    }
+}
+
+int main(int argc, char *argv[]) {
+    long n = argc > 1 ? atol(argv[1]) : 1000000;
+    int reps = argc > 2 ? atoi(argv[2]) : 100;
+    Data d = {0};
+    d.n = n > 0 ? (size_t)n : 0;
+    d.a = (double*)malloc(d.n * sizeof(double));
+    d.b = (double*)malloc(d.n * sizeof(double));
+    d.ia = (int32_t*)malloc(d.n * sizeof(int32_t));
+    d.ib = (int32_t*)malloc(d.n * sizeof(int32_t));
+    if (!d.a || !d.b || !d.ia || !d.ib || d.n == 0 || reps <= 0) {
+        fprintf(stderr, "Error: No hay memoria suficiente\n");
+        return EXIT_FAILURE;
+    }
+
+    const SimdKernels *levels[] = {
+        simd_kernels_for(SIMD_SCALAR), simd_kernels_for(SIMD_SSE2), simd_kernels_for(SIMD_AVX2)
+    };
+    printf("%ld elementos, %d repeticiones; variante por defecto: %s\n", n, reps,
+           simd_level_name(simd_kernels()->level));
+    printf("  %-10s", "");
+    for (int l = 0; l < 3; l++) {
+        if (levels[l]) printf(" %19s", simd_level_name(levels[l]->level));
+    }
+    printf("\n");
+
+    int mismatches = 0;
+    for (size_t b = 0; b < sizeof(benchmarks) / sizeof(benchmarks[0]); b++) {
+        printf("  %-10s", benchmarks[b].name);
+        double expected = 0;
+        for (int l = 0; l < 3; l++) {
+            if (!levels[l]) continue;
+            reset(&d);
+            double start = now();
+            for (int r = 0; r < reps; r++) benchmarks[b].run(levels[l], &d);
+            double elapsed = now() - start;
+            printf("  %7.3f ms %5.2f ns", elapsed * 1e3 / reps, elapsed * 1e9 / ((double)d.n * reps));
+            if (l == 0) {
+                expected = d.result;
+            } else {
+                double tolerance = benchmarks[b].reduction ? fabs(expected) * DBL_EPSILON * d.n : 0;
+                if (fabs(d.result - expected) > tolerance) {
+                    printf(" (!)");
+                    mismatches++;
+                }
+            }
+        }
+        printf("\n");
+    }
+
+    free(d.a);
+    free(d.b);
+    free(d.ia);
+    free(d.ib);
+    if (mismatches) fprintf(stderr, "%d resultados distintos de la variante escalar\n", mismatches);
+    return mismatches ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,144 @@
+// Benchmark de sort.c: sort_i32, sort_i64 y sort_f64 sobre arrays aleatorios
+// de 1K a N elementos (de 10 en 10), con 1 hilo y con los indicados, frente a
+// qsort. Comprueba que cada resultado está ordenado y conserva los elementos
+// (suma y xor de los bits).
+//
+//     cc -O2 -I vm/src bench/sort.c vm/src/sort.c vm/src/parallel.c -lpthread -o sort_bench
+//     ./sort_bench [N máximo] [hilos]
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "sort.h"
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static uint64_t state = 88172645463325252ull;
+
+static uint64_t next_random(void) {
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    return state;
+}
+
+static int compare_i32(const void *a, const void *b) {
+    int32_t x = *(const int32_t*)a, y = *(const int32_t*)b;
+    return (x > y) - (x < y);
+}
+
+static int compare_i64(const void *a, const void *b) {
+    int64_t x = *(const int64_t*)a, y = *(const int64_t*)b;
+    return (x > y) - (x < y);
+}
+
+static int compare_f64(const void *a, const void *b) {
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+typedef enum { TYPE_I32, TYPE_I64, TYPE_F64 } Type;
+
+static const char *const type_names[] = {"int32", "int64", "double"};
+static const size_t type_sizes[] = {sizeof(int32_t), sizeof(int64_t), sizeof(double)};
+
+static void fill(Type type, void *data, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        uint64_t r = next_random();
+        switch (type) {
+            case TYPE_I32: ((int32_t*)data)[i] = (int32_t)r; break;
+            case TYPE_I64: ((int64_t*)data)[i] = (int64_t)r; break;
+            case TYPE_F64: ((double*)data)[i] = (double)(int64_t)r * 1e-9; break;
+        }
+    }
+}
+
+// Suma y xor de los bits de cada elemento: no cambian al reordenar
+static void checksum(Type type, const void *data, size_t n, uint64_t *sum, uint64_t *bits) {
+    *sum = 0;
+    *bits = 0;
+    for (size_t i = 0; i < n; i++) {
+        uint64_t v = 0;
+        memcpy(&v, (const char*)data + i * type_sizes[type], type_sizes[type]);
+        *sum += v;
+        *bits ^= v * 0x9E3779B97F4A7C15ull;
+    }
+}
+
+static int is_sorted(Type type, const void *data, size_t n) {
+    for (size_t i = 1; i < n; i++) {
+        int out_of_order = 0;
+        switch (type) {
+            case TYPE_I32: out_of_order = ((const int32_t*)data)[i] < ((const int32_t*)data)[i - 1]; break;
+            case TYPE_I64: out_of_order = ((const int64_t*)data)[i] < ((const int64_t*)data)[i - 1]; break;
+            case TYPE_F64: out_of_order = ((const double*)data)[i] < ((const double*)data)[i - 1]; break;
+        }
+        if (out_of_order) return 0;
+    }
+    return 1;
+}
+
+static int run_sort(Type type, void *data, size_t n, int threads) {
+    switch (type) {
+        case TYPE_I32: return sort_i32((int32_t*)data, n, 0, threads);
+        case TYPE_I64: return sort_i64((int64_t*)data, n, 0, threads);
+        case TYPE_F64: return sort_f64((double*)data, n, 0, threads);
+    }
+    return -1;
+}
+
+// Segundos de una ordenación de 'n' elementos (hilos < 0: qsort), o -1 si el
+// resultado no es correcto
+static double measure(Type type, void *data, size_t n, int threads) {
+    uint64_t sum, bits, sum_after, bits_after;
+    state = 88172645463325252ull + n;
+    fill(type, data, n);
+    checksum(type, data, n, &sum, &bits);
+    double start = now();
+    if (threads < 0) {
+        qsort(data, n, type_sizes[type],
+              type == TYPE_I32 ? compare_i32 : type == TYPE_I64 ? compare_i64 : compare_f64);
+    } else if (run_sort(type, data, n, threads) != 0) {
+        return -1;
+    }
+    double elapsed = now() - start;
+    checksum(type, data, n, &sum_after, &bits_after);
+    return is_sorted(type, data, n) && sum == sum_after && bits == bits_after ? elapsed : -1;
+}
+
+int main(int argc, char *argv[]) {
+    long max = argc > 1 ? atol(argv[1]) : 100000000;
+    int threads = argc > 2 ? atoi(argv[2]) : 0;
+    void *data = max > 0 ? malloc((size_t)max * sizeof(int64_t)) : NULL;
+    if (!data) {
+        fprintf(stderr, "Error: No hay memoria suficiente\n");
+        return EXIT_FAILURE;
+    }
+
+    printf("%-7s %10s %12s %12s %12s\n", "", "elementos", "qsort", "1 hilo",
+           threads > 0 ? "hilos" : "núcleos");
+    int failures = 0;
+    for (int type = TYPE_I32; type <= TYPE_F64; type++) {
+        for (size_t n = 1000; n <= (size_t)max; n *= 10) {
+            // qsort tarda demasiado en los tamaños grandes
+            double reference = n <= 10000000 ? measure(type, data, n, -1) : 0;
+            double serial = measure(type, data, n, 1);
+            double parallel = measure(type, data, n, threads);
+            printf("%-7s %10zu %10.2f ms %10.2f ms %10.2f ms", type_names[type], n,
+                   reference * 1e3, serial * 1e3, parallel * 1e3);
+            if (serial < 0 || parallel < 0) {
+                printf(" (!)");
+                failures++;
+            }
+            printf("\n");
+        }
+    }
+
+    free(data);
+    if (failures) fprintf(stderr, "%d ordenaciones incorrectas\n", failures);
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,41 @@
+#!/usr/bin/env python3
+# Genera proyectos sintéticos con N globales y mide cuánto tarda `gld build`.
+# Uso: bench/symbols.py [ruta/a/gld] [N...]
+import os
+import subprocess
+import sys
+import tempfile
+import time
+
+
+def generate(project, n):
+    os.makedirs(os.path.join(project, "src"), exist_ok=True)
+    with open(os.path.join(project, "project.conf"), "w") as f:
+        f.write("[project]\nname = sym\nrenderer = none\n")
+    with open(os.path.join(project, "src", "main.gsf"), "w") as f:
+        for i in range(n // 2):
+            f.write(f"int g{i} = {i};\n")
+        for i in range(n // 2):
+            f.write(f"double h{i} = g{i} * 2;\n")
+        # Declarado al final: una búsqueda lineal recorrería todas las globales
+        f.write("int data[4];\n")
+        f.write("int main() {\n")
+        for i in range(100):
+            f.write(f"    data[{i % 4}] = {i};\n")
+        f.write("    println(data[1]);\n    return 0;\n}\n")
+
+
+def main():
+    gld = sys.argv[1] if len(sys.argv) > 1 else "gld"
+    sizes = [int(x) for x in sys.argv[2:]] or [12500, 25000, 50000, 100000]
+    with tempfile.TemporaryDirectory() as tmp:
+        for n in sizes:
+            project = os.path.join(tmp, f"sym{n}")
+            generate(project, n)
+            start = time.perf_counter()
+            subprocess.run([gld, "build", project], check=True, stdout=subprocess.DEVNULL)
+            print(f"{n:>8} símbolos: {time.perf_counter() - start:.3f} s")
+
+
+if __name__ == "__main__":
+    main()
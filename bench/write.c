@@ -0,0 +1,162 @@
+// Benchmark de la escritura de la imagen .gld con N instrucciones (1M por
+// defecto): el camino anterior de compiler.c, un fwrite de 3 bytes por
+// instrucción a un tmpfile() que después se copia al destino de 3 en 3
+// bytes, frente al actual, un buffer en memoria que crece al doble y un solo
+// writev sobre <destino>.tmp renombrado al final (ver write_image). Comprueba
+// que las dos imágenes son idénticas.
+//
+//     cc -O2 -I client/src bench/write.c -o write_bench
+//     ./write_bench [N] [directorio]
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/uio.h>
+#include "compiler.h"
+
+#define RUNS 5
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// Cabecera de tamaño realista: magic, versión y unos cuantos strings
+static uint8_t header[4096];
+
+// Instrucción i del programa: PRINTCHR de una letra, como en un programa
+// generado con un printchr por línea
+static Instruction instruction_at(int i) {
+    Instruction instr = { OPCODE_PRINTCHR, (uint8_t)('a' + i % 26), 0 };
+    return instr;
+}
+
+// Antes: tmpfile() con un fwrite por instrucción y copia de 3 en 3 bytes
+static int write_tmpfile(const char *path, int n) {
+    FILE *code = tmpfile();
+    if (!code) return -1;
+    for (int i = 0; i < n; i++) {
+        Instruction instr = instruction_at(i);
+        fwrite(&instr, sizeof(Instruction), 1, code);
+    }
+
+    FILE *out = fopen(path, "wb");
+    if (!out) {
+        fclose(code);
+        return -1;
+    }
+    fwrite(header, 1, sizeof(header), out);
+    rewind(code);
+    Instruction instr;
+    while (fread(&instr, sizeof(Instruction), 1, code) == 1) {
+        fwrite(&instr, sizeof(Instruction), 1, out);
+    }
+    fclose(code);
+    return fclose(out) == 0 ? 0 : -1;
+}
+
+// Ahora: CodeBuffer (emit_instruction) y un writev sobre un temporal renombrado
+static int write_buffer(const char *path, int n) {
+    CodeBuffer buffer = { NULL, 0, 0 };
+    for (int i = 0; i < n; i++) {
+        if (buffer.count >= buffer.capacity) {
+            int capacity = buffer.capacity ? buffer.capacity * 2 : 256;
+            Instruction *temp = realloc(buffer.code, capacity * sizeof(Instruction));
+            if (!temp) {
+                free(buffer.code);
+                return -1;
+            }
+            buffer.code = temp;
+            buffer.capacity = capacity;
+        }
+        buffer.code[buffer.count++] = instruction_at(i);
+    }
+
+    char temp_file[512];
+    snprintf(temp_file, sizeof(temp_file), "%s.tmp", path);
+    int fd = open(temp_file, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        free(buffer.code);
+        return -1;
+    }
+    struct iovec iov[2] = {
+        { header, sizeof(header) },
+        { buffer.code, (size_t)buffer.count * sizeof(Instruction) },
+    };
+    int iov_index = 0;
+    while (iov_index < 2) {
+        ssize_t written = writev(fd, iov + iov_index, 2 - iov_index);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            close(fd);
+            free(buffer.code);
+            return -1;
+        }
+        while (iov_index < 2 && (size_t)written >= iov[iov_index].iov_len) {
+            written -= iov[iov_index].iov_len;
+            iov_index++;
+        }
+        if (iov_index < 2) {
+            iov[iov_index].iov_base = (uint8_t*)iov[iov_index].iov_base + written;
+            iov[iov_index].iov_len -= written;
+        }
+    }
+    free(buffer.code);
+    return close(fd) == 0 && rename(temp_file, path) == 0 ? 0 : -1;
+}
+
+// Mejor tiempo de RUNS escrituras
+static double run(const char *name, int (*write)(const char *, int), const char *path, int n) {
+    double best = 0;
+    for (int r = 0; r < RUNS; r++) {
+        double start = now();
+        if (write(path, n) != 0) {
+            fprintf(stderr, "Error: no se puede escribir '%s'\n", path);
+            exit(EXIT_FAILURE);
+        }
+        double elapsed = now() - start;
+        if (r == 0 || elapsed < best) best = elapsed;
+    }
+    printf("  %-28s %7.3f s  %6.1f ns/instrucción\n", name, best, best * 1e9 / n);
+    return best;
+}
+
+static int same_file(const char *a, const char *b) {
+    FILE *fa = fopen(a, "rb"), *fb = fopen(b, "rb");
+    int same = fa && fb;
+    while (same) {
+        int ca = fgetc(fa), cb = fgetc(fb);
+        if (ca != cb) same = 0;
+        if (ca == EOF) break;
+    }
+    if (fa) fclose(fa);
+    if (fb) fclose(fb);
+    return same;
+}
+
+int main(int argc, char *argv[]) {
+    int n = argc > 1 ? atoi(argv[1]) : 1000000;
+    const char *dir = argc > 2 ? argv[2] : ".";
+    memcpy(header, "GOLD\x01", 5);
+    for (size_t i = 5; i < sizeof(header); i++) header[i] = (uint8_t)('A' + i % 26);
+
+    char old_path[512], new_path[512];
+    snprintf(old_path, sizeof(old_path), "%s/write_bench_tmpfile.gld", dir);
+    snprintf(new_path, sizeof(new_path), "%s/write_bench_writev.gld", dir);
+
+    printf("Imagen de %d instrucciones (%zu bytes), mejor de %d:\n",
+           n, sizeof(header) + (size_t)n * sizeof(Instruction), RUNS);
+    double before = run("tmpfile + fwrite de 3 bytes", write_tmpfile, old_path, n);
+    double after = run("buffer + writev + rename", write_buffer, new_path, n);
+    printf("  %.2fx\n", before / after);
+
+    int same = same_file(old_path, new_path);
+    printf("  imágenes %s\n", same ? "idénticas" : "DISTINTAS");
+    unlink(old_path);
+    unlink(new_path);
+    return same ? EXIT_SUCCESS : EXIT_FAILURE;
+}
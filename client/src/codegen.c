@@ -0,0 +1,410 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "codegen.h"
+#include "consteval.h"
+
+static int emit(CodegenContext *ctx, uint8_t opcode, int32_t arg1, int32_t arg2) {
+    IRInstr instr = {opcode, arg1, arg2};
+    return ir_emit(ctx->ir, instr) < 0 ? -1 : 0;
+}
+
+static int append_string(StringPool *pool, const char *str) {
+    char **temp = realloc(pool->strings, (pool->count + 1) * sizeof(char*));
+    if (!temp) return -1;
+
+    pool->strings = temp;
+    pool->strings[pool->count] = (char*)malloc(strlen(str) + 1);
+    if (!pool->strings[pool->count]) return -1;
+
+    strcpy(pool->strings[pool->count], str);
+    return pool->count++;
+}
+
+int codegen_constant(CodegenContext *ctx, double value, char type) {
+    if (type == 'i') {
+        value = trunc(value);
+        // Enteros pequeños van en los operandos, sin pasar por el string pool
+        if (value >= -32768 && value <= 32767) {
+            int bits = (int)value & 0xFFFF;
+            return emit(ctx, OPCODE_PUSH_INT, bits & 0xFF, bits >> 8);
+        }
+    }
+
+    char number[64];
+    snprintf(number, sizeof(number), "%.17g", value);
+    int idx = append_string(ctx->string_pool, number);
+    if (idx < 0 || emit(ctx, OPCODE_PUSH_VALUE, idx, 0) != 0) return -1;
+    return type == 'i' ? emit(ctx, OPCODE_F2I, 0, 0) : 0;
+}
+
+int codegen_integer(CodegenContext *ctx, int64_t value) {
+    if (value >= -32768 && value <= 32767) return codegen_constant(ctx, (double)value, 'i');
+
+    char number[32];
+    snprintf(number, sizeof(number), "%lld", (long long)value);
+    int idx = append_string(ctx->string_pool, number);
+    return idx < 0 ? -1 : emit(ctx, OPCODE_PUSH_I64, idx, 0);
+}
+
+int codegen_convert(CodegenContext *ctx, char from, char to) {
+    if (from == to || !to) return 0;
+    return emit(ctx, to == 'd' ? OPCODE_I2F : OPCODE_F2I, 0, 0);
+}
+
+// Un subárbol es constante si no nombra locales, campos ni elementos de arrays
+static int uses_runtime_names(CodegenContext *ctx, const ExprNode *node) {
+    if (!node) return 0;
+    if (node->kind == EXPR_NAME) return ctx->resolve_name(ctx->user, node->name, NULL) != 0;
+    if (node->kind == EXPR_INDEX) return 1;
+    if (node->kind == EXPR_CALL && strchr(node->name, '.')) return 1;   // arr.pop()
+    if (uses_runtime_names(ctx, node->left) || uses_runtime_names(ctx, node->right)) return 1;
+    for (int i = 0; i < node->arg_count; i++) {
+        if (uses_runtime_names(ctx, node->args[i])) return 1;
+    }
+    return 0;
+}
+
+// Array global de "arr.metodo", o -1
+static int method_array(CodegenContext *ctx, const char *name) {
+    const char *dot = strchr(name, '.');
+    char arr_name[256];
+    if (!dot || !ctx->resolve_array || dot - name >= (int)sizeof(arr_name)) return -1;
+    memcpy(arr_name, name, dot - name);
+    arr_name[dot - name] = '\0';
+    return ctx->resolve_array(ctx->user, arr_name);
+}
+
+// Tipo del valor de "arr.metodo()": binary_search y unique dan un índice o
+// un tamaño, el resto un elemento
+static char method_type(CodegenContext *ctx, int array, const char *name) {
+    const char *method = strchr(name, '.') + 1;
+    if (strcmp(method, "binary_search") == 0 || strcmp(method, "unique") == 0) return 'i';
+    return array_value_type(ctx->var_pool, array);
+}
+
+// Tipo del resultado sin emitir código. Los errores los informa codegen_node.
+static char infer_type(CodegenContext *ctx, const ExprNode *node) {
+    if (!uses_runtime_names(ctx, node)) {
+        ConstValue value;
+        if (const_eval(node, ctx->var_pool, &value, NULL) != CONST_OK) return 'd';
+        return value.is_int ? 'i' : 'd';
+    }
+
+    switch (node->kind) {
+        case EXPR_NAME: {
+            int type = ctx->resolve_name(ctx->user, node->name, NULL);
+            return type > 0 ? (char)type : 'd';
+        }
+        case EXPR_UNARY:
+            return node->op == '!' ? 'i' : infer_type(ctx, node->left);
+        case EXPR_BINARY:
+            if (expr_is_comparison(node->op) || expr_is_logical(node->op)) return 'i';
+            return infer_type(ctx, node->left) == 'i' && infer_type(ctx, node->right) == 'i' ? 'i' : 'd';
+        case EXPR_INDEX: {
+            int array = ctx->resolve_array ? ctx->resolve_array(ctx->user, node->name) : -1;
+            return array >= 0 ? array_value_type(ctx->var_pool, array) : 'd';
+        }
+        case EXPR_CALL: {
+            int array = method_array(ctx, node->name);
+            return array >= 0 ? method_type(ctx, array, node->name) : 'd';
+        }
+        default:
+            return 'd';
+    }
+}
+
+// Posición del operador en EQ, NE, LT, LE, GT, GE (el orden de los opcodes)
+static int comparison_index(char op) {
+    switch (op) {
+        case EXPR_OP_EQ: return 0;
+        case EXPR_OP_NE: return 1;
+        case '<':        return 2;
+        case EXPR_OP_LE: return 3;
+        case '>':        return 4;
+        default:         return 5;
+    }
+}
+
+static void report_const_error(CodegenContext *ctx, ConstStatus status, const char *unresolved) {
+    if (status == CONST_DOMAIN_ERROR) {
+        fprintf(stderr, "Error: %s: división entera por cero en una expresión constante\n", ctx->source_file);
+    } else if (unresolved) {
+        fprintf(stderr, "Error: %s: '%s' no está declarada o no es numérica\n", ctx->source_file, unresolved);
+    } else {
+        fprintf(stderr, "Error: %s: expresión no soportada\n", ctx->source_file);
+    }
+}
+
+static char codegen_node(CodegenContext *ctx, const ExprNode *node, char target);
+
+// Emite los dos operandos de una comparación en el tipo común. Devuelve ese tipo.
+static char codegen_operands(CodegenContext *ctx, const ExprNode *node) {
+    char type = infer_type(ctx, node->left) == 'i' && infer_type(ctx, node->right) == 'i' ? 'i' : 'd';
+    if (!codegen_node(ctx, node->left, type) || !codegen_node(ctx, node->right, type)) return 0;
+    return type;
+}
+
+// Deja un int64 distinto de cero si el valor es verdadero
+static int codegen_truth(CodegenContext *ctx, const ExprNode *node) {
+    char type = codegen_node(ctx, node, 0);
+    if (!type) return -1;
+    if (type == 'i') return 0;
+    if (codegen_constant(ctx, 0, 'd') != 0) return -1;
+    return emit(ctx, OPCODE_NE_F64, 0, 0);
+}
+
+// a * b de tipo 'type' que no se pliega: candidato a MULADD
+static int is_fusable_multiply(CodegenContext *ctx, const ExprNode *node, char type) {
+    return node->kind == EXPR_BINARY && node->op == '*' &&
+           uses_runtime_names(ctx, node) && infer_type(ctx, node) == type;
+}
+
+static char codegen_binary(CodegenContext *ctx, const ExprNode *node) {
+    if (expr_is_logical(node->op)) {
+        // Sin saltos, ambos lados se evalúan (las expresiones no tienen efectos)
+        if (codegen_truth(ctx, node->left) != 0 || codegen_truth(ctx, node->right) != 0) return 0;
+        return emit(ctx, node->op == EXPR_OP_AND ? OPCODE_AND : OPCODE_OR, 0, 0) == 0 ? 'i' : 0;
+    }
+
+    if (expr_is_comparison(node->op)) {
+        char type = codegen_operands(ctx, node);
+        if (!type) return 0;
+        uint8_t base = type == 'i' ? OPCODE_EQ_I64 : OPCODE_EQ_F64;
+        return emit(ctx, base + comparison_index(node->op), 0, 0) == 0 ? 'i' : 0;
+    }
+
+    // Ambos enteros: aritmética int64; si no, se promueve el lado entero
+    char type = infer_type(ctx, node);
+
+    // a * b + c y c + a * b: una sola instrucción
+    if (node->op == '+') {
+        const ExprNode *mul = NULL, *addend = NULL;
+        if (is_fusable_multiply(ctx, node->left, type)) {
+            mul = node->left;
+            addend = node->right;
+        } else if (is_fusable_multiply(ctx, node->right, type)) {
+            mul = node->right;
+            addend = node->left;
+        }
+        if (mul) {
+            if (!codegen_node(ctx, mul->left, type) || !codegen_node(ctx, mul->right, type) ||
+                !codegen_node(ctx, addend, type)) return 0;
+            return emit(ctx, type == 'i' ? OPCODE_MULADD_I64 : OPCODE_MULADD_F64, 0, 0) == 0 ? type : 0;
+        }
+    }
+
+    if (!codegen_node(ctx, node->left, type) || !codegen_node(ctx, node->right, type)) return 0;
+
+    uint8_t opcode;
+    switch (node->op) {
+        case '+': opcode = type == 'i' ? OPCODE_ADD_I64 : OPCODE_ADD_F64; break;
+        case '-': opcode = type == 'i' ? OPCODE_SUB_I64 : OPCODE_SUB_F64; break;
+        case '*': opcode = type == 'i' ? OPCODE_MUL_I64 : OPCODE_MUL_F64; break;
+        case '/': opcode = type == 'i' ? OPCODE_DIV_I64 : OPCODE_DIV_F64; break;
+        default:  opcode = type == 'i' ? OPCODE_MOD_I64 : OPCODE_MOD_F64; break;
+    }
+    return emit(ctx, opcode, 0, 0) == 0 ? type : 0;
+}
+
+static char codegen_index(CodegenContext *ctx, const ExprNode *node) {
+    int array = ctx->resolve_array ? ctx->resolve_array(ctx->user, node->name) : -1;
+    if (array < 0) {
+        fprintf(stderr, "Error: %s: '%s' no es un array\n", ctx->source_file, node->name);
+        return 0;
+    }
+
+    int dims = array_dims(ctx->var_pool, array);
+    if (node->arg_count + 1 != dims) {
+        fprintf(stderr, "Error: %s: '%s' tiene %d dimensiones y se usa con %d índices\n",
+                ctx->source_file, node->name, dims, node->arg_count + 1);
+        return 0;
+    }
+    if (dims > 1) {
+        // Índice lineal row-major, ((y * ancho + x) * ...), con los tamaños
+        // como constantes: se pliega si todo es constante y si no sale MULADD
+        const int *shape = ctx->var_pool->vars[array].array_shape;
+        ExprNode sizes[ARRAY_MAX_DIMS], products[ARRAY_MAX_DIMS], sums[ARRAY_MAX_DIMS];
+        const ExprNode *flat = node->left;
+        for (int k = 1; k < dims; k++) {
+            sizes[k] = (ExprNode){.kind = EXPR_NUMBER, .number = shape[k], .is_int = 1, .integer = shape[k]};
+            products[k] = (ExprNode){.kind = EXPR_BINARY, .op = '*', .left = (ExprNode*)flat, .right = &sizes[k]};
+            sums[k] = (ExprNode){.kind = EXPR_BINARY, .op = '+', .left = &products[k], .right = node->args[k - 1]};
+            flat = &sums[k];
+        }
+        if (!codegen_node(ctx, flat, 'i')) return 0;
+        char type = array_value_type(ctx->var_pool, array);
+        uint8_t opcode = type == 'i' ? OPCODE_ARRAY_GET_INT : OPCODE_ARRAY_GET_I64;
+        return emit(ctx, opcode, array, 0) == 0 ? type : 0;
+    }
+
+    // Arrays de enteros: índice y valor int64 (ver array_value_type)
+    if (array_value_type(ctx->var_pool, array) == 'i') {
+        if (!codegen_node(ctx, node->left, 'i')) return 0;
+        return emit(ctx, OPCODE_ARRAY_GET_INT, array, 0) == 0 ? 'i' : 0;
+    }
+
+    char index_type = codegen_node(ctx, node->left, 0);
+    if (!index_type) return 0;
+    uint8_t opcode = index_type == 'i' ? OPCODE_ARRAY_GET_I64 : OPCODE_ARRAY_GET;
+    return emit(ctx, opcode, array, 0) == 0 ? 'd' : 0;
+}
+
+// Llamada que no se pudo plegar: los métodos de array con valor, arr.pop(),
+// sum(), min(), max(), dot(otro), binary_search(x) y unique(). Las funciones matemáticas necesitan
+// argumentos constantes.
+static char codegen_call(CodegenContext *ctx, const ExprNode *node) {
+    if (!strchr(node->name, '.')) {
+        fprintf(stderr, "Error: %s: la llamada a '%s' solo se admite con argumentos constantes\n",
+                ctx->source_file, node->name);
+        return 0;
+    }
+    int array = method_array(ctx, node->name);
+    const char *method = strchr(node->name, '.') + 1;
+    uint8_t opcode = strcmp(method, "pop") == 0 ? OPCODE_ARRAY_POP :
+                     strcmp(method, "sum") == 0 ? OPCODE_ARRAY_SUM :
+                     strcmp(method, "min") == 0 ? OPCODE_ARRAY_MIN :
+                     strcmp(method, "max") == 0 ? OPCODE_ARRAY_MAX :
+                     strcmp(method, "dot") == 0 ? OPCODE_ARRAY_DOT :
+                     strcmp(method, "binary_search") == 0 ? OPCODE_ARRAY_SEARCH :
+                     strcmp(method, "unique") == 0 ? OPCODE_ARRAY_UNIQUE : 0;
+    int arg_count = opcode == OPCODE_ARRAY_DOT || opcode == OPCODE_ARRAY_SEARCH ? 1 : 0;
+    if (array < 0 || !opcode || node->arg_count != arg_count) {
+        fprintf(stderr, "Error: %s: '%s()' no se puede usar en una expresión\n", ctx->source_file, node->name);
+        return 0;
+    }
+    if ((opcode == OPCODE_ARRAY_POP || opcode == OPCODE_ARRAY_UNIQUE) && ctx->var_pool->vars[array].type != 'b') {
+        fprintf(stderr, "Error: %s: '%s' es un array estático; %s() solo existe en arrays dinámicos\n",
+                ctx->source_file, ctx->var_pool->vars[array].name, method);
+        return 0;
+    }
+    if (opcode == OPCODE_ARRAY_SEARCH) {
+        if (!codegen_node(ctx, node->args[0], array_value_type(ctx->var_pool, array))) return 0;
+        return emit(ctx, opcode, array, 0) == 0 ? 'i' : 0;
+    }
+    int other = 0;
+    if (opcode == OPCODE_ARRAY_DOT) {
+        const ExprNode *arg = node->args[0];
+        other = arg->kind == EXPR_NAME && ctx->resolve_array ? ctx->resolve_array(ctx->user, arg->name) : -1;
+        if (other < 0) {
+            fprintf(stderr, "Error: %s: dot() espera el nombre de un array\n", ctx->source_file);
+            return 0;
+        }
+    }
+    return emit(ctx, opcode, array, other) == 0 ? method_type(ctx, array, node->name) : 0;
+}
+
+// Emite 'node' y lo convierte a 'target' (0 = dejar el tipo inferido)
+static char codegen_node(CodegenContext *ctx, const ExprNode *node, char target) {
+    char type = 0;
+
+    if (!uses_runtime_names(ctx, node)) {
+        ConstValue value;
+        const char *unresolved = NULL;
+        ConstStatus status = const_eval(node, ctx->var_pool, &value, &unresolved);
+        if (status != CONST_OK) {
+            report_const_error(ctx, status, unresolved);
+            return 0;
+        }
+        // La constante se emite ya con el tipo pedido
+        type = target ? target : (value.is_int ? 'i' : 'd');
+        if (type == 'i' && value.is_int) return codegen_integer(ctx, value.integer) == 0 ? type : 0;
+        return codegen_constant(ctx, value.value, type) == 0 ? type : 0;
+    }
+
+    switch (node->kind) {
+        case EXPR_NAME: {
+            IRInstr load = {0, 0, 0};
+            int resolved = ctx->resolve_name(ctx->user, node->name, &load);
+            if (resolved <= 0 || ir_emit(ctx->ir, load) < 0) return 0;
+            type = (char)resolved;
+            break;
+        }
+        case EXPR_UNARY:
+            if (node->op == '!') {
+                if (codegen_truth(ctx, node->left) != 0 || emit(ctx, OPCODE_NOT, 0, 0) != 0) return 0;
+                type = 'i';
+                break;
+            }
+            type = codegen_node(ctx, node->left, 0);
+            if (!type) return 0;
+            if (node->op == '-' && emit(ctx, type == 'i' ? OPCODE_NEG_I64 : OPCODE_NEG_F64, 0, 0) != 0) return 0;
+            break;
+        case EXPR_BINARY:
+            type = codegen_binary(ctx, node);
+            if (!type) return 0;
+            break;
+        case EXPR_INDEX:
+            type = codegen_index(ctx, node);
+            if (!type) return 0;
+            break;
+        default:
+            type = codegen_call(ctx, node);
+            if (!type) return 0;
+            break;
+    }
+
+    if (codegen_convert(ctx, type, target) != 0) return 0;
+    return target ? target : type;
+}
+
+// Parsea 'src' exigiendo que la expresión termine donde termina la sentencia
+static ExprNode *parse_statement_expression(CodegenContext *ctx, const char *src) {
+    const char *end = NULL;
+    ExprNode *root = expr_parse(src, &end);
+    while (end && (*end == ' ' || *end == '\t')) end++;
+
+    if (!root || (*end && *end != ';' && *end != '\n' && *end != '\r' && *end != ')' && *end != ']' &&
+                  !(end[0] == '/' && end[1] == '/'))) {
+        int len = 0;
+        while (src[len] && src[len] != ';' && src[len] != '\n') len++;
+        fprintf(stderr, "Error: %s: expresión no válida '%.*s'\n", ctx->source_file, len, src);
+        expr_free(root);
+        return NULL;
+    }
+    return root;
+}
+
+char codegen_expression(CodegenContext *ctx, const char *src, char target) {
+    ExprNode *root = parse_statement_expression(ctx, src);
+    if (!root) return 0;
+
+    char type = codegen_node(ctx, root, target);
+    expr_free(root);
+    return type;
+}
+
+int codegen_branch(CodegenContext *ctx, const char *src, int target_block, int *jump_index) {
+    *jump_index = -1;
+    ExprNode *root = parse_statement_expression(ctx, src);
+    if (!root) return -1;
+
+    int status = 0;
+    if (!uses_runtime_names(ctx, root)) {
+        // Condición constante: o no se salta nunca o siempre
+        ConstValue value;
+        const char *unresolved = NULL;
+        ConstStatus const_status = const_eval(root, ctx->var_pool, &value, &unresolved);
+        if (const_status != CONST_OK) {
+            report_const_error(ctx, const_status, unresolved);
+            status = -1;
+        } else if (value.value == 0) {
+            IRInstr jump = {OPCODE_JUMP, target_block, 0};
+            *jump_index = ir_emit(ctx->ir, jump);
+            if (*jump_index < 0) status = -1;
+        }
+    } else if (root->kind == EXPR_BINARY && expr_is_comparison(root->op)) {
+        // Comparar y saltar en una sola instrucción
+        char type = codegen_operands(ctx, root);
+        uint8_t base = type == 'i' ? OPCODE_JUMP_UNLESS_EQ_I64 : OPCODE_JUMP_UNLESS_EQ_F64;
+        IRInstr jump = {(uint8_t)(base + comparison_index(root->op)), target_block, 0};
+        if (!type || (*jump_index = ir_emit(ctx->ir, jump)) < 0) status = -1;
+    } else {
+        IRInstr jump = {OPCODE_JUMP_IF_FALSE, target_block, 0};
+        if (codegen_truth(ctx, root) != 0 || (*jump_index = ir_emit(ctx->ir, jump)) < 0) status = -1;
+    }
+
+    expr_free(root);
+    return status;
+}
@@ -0,0 +1,49 @@
+#ifndef CODEGEN_H
+#define CODEGEN_H
+
+#include "compiler.h"
+#include "expr.h"
+#include "ir.h"
+
+// Compilación de expresiones a código de stack con tipos inferidos: 'i'
+// (int64) o 'd' (double). Los subárboles constantes se pliegan; el resto usa
+// los opcodes *_I64 / *_F64 según el tipo de los operandos. Las comparaciones
+// y los lógicos dan un int64 0/1; a * b + c se emite como MULADD.
+
+typedef struct {
+    IRProgram *ir;
+    StringPool *string_pool;
+    VariablePool *var_pool;
+    const char *source_file;
+
+    // Resuelve un nombre no constante (local, obj.campo). Si 'load' no es NULL
+    // recibe la instrucción que lo apila. Devuelve su tipo, 0 si no existe o
+    // -1 si existe pero es inválido (ya informado).
+    int (*resolve_name)(void *user, const char *name, IRInstr *load);
+    // Global array con ese nombre, o -1
+    int (*resolve_array)(void *user, const char *name);
+    void *user;
+} CodegenContext;
+
+// Emite 'src' (hasta ';' o fin de línea) dejando su valor en el stack. Con
+// 'target' != 0 convierte el resultado a ese tipo. Devuelve el tipo final, o 0
+// tras informar del error.
+char codegen_expression(CodegenContext *ctx, const char *src, char target);
+
+// Emite el salto al bloque 'target_block' si la condición 'src' es falsa.
+// Una comparación se compila a un único JUMP_UNLESS_*; otro valor, a
+// JUMP_IF_FALSE. 'jump_index' recibe la posición del salto en el bloque actual
+// (para parchear el destino) o -1 si la condición es constante y verdadera.
+// 0 o -1.
+int codegen_branch(CodegenContext *ctx, const char *src, int target_block, int *jump_index);
+
+// Emite la conversión entre tipos ('i' <-> 'd'). 0 o -1.
+int codegen_convert(CodegenContext *ctx, char from, char to);
+
+// Apila una constante con el tipo dado
+int codegen_constant(CodegenContext *ctx, double value, char type);
+
+// Apila un entero exacto (PUSH_INT o, si no cabe en 16 bits, PUSH_I64)
+int codegen_integer(CodegenContext *ctx, int64_t value);
+
+#endif
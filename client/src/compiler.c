@@ -4,21 +4,27 @@
 #include <stdint.h>
 #include <dirent.h>
 #include <sys/stat.h>
+#include <sys/uio.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <math.h>
 #include "compiler.h"
 #include "utils.h"
 #include "imports.h"
 #include "config.h"
+#include "linker.h"
+#include "ir.h"
+#include "consteval.h"
+#include "dce.h"
+#include "optimizer.h"
+#include "codegen.h"
 
 typedef struct {
-    uint8_t opcode;
-    uint8_t arg1;
-    uint8_t arg2;
-} Instruction;
-
-typedef struct {
-    char **strings;
-    int count;
-} StringPool;
+    uint8_t *data;
+    size_t size;
+    size_t capacity;
+} ByteBuffer;
 
 static char* extract_string_from_printf(const char *line) {
     const char *start = strchr(line, '"');
@@ -91,6 +97,82 @@ static int add_string_to_pool(StringPool *pool, const char *str) {
     return pool->count++;
 }
 
+int emit_instruction(CodeBuffer *buffer, Instruction instr) {
+    if (buffer->count >= buffer->capacity) {
+        int capacity = buffer->capacity ? buffer->capacity * 2 : 256;
+        Instruction *temp = realloc(buffer->code, capacity * sizeof(Instruction));
+        if (!temp) {
+            fprintf(stderr, "Error: No hay memoria suficiente\n");
+            return -1;
+        }
+        buffer->code = temp;
+        buffer->capacity = capacity;
+    }
+    buffer->code[buffer->count] = instr;
+    return buffer->count++;
+}
+
+static int byte_buffer_append(ByteBuffer *buffer, const void *data, size_t len) {
+    if (buffer->size + len > buffer->capacity) {
+        size_t capacity = buffer->capacity ? buffer->capacity : 1024;
+        while (buffer->size + len > capacity) capacity *= 2;
+        uint8_t *temp = realloc(buffer->data, capacity);
+        if (!temp) return -1;
+        buffer->data = temp;
+        buffer->capacity = capacity;
+    }
+    memcpy(buffer->data + buffer->size, data, len);
+    buffer->size += len;
+    return 0;
+}
+
+// Escribe cabecera + código con un único writev sobre un archivo temporal y lo
+// renombra al destino, de modo que nunca queda una imagen a medio escribir.
+static int write_image(const char *output_file, const ByteBuffer *header, const CodeBuffer *code) {
+    char temp_file[512];
+    snprintf(temp_file, sizeof(temp_file), "%s.tmp", output_file);
+
+    int fd = open(temp_file, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        fprintf(stderr, "Error: No se puede crear '%s'\n", temp_file);
+        return -1;
+    }
+
+    struct iovec iov[2];
+    iov[0].iov_base = header->data;
+    iov[0].iov_len = header->size;
+    iov[1].iov_base = code->code;
+    iov[1].iov_len = (size_t)code->count * sizeof(Instruction);
+    int iov_index = 0;
+
+    while (iov_index < 2) {
+        ssize_t written = writev(fd, iov + iov_index, 2 - iov_index);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            fprintf(stderr, "Error: No se puede escribir '%s'\n", temp_file);
+            close(fd);
+            unlink(temp_file);
+            return -1;
+        }
+        // Avanzar sobre lo ya escrito (writev puede escribir parcialmente)
+        while (iov_index < 2 && (size_t)written >= iov[iov_index].iov_len) {
+            written -= iov[iov_index].iov_len;
+            iov_index++;
+        }
+        if (iov_index < 2) {
+            iov[iov_index].iov_base = (uint8_t*)iov[iov_index].iov_base + written;
+            iov[iov_index].iov_len -= written;
+        }
+    }
+
+    if (close(fd) != 0 || rename(temp_file, output_file) != 0) {
+        fprintf(stderr, "Error: No se puede crear '%s'\n", output_file);
+        unlink(temp_file);
+        return -1;
+    }
+    return 0;
+}
+
 static int add_variable_to_pool(VariablePool *pool, const char *name, char type, double value, const char *str_val) {
     GlobalVariable *temp = realloc(pool->vars, (pool->count + 1) * sizeof(GlobalVariable));
     if (!temp) return -1;
@@ -102,9 +184,11 @@ static int add_variable_to_pool(VariablePool *pool, const char *name, char type,
     strcpy(pool->vars[pool->count].name, name);
     pool->vars[pool->count].type = type;
     pool->vars[pool->count].value = value;
+    pool->vars[pool->count].int_value = 0;
     pool->vars[pool->count].array_size = 0;
     pool->vars[pool->count].dynamic_array_size = 0;
     pool->vars[pool->count].array_element_type = '\0';
+    pool->vars[pool->count].array_dims = 1;
     
     if (type == 's' && str_val) {
         pool->vars[pool->count].str_val = (char*)malloc(strlen(str_val) + 1);
@@ -117,6 +201,15 @@ static int add_variable_to_pool(VariablePool *pool, const char *name, char type,
     return pool->count++;
 }
 
+// Global numérica con su inicializador plegado: las enteras guardan el
+// int64 exacto además del double
+static int add_constant_to_pool(VariablePool *pool, const char *name, char type, const ConstValue *folded) {
+    int64_t integer = folded->is_int ? folded->integer : (int64_t)trunc(folded->value);
+    int var = add_variable_to_pool(pool, name, type, type == 'i' ? (double)integer : folded->value, NULL);
+    if (var >= 0) pool->vars[var].int_value = integer;
+    return var;
+}
+
 static int add_array_to_pool(VariablePool *pool, const char *name, char element_type, int size) {
     GlobalVariable *temp = realloc(pool->vars, (pool->count + 1) * sizeof(GlobalVariable));
     if (!temp) return -1;
@@ -130,18 +223,141 @@ static int add_array_to_pool(VariablePool *pool, const char *name, char element_
     pool->vars[pool->count].array_element_type = element_type;
     pool->vars[pool->count].array_size = size;
     pool->vars[pool->count].dynamic_array_size = 0;
+    pool->vars[pool->count].array_dims = 1;
+    pool->vars[pool->count].array_shape[0] = size;
     pool->vars[pool->count].value = 0;
     pool->vars[pool->count].str_val = NULL;
     
     return pool->count++;
 }
 
-static int extract_global_variables(const char *source_file, VariablePool *var_pool) {
+static int is_ident_char(char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_';
+}
+
+// Tipo de elemento de un array declarado como "tipo[]" o "tipo nombre[N]": el
+// identificador que termina en 'end'. Cada tipo se guarda con su tamaño (ver
+// GlobalVariable); 0 si no es un tipo de elemento.
+static char parse_element_type(const char *line, const char *end) {
+    static const struct { const char *keyword; char type; } types[] = {
+        {"int", 'i'}, {"long", 'l'}, {"byte", 'u'}, {"bool", 'z'}, {"double", 'd'}, {"float", 'd'}
+    };
+
+    const char *start = end;
+    while (start > line && is_ident_char(start[-1])) start--;
+    for (size_t i = 0; i < sizeof(types) / sizeof(types[0]); i++) {
+        if ((int)strlen(types[i].keyword) == end - start && strncmp(start, types[i].keyword, end - start) == 0) {
+            return types[i].type;
+        }
+    }
+    return 0;
+}
+
+char array_value_type(const VariablePool *pool, int var) {
+    return pool->vars[var].array_element_type == 'd' ? 'd' : 'i';
+}
+
+int array_dims(const VariablePool *pool, int var) {
+    const GlobalVariable *v = &pool->vars[var];
+    return v->type == 'a' && v->array_dims > 1 ? v->array_dims : 1;
+}
+
+// Inicializador de una global que nombra otra global aún no extraída
+// (p. ej. definida en otro archivo del proyecto)
+typedef struct {
+    char *name;
+    char type;
+    char *expr;
+    char *source_file;
+} PendingInitializer;
+
+typedef struct {
+    PendingInitializer *items;
+    int count;
+} PendingInitList;
+
+static int queue_initializer(PendingInitList *pending, const char *name, char type,
+                             const char *expr, const char *source_file) {
+    PendingInitializer *temp = realloc(pending->items, (pending->count + 1) * sizeof(PendingInitializer));
+    if (!temp) return -1;
+    pending->items = temp;
+
+    PendingInitializer *item = &pending->items[pending->count];
+    item->name = strdup(name);
+    item->type = type;
+    item->expr = strdup(expr);
+    item->source_file = strdup(source_file);
+    if (!item->name || !item->expr || !item->source_file) return -1;
+    pending->count++;
+    return 0;
+}
+
+static void free_pending_initializers(PendingInitList *pending) {
+    for (int i = 0; i < pending->count; i++) {
+        free(pending->items[i].name);
+        free(pending->items[i].expr);
+        free(pending->items[i].source_file);
+    }
+    free(pending->items);
+    pending->items = NULL;
+    pending->count = 0;
+}
+
+static void report_const_error(const char *source_file, const char *var_name,
+                               ConstStatus status, const char *unresolved) {
+    if (status == CONST_DOMAIN_ERROR) {
+        fprintf(stderr, "Error: %s: división entera por cero en el inicializador de '%s'\n", source_file, var_name);
+    } else if (unresolved) {
+        fprintf(stderr, "Error: %s: el inicializador de '%s' usa '%s', que no es constante\n",
+                source_file, var_name, unresolved);
+    } else {
+        fprintf(stderr, "Error: %s: el inicializador de '%s' no es una expresión constante\n",
+                source_file, var_name);
+    }
+}
+
+// Evalúa los inicializadores diferidos hasta que no haya progreso. Devuelve
+// la cantidad de inicializadores que no se pudieron resolver.
+static int resolve_pending_initializers(PendingInitList *pending, VariablePool *var_pool) {
+    int progress = 1;
+    while (progress) {
+        progress = 0;
+        for (int i = 0; i < pending->count; i++) {
+            PendingInitializer *item = &pending->items[i];
+            if (!item->expr) continue;
+
+            ConstValue folded;
+            if (const_eval_string(item->expr, var_pool, &folded, NULL) != CONST_OK) continue;
+
+            add_constant_to_pool(var_pool, item->name, item->type, &folded);
+            free(item->expr);
+            item->expr = NULL;
+            progress = 1;
+        }
+    }
+
+    int failed = 0;
+    for (int i = 0; i < pending->count; i++) {
+        PendingInitializer *item = &pending->items[i];
+        if (!item->expr) continue;
+
+        ConstValue folded;
+        const char *unresolved = NULL;
+        ConstStatus status = const_eval_string(item->expr, var_pool, &folded, &unresolved);
+        report_const_error(item->source_file, item->name, status, unresolved);
+        failed++;
+    }
+    return failed;
+}
+
+// Devuelve la cantidad de globales del pool, o -1 si algún inicializador no es constante
+static int extract_global_variables(const char *source_file, VariablePool *var_pool, PendingInitList *pending) {
     FILE *src = fopen(source_file, "r");
     if (!src) return 0;
 
     char line[512];
     int in_function = 0;
+    int errors = 0;
     
     while (fgets(line, sizeof(line), src)) {
         // Trim leading whitespace
@@ -160,10 +376,8 @@ static int extract_global_variables(const char *source_file, VariablePool *var_p
             char size_str[256] = {0};
             
             // Extraer tipo: int, double, etc
-            char element_type = 'i';
-            if (strstr(line, "int[]")) element_type = 'i';
-            else if (strstr(line, "double[]")) element_type = 'd';
-            else if (strstr(line, "float[]")) element_type = 'd';
+            char element_type = parse_element_type(line, strstr(line, "[]"));
+            if (!element_type) element_type = 'd';
             
             // Extraer nombre: entre "[] " y " ="
             char *bracket_end = strstr(line, "[]");
@@ -217,21 +431,28 @@ static int extract_global_variables(const char *source_file, VariablePool *var_p
                 }
             }
         }
-        // Buscar arrays estáticos: int arr[10]; o double arr[5]; etc (SOLO antes de main)
+        // Buscar arrays estáticos: int arr[10]; o double arr[5]; etc (SOLO antes de main).
+        // Con varias dimensiones (int grid[640][480];) se guardan seguidos, row-major.
         else if (strchr(line, '[') && strchr(line, ']') && strstr(line, ";") && !strstr(line, "new")) {
             char type_name[256];
             char arr_name[256];
             int arr_size = 0;
             
-            // Determinar tipo - debe haber "int ", "double ", "float " al inicio
-            char element_type = 'd';  // Default
-            if (strstr(line, "int ")) element_type = 'i';
-            else if (strstr(line, "double ")) element_type = 'd';
-            else if (strstr(line, "float ")) element_type = 'd';
-            else {
+            // Determinar tipo: la primera palabra (int, long, byte, bool, double, float)
+            const char *type_end = trimmed;
+            while (is_ident_char(*type_end)) type_end++;
+            char element_type = parse_element_type(trimmed, type_end);
+            if (!element_type) {
                 // No es una declaración de tipo, saltar
                 continue;
             }
+            if (strstr(trimmed, "[]")) {
+                // int[] fila = grid.row(0); solo vale dentro de las funciones
+                fprintf(stderr, "Error: %s: los arrays dinámicos se declaran con new; las vistas se toman "
+                        "dentro de las funciones\n", source_file);
+                errors++;
+                continue;
+            }
             
             // Extraer nombre del array: entre espacio y [
             char *start = strchr(line, ' ');
@@ -244,18 +465,34 @@ static int extract_global_variables(const char *source_file, VariablePool *var_p
                         strncpy(arr_name, start, name_len);
                         arr_name[name_len] = '\0';
                         
-                        // Extraer tamaño: entre [ y ]
-                        char *size_start = bracket + 1;
-                        char *size_end = strchr(size_start, ']');
-                        if (size_end && size_end > size_start) {
-                            int size_len = size_end - size_start;
-                            char size_str[256];
-                            strncpy(size_str, size_start, size_len);
-                            size_str[size_len] = '\0';
-                            arr_size = atoi(size_str);
-                            
-                            if (arr_size > 0) {
-                                add_array_to_pool(var_pool, arr_name, element_type, arr_size);
+                        // Extraer el tamaño de cada dimensión: entre [ y ]
+                        int shape[ARRAY_MAX_DIMS];
+                        int dims = 0;
+                        int64_t total = 1;
+                        char *size_start = bracket;
+                        while (*size_start == '[') {
+                            char *size_end = strchr(size_start, ']');
+                            if (!size_end || size_end == size_start + 1) break;
+                            int dim = atoi(size_start + 1);
+                            if (dim <= 0) break;
+                            if (dims == ARRAY_MAX_DIMS || (total *= dim) > INT32_MAX) {
+                                fprintf(stderr, "Error: %s: '%s' tiene más de %d dimensiones o demasiados elementos\n",
+                                        source_file, arr_name, ARRAY_MAX_DIMS);
+                                errors++;
+                                dims = 0;
+                                break;
+                            }
+                            shape[dims++] = dim;
+                            size_start = size_end + 1;
+                            while (*size_start == ' ' || *size_start == '\t') size_start++;
+                        }
+                        arr_size = (int)total;
+                        
+                        if (dims > 0) {
+                            int var = add_array_to_pool(var_pool, arr_name, element_type, arr_size);
+                            if (var >= 0) {
+                                var_pool->vars[var].array_dims = dims;
+                                memcpy(var_pool->vars[var].array_shape, shape, dims * sizeof(int));
                             }
                         }
                     }
@@ -299,17 +536,18 @@ static int extract_global_variables(const char *source_file, VariablePool *var_p
                 }
             }
         }
-        // Buscar líneas como: double PI = 3.14159...;
-        else if ((strstr(line, "double") || strstr(line, "int") || strstr(line, "float")) && 
+        // Buscar líneas como: double PI = 3.14159...; int y long son enteras (int64)
+        else if ((strstr(line, "double") || strstr(line, "int") || strstr(line, "long") || strstr(line, "float")) &&
             strstr(line, "=") && strstr(line, ";")) {
             
             char var_name[256];
-            double var_value = 0;
             char type_char = 'd';  // Default to double
             
-            if (strstr(line, "int")) type_char = 'i';
-            else if (strstr(line, "double")) type_char = 'd';
-            else if (strstr(line, "float")) type_char = 'd';
+            const char *type_end = trimmed;
+            while (is_ident_char(*type_end)) type_end++;
+            char keyword = parse_element_type(trimmed, type_end);
+            if (keyword) type_char = keyword == 'i' || keyword == 'l' ? 'i' : 'd';
+            else if (strstr(line, "int") || strstr(line, "long")) type_char = 'i';
             
             // Simple parsing: extraer nombre entre espacios y =
             char *start = strchr(line, ' ');
@@ -324,12 +562,26 @@ static int extract_global_variables(const char *source_file, VariablePool *var_p
                         strncpy(var_name, start, len);
                         var_name[len] = '\0';
                         
-                        // Extraer valor
+                        // Extraer valor: se pliega la expresión completa en tiempo de compilación
                         char *val_start = strchr(line, '=');
                         if (val_start) {
                             val_start++;  // Skip =
-                            var_value = strtod(val_start, NULL);
-                            add_variable_to_pool(var_pool, var_name, type_char, var_value, NULL);
+
+                            ConstValue folded;
+                            const char *unresolved = NULL;
+                            ConstStatus status = const_eval_string(val_start, var_pool, &folded, &unresolved);
+
+                            if (status == CONST_OK) {
+                                add_constant_to_pool(var_pool, var_name, type_char, &folded);
+                            } else if (status == CONST_UNRESOLVED && pending) {
+                                // Puede estar definida más adelante o en otro archivo
+                                if (queue_initializer(pending, var_name, type_char, val_start, source_file) != 0) {
+                                    errors++;
+                                }
+                            } else {
+                                report_const_error(source_file, var_name, status, unresolved);
+                                errors++;
+                            }
                         }
                     }
                 }
@@ -338,25 +590,196 @@ static int extract_global_variables(const char *source_file, VariablePool *var_p
     }
 
     fclose(src);
-    return var_pool->count;
+    return errors ? -1 : var_pool->count;
 }
 
-static int get_class_index(const ClassPool *class_pool, const char *class_name) {
-    for (int i = 0; i < class_pool->count; i++) {
-        if (strcmp(class_pool->classes[i].name, class_name) == 0) {
-            return i;
-        }
+// Vuelca en 'table' las entradas [indexed, count) de un array cuyos elementos
+// empiezan por un 'char *name' (o son directamente char*), separados 'stride' bytes
+static int sync_index(SymbolTable *table, const void *items, size_t stride, int count) {
+    if (table->indexed > count) symtab_clear(table);
+
+    for (int i = table->indexed; i < count; i++) {
+        const char *name = *(char * const *)((const char*)items + i * stride);
+        if (name && symtab_put_if_absent(table, name, i) != 0) return -1;
     }
-    return -1;
+    table->indexed = count;
+    return 0;
+}
+
+static int find_indexed(SymbolTable *table, const void *items, size_t stride, int count,
+                        const char *name, int len) {
+    if (len < 0) len = strlen(name);
+    if (sync_index(table, items, stride, count) != 0) return -1;
+    return symtab_get(table, name, len);
+}
+
+int var_pool_find(VariablePool *pool, const char *name, int len) {
+    return find_indexed(&pool->names, pool->vars, sizeof(GlobalVariable), pool->count, name, len);
+}
+
+int class_pool_find(ClassPool *pool, const char *name, int len) {
+    return find_indexed(&pool->names, pool->classes, sizeof(ClassDefinition), pool->count, name, len);
+}
+
+int class_find_field(ClassDefinition *cls, const char *name, int len) {
+    return find_indexed(&cls->field_names, cls->var_names, sizeof(char*), cls->var_count, name, len);
+}
+
+int class_find_method(ClassDefinition *cls, const char *name, int len) {
+    return find_indexed(&cls->method_names, cls->methods, sizeof(ClassMethod), cls->method_count, name, len);
+}
+
+static int find_array_global(VariablePool *var_pool, const char *name) {
+    int idx = var_pool_find(var_pool, name, -1);
+    if (idx >= 0 && var_pool->vars[idx].type != 'a' && var_pool->vars[idx].type != 'b') return -1;
+    return idx;
 }
 
-static int get_field_index(const ClassDefinition *cls, const char *field_name) {
-    for (int i = 0; i < cls->var_count; i++) {
-        if (strcmp(cls->var_names[i], field_name) == 0) {
-            return i;
+static int get_class_index(ClassPool *class_pool, const char *class_name) {
+    return class_pool_find(class_pool, class_name, -1);
+}
+
+static int get_field_index(ClassDefinition *cls, const char *field_name) {
+    return class_find_field(cls, field_name, -1);
+}
+
+// Reconoce "obj.campo" al inicio de 'text'. Devuelve el puntero tras el campo, o NULL.
+static const char *parse_field_access(const char *text, char *obj_name, char *field_name, int size) {
+    const char *p = text;
+    while (is_ident_char(*p)) p++;
+    int obj_len = p - text;
+    if (obj_len == 0 || obj_len >= size || *p != '.') return NULL;
+
+    const char *field = ++p;
+    while (is_ident_char(*p)) p++;
+    int field_len = p - field;
+    if (field_len == 0 || field_len >= size) return NULL;
+
+    memcpy(obj_name, text, obj_len);
+    obj_name[obj_len] = '\0';
+    memcpy(field_name, field, field_len);
+    field_name[field_len] = '\0';
+    return p;
+}
+
+// Llamada sin objeto al inicio de 'text': "nombre(" que no sea una sentencia
+// propia del lenguaje. Devuelve el puntero al '(', o NULL.
+static const char *parse_bare_call(const char *text, char *name, int size) {
+    static const char *const statements[] = {"print", "println", "printf", "printchr", "flush", "return"};
+    const char *p = text;
+    while (is_ident_char(*p)) p++;
+    int len = p - text;
+    if (len == 0 || len >= size || (text[0] >= '0' && text[0] <= '9') || *p != '(') return NULL;
+    for (size_t i = 0; i < sizeof(statements) / sizeof(statements[0]); i++) {
+        if ((int)strlen(statements[i]) == len && strncmp(text, statements[i], len) == 0) return NULL;
+    }
+    memcpy(name, text, len);
+    name[len] = '\0';
+    return p;
+}
+
+// "obj.campo = valor" (no "==")
+static int is_field_assignment(const char *after_field) {
+    while (*after_field == ' ' || *after_field == '\t') after_field++;
+    return after_field[0] == '=' && after_field[1] != '=';
+}
+
+static int is_object_variable(VariablePool *var_pool, const char *name) {
+    int idx = var_pool ? var_pool_find(var_pool, name, -1) : -1;
+    return idx >= 0 && var_pool->vars[idx].type == 'o';
+}
+
+// Resuelve obj.campo a (variable objeto, slot del campo) usando la tabla de clases.
+// Devuelve 0, o -1 tras informar del error.
+static int resolve_field(VariablePool *var_pool, ClassPool *class_pool, const char *source_file,
+                         const char *obj_name, const char *field_name, int *obj_idx, int *slot) {
+    int idx = var_pool ? var_pool_find(var_pool, obj_name, -1) : -1;
+    if (idx < 0 || var_pool->vars[idx].type != 'o') {
+        fprintf(stderr, "Error: %s: '%s' no es un objeto\n", source_file, obj_name);
+        return -1;
+    }
+
+    ClassDefinition *cls = &class_pool->classes[(int)var_pool->vars[idx].value];
+    int field = get_field_index(cls, field_name);
+    if (field < 0) {
+        fprintf(stderr, "Error: %s: la clase '%s' no tiene el campo '%s'\n", source_file, cls->name, field_name);
+        return -1;
+    }
+
+    *obj_idx = idx;
+    *slot = field;
+    return 0;
+}
+
+// Slot del método en la tabla de la clase (su vtable). Los privados solo se
+// pueden llamar desde la propia clase. -1 tras informar del error.
+static int resolve_method(ClassPool *class_pool, const char *source_file, int class_idx,
+                          const char *method_name, int caller_class) {
+    ClassDefinition *cls = &class_pool->classes[class_idx];
+    int slot = class_find_method(cls, method_name, -1);
+    if (slot < 0) {
+        fprintf(stderr, "Error: %s: la clase '%s' no tiene el método '%s'\n", source_file, cls->name, method_name);
+        return -1;
+    }
+    if (!cls->methods[slot].is_public && caller_class != class_idx) {
+        fprintf(stderr, "Error: %s: el método '%s.%s' es privado\n", source_file, cls->name, method_name);
+        return -1;
+    }
+    return slot;
+}
+
+// Variable que recibe "Clase nombre = new Clase();". La registra como global de
+// tipo 'o' (valor = índice de la clase) la primera vez. -1 si no hay destino válido.
+static int declare_object_variable(VariablePool *var_pool, ClassPool *class_pool, const char *source_file,
+                                   const char *line, const char *new_kw, int class_idx) {
+    const char *eq = line;
+    while (eq < new_kw && *eq != '=') eq++;
+    if (eq == new_kw) {
+        fprintf(stderr, "Error: %s: la instancia de '%s' no se asigna a ninguna variable\n",
+                source_file, class_pool->classes[class_idx].name);
+        return -1;
+    }
+
+    const char *end = eq;
+    while (end > line && (end[-1] == ' ' || end[-1] == '\t')) end--;
+    const char *start = end;
+    while (start > line && is_ident_char(start[-1])) start--;
+    if (start == end) return -1;
+
+    char name[256];
+    int len = end - start < (int)sizeof(name) ? end - start : (int)sizeof(name) - 1;
+    memcpy(name, start, len);
+    name[len] = '\0';
+
+    int idx = var_pool_find(var_pool, name, len);
+    if (idx < 0) return add_variable_to_pool(var_pool, name, 'o', class_idx, NULL);
+
+    if (var_pool->vars[idx].type != 'o' || (int)var_pool->vars[idx].value != class_idx) {
+        fprintf(stderr, "Error: %s: '%s' ya está declarada con otro tipo\n", source_file, name);
+        return -1;
+    }
+    return idx;
+}
+
+// Variación de profundidad de llaves de una línea, ignorando strings y chars
+static int brace_delta(const char *line) {
+    int delta = 0;
+    char quote = 0;
+    for (const char *p = line; *p; p++) {
+        if (quote) {
+            if (*p == '\\' && p[1]) p++;
+            else if (*p == quote) quote = 0;
+        } else if (*p == '"' || *p == '\'') {
+            quote = *p;
+        } else if (*p == '/' && p[1] == '/') {
+            break;
+        } else if (*p == '{') {
+            delta++;
+        } else if (*p == '}') {
+            delta--;
         }
     }
-    return -1;
+    return delta;
 }
 
 static int extract_classes(const char *source_file, ClassPool *class_pool) {
@@ -365,12 +788,17 @@ static int extract_classes(const char *source_file, ClassPool *class_pool) {
 
     char line[512];
     int in_class = 0;
+    int class_depth = 0;    // 1 = cuerpo de la clase; más = cuerpo de un método
     char class_name[256] = {0};
     
     while (fgets(line, sizeof(line), src)) {
+        int line_depth = class_depth;
+        if (in_class) class_depth += brace_delta(line);
+
         // Buscar definición de clase
-        if (strstr(line, "class ") && strchr(line, '{')) {
+        if (!in_class && strstr(line, "class ") && strchr(line, '{')) {
             in_class = 1;
+            class_depth = brace_delta(line);
             // Extraer nombre de la clase
             char *start = strstr(line, "class ");
             if (start) {
@@ -401,25 +829,30 @@ static int extract_classes(const char *source_file, ClassPool *class_pool) {
                     cls->var_names = NULL;
                     cls->var_types = NULL;
                     cls->var_count = 0;
+                    symtab_init(&cls->field_names, NULL);
+                    symtab_init(&cls->method_names, NULL);
                     class_pool->count++;
                 }
             }
         }
-        else if (in_class && strchr(line, '}')) {
+        else if (in_class && class_depth <= 0) {
             in_class = 0;
         }
-        else if (in_class && (strstr(line, "double") || strstr(line, "uint") || strstr(line, "int") || strstr(line, "char")) && !strstr(line, "(")) {
+        else if (in_class && line_depth == 1 && (strstr(line, "double") || strstr(line, "uint") || strstr(line, "int") || strstr(line, "char")) && !strstr(line, "(")) {
             // Agregar variable de instancia (no es método)
             if (class_pool->count > 0) {
                 ClassDefinition *cls = &class_pool->classes[class_pool->count - 1];
                 char var_name[256] = {0};
                 
-                char *start = strchr(line, ' ');
+                // Saltar indentación y tipo; el nombre es el identificador siguiente
+                char *start = line;
+                while (*start == ' ' || *start == '\t') start++;
+                start = strpbrk(start, " \t");
                 if (start) {
-                    start++;
-                    char *end = strchr(start, ';');
-                    if (!end) end = strchr(start, '=');
-                    if (end) {
+                    while (*start == ' ' || *start == '\t') start++;
+                    char *end = start;
+                    while (is_ident_char(*end)) end++;
+                    if (end > start && end - start < (int)sizeof(var_name)) {
                         int len = end - start;
                         strncpy(var_name, start, len);
                         var_name[len] = '\0';
@@ -445,7 +878,7 @@ static int extract_classes(const char *source_file, ClassPool *class_pool) {
                 }
             }
         }
-        else if (in_class && (strstr(line, "public") || strstr(line, "private")) && strchr(line, '(')) {
+        else if (in_class && line_depth == 1 && (strstr(line, "public") || strstr(line, "private")) && strchr(line, '(')) {
             // Agregar método de clase
             if (class_pool->count > 0) {
                 ClassDefinition *cls = &class_pool->classes[class_pool->count - 1];
@@ -475,6 +908,7 @@ static int extract_classes(const char *source_file, ClassPool *class_pool) {
                         method->start_instruction = 0;  // Se asignará después
                         method->instruction_count = 0;
                         method->param_count = 0;  // Simplificado por ahora
+                        method->local_count = 0;  // ir_lower lo rellena
                         method->is_public = is_public;
                         cls->method_count++;
                     }
@@ -487,24 +921,948 @@ static int extract_classes(const char *source_file, ClassPool *class_pool) {
     return class_pool->count;
 }
 
-static int compile_file_internal(const char *source_file, const char *project_dir, FILE *out, StringPool *string_pool, VariablePool *var_pool, int *instruction_count) {
-    // Verificar si es un archivo .slibgld (librería compilada)
-    if (strstr(source_file, ".slibgld")) {
-        FILE *lib = fopen(source_file, "rb");
-        if (!lib) {
-            fprintf(stderr, "Error: No se puede abrir librería '%s'\n", source_file);
-            return EXIT_FAILURE;
+static int find_class_index(ClassPool *class_pool, const char *line) {
+    const char *start = strstr(line, "class ");
+    if (!class_pool || !start) return -1;
+    start += 6;
+    while (*start == ' ' || *start == '\t') start++;
+
+    int len = 0;
+    while (start[len] && start[len] != ' ' && start[len] != '\t' && start[len] != '{') len++;
+
+    return class_pool_find(class_pool, start, len);
+}
+
+// Índice del método declarado en 'line' (mismo criterio que extract_classes)
+static int find_method_index(ClassDefinition *cls, const char *line) {
+    const char *paren = strchr(line, '(');
+    if (!paren) return -1;
+
+    const char *start = paren - 1;
+    while (start > line && *start == ' ') start--;
+    while (start > line && *start != ' ' && *start != '\t') start--;
+    if (*start == ' ' || *start == '\t') start++;
+
+    return class_find_method(cls, start, paren - start);
+}
+
+// Ámbitos de variables locales de la función que se está compilando: una tabla
+// por nivel de llaves, encadenadas para que symtab_lookup vea las exteriores
+#define MAX_LOCAL_SCOPES 64
+
+typedef struct {
+    SymbolTable tables[MAX_LOCAL_SCOPES];
+    int count;
+    int base_depth;     // Profundidad de la cabecera de la función (-1 = fuera)
+} LocalScopes;
+
+// Abre o cierra ámbitos hasta que coincidan con la profundidad 'depth'
+static void scopes_sync(LocalScopes *scopes, int depth) {
+    int wanted = scopes->base_depth < 0 ? 0 : depth - scopes->base_depth;
+    if (wanted < 0) wanted = 0;
+    if (wanted > MAX_LOCAL_SCOPES) wanted = MAX_LOCAL_SCOPES;
+
+    while (scopes->count > wanted) {
+        symtab_free(&scopes->tables[--scopes->count]);
+    }
+    for (; scopes->count < wanted; scopes->count++) {
+        SymbolTable *table = &scopes->tables[scopes->count];
+        symtab_init(table, scopes->count > 0 ? table - 1 : NULL);
+    }
+}
+
+static int find_local(const LocalScopes *scopes, const char *name, int len) {
+    if (scopes->count == 0) return -1;
+    return symtab_lookup(&scopes->tables[scopes->count - 1], name, len < 0 ? (int)strlen(name) : len);
+}
+
+// "tipo nombre = ...;" o "tipo nombre;" con tipo numérico. Devuelve el puntero
+// al '=' o ';' tras el nombre, o NULL si la línea no es una declaración local.
+static const char *parse_local_declaration(const char *line, char *type, char *name, int size) {
+    static const struct { const char *keyword; char type; } types[] = {
+        {"int", 'i'}, {"uint", 'i'}, {"long", 'i'}, {"bool", 'i'}, {"double", 'd'}, {"float", 'd'}
+    };
+
+    const char *p = line;
+    while (is_ident_char(*p)) p++;
+    int keyword_len = p - line;
+
+    *type = 0;
+    for (size_t i = 0; i < sizeof(types) / sizeof(types[0]); i++) {
+        if ((int)strlen(types[i].keyword) == keyword_len && strncmp(line, types[i].keyword, keyword_len) == 0) {
+            *type = types[i].type;
         }
-        
-        // Leer el archivo .slibgld y copiarlo al output
-        unsigned char buffer[4096];
-        size_t bytes;
-        while ((bytes = fread(buffer, 1, sizeof(buffer), lib)) > 0) {
-            fwrite(buffer, 1, bytes, out);
+    }
+    if (!*type || (*p != ' ' && *p != '\t')) return NULL;
+
+    while (*p == ' ' || *p == '\t') p++;
+    const char *start = p;
+    while (is_ident_char(*p)) p++;
+    int len = p - start;
+    if (len == 0 || len >= size || (*start >= '0' && *start <= '9')) return NULL;
+
+    while (*p == ' ' || *p == '\t') p++;
+    if (*p != ';' && (*p != '=' || p[1] == '=')) return NULL;
+
+    memcpy(name, start, len);
+    name[len] = '\0';
+    return p;
+}
+
+// Estructuras de control abiertas: if/else, while y for. Los saltos hacia
+// delante se emiten con destino provisional y se parchean al crear su bloque.
+#define MAX_CONTROL_DEPTH 32
+#define MAX_CONTROL_JUMPS 64
+
+typedef struct {
+    int block;
+    int index;          // -1 = no hay salto
+} JumpPatch;
+
+typedef struct {
+    char kind;              // 'i' if, 'e' else, 'w' while, 'f' for, 'p' parallel for
+    int depth;              // Profundidad de llaves de la cabecera
+    int head_block;         // Bloque de la condición (bucles); parallel for: primero del cuerpo
+    int slot;               // parallel for: local del índice (el final va en slot + 1)
+    JumpPatch exit;         // Salto de la condición cuando es falsa
+    JumpPatch ends[MAX_CONTROL_JUMPS];       // if: saltos al final de la cadena; bucles: break
+    int end_count;
+    JumpPatch continues[MAX_CONTROL_JUMPS];  // Bucles: continue (van al paso y al LOOP)
+    int continue_count;
+    char step[256];         // for: paso que se compila al cerrar el cuerpo
+} ControlFrame;
+
+typedef struct {
+    ControlFrame frames[MAX_CONTROL_DEPTH];
+    int count;
+} ControlStack;
+
+// Nombres que no son constantes dentro de una expresión: locales, obj.campo,
+// arr.len y elementos de arrays globales
+typedef struct {
+    IRProgram *ir;
+    const LocalScopes *scopes;
+    VariablePool *var_pool;
+    ClassPool *class_pool;
+    const char *source_file;
+} NameResolver;
+
+static int resolve_runtime_name(void *user, const char *name, IRInstr *load) {
+    NameResolver *r = (NameResolver*)user;
+    IRInstr instr = {0, 0, 0};
+    int type = 0;
+
+    int slot = find_local(r->scopes, name, -1);
+    char obj_name[256];
+    char field_name[256];
+    const char *end = parse_field_access(name, obj_name, field_name, sizeof(obj_name));
+
+    if (slot >= 0) {
+        instr.opcode = OPCODE_LOAD_LOCAL;
+        instr.arg1 = slot;
+        type = r->ir->functions[r->ir->current].local_types[slot];
+    } else if (end && *end == '\0' && is_object_variable(r->var_pool, obj_name)) {
+        int obj_idx = var_pool_find(r->var_pool, obj_name, -1);
+        ClassDefinition *cls = &r->class_pool->classes[(int)r->var_pool->vars[obj_idx].value];
+        int field = get_field_index(cls, field_name);
+        if (field < 0) {
+            if (load) resolve_field(r->var_pool, r->class_pool, r->source_file, obj_name, field_name, &obj_idx, &field);
+            return -1;
+        }
+        instr.opcode = OPCODE_GET_FIELD;
+        instr.arg1 = obj_idx;
+        instr.arg2 = field;
+        type = cls->var_types[field] == 'd' ? 'd' : 'i';
+    } else if (end && *end == '\0' && strcmp(field_name, "len") == 0 &&
+               r->var_pool && find_array_global(r->var_pool, obj_name) >= 0) {
+        instr.opcode = OPCODE_ARRAY_LEN;
+        instr.arg1 = find_array_global(r->var_pool, obj_name);
+        type = 'i';
+    } else {
+        return 0;
+    }
+
+    if (load) *load = instr;
+    return type;
+}
+
+static int resolve_runtime_array(void *user, const char *name) {
+    NameResolver *r = (NameResolver*)user;
+    return r->var_pool ? find_array_global(r->var_pool, name) : -1;
+}
+
+// Emite el código que deja en el stack el valor de 'text' (hasta ';' o fin de
+// línea) convertido a 'target' ('i', 'd' o 0 = el inferido). Devuelve el tipo
+// del valor, o 0 tras informar del error.
+static char compile_value(IRProgram *ir, StringPool *string_pool, VariablePool *var_pool,
+                          ClassPool *class_pool, const LocalScopes *scopes, const char *source_file,
+                          const char *text, char target) {
+    NameResolver resolver = {ir, scopes, var_pool, class_pool, source_file};
+    CodegenContext ctx = {ir, string_pool, var_pool, source_file,
+                          resolve_runtime_name, resolve_runtime_array, &resolver};
+    return codegen_expression(&ctx, text, target);
+}
+
+// Emite el salto (con destino provisional) que se toma si 'cond' es falsa
+static int compile_branch(IRProgram *ir, StringPool *string_pool, VariablePool *var_pool,
+                          ClassPool *class_pool, const LocalScopes *scopes, const char *source_file,
+                          const char *cond, JumpPatch *exit) {
+    NameResolver resolver = {ir, scopes, var_pool, class_pool, source_file};
+    CodegenContext ctx = {ir, string_pool, var_pool, source_file,
+                          resolve_runtime_name, resolve_runtime_array, &resolver};
+    if (codegen_branch(&ctx, cond, -1, &exit->index) != 0) return -1;
+    exit->block = ir->functions[ir->current].current_block;
+    return 0;
+}
+
+// Último ']' de los índices que empiezan en 'open' ("[y][x]"), o NULL
+static char *index_chain_end(char *open) {
+    int depth = 0;
+    for (char *p = open; *p; p++) {
+        if (*p == '[') {
+            depth++;
+        } else if (*p == ']' && --depth == 0) {
+            char *next = p + 1;
+            while (*next == ' ' || *next == '\t') next++;
+            if (*next != '[') return p;
+            p = next - 1;
         }
-        
-        fclose(lib);
-        return EXIT_SUCCESS;
+    }
+    return NULL;
+}
+
+// Índice lineal row-major de un array de varias dimensiones a partir del
+// texto entre sus corchetes ("y][x" -> "((y) * 480 + (x))"). 0, o -1 tras
+// informar del error.
+static int flatten_index(const VariablePool *var_pool, const char *source_file, int arr_idx,
+                         const char *text, char *out, size_t size) {
+    const GlobalVariable *var = &var_pool->vars[arr_idx];
+    int dims = array_dims(var_pool, arr_idx);
+    char prev[512];
+    int count = 0;
+    const char *start = text;
+    out[0] = '\0';
+    for (;;) {
+        const char *end = start;
+        int depth = 0;
+        while (*end && !(depth == 0 && *end == ']')) {
+            if (*end == '[' || *end == '(') depth++;
+            else if (*end == ']' || *end == ')') depth--;
+            end++;
+        }
+        if (++count > dims) break;
+        snprintf(prev, sizeof(prev), "%s", out);
+        int len = count == 1 ? snprintf(out, size, "(%.*s)", (int)(end - start), start)
+                             : snprintf(out, size, "(%s * %d + (%.*s))", prev, var->array_shape[count - 1],
+                                        (int)(end - start), start);
+        if (len < 0 || (size_t)len >= size) {
+            fprintf(stderr, "Error: %s: índice demasiado largo en '%s'\n", source_file, var->name);
+            return -1;
+        }
+        if (!*end) break;
+        start = end + 1;
+        while (*start == ' ' || *start == '\t') start++;
+        if (*start == '[') start++;
+    }
+    if (count != dims) {
+        fprintf(stderr, "Error: %s: '%s' tiene %d dimensiones y se usa con %d índices\n",
+                source_file, var->name, dims, count);
+        return -1;
+    }
+    return 0;
+}
+
+// Emite el índice de arr[...] y devuelve el opcode de acceso. Los arrays de
+// enteros usan ARRAY_GET_INT/SET_INT con el índice como int64; en los de
+// double, las variantes _I64 toman el índice entero tal cual y un índice
+// double se trunca en la VM. 'index_text' es lo que va entre el primer '[' y
+// el último ']'; con varias dimensiones se emite el índice lineal (int64).
+static int compile_array_index(IRProgram *ir, StringPool *string_pool, VariablePool *var_pool,
+                               ClassPool *class_pool, const LocalScopes *scopes, const char *source_file,
+                               int arr_idx, const char *index_text, int store) {
+    int int_elements = array_value_type(var_pool, arr_idx) == 'i';
+    char flat[512];
+    if (strchr(index_text, ']') || array_dims(var_pool, arr_idx) > 1) {
+        if (flatten_index(var_pool, source_file, arr_idx, index_text, flat, sizeof(flat)) != 0 ||
+            !compile_value(ir, string_pool, var_pool, class_pool, scopes, source_file, flat, 'i')) return -1;
+        if (int_elements) return store ? OPCODE_ARRAY_SET_INT : OPCODE_ARRAY_GET_INT;
+        return store ? OPCODE_ARRAY_SET_I64 : OPCODE_ARRAY_GET_I64;
+    }
+    char type = compile_value(ir, string_pool, var_pool, class_pool, scopes, source_file, index_text,
+                              int_elements ? 'i' : 0);
+    if (!type) return -1;
+    if (int_elements) return store ? OPCODE_ARRAY_SET_INT : OPCODE_ARRAY_GET_INT;
+    if (store) return type == 'i' ? OPCODE_ARRAY_SET_I64 : OPCODE_ARRAY_SET;
+    return type == 'i' ? OPCODE_ARRAY_GET_I64 : OPCODE_ARRAY_GET;
+}
+
+// Argumento de un método de array que es otro array: su nombre y ')'. Índice
+// de la global, o -1 tras informar del error.
+static int array_argument(VariablePool *var_pool, const char *source_file,
+                          const char *method, const char *args) {
+    char name[256];
+    while (*args == ' ' || *args == '\t') args++;
+    const char *end = args;
+    while (is_ident_char(*end)) end++;
+    int len = end - args;
+    while (*end == ' ' || *end == '\t') end++;
+    if (len == 0 || len >= (int)sizeof(name) || *end != ')') {
+        fprintf(stderr, "Error: %s: %s() espera el nombre de un array\n", source_file, method);
+        return -1;
+    }
+    memcpy(name, args, len);
+    name[len] = '\0';
+    int index = find_array_global(var_pool, name);
+    if (index < 0) fprintf(stderr, "Error: %s: '%s' no es un array\n", source_file, name);
+    return index;
+}
+
+// Métodos de arrays como sentencias; 'args' apunta tras el '('. push, pop,
+// reserve, resize, copy y unique cambian el tamaño y solo existen en los
+// arrays dinámicos. fill, add, mul, scale, axpy, sort y sort_desc operan sobre
+// el array completo, y sum, min, max, dot, binary_search y unique (que
+// descartan su resultado) también valen en expresiones. 0 o -1 tras informar
+// del error.
+static int compile_array_method(IRProgram *ir, StringPool *string_pool, VariablePool *var_pool,
+                                ClassPool *class_pool, const LocalScopes *scopes, const char *source_file,
+                                const char *arr_name, const char *method, const char *args) {
+    static const struct {
+        const char *name;
+        uint8_t opcode;
+    } methods[] = {
+        {"push", OPCODE_ARRAY_PUSH}, {"pop", OPCODE_ARRAY_POP}, {"reserve", OPCODE_ARRAY_RESERVE},
+        {"resize", OPCODE_ARRAY_RESIZE}, {"copy", OPCODE_ARRAY_COPY},
+        {"fill", OPCODE_ARRAY_FILL}, {"add", OPCODE_ARRAY_ADD}, {"mul", OPCODE_ARRAY_MUL},
+        {"scale", OPCODE_ARRAY_SCALE}, {"axpy", OPCODE_ARRAY_AXPY}, {"sum", OPCODE_ARRAY_SUM},
+        {"min", OPCODE_ARRAY_MIN}, {"max", OPCODE_ARRAY_MAX}, {"dot", OPCODE_ARRAY_DOT},
+        {"sort", OPCODE_ARRAY_SORT}, {"sort_desc", OPCODE_ARRAY_SORT_DESC},
+        {"binary_search", OPCODE_ARRAY_SEARCH}, {"unique", OPCODE_ARRAY_UNIQUE}
+    };
+    int arr_idx = find_array_global(var_pool, arr_name);
+    IRInstr instr = {0, arr_idx, 0};
+    for (size_t i = 0; i < sizeof(methods) / sizeof(methods[0]) && !instr.opcode; i++) {
+        if (strcmp(method, methods[i].name) == 0) instr.opcode = methods[i].opcode;
+    }
+
+    if (!instr.opcode) {
+        fprintf(stderr, "Error: %s: los arrays no tienen el método '%s'\n", source_file, method);
+        return -1;
+    }
+    if ((instr.opcode <= OPCODE_ARRAY_COPY || instr.opcode == OPCODE_ARRAY_UNIQUE) &&
+        var_pool->vars[arr_idx].type != 'b') {
+        fprintf(stderr, "Error: %s: '%s' es un array estático; %s() solo existe en arrays dinámicos\n",
+                source_file, arr_name, method);
+        return -1;
+    }
+
+    while (*args == ' ' || *args == '\t') args++;
+    switch (instr.opcode) {
+        case OPCODE_ARRAY_PUSH:
+        case OPCODE_ARRAY_RESERVE:
+        case OPCODE_ARRAY_RESIZE:
+        case OPCODE_ARRAY_FILL:
+        case OPCODE_ARRAY_SCALE: {
+            int sized = instr.opcode == OPCODE_ARRAY_RESERVE || instr.opcode == OPCODE_ARRAY_RESIZE;
+            char target = sized ? 'i' : array_value_type(var_pool, arr_idx);
+            if (!compile_value(ir, string_pool, var_pool, class_pool, scopes, source_file, args, target)) return -1;
+            return ir_emit(ir, instr) < 0 ? -1 : 0;
+        }
+        case OPCODE_ARRAY_COPY:
+        case OPCODE_ARRAY_ADD:
+        case OPCODE_ARRAY_MUL:
+            instr.arg2 = array_argument(var_pool, source_file, method, args);
+            if (instr.arg2 < 0) return -1;
+            return ir_emit(ir, instr) < 0 ? -1 : 0;
+        case OPCODE_ARRAY_AXPY: {
+            // axpy(k, x): k es el último argumento antes de la coma de nivel superior
+            char factor[256];
+            int depth = 0;
+            const char *comma = args;
+            while (*comma && !(*comma == ',' && depth == 0)) {
+                if (*comma == '(') depth++;
+                else if (*comma == ')') depth--;
+                comma++;
+            }
+            if (*comma != ',' || comma - args >= (int)sizeof(factor)) {
+                fprintf(stderr, "Error: %s: axpy() espera un factor y un array\n", source_file);
+                return -1;
+            }
+            memcpy(factor, args, comma - args);
+            factor[comma - args] = '\0';
+            instr.arg2 = array_argument(var_pool, source_file, method, comma + 1);
+            if (instr.arg2 < 0) return -1;
+            if (!compile_value(ir, string_pool, var_pool, class_pool, scopes, source_file, factor,
+                               array_value_type(var_pool, arr_idx))) return -1;
+            return ir_emit(ir, instr) < 0 ? -1 : 0;
+        }
+        case OPCODE_ARRAY_SEARCH: {
+            char target = array_value_type(var_pool, arr_idx);
+            if (!compile_value(ir, string_pool, var_pool, class_pool, scopes, source_file, args, target)) return -1;
+            IRInstr pop = {OPCODE_POP_VALUE, 0, 0};
+            return ir_emit(ir, instr) < 0 || ir_emit(ir, pop) < 0 ? -1 : 0;
+        }
+        default:
+            break;
+    }
+
+    if (*args != ')' && instr.opcode != OPCODE_ARRAY_DOT) {
+        fprintf(stderr, "Error: %s: %s() no lleva argumentos\n", source_file, method);
+        return -1;
+    }
+    if (instr.opcode == OPCODE_ARRAY_SORT || instr.opcode == OPCODE_ARRAY_SORT_DESC) {
+        return ir_emit(ir, instr) < 0 ? -1 : 0;
+    }
+
+    // pop, sum, min, max, dot y unique: como sentencia, el valor se descarta
+    if (instr.opcode == OPCODE_ARRAY_DOT) {
+        instr.arg2 = array_argument(var_pool, source_file, method, args);
+        if (instr.arg2 < 0) return -1;
+    }
+    if (ir_emit(ir, instr) < 0) return -1;
+    IRInstr pop = {OPCODE_POP_VALUE, 0, 0};
+    return ir_emit(ir, pop) < 0 ? -1 : 0;
+}
+
+// Vistas: "vista = origen.row(i);", "vista = origen.col(j);" y
+// "vista = origen.slice(desde, hasta);". 'vista' es un array dinámico que pasa
+// a compartir los datos de 'origen' sin copiarlos (ver vm_array_view).
+// Devuelve 1 si la compiló, 0 si no es una de ellas o -1 tras un error.
+static int compile_view_statement(IRProgram *ir, StringPool *string_pool, VariablePool *var_pool,
+                                  ClassPool *class_pool, const LocalScopes *scopes, const char *source_file,
+                                  const char *line) {
+    static const struct {
+        const char *name;
+        uint8_t opcode;
+    } views[] = {
+        {"row", OPCODE_ARRAY_ROW}, {"col", OPCODE_ARRAY_COL}, {"slice", OPCODE_ARRAY_SLICE}
+    };
+    char view_name[256], src_name[256], method[256];
+    const char *p = line;
+    while (is_ident_char(*p)) p++;
+    int len = p - line;
+    if (!var_pool || len == 0 || len >= (int)sizeof(view_name)) return 0;
+    memcpy(view_name, line, len);
+    view_name[len] = '\0';
+    while (*p == ' ' || *p == '\t') p++;
+    if (p[0] != '=' || p[1] == '=') return 0;
+    p++;
+    while (*p == ' ' || *p == '\t') p++;
+
+    const char *args = parse_field_access(p, src_name, method, sizeof(src_name));
+    if (!args || *args != '(') return 0;
+    IRInstr instr = {0, 0, 0};
+    for (size_t i = 0; i < sizeof(views) / sizeof(views[0]) && !instr.opcode; i++) {
+        if (strcmp(method, views[i].name) == 0) instr.opcode = views[i].opcode;
+    }
+    int view = find_array_global(var_pool, view_name);
+    int src = find_array_global(var_pool, src_name);
+    if (!instr.opcode || view < 0 || src < 0 || find_local(scopes, view_name, -1) >= 0) return 0;
+
+    if (var_pool->vars[view].type != 'b') {
+        fprintf(stderr, "Error: %s: '%s' es un array estático; las vistas se guardan en arrays dinámicos\n",
+                source_file, view_name);
+        return -1;
+    }
+    if (var_pool->vars[view].array_element_type != var_pool->vars[src].array_element_type) {
+        fprintf(stderr, "Error: %s: '%s' y '%s' no tienen el mismo tipo de elemento\n",
+                source_file, view_name, src_name);
+        return -1;
+    }
+    if (instr.opcode != OPCODE_ARRAY_SLICE && var_pool->vars[src].type == 'a' && array_dims(var_pool, src) < 2) {
+        fprintf(stderr, "Error: %s: %s() necesita un array de varias dimensiones y '%s' tiene una\n",
+                source_file, method, src_name);
+        return -1;
+    }
+    instr.arg1 = view;
+    instr.arg2 = src;
+
+    args++;
+    if (instr.opcode == OPCODE_ARRAY_SLICE) {
+        // slice(desde, hasta): filas [desde, hasta)
+        char from[256];
+        int depth = 0;
+        const char *comma = args;
+        while (*comma && !(*comma == ',' && depth == 0)) {
+            if (*comma == '(') depth++;
+            else if (*comma == ')') depth--;
+            comma++;
+        }
+        if (*comma != ',' || comma - args >= (int)sizeof(from)) {
+            fprintf(stderr, "Error: %s: slice() espera el principio y el final\n", source_file);
+            return -1;
+        }
+        memcpy(from, args, comma - args);
+        from[comma - args] = '\0';
+        if (!compile_value(ir, string_pool, var_pool, class_pool, scopes, source_file, from, 'i')) return -1;
+        args = comma + 1;
+    }
+    if (!compile_value(ir, string_pool, var_pool, class_pool, scopes, source_file, args, 'i')) return -1;
+    return ir_emit(ir, instr) < 0 ? -1 : 1;
+}
+
+// '{' que abre un hueco de interpolación: le sigue un nombre y se cierra
+static const char *interpolation_hole(const char *p) {
+    if (*p != '{') return NULL;
+    const char *q = p + 1;
+    while (*q == ' ' || *q == '\t') q++;
+    if (!is_ident_char(*q) || (*q >= '0' && *q <= '9')) return NULL;
+    return strchr(q, '}');
+}
+
+// Copia texto literal a la plantilla, duplicando el byte de hueco si aparece
+static int append_template_text(ByteBuffer *tmpl, const char *text, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        if (byte_buffer_append(tmpl, &text[i], 1) != 0) return -1;
+        if (text[i] == FORMAT_HOLE && byte_buffer_append(tmpl, &text[i], 1) != 0) return -1;
+    }
+    return 0;
+}
+
+// print/println con interpolación: "x = {x}, y = {y + 1}". Cada hueco se
+// compila como expresión (en orden, al stack) y el literal de la línea se
+// sustituye en el pool por la plantilla de FORMAT_PRINT. Los strings globales
+// se copian tal cual en la plantilla (no cambian en ejecución). Con huecos,
+// "{{" y "}}" son llaves literales; sin ellos el literal no se toca.
+// Devuelve 1 si emitió FORMAT_PRINT, 0 si el literal no tiene huecos o -1
+// tras un error.
+static int compile_interpolation(IRProgram *ir, StringPool *string_pool, VariablePool *var_pool,
+                                 ClassPool *class_pool, const LocalScopes *scopes, const char *source_file,
+                                 int pool_index, int newline) {
+    if (pool_index >= string_pool->count) return 0;
+    const char *text = string_pool->strings[pool_index];
+
+    int has_hole = 0;
+    for (const char *p = text; *p && !has_hole; p++) {
+        if (p[0] == '{' && p[1] == '{') p++;
+        else has_hole = interpolation_hole(p) != NULL;
+    }
+    if (!has_hole) return 0;
+
+    ByteBuffer tmpl = {NULL, 0, 0};
+    int count = 0;
+    int status = -1;
+    const char *p = text;
+    while (*p) {
+        const char *close = interpolation_hole(p);
+        if ((p[0] == '{' && p[1] == '{') || (p[0] == '}' && p[1] == '}')) {
+            if (byte_buffer_append(&tmpl, p, 1) != 0) goto nomem;
+            p += 2;
+            continue;
+        }
+        if (!close) {
+            if (append_template_text(&tmpl, p, 1) != 0) goto nomem;
+            p++;
+            continue;
+        }
+
+        char expr[256];
+        const char *start = p + 1;
+        while (*start == ' ' || *start == '\t') start++;
+        int len = close - start;
+        while (len > 0 && (start[len - 1] == ' ' || start[len - 1] == '\t')) len--;
+        if (len >= (int)sizeof(expr)) {
+            fprintf(stderr, "Error: %s: expresión demasiado larga en la interpolación\n", source_file);
+            goto done;
+        }
+        memcpy(expr, start, len);
+        expr[len] = '\0';
+
+        int var = var_pool ? var_pool_find(var_pool, expr, -1) : -1;
+        if (var >= 0 && var_pool->vars[var].type == 's' && find_local(scopes, expr, -1) < 0) {
+            const char *value = var_pool->vars[var].str_val ? var_pool->vars[var].str_val : "";
+            if (append_template_text(&tmpl, value, strlen(value)) != 0) goto nomem;
+        } else {
+            if (count == 255) {
+                fprintf(stderr, "Error: %s: demasiados huecos en la interpolación\n", source_file);
+                goto done;
+            }
+            char type = compile_value(ir, string_pool, var_pool, class_pool, scopes, source_file, expr, 0);
+            if (!type) goto done;
+            char hole[2] = {FORMAT_HOLE, type == 'i' ? 'i' : 'f'};
+            if (byte_buffer_append(&tmpl, hole, 2) != 0) goto nomem;
+            count++;
+        }
+        p = close + 1;
+    }
+    if ((newline && byte_buffer_append(&tmpl, "\n", 1) != 0) || byte_buffer_append(&tmpl, "", 1) != 0) {
+        goto nomem;
+    }
+
+    free(string_pool->strings[pool_index]);
+    string_pool->strings[pool_index] = (char*)tmpl.data;
+    tmpl.data = NULL;
+
+    IRInstr instr = {OPCODE_FORMAT_PRINT, pool_index, count};
+    if (ir_emit(ir, instr) >= 0) status = 1;
+    goto done;
+
+nomem:
+    fprintf(stderr, "Error: No hay memoria suficiente\n");
+done:
+    free(tmpl.data);
+    return status;
+}
+
+// Sentencias sobre locales: declaración "tipo nombre [= valor]", asignación
+// "nombre = valor", "nombre op= valor" y "nombre++" / "nombre--".
+// Devuelve 1 si la compiló, 0 si no es una de ellas o -1 tras un error.
+static int compile_local_statement(IRProgram *ir, StringPool *string_pool, VariablePool *var_pool,
+                                   ClassPool *class_pool, LocalScopes *scopes, const char *source_file,
+                                   const char *text) {
+    char name[256];
+    char type;
+    const char *end;
+    int slot;
+    char value[512];
+    const char *rhs;
+
+    if (scopes->count > 0 && (end = parse_local_declaration(text, &type, name, sizeof(name)))) {
+        SymbolTable *scope = &scopes->tables[scopes->count - 1];
+        if (symtab_get(scope, name, strlen(name)) >= 0) {
+            fprintf(stderr, "Error: %s: '%s' ya está declarada en este ámbito\n", source_file, name);
+            return -1;
+        }
+        slot = ir_add_local(ir, type);
+        if (slot < 0) {
+            fprintf(stderr, "Error: %s: demasiadas variables locales en '%s'\n",
+                    source_file, ir->functions[ir->current].name);
+            return -1;
+        }
+        symtab_put(scope, name, slot);
+
+        // Sin inicializador vale 0 (también al repetir la declaración en un bucle)
+        rhs = *end == '=' ? end + 1 : "0";
+    } else {
+        const char *p = text;
+        while (is_ident_char(*p)) p++;
+        int len = p - text;
+        if (len == 0 || len >= (int)sizeof(name)) return 0;
+        memcpy(name, text, len);
+        name[len] = '\0';
+
+        slot = find_local(scopes, name, -1);
+        if (slot < 0) return 0;
+        type = ir->functions[ir->current].local_types[slot];
+
+        while (*p == ' ' || *p == '\t') p++;
+        if (*p == '=' && p[1] != '=') {
+            rhs = p + 1;
+        } else if ((p[0] == '+' && p[1] == '+') || (p[0] == '-' && p[1] == '-')) {
+            snprintf(value, sizeof(value), "%s %c 1", name, p[0]);
+            rhs = value;
+        } else if (strchr("+-*/%", p[0]) && p[0] && p[1] == '=') {
+            // El valor termina en ';' o en el ')' de una cabecera for (el que
+            // no cierra un paréntesis del propio valor)
+            const char *v = p + 2;
+            int v_len = 0, parens = 0;
+            while (v[v_len] && v[v_len] != ';' && v[v_len] != '\n' && (v[v_len] != ')' || parens > 0)) {
+                if (v[v_len] == '(') parens++;
+                if (v[v_len] == ')') parens--;
+                v_len++;
+            }
+            snprintf(value, sizeof(value), "%s %c (%.*s)", name, p[0], v_len, v);
+            rhs = value;
+        } else {
+            return 0;
+        }
+    }
+
+    if (!compile_value(ir, string_pool, var_pool, class_pool, scopes, source_file, rhs, type)) return -1;
+    IRInstr store = {OPCODE_STORE_LOCAL, slot, 0};
+    return ir_emit(ir, store) < 0 ? -1 : 1;
+}
+
+static void patch_jump(IRProgram *ir, JumpPatch patch, int target_block) {
+    if (patch.index < 0) return;
+    ir->functions[ir->current].blocks[patch.block].instrs[patch.index].arg1 = target_block;
+}
+
+static int emit_jump(IRProgram *ir, uint8_t opcode, int target_block, JumpPatch *patch) {
+    IRInstr jump = {opcode, target_block, 0};
+    int index = ir_emit(ir, jump);
+    if (patch) {
+        patch->block = ir->functions[ir->current].current_block;
+        patch->index = index;
+    }
+    return index < 0 ? -1 : 0;
+}
+
+static int add_patch(JumpPatch *list, int *count, JumpPatch patch, const char *source_file) {
+    if (*count >= MAX_CONTROL_JUMPS) {
+        fprintf(stderr, "Error: %s: demasiados saltos en una estructura de control\n", source_file);
+        return -1;
+    }
+    list[(*count)++] = patch;
+    return 0;
+}
+
+// "palabra" seguida de espacio o '(' al inicio de 'text'
+static const char *match_keyword(const char *text, const char *keyword) {
+    size_t len = strlen(keyword);
+    if (strncmp(text, keyword, len) != 0 || is_ident_char(text[len])) return NULL;
+    text += len;
+    while (*text == ' ' || *text == '\t') text++;
+    return text;
+}
+
+// Copia lo que hay entre '(' y su ')' en 'out'. NULL si no está balanceado.
+static const char *parse_parenthesized(const char *text, char *out, int size) {
+    if (*text != '(') return NULL;
+    int level = 0;
+    const char *p = text;
+    for (; *p; p++) {
+        if (*p == '(') level++;
+        else if (*p == ')' && --level == 0) break;
+    }
+    int len = p - text - 1;
+    if (!*p || len >= size) return NULL;
+    memcpy(out, text + 1, len);
+    out[len] = '\0';
+    return p + 1;
+}
+
+// Cabecera "(...) {" de if/while/for: condición en 'cond' y comprobación de '{'
+static int parse_control_header(const char *text, char *cond, int size, const char *source_file,
+                                const char *keyword) {
+    const char *rest = parse_parenthesized(text, cond, size);
+    if (rest) {
+        while (*rest == ' ' || *rest == '\t') rest++;
+    }
+    if (!rest || *rest != '{') {
+        fprintf(stderr, "Error: %s: se esperaba '%s (...) {' con el cuerpo en las líneas siguientes\n",
+                source_file, keyword);
+        return -1;
+    }
+    return 0;
+}
+
+// Divide "init; cond; paso" de un for
+static int split_for_header(char *header, char **init, char **cond, char **step) {
+    char *first = strchr(header, ';');
+    char *second = first ? strchr(first + 1, ';') : NULL;
+    if (!second) return -1;
+    *first = '\0';
+    *second = '\0';
+    *init = header;
+    *cond = first + 1;
+    *step = second + 1;
+    while (**cond == ' ' || **cond == '\t') (*cond)++;
+    while (**step == ' ' || **step == '\t') (*step)++;
+    while (**init == ' ' || **init == '\t') (*init)++;
+    return 0;
+}
+
+static int is_blank(const char *text) {
+    while (*text == ' ' || *text == '\t') text++;
+    return *text == '\0';
+}
+
+// Cuerpo de un if (también en "else if"): salto de la condición y bloque nuevo
+static int open_if(IRProgram *ir, StringPool *string_pool, VariablePool *var_pool, ClassPool *class_pool,
+                   const LocalScopes *scopes, const char *source_file, ControlFrame *frame, const char *header) {
+    char cond[512];
+    if (parse_control_header(header, cond, sizeof(cond), source_file, "if") != 0 ||
+        compile_branch(ir, string_pool, var_pool, class_pool, scopes, source_file, cond, &frame->exit) != 0) {
+        return -1;
+    }
+    return ir_new_block(ir) < 0 ? -1 : 0;
+}
+
+// Abre while/for. La condición va en su propio bloque, destino del LOOP.
+static int open_loop(IRProgram *ir, StringPool *string_pool, VariablePool *var_pool, ClassPool *class_pool,
+                     LocalScopes *scopes, const char *source_file, ControlFrame *frame, const char *header) {
+    char text[512];
+    char *cond = text;
+    char *init = NULL;
+    char *step = NULL;
+
+    if (parse_control_header(header, text, sizeof(text), source_file, frame->kind == 'w' ? "while" : "for") != 0) {
+        return -1;
+    }
+    if (frame->kind == 'f') {
+        if (split_for_header(text, &init, &cond, &step) != 0) {
+            fprintf(stderr, "Error: %s: se esperaba 'for (inicio; condición; paso)'\n", source_file);
+            return -1;
+        }
+        if (!is_blank(init) &&
+            compile_local_statement(ir, string_pool, var_pool, class_pool, scopes, source_file, init) != 1) {
+            fprintf(stderr, "Error: %s: inicialización de for no soportada '%s'\n", source_file, init);
+            return -1;
+        }
+        snprintf(frame->step, sizeof(frame->step), "%s", step);
+    }
+
+    frame->head_block = ir_new_block(ir);
+    if (frame->head_block < 0) return -1;
+    frame->exit.index = -1;
+    if (!is_blank(cond) &&
+        compile_branch(ir, string_pool, var_pool, class_pool, scopes, source_file, cond, &frame->exit) != 0) {
+        return -1;
+    }
+    return ir_new_block(ir) < 0 ? -1 : 0;
+}
+
+// Abre "parallel for (int i = inicio; i < fin; i++)": guarda el índice y, en
+// el slot siguiente, el final, y emite PARALLEL_FOR. El cuerpo empieza en un
+// bloque nuevo y acaba en el PARALLEL_END que emite close_parallel_for.
+static int open_parallel_for(IRProgram *ir, StringPool *string_pool, VariablePool *var_pool, ClassPool *class_pool,
+                             LocalScopes *scopes, const ControlStack *control, const char *source_file,
+                             ControlFrame *frame, const char *header) {
+    char text[512];
+    char *init, *cond, *step;
+    char name[256];
+    char type;
+
+    for (int i = 0; i < control->count - 1; i++) {
+        if (control->frames[i].kind == 'p') {
+            fprintf(stderr, "Error: %s: no se puede anidar un parallel for dentro de otro\n", source_file);
+            return -1;
+        }
+    }
+    if (parse_control_header(header, text, sizeof(text), source_file, "parallel for") != 0) return -1;
+
+    // Solo la forma canónica: el reparto necesita conocer todo el rango al entrar
+    const char *limit = NULL;
+    const char *increment = NULL;
+    if (split_for_header(text, &init, &cond, &step) == 0 &&
+        parse_local_declaration(init, &type, name, sizeof(name)) && type == 'i' &&
+        strncmp(cond, name, strlen(name)) == 0 && strncmp(step, name, strlen(name)) == 0) {
+        limit = cond + strlen(name);
+        while (*limit == ' ' || *limit == '\t') limit++;
+        increment = step + strlen(name);
+        while (*increment == ' ' || *increment == '\t') increment++;
+    }
+    if (!limit || limit[0] != '<' || limit[1] == '=' || strncmp(increment, "++", 2) != 0 || !is_blank(increment + 2)) {
+        fprintf(stderr, "Error: %s: se esperaba 'parallel for (int i = inicio; i < fin; i++)'\n", source_file);
+        return -1;
+    }
+
+    if (compile_local_statement(ir, string_pool, var_pool, class_pool, scopes, source_file, init) != 1) return -1;
+    frame->slot = find_local(scopes, name, -1);
+    int end_slot = ir_add_local(ir, 'i');
+    if (end_slot != frame->slot + 1) {
+        fprintf(stderr, "Error: %s: demasiadas variables locales en '%s'\n",
+                source_file, ir->functions[ir->current].name);
+        return -1;
+    }
+    if (!compile_value(ir, string_pool, var_pool, class_pool, scopes, source_file, limit + 1, 'i')) return -1;
+
+    IRInstr store = {OPCODE_STORE_LOCAL, end_slot, 0};
+    IRInstr open = {OPCODE_PARALLEL_FOR, frame->slot, 0};
+    if (ir_emit(ir, store) < 0 || ir_emit(ir, open) < 0) return -1;
+    frame->head_block = ir_new_block(ir);
+    return frame->head_block < 0 ? -1 : 0;
+}
+
+// '}' de un parallel for: PARALLEL_END en su propio bloque, destino de los
+// continue. Cada hilo trabaja sobre su copia del frame, así que el cuerpo no
+// puede asignar a locales de fuera de él (la escritura se perdería) ni salir
+// de la región con return.
+static int close_parallel_for(IRProgram *ir, ControlFrame *frame, const char *source_file) {
+    const IRFunction *fn = &ir->functions[ir->current];
+    for (int b = frame->head_block; b < fn->block_count; b++) {
+        for (int k = 0; k < fn->blocks[b].count; k++) {
+            IRInstr instr = fn->blocks[b].instrs[k];
+            if (instr.opcode == OPCODE_RETURN) {
+                fprintf(stderr, "Error: %s: 'return' dentro de parallel for\n", source_file);
+                return -1;
+            }
+            if (instr.opcode == OPCODE_STORE_LOCAL && instr.arg1 <= frame->slot + 1) {
+                fprintf(stderr, "Error: %s: dentro de parallel for solo se asigna a locales declaradas en el cuerpo\n",
+                        source_file);
+                return -1;
+            }
+        }
+    }
+
+    int end_block = ir_new_block(ir);
+    if (end_block < 0) return -1;
+    for (int i = 0; i < frame->continue_count; i++) {
+        patch_jump(ir, frame->continues[i], end_block);
+    }
+    IRInstr close = {OPCODE_PARALLEL_END, frame->slot, 0};
+    if (ir_emit(ir, close) < 0) return -1;
+    return ir_new_block(ir) < 0 ? -1 : 0;
+}
+
+// "} else": el if salta al final de la cadena y su condición falsa, aquí
+static int enter_else(IRProgram *ir, ControlFrame *frame, const char *source_file) {
+    JumpPatch end;
+    if (emit_jump(ir, OPCODE_JUMP, -1, &end) != 0 ||
+        add_patch(frame->ends, &frame->end_count, end, source_file) != 0) {
+        return -1;
+    }
+    int block = ir_new_block(ir);
+    if (block < 0) return -1;
+    patch_jump(ir, frame->exit, block);
+    frame->exit.index = -1;
+    return 0;
+}
+
+// '}' de la estructura: cierra el if/else o emite el paso y el LOOP del bucle,
+// destino de los continue
+static int close_control(IRProgram *ir, StringPool *string_pool, VariablePool *var_pool, ClassPool *class_pool,
+                         LocalScopes *scopes, const char *source_file, ControlFrame *frame) {
+    if (frame->kind == 'p') return close_parallel_for(ir, frame, source_file);
+    if (frame->kind == 'w' || frame->kind == 'f') {
+        int latch_block = ir_new_block(ir);
+        if (latch_block < 0) return -1;
+        for (int i = 0; i < frame->continue_count; i++) {
+            patch_jump(ir, frame->continues[i], latch_block);
+        }
+    }
+    if (frame->kind == 'f') {
+        if (!is_blank(frame->step) &&
+            compile_local_statement(ir, string_pool, var_pool, class_pool, scopes, source_file, frame->step) != 1) {
+            fprintf(stderr, "Error: %s: paso de for no soportado '%s'\n", source_file, frame->step);
+            return -1;
+        }
+    }
+    if ((frame->kind == 'w' || frame->kind == 'f') && emit_jump(ir, OPCODE_LOOP, frame->head_block, NULL) != 0) {
+        return -1;
+    }
+
+    int end_block = ir_new_block(ir);
+    if (end_block < 0) return -1;
+    patch_jump(ir, frame->exit, end_block);
+    for (int i = 0; i < frame->end_count; i++) {
+        patch_jump(ir, frame->ends[i], end_block);
+    }
+    return 0;
+}
+
+// break / continue: salto al bucle más interno
+static int compile_loop_exit(IRProgram *ir, ControlStack *control, const char *source_file, int is_break) {
+    ControlFrame *loop = NULL;
+    for (int i = control->count - 1; i >= 0 && !loop; i--) {
+        char kind = control->frames[i].kind;
+        if (kind == 'w' || kind == 'f' || kind == 'p') loop = &control->frames[i];
+    }
+    if (!loop) {
+        fprintf(stderr, "Error: %s: '%s' fuera de un bucle\n", source_file, is_break ? "break" : "continue");
+        return -1;
+    }
+    if (is_break && loop->kind == 'p') {
+        fprintf(stderr, "Error: %s: 'break' dentro de parallel for (el cuerpo se ejecuta para todos los índices)\n",
+                source_file);
+        return -1;
+    }
+
+    // continue va al bloque del LOOP: cada iteración pasa por el mismo contador
+    JumpPatch patch;
+    if (emit_jump(ir, OPCODE_JUMP, -1, &patch) != 0 ||
+        (is_break ? add_patch(loop->ends, &loop->end_count, patch, source_file)
+                  : add_patch(loop->continues, &loop->continue_count, patch, source_file)) != 0) {
+        return -1;
+    }
+    // Lo que siga en el cuerpo es inalcanzable: bloque aparte
+    return ir_new_block(ir) < 0 ? -1 : 0;
+}
+
+static int compile_file_internal(const char *source_file, const char *project_dir, IRProgram *ir, StringPool *string_pool, VariablePool *var_pool, ClassPool *class_pool) {
+    // Verificar si es un archivo .slibgld (librería compilada): enlazar sus secciones
+    if (strstr(source_file, ".slibgld")) {
+        return link_static_library(source_file, ir, string_pool, var_pool, class_pool);
     }
 
     FILE *src = fopen(source_file, "r");
@@ -520,7 +1878,11 @@ static int compile_file_internal(const char *source_file, const char *project_di
     if (imports && imports->count > 0) {
         printf("  (importando %d libreria(s))\n", imports->count);
         for (int i = 0; i < imports->count; i++) {
-            compile_file_internal(imports->files[i], project_dir, out, string_pool, var_pool, instruction_count);
+            if (compile_file_internal(imports->files[i], project_dir, ir, string_pool, var_pool, class_pool) != EXIT_SUCCESS) {
+                free_file_list(imports);
+                fclose(src);
+                return EXIT_FAILURE;
+            }
         }
         free_file_list(imports);
     }
@@ -551,22 +1913,112 @@ static int compile_file_internal(const char *source_file, const char *project_di
     int local_printf_count = 0;
     int emitted_dynamic_arrays = 0;  // Bandera para emitir ARRAY_NEW solo una vez
 
+    // Cada método se emite en su propia función IR; el resto va a la entrada
+    int depth = 0;
+    int class_index = -1;
+    int class_depth = 0;
+    int method_depth = -1;
+
+    // Destino de los accesos obj.campo
+    char obj_name[256];
+    char field_name[256];
+    const char *field_end;
+    int status = EXIT_SUCCESS;
+
+    // Variables locales de la función actual (slots de su frame)
+    LocalScopes scopes;
+    memset(&scopes, 0, sizeof(scopes));
+    scopes.base_depth = -1;
+    int local_status;
+
+    // if/else, while y for abiertos
+    ControlStack control;
+    control.count = 0;
+
+    int line_number = 0;
     while (fgets(line, sizeof(line), src)) {
+        line_number++;
         // Trimear espacios iniciales
         char *trimmed = line;
         while (*trimmed && (*trimmed == ' ' || *trimmed == '\t')) trimmed++;
+
+        int line_depth = depth;
+        depth += brace_delta(trimmed);
+
+        if (class_index < 0 && strstr(trimmed, "class ") && strchr(trimmed, '{')) {
+            class_index = find_class_index(class_pool, trimmed);
+            class_depth = line_depth;
+        } else if (class_index >= 0 && method_depth < 0 && line_depth == class_depth + 1 &&
+                   (strstr(trimmed, "public") || strstr(trimmed, "private")) &&
+                   strchr(trimmed, '(') && strchr(trimmed, '{')) {
+            ClassDefinition *cls = &class_pool->classes[class_index];
+            int method_index = find_method_index(cls, trimmed);
+            if (method_index >= 0) {
+                char name[512];
+                snprintf(name, sizeof(name), "%s.%s", cls->name, cls->methods[method_index].name);
+                if (ir_begin_function(ir, name, class_index, method_index) < 0) {
+                    fclose(src);
+                    return EXIT_FAILURE;
+                }
+                method_depth = line_depth;
+                scopes.base_depth = line_depth;
+                scopes_sync(&scopes, depth);
+                continue;
+            }
+        } else if (class_index < 0 && line_depth == 0 && strchr(trimmed, '(') && strchr(trimmed, '{')) {
+            // Cabecera de función de nivel superior (main)
+            scopes.base_depth = line_depth;
+        }
+
+        // '}' que cierra la estructura de control más interna. "} else" la
+        // mantiene abierta: la rama else se abre más abajo, en su propio ámbito.
+        const char *else_rest = NULL;
+        if (trimmed[0] == '}' && control.count > 0 &&
+            control.frames[control.count - 1].depth == line_depth - 1) {
+            ControlFrame *frame = &control.frames[control.count - 1];
+            const char *after = trimmed + 1;
+            while (*after == ' ' || *after == '\t') after++;
+            else_rest = match_keyword(after, "else");
+
+            int ok;
+            if (else_rest && frame->kind == 'i') {
+                ok = enter_else(ir, frame, source_file);
+            } else if (else_rest) {
+                fprintf(stderr, "Error: %s: 'else' sin 'if'\n", source_file);
+                ok = -1;
+                else_rest = NULL;
+            } else {
+                ok = close_control(ir, string_pool, var_pool, class_pool, &scopes, source_file, frame);
+                control.count--;
+            }
+            if (ok != 0) status = EXIT_FAILURE;
+            scopes_sync(&scopes, line_depth - 1);
+        }
+
+        if (method_depth >= 0 && depth <= method_depth) {
+            method_depth = -1;
+            ir_set_function(ir, 0);
+        }
+        if (class_index >= 0 && depth <= class_depth) {
+            class_index = -1;
+        }
+        if (scopes.base_depth >= 0 && depth <= scopes.base_depth) {
+            scopes.base_depth = -1;
+        }
+        scopes_sync(&scopes, depth);
         
         // Omitir comentarios, líneas vacías e imports
         if (trimmed[0] == '/' || trimmed[0] == '\n' || strstr(trimmed, "import") || strstr(trimmed, "class ")) continue;
 
         // Emitir ARRAY_NEW para arrays dinámicos justo al inicio de main()
-        if (!emitted_dynamic_arrays && var_pool != NULL && (strstr(trimmed, "int main(") || strstr(trimmed, "return"))) {
+        if (!emitted_dynamic_arrays && var_pool != NULL && ir->current == 0 && (strstr(trimmed, "int main(") || strstr(trimmed, "return"))) {
             emitted_dynamic_arrays = 1;
             
             // Emitir ARRAY_NEW para cada variable dinámica
             for (int i = 0; i < var_pool->count; i++) {
-                if (var_pool->vars[i].type == 'b') {  // 'b' = dynamic array
-                    Instruction instr = {0, 0, 0};
+                // dynamic_array_size < 0: array enlazado desde una librería que ya emite su ARRAY_NEW
+                if (var_pool->vars[i].type == 'b' && var_pool->vars[i].dynamic_array_size >= 0) {
+                    IRInstr instr = {0, 0, 0};
                     
                     // Emitir PUSH_VALUE con el tamaño almacenado
                     instr.opcode = 0x06;  // OPCODE_PUSH_VALUE
@@ -580,23 +2032,128 @@ static int compile_file_internal(const char *source_file, const char *project_di
                     }
                     instr.arg1 = size_pool_idx;
                     instr.arg2 = 0;
-                    (*instruction_count)++;
-                    fwrite(&instr, sizeof(Instruction), 1, out);
+                    ir_emit(ir, instr);
                     
                     // ARRAY_NEW
                     instr.opcode = 0x0E;  // OPCODE_ARRAY_NEW
                     instr.arg1 = i;  // Índice en var_pool
                     instr.arg2 = var_pool->vars[i].array_element_type;  // Tipo de elemento
-                    (*instruction_count)++;
-                    fwrite(&instr, sizeof(Instruction), 1, out);
+                    ir_emit(ir, instr);
                 }
             }
         }
 
-        Instruction instr = {0, 0, 0};
+        // Cabeceras de if / else / while / for / parallel for y saltos break / continue
+        const char *header;
+        if (else_rest) {
+            ControlFrame *frame = &control.frames[control.count - 1];
+            if ((header = match_keyword(else_rest, "if"))) {
+                if (open_if(ir, string_pool, var_pool, class_pool, &scopes, source_file, frame, header) != 0) {
+                    status = EXIT_FAILURE;
+                }
+            } else if (*else_rest == '{') {
+                frame->kind = 'e';
+            } else {
+                fprintf(stderr, "Error: %s: se esperaba '} else {' o '} else if (...) {'\n", source_file);
+                status = EXIT_FAILURE;
+            }
+            continue;
+        }
+        char control_kind = 0;
+        if ((header = match_keyword(trimmed, "if"))) control_kind = 'i';
+        else if ((header = match_keyword(trimmed, "while"))) control_kind = 'w';
+        else if ((header = match_keyword(trimmed, "for"))) control_kind = 'f';
+        else if ((header = match_keyword(trimmed, "parallel")) && (header = match_keyword(header, "for"))) {
+            control_kind = 'p';
+        }
+        if (control_kind) {
+            if (control.count >= MAX_CONTROL_DEPTH) {
+                fprintf(stderr, "Error: %s: demasiadas estructuras de control anidadas\n", source_file);
+                status = EXIT_FAILURE;
+                continue;
+            }
+            ControlFrame *frame = &control.frames[control.count++];
+            memset(frame, 0, sizeof(*frame));
+            frame->kind = control_kind;
+            frame->depth = line_depth;
+            frame->exit.index = -1;
+            int ok = control_kind == 'i'
+                ? open_if(ir, string_pool, var_pool, class_pool, &scopes, source_file, frame, header)
+                : control_kind == 'p'
+                ? open_parallel_for(ir, string_pool, var_pool, class_pool, &scopes, &control, source_file, frame, header)
+                : open_loop(ir, string_pool, var_pool, class_pool, &scopes, source_file, frame, header);
+            if (ok != 0) status = EXIT_FAILURE;
+            continue;
+        }
+        if ((header = match_keyword(trimmed, "break")) || (header = match_keyword(trimmed, "continue"))) {
+            if (compile_loop_exit(ir, &control, source_file, trimmed[0] == 'b') != 0) status = EXIT_FAILURE;
+            continue;
+        }
+
+        IRInstr instr = {0, 0, 0};
         
+        // nombre(); dentro de un método es this.nombre(): método de la clase que lo contiene
+        if (parse_bare_call(trimmed, field_name, sizeof(field_name))) {
+            if (method_depth < 0) {
+                fprintf(stderr, "Error: %s:%d: '%s()' fuera de un método: la llamada necesita un objeto (obj.%s())\n",
+                        source_file, line_number, field_name, field_name);
+                status = EXIT_FAILURE;
+                continue;
+            }
+            int slot = resolve_method(class_pool, source_file, class_index, field_name, class_index);
+            if (slot < 0) {
+                status = EXIT_FAILURE;
+                continue;
+            }
+
+            instr.opcode = 0x03;  // OPCODE_CALL_METHOD
+            instr.arg1 = class_index;
+            instr.arg2 = slot;
+            ir_emit(ir, instr);
+        }
+        // Llamada a método: obj.metodo(); se despacha por (clase, slot) resuelto aquí
+        else if ((field_end = parse_field_access(trimmed, obj_name, field_name, sizeof(obj_name))) &&
+            *field_end == '(' && is_object_variable(var_pool, obj_name)) {
+            int obj_class = (int)var_pool->vars[var_pool_find(var_pool, obj_name, -1)].value;
+            int slot = resolve_method(class_pool, source_file, obj_class, field_name, class_index);
+            if (slot < 0) {
+                status = EXIT_FAILURE;
+                continue;
+            }
+            
+            instr.opcode = 0x03;  // OPCODE_CALL_METHOD
+            instr.arg1 = obj_class;
+            instr.arg2 = slot;
+            ir_emit(ir, instr);
+        }
+        // Métodos de arrays salvo clear() (ver compile_array_method)
+        else if ((field_end = parse_field_access(trimmed, obj_name, field_name, sizeof(obj_name))) &&
+                 *field_end == '(' && find_array_global(var_pool, obj_name) >= 0 &&
+                 strcmp(field_name, "clear") != 0) {
+            if (compile_array_method(ir, string_pool, var_pool, class_pool, &scopes, source_file,
+                                     obj_name, field_name, field_end + 1) != 0) {
+                status = EXIT_FAILURE;
+                continue;
+            }
+        }
+        // Vistas de arrays (ver compile_view_statement)
+        else if ((local_status = compile_view_statement(ir, string_pool, var_pool, class_pool, &scopes,
+                                                        source_file, trimmed)) != 0) {
+            if (local_status < 0) {
+                status = EXIT_FAILURE;
+                continue;
+            }
+        }
+        // Locales: declaración (siguiente slot del frame), asignación, op= y ++/--
+        else if ((local_status = compile_local_statement(ir, string_pool, var_pool, class_pool, &scopes,
+                                                         source_file, trimmed)) != 0) {
+            if (local_status < 0) {
+                status = EXIT_FAILURE;
+                continue;
+            }
+        }
         // Detectar arr.len (acceso a propiedad length del array) - pero NO dentro de println
-        if (strchr(trimmed, '.') && strstr(trimmed, ".len") && !strstr(trimmed, "=") && !strstr(trimmed, "println")) {
+        else if (strchr(trimmed, '.') && strstr(trimmed, ".len") && !strstr(trimmed, "=") && !strstr(trimmed, "println")) {
             char arr_name[256] = {0};
             char *dot = strchr(trimmed, '.');
             if (dot && dot > trimmed) {
@@ -606,22 +2163,19 @@ static int compile_file_internal(const char *source_file, const char *project_di
                     arr_name[arr_len] = '\0';
                     
                     // Buscar el array en var_pool
-                    int arr_idx = -1;
-                    for (int i = 0; i < var_pool->count; i++) {
-                        if (strcmp(var_pool->vars[i].name, arr_name) == 0 && 
-                            (var_pool->vars[i].type == 'a' || var_pool->vars[i].type == 'b')) {
-                            arr_idx = i;
-                            break;
-                        }
-                    }
+                    int arr_idx = find_array_global(var_pool, arr_name);
                     
                     if (arr_idx >= 0) {
                         // Emitir ARRAY_LEN
                         instr.opcode = 0x0F;  // OPCODE_ARRAY_LEN
                         instr.arg1 = arr_idx;  // Índice del array en var_pool
                         instr.arg2 = 0;
-                        (*instruction_count)++;
-                        fwrite(&instr, sizeof(Instruction), 1, out);
+                        ir_emit(ir, instr);
+                        
+                        // El valor no se usa: descartarlo para no desbalancear el stack
+                        instr.opcode = 0x07;  // OPCODE_POP_VALUE
+                        instr.arg1 = 0;
+                        ir_emit(ir, instr);
                     }
                 }
             }
@@ -637,115 +2191,160 @@ static int compile_file_internal(const char *source_file, const char *project_di
                     arr_name[arr_len] = '\0';
                     
                     // Buscar el array en var_pool
-                    int arr_idx = -1;
-                    for (int i = 0; i < var_pool->count; i++) {
-                        if (strcmp(var_pool->vars[i].name, arr_name) == 0 && 
-                            (var_pool->vars[i].type == 'a' || var_pool->vars[i].type == 'b')) {
-                            arr_idx = i;
-                            break;
-                        }
-                    }
+                    int arr_idx = find_array_global(var_pool, arr_name);
                     
                     if (arr_idx >= 0) {
                         // Emitir ARRAY_CLEAR
                         instr.opcode = 0x10;  // OPCODE_ARRAY_CLEAR
                         instr.arg1 = arr_idx;  // Índice del array en var_pool
                         instr.arg2 = 0;
-                        (*instruction_count)++;
-                        fwrite(&instr, sizeof(Instruction), 1, out);
+                        ir_emit(ir, instr);
                     }
                 }
             }
         }
         // Detectar acceso a campos: obj.field = valor
-        else if (strchr(trimmed, '.') && strstr(trimmed, "=")) {
-            // Parsear: objName.fieldName = valor;
-            char obj_name[256] = {0};
-            char field_name[256] = {0};
-            char value_str[256] = {0};
-            char *dot = strchr(trimmed, '.');
-            if (dot) {
-                // Extraer nombre del objeto (antes del punto)
-                int obj_len = dot - trimmed;
-                if (obj_len > 0 && obj_len < 256) {
-                    strncpy(obj_name, trimmed, obj_len);
-                    obj_name[obj_len] = '\0';
-                    
-                    // Extraer nombre del campo (después del punto)
-                    dot++;
-                    char *space_or_eq = strchr(dot, ' ');
-                    if (!space_or_eq) space_or_eq = strchr(dot, '=');
-                    if (space_or_eq) {
-                        int field_len = space_or_eq - dot;
-                        if (field_len > 0 && field_len < 256) {
-                            strncpy(field_name, dot, field_len);
-                            field_name[field_len] = '\0';
-                            
-                            // Extraer el valor después del =
-                            char *eq = strchr(trimmed, '=');
-                            if (eq) {
-                                eq++;  // Skip '='
-                                // Skip whitespace
-                                while (*eq && (*eq == ' ' || *eq == '\t')) eq++;
-                                
-                                // Extraer valor hasta ; o fin de línea
-                                char *val_end = eq;
-                                while (*val_end && *val_end != ';' && *val_end != '\n') val_end++;
-                                
-                                // Trim trailing whitespace from value
-                                val_end--;
-                                while (val_end > eq && (*val_end == ' ' || *val_end == '\t')) val_end--;
-                                val_end++;
-                                
-                                int val_len = val_end - eq;
-                                if (val_len > 0 && val_len < 256) {
-                                    strncpy(value_str, eq, val_len);
-                                    value_str[val_len] = '\0';
-                                    
-                                    // Si es una cadena entre comillas, remover las comillas
-                                    char processed_value[256] = {0};
-                                    int proc_len = val_len;
-                                    
-                                    if ((value_str[0] == '"' && value_str[val_len-1] == '"') ||
-                                        (value_str[0] == '\'' && value_str[val_len-1] == '\'')) {
-                                        // Es un string literal, remover comillas
-                                        strncpy(processed_value, value_str + 1, val_len - 2);
-                                        processed_value[val_len - 2] = '\0';
-                                        proc_len = val_len - 2;
-                                    } else {
-                                        // No es string, usar como está
-                                        strcpy(processed_value, value_str);
-                                    }
+        else if ((field_end = parse_field_access(trimmed, obj_name, field_name, sizeof(obj_name))) &&
+                 is_field_assignment(field_end)) {
+            int obj_idx, slot;
+            if (resolve_field(var_pool, class_pool, source_file, obj_name, field_name, &obj_idx, &slot) != 0) {
+                status = EXIT_FAILURE;
+                continue;
+            }
+
+            // Extraer el valor después del =
+            const char *eq = strchr(field_end, '=') + 1;
+            while (*eq == ' ' || *eq == '\t') eq++;
+            
+            // Extraer valor hasta ; o fin de línea, sin espacios finales
+            const char *val_end = eq;
+            while (*val_end && *val_end != ';' && *val_end != '\n') val_end++;
+            while (val_end > eq && (val_end[-1] == ' ' || val_end[-1] == '\t')) val_end--;
+            
+            int val_len = val_end - eq;
+            if (val_len > 0 && eq[0] != '"' && eq[0] != '\'') {
+                // Valor numérico: local, global, campo o constante
+                ClassDefinition *cls = &class_pool->classes[(int)var_pool->vars[obj_idx].value];
+                char field_type = cls->var_types[slot] == 'd' ? 'd' : 'i';
+                if (!compile_value(ir, string_pool, var_pool, class_pool, &scopes, source_file,
+                                   eq, field_type)) {
+                    status = EXIT_FAILURE;
+                    continue;
+                }
+                
+                instr.opcode = 0x05;  // OPCODE_SET_FIELD
+                instr.arg1 = obj_idx;
+                instr.arg2 = slot;
+                ir_emit(ir, instr);
+            } else if (val_len > 0 && val_len < 256) {
+                // Si es una cadena entre comillas, remover las comillas
+                char processed_value[256] = {0};
+                if (val_len >= 2 && ((eq[0] == '"' && eq[val_len-1] == '"') ||
+                                     (eq[0] == '\'' && eq[val_len-1] == '\''))) {
+                    strncpy(processed_value, eq + 1, val_len - 2);
+                } else {
+                    strncpy(processed_value, eq, val_len);
+                }
+                
+                // Generar PUSH_VALUE con el valor procesado
+                uint16_t string_idx = string_pool->count;
+                if (string_pool->count < 1024) {
+                    string_pool->strings = (char**)realloc(string_pool->strings, 
+                                                            (string_pool->count + 1) * sizeof(char*));
+                    string_pool->strings[string_pool->count] = malloc(strlen(processed_value) + 1);
+                    strcpy(string_pool->strings[string_pool->count], processed_value);
+                    string_pool->count++;
+                }
+                
+                instr.opcode = 0x06;  // OPCODE_PUSH_VALUE
+                instr.arg1 = string_idx;
+                instr.arg2 = 0;
+                ir_emit(ir, instr);
+                
+                // PUSH_VALUE apila un double: los campos no double guardan int64
+                ClassDefinition *cls = &class_pool->classes[(int)var_pool->vars[obj_idx].value];
+                if (cls->var_types[slot] != 'd') {
+                    instr.opcode = OPCODE_F2I;
+                    instr.arg1 = 0;
+                    ir_emit(ir, instr);
+                }
+                
+                // SET_FIELD directo: objeto y slot resueltos en compilación
+                instr.opcode = 0x05;  // OPCODE_SET_FIELD
+                instr.arg1 = obj_idx;
+                instr.arg2 = slot;
+                ir_emit(ir, instr);
+            }
+        } else if (strstr(trimmed, "[] ") && strstr(trimmed, "new ") && strstr(trimmed, "[")) {
+            // Parsear asignación de array dinámico: int[] arr = new int[size]; antes que
+            // arr[index] = value, que también casaría con la línea
+            char var_name[256] = {0};
+            char elem_type[256] = {0};
+            char size_str[256] = {0};
+            
+            // Extraer tipo: int, double, etc
+            char element_type = parse_element_type(trimmed, strstr(trimmed, "[]"));
+            if (!element_type) element_type = 'd';
+            
+            // Extraer nombre: entre "[] " y " ="
+            char *bracket_end = strstr(trimmed, "[]");
+            if (bracket_end) {
+                bracket_end += 2;  // Skip "[]"
+                while (*bracket_end && (*bracket_end == ' ' || *bracket_end == '\t')) bracket_end++;
+                
+                char *eq = strchr(bracket_end, '=');
+                if (eq && eq > bracket_end) {
+                    int name_len = eq - bracket_end;
+                    while (name_len > 0 && (bracket_end[name_len-1] == ' ' || bracket_end[name_len-1] == '\t')) {
+                        name_len--;
+                    }
+                    if (name_len > 0 && name_len < sizeof(var_name)) {
+                        strncpy(var_name, bracket_end, name_len);
+                        var_name[name_len] = '\0';
+                        
+                        // Extraer tamaño: entre [ y ]
+                        char *size_bracket_open = strchr(eq, '[');
+                        if (size_bracket_open) {
+                            char *size_bracket_close = strchr(size_bracket_open, ']');
+                            if (size_bracket_close && size_bracket_close > size_bracket_open) {
+                                char *size_start = size_bracket_open + 1;
+                                int size_len = size_bracket_close - size_start;
+                                if (size_len > 0 && size_len < sizeof(size_str)) {
+                                    strncpy(size_str, size_start, size_len);
+                                    size_str[size_len] = '\0';
                                     
-                                    // Generar PUSH_VALUE con el valor procesado
-                                    uint16_t string_idx = string_pool->count;
-                                    if (string_pool->count < 1024) {
-                                        string_pool->strings = (char**)realloc(string_pool->strings, 
-                                                                                (string_pool->count + 1) * sizeof(char*));
-                                        string_pool->strings[string_pool->count] = malloc(proc_len + 1);
-                                        strcpy(string_pool->strings[string_pool->count], processed_value);
-                                        string_pool->count++;
+                                    // Agregar la variable dinámica al pool ('b'); el tamaño se fija en runtime
+                                    int var_idx = add_variable_to_pool(var_pool, var_name, 'b', 0, NULL);
+                                    if (var_idx >= 0) {
+                                        var_pool->vars[var_idx].array_element_type = element_type;
+                                        
+                                        // Emitir PUSH_VALUE con el tamaño
+                                        instr.opcode = 0x06;  // OPCODE_PUSH_VALUE
+                                        uint16_t size_pool_idx = string_pool->count;
+                                        if (string_pool->count < 1024) {
+                                            string_pool->strings = (char**)realloc(string_pool->strings, 
+                                                                                    (string_pool->count + 1) * sizeof(char*));
+                                            string_pool->strings[string_pool->count] = malloc(strlen(size_str) + 1);
+                                            strcpy(string_pool->strings[string_pool->count], size_str);
+                                            string_pool->count++;
+                                        }
+                                        instr.arg1 = size_pool_idx;
+                                        instr.arg2 = 0;
+                                        ir_emit(ir, instr);
+                                        
+                                        // Emitir ARRAY_NEW con el índice de la variable
+                                        instr.opcode = 0x0E;  // OPCODE_ARRAY_NEW
+                                        instr.arg1 = var_idx;  // Índice en var_pool
+                                        instr.arg2 = element_type;  // Tipo de elemento
+                                        ir_emit(ir, instr);
                                     }
-                                    
-                                    instr.opcode = 0x06;  // OPCODE_PUSH_VALUE
-                                    instr.arg1 = string_idx;
-                                    instr.arg2 = 0;
-                                    (*instruction_count)++;
-                                    fwrite(&instr, sizeof(Instruction), 1, out);
-                                    
-                                    // Generar instrucción SET_FIELD
-                                    instr.opcode = 0x05;  // OPCODE_SET_FIELD
-                                    instr.arg1 = 0;  // field index (simplificado)
-                                    instr.arg2 = 0;  // object index (simplificado)
-                                    (*instruction_count)++;
-                                    fwrite(&instr, sizeof(Instruction), 1, out);
                                 }
                             }
                         }
                     }
                 }
             }
-        } else if (strchr(trimmed, '[') && strchr(trimmed, ']') && strstr(trimmed, "=")) {
+        } else if (strchr(trimmed, '[') && strchr(trimmed, ']') && strstr(trimmed, "=") && !strstr(trimmed, "println")) {
             // Parsear asignación a array: arr[index] = value;
             char arr_name[256] = {0};
             char index_str[256] = {0};
@@ -759,7 +2358,7 @@ static int compile_file_internal(const char *source_file, const char *project_di
                     arr_name[arr_name_len] = '\0';
                     
                     // Extraer índice entre [ y ]
-                    char *bracket_close = strchr(bracket_open, ']');
+                    char *bracket_close = index_chain_end(bracket_open);
                     if (bracket_close && bracket_close > bracket_open) {
                         char *index_start = bracket_open + 1;
                         int index_len = bracket_close - index_start;
@@ -785,55 +2384,24 @@ static int compile_file_internal(const char *source_file, const char *project_di
                                     value_str[val_len] = '\0';
                                     
                                     // Buscar el array en el pool
-                                    int arr_idx = -1;
-                                    for (int i = 0; i < var_pool->count; i++) {
-                                        if (strcmp(var_pool->vars[i].name, arr_name) == 0 && 
-                                            (var_pool->vars[i].type == 'a' || var_pool->vars[i].type == 'b')) {
-                                            arr_idx = i;
-                                            break;
-                                        }
-                                    }
+                                    int arr_idx = find_array_global(var_pool, arr_name);
                                     
                                     if (arr_idx >= 0) {
-                                        // Emitir PUSH_VALUE con el índice
-                                        instr.opcode = 0x06;  // OPCODE_PUSH_VALUE
-                                        // Convertir index_str a índice
-                                        int idx_val = atoi(index_str);
-                                        // Almacenar en string pool para reutilizar PUSH_VALUE
-                                        uint16_t idx_pool = string_pool->count;
-                                        if (string_pool->count < 1024) {
-                                            string_pool->strings = (char**)realloc(string_pool->strings, 
-                                                                                    (string_pool->count + 1) * sizeof(char*));
-                                            string_pool->strings[string_pool->count] = malloc(strlen(index_str) + 1);
-                                            strcpy(string_pool->strings[string_pool->count], index_str);
-                                            string_pool->count++;
-                                        }
-                                        instr.arg1 = idx_pool;
-                                        instr.arg2 = 0;
-                                        (*instruction_count)++;
-                                        fwrite(&instr, sizeof(Instruction), 1, out);
-                                        
-                                        // Emitir PUSH_VALUE con el valor
-                                        instr.opcode = 0x06;  // OPCODE_PUSH_VALUE
-                                        uint16_t val_pool = string_pool->count;
-                                        if (string_pool->count < 1024) {
-                                            string_pool->strings = (char**)realloc(string_pool->strings, 
-                                                                                    (string_pool->count + 1) * sizeof(char*));
-                                            string_pool->strings[string_pool->count] = malloc(strlen(value_str) + 1);
-                                            strcpy(string_pool->strings[string_pool->count], value_str);
-                                            string_pool->count++;
+                                        // Índice (int64 si es entero) y valor del elemento
+                                        int opcode = compile_array_index(ir, string_pool, var_pool, class_pool,
+                                                                         &scopes, source_file, arr_idx, index_str, 1);
+                                        if (opcode < 0 ||
+                                            !compile_value(ir, string_pool, var_pool, class_pool, &scopes, source_file,
+                                                           value_str, array_value_type(var_pool, arr_idx))) {
+                                            status = EXIT_FAILURE;
+                                            continue;
                                         }
-                                        instr.arg1 = val_pool;
-                                        instr.arg2 = 0;
-                                        (*instruction_count)++;
-                                        fwrite(&instr, sizeof(Instruction), 1, out);
                                         
                                         // Emitir ARRAY_SET
-                                        instr.opcode = 0x0C;  // OPCODE_ARRAY_SET
+                                        instr.opcode = opcode;
                                         instr.arg1 = arr_idx;  // Índice del array en var_pool
                                         instr.arg2 = 0;
-                                        (*instruction_count)++;
-                                        fwrite(&instr, sizeof(Instruction), 1, out);
+                                        ir_emit(ir, instr);
                                     }
                                 }
                             }
@@ -854,7 +2422,7 @@ static int compile_file_internal(const char *source_file, const char *project_di
                     strncpy(arr_name, trimmed, arr_name_len);
                     arr_name[arr_name_len] = '\0';
                     
-                    char *bracket_close = strchr(bracket_open, ']');
+                    char *bracket_close = index_chain_end(bracket_open);
                     if (bracket_close && bracket_close > bracket_open) {
                         char *index_start = bracket_open + 1;
                         int index_len = bracket_close - index_start;
@@ -862,42 +2430,35 @@ static int compile_file_internal(const char *source_file, const char *project_di
                             strncpy(index_str, index_start, index_len);
                             index_str[index_len] = '\0';
                             
-                            int arr_idx = -1;
-                            for (int i = 0; i < var_pool->count; i++) {
-                                if (strcmp(var_pool->vars[i].name, arr_name) == 0 && 
-                                    (var_pool->vars[i].type == 'a' || var_pool->vars[i].type == 'b')) {
-                                    arr_idx = i;
-                                    break;
-                                }
-                            }
+                            int arr_idx = find_array_global(var_pool, arr_name);
                             
                             if (arr_idx >= 0) {
-                                // Emitir PUSH_VALUE con índice
-                                instr.opcode = 0x06;  // OPCODE_PUSH_VALUE
-                                uint16_t idx_pool = string_pool->count;
-                                if (string_pool->count < 1024) {
-                                    string_pool->strings = (char**)realloc(string_pool->strings, 
-                                                                            (string_pool->count + 1) * sizeof(char*));
-                                    string_pool->strings[string_pool->count] = malloc(strlen(index_str) + 1);
-                                    strcpy(string_pool->strings[string_pool->count], index_str);
-                                    string_pool->count++;
+                                int opcode = compile_array_index(ir, string_pool, var_pool, class_pool,
+                                                                 &scopes, source_file, arr_idx, index_str, 0);
+                                if (opcode < 0) {
+                                    status = EXIT_FAILURE;
+                                    continue;
                                 }
-                                instr.arg1 = idx_pool;
-                                instr.arg2 = 0;
-                                (*instruction_count)++;
-                                fwrite(&instr, sizeof(Instruction), 1, out);
                                 
                                 // Emitir ARRAY_GET
-                                instr.opcode = 0x0D;  // OPCODE_ARRAY_GET
+                                instr.opcode = opcode;
                                 instr.arg1 = arr_idx;
                                 instr.arg2 = 0;
-                                (*instruction_count)++;
-                                fwrite(&instr, sizeof(Instruction), 1, out);
+                                ir_emit(ir, instr);
+                                
+                                // Lectura como sentencia: descartar el valor leído
+                                instr.opcode = 0x07;  // OPCODE_POP_VALUE
+                                instr.arg1 = 0;
+                                ir_emit(ir, instr);
                             }
                         }
                     }
                 }
             }
+        } else if (strncmp(trimmed, "flush()", 7) == 0) {
+            // Vuelca ya el buffer de salida de la VM
+            instr.opcode = OPCODE_FLUSH;
+            ir_emit(ir, instr);
         } else if (strstr(trimmed, "printchr(")) {
             // Optimizado: printchr(char) - imprime un carácter directamente sin pasar por string pool
             instr.opcode = 0x09;
@@ -910,8 +2471,7 @@ static int compile_file_internal(const char *source_file, const char *project_di
                     quote1++;
                     char c = *quote1;
                     instr.arg1 = (uint8_t)c;  // Almacenar el ASCII directamente en arg1
-                    (*instruction_count)++;
-                    fwrite(&instr, sizeof(Instruction), 1, out);
+                    ir_emit(ir, instr);
                 }
             }
         } else if (strstr(trimmed, "println")) {
@@ -919,7 +2479,7 @@ static int compile_file_internal(const char *source_file, const char *project_di
             char *start = strstr(trimmed, "println(");
             if (start) {
                 start += 8;
-                char *end = strchr(start, ')');
+                char *end = strrchr(start, ')');
                 if (end) {
                     int arg_len = end - start;
                     char arg[256] = {0};
@@ -930,254 +2490,101 @@ static int compile_file_internal(const char *source_file, const char *project_di
                     char *trimmed_arg = arg;
                     while (*trimmed_arg && (*trimmed_arg == ' ' || *trimmed_arg == '\t')) trimmed_arg++;
                     
-                    // Detectar si es acceso a array: arr[index]
-                    if (strchr(trimmed_arg, '[') && strchr(trimmed_arg, ']')) {
-                        // Parsear acceso a array
-                        char arr_name[256] = {0};
-                        char index_str[256] = {0};
-                        
-                        char *bracket_open = strchr(trimmed_arg, '[');
-                        if (bracket_open && bracket_open > trimmed_arg) {
-                            int arr_name_len = bracket_open - trimmed_arg;
-                            if (arr_name_len > 0 && arr_name_len < sizeof(arr_name)) {
-                                strncpy(arr_name, trimmed_arg, arr_name_len);
-                                arr_name[arr_name_len] = '\0';
-                                
-                                char *bracket_close = strchr(bracket_open, ']');
-                                if (bracket_close && bracket_close > bracket_open) {
-                                    char *index_start = bracket_open + 1;
-                                    int index_len = bracket_close - index_start;
-                                    if (index_len > 0 && index_len < sizeof(index_str)) {
-                                        strncpy(index_str, index_start, index_len);
-                                        index_str[index_len] = '\0';
-                                        
-                                        int arr_idx = -1;
-                                        for (int i = 0; i < var_pool->count; i++) {
-                                            if (strcmp(var_pool->vars[i].name, arr_name) == 0 && 
-                                                (var_pool->vars[i].type == 'a' || var_pool->vars[i].type == 'b')) {
-                                                arr_idx = i;
-                                                break;
-                                            }
-                                        }
-                                        
-                                        if (arr_idx >= 0) {
-                                            // Emitir PUSH_VALUE con índice
-                                            instr.opcode = 0x06;  // OPCODE_PUSH_VALUE
-                                            uint16_t idx_pool = string_pool->count;
-                                            if (string_pool->count < 1024) {
-                                                string_pool->strings = (char**)realloc(string_pool->strings, 
-                                                                                        (string_pool->count + 1) * sizeof(char*));
-                                                string_pool->strings[string_pool->count] = malloc(strlen(index_str) + 1);
-                                                strcpy(string_pool->strings[string_pool->count], index_str);
-                                                string_pool->count++;
-                                            }
-                                            instr.arg1 = idx_pool;
-                                            instr.arg2 = 0;
-                                            (*instruction_count)++;
-                                            fwrite(&instr, sizeof(Instruction), 1, out);
-                                            
-                                            // Emitir ARRAY_GET
-                                            instr.opcode = 0x0D;  // OPCODE_ARRAY_GET
-                                            instr.arg1 = arr_idx;
-                                            instr.arg2 = 0;
-                                            (*instruction_count)++;
-                                            fwrite(&instr, sizeof(Instruction), 1, out);
-                                            
-                                            // Emitir PRINTLN (que imprimirá el valor del top del stack)
-                                            instr.opcode = 0x08;  // PRINTLN
-                                            instr.arg1 = 0;
-                                            (*instruction_count)++;
-                                            fwrite(&instr, sizeof(Instruction), 1, out);
-                                            
-                                            // Ya procesamos este array, saltar al final
-                                            goto println_done;
-                                        }
-                                    }
-                                }
-                            }
-                        }
-                    } else if (strchr(trimmed_arg, '.') && strstr(trimmed_arg, ".len")) {
-                        // Detectar si es arr.len (acceso a propiedad length)
-                        char arr_name[256] = {0};
-                        char *dot = strchr(trimmed_arg, '.');
-                        if (dot && dot > trimmed_arg) {
-                            int arr_len = dot - trimmed_arg;
-                            if (arr_len > 0 && arr_len < sizeof(arr_name)) {
-                                strncpy(arr_name, trimmed_arg, arr_len);
-                                arr_name[arr_len] = '\0';
-                                
-                                // Buscar el array en var_pool
-                                int arr_idx = -1;
-                                for (int i = 0; i < var_pool->count; i++) {
-                                    if (strcmp(var_pool->vars[i].name, arr_name) == 0 && 
-                                        (var_pool->vars[i].type == 'a' || var_pool->vars[i].type == 'b')) {
-                                        arr_idx = i;
-                                        break;
-                                    }
-                                }
-                                
-                                if (arr_idx >= 0) {
-                                    // Emitir ARRAY_LEN
-                                    instr.opcode = 0x0F;  // OPCODE_ARRAY_LEN
-                                    instr.arg1 = arr_idx;
-                                    instr.arg2 = 0;
-                                    (*instruction_count)++;
-                                    fwrite(&instr, sizeof(Instruction), 1, out);
-                                    
-                                    // Emitir PRINTLN
-                                    instr.opcode = 0x08;  // PRINTLN
-                                    instr.arg1 = 0;
-                                    (*instruction_count)++;
-                                    fwrite(&instr, sizeof(Instruction), 1, out);
-                                    
-                                    goto println_done;
-                                }
-                            }
+                    // Global string: GET_GLOBAL y PRINTLN del stack
+                    int name_len = strlen(trimmed_arg);
+                    while (name_len > 0 && (trimmed_arg[name_len - 1] == ' ' || trimmed_arg[name_len - 1] == '\t')) {
+                        name_len--;
+                    }
+                    // Un literal numérico (5, 1e5) no es un nombre: va por compile_value
+                    int is_name = name_len > 0 && !(trimmed_arg[0] >= '0' && trimmed_arg[0] <= '9');
+                    for (int i = 0; i < name_len; i++) {
+                        if (!is_ident_char(trimmed_arg[i])) is_name = 0;
+                    }
+                    int var_idx = var_pool ? var_pool_find(var_pool, trimmed_arg, name_len) : -1;
+                    
+                    // Literal con huecos {expresión}: FORMAT_PRINT
+                    if (trimmed_arg[0] == '"') {
+                        int interpolated = compile_interpolation(ir, string_pool, var_pool, class_pool, &scopes,
+                                                                 source_file, printf_index + local_printf_count, 1);
+                        if (interpolated != 0) {
+                            local_printf_count++;
+                            if (interpolated < 0) status = EXIT_FAILURE;
+                            goto println_done;
                         }
                     }
                     
-                    // Si es variable (no empieza con comilla)
-                    if (var_pool && trimmed_arg[0] != '"' && trimmed_arg[0] != '\'') {
-                        // Buscar en variables globales
-                        int var_idx = -1;
-                        for (int i = 0; i < var_pool->count; i++) {
-                            if (strncmp(var_pool->vars[i].name, trimmed_arg, strlen(trimmed_arg)) == 0) {
-                                var_idx = i;
-                                break;
-                            }
+                    // Local, global numérica (constante plegada), campo, arr[i], arr.len o
+                    // expresión: PRINTLN_I64 / PRINTLN según el tipo
+                    int numeric_global = var_idx >= 0 && (var_pool->vars[var_idx].type == 'i' ||
+                                                          var_pool->vars[var_idx].type == 'd');
+                    if (trimmed_arg[0] != '"' && trimmed_arg[0] != '\'' &&
+                        (find_local(&scopes, trimmed_arg, name_len) >= 0 || numeric_global ||
+                         (parse_field_access(trimmed_arg, obj_name, field_name, sizeof(obj_name)) &&
+                          is_object_variable(var_pool, obj_name)) ||
+                         (!is_name && !strchr(trimmed_arg, '"')))) {
+                        char type = compile_value(ir, string_pool, var_pool, class_pool, &scopes,
+                                                  source_file, trimmed_arg, 0);
+                        if (!type) {
+                            status = EXIT_FAILURE;
+                            goto println_done;
                         }
                         
+                        instr.opcode = type == 'i' ? OPCODE_PRINTLN_I64 : 0x08;
+                        instr.arg1 = 0;
+                        instr.arg2 = 0;
+                        ir_emit(ir, instr);
+                        goto println_done;
+                    }
+                    
+                    // Si es variable (no empieza con comilla)
+                    if (trimmed_arg[0] != '"' && trimmed_arg[0] != '\'') {
                         if (var_idx >= 0 && var_pool->vars[var_idx].type == 's') {
                             // Emitir GET_GLOBAL seguido de PRINTLN
                             instr.opcode = 0x0A;  // GET_GLOBAL
                             instr.arg1 = var_idx;
-                            (*instruction_count)++;
-                            fwrite(&instr, sizeof(Instruction), 1, out);
+                            ir_emit(ir, instr);
                             
                             instr.opcode = 0x08;  // PRINTLN
                             instr.arg1 = 0;  // Dummy, se ignora
-                            (*instruction_count)++;
-                            fwrite(&instr, sizeof(Instruction), 1, out);
+                            ir_emit(ir, instr);
                         } else {
-                            // Variable no encontrada o no es string, emitir normal
-                            instr.opcode = 0x08;
-                            instr.arg1 = printf_index + local_printf_count;
-                            local_printf_count++;
-                            (*instruction_count)++;
-                            fwrite(&instr, sizeof(Instruction), 1, out);
+                            // Sin comillas no hay slot reservado en el pool: el nombre tiene que existir
+                            fprintf(stderr, var_idx < 0 ? "Error: %s:%d: '%.*s' no está declarada\n"
+                                                        : "Error: %s:%d: '%.*s' no es un número ni una cadena\n",
+                                    source_file, line_number, name_len, trimmed_arg);
+                            status = EXIT_FAILURE;
                         }
                     } else {
                         // Es un string literal
                         instr.opcode = 0x08;
                         instr.arg1 = printf_index + local_printf_count;
                         local_printf_count++;
-                        (*instruction_count)++;
-                        fwrite(&instr, sizeof(Instruction), 1, out);
+                        ir_emit(ir, instr);
                     }
                     println_done:
                 } else {
                     instr.opcode = 0x08;
                     instr.arg1 = printf_index + local_printf_count;
                     local_printf_count++;
-                    (*instruction_count)++;
-                    fwrite(&instr, sizeof(Instruction), 1, out);
+                    ir_emit(ir, instr);
                 }
             } else {
                 instr.opcode = 0x08;
                 instr.arg1 = printf_index + local_printf_count;
                 local_printf_count++;
-                (*instruction_count)++;
-                fwrite(&instr, sizeof(Instruction), 1, out);
+                ir_emit(ir, instr);
             }
         } else if (strstr(trimmed, "print") || strstr(trimmed, "printf")) {
-            instr.opcode = 0x01;
-            instr.arg1 = printf_index + local_printf_count;
-            local_printf_count++;
-            (*instruction_count)++;
-            fwrite(&instr, sizeof(Instruction), 1, out);
-        } else if (strstr(trimmed, "[] ") && strstr(trimmed, "new ") && strstr(trimmed, "[")) {
-            // Parsear asignación de array dinámico: int[] arr = new int[size];
-            char var_name[256] = {0};
-            char elem_type[256] = {0};
-            char size_str[256] = {0};
-            
-            // Extraer tipo: int, double, etc
-            char element_type = 'i';
-            if (strstr(trimmed, "int[]")) element_type = 'i';
-            else if (strstr(trimmed, "double[]")) element_type = 'd';
-            else if (strstr(trimmed, "float[]")) element_type = 'd';
-            
-            // Extraer nombre: entre "[] " y " ="
-            char *bracket_end = strstr(trimmed, "[]");
-            if (bracket_end) {
-                bracket_end += 2;  // Skip "[]"
-                while (*bracket_end && (*bracket_end == ' ' || *bracket_end == '\t')) bracket_end++;
-                
-                char *eq = strchr(bracket_end, '=');
-                if (eq && eq > bracket_end) {
-                    int name_len = eq - bracket_end;
-                    while (name_len > 0 && (bracket_end[name_len-1] == ' ' || bracket_end[name_len-1] == '\t')) {
-                        name_len--;
-                    }
-                    if (name_len > 0 && name_len < sizeof(var_name)) {
-                        strncpy(var_name, bracket_end, name_len);
-                        var_name[name_len] = '\0';
-                        
-                        // Extraer tamaño: entre [ y ]
-                        char *size_bracket_open = strchr(eq, '[');
-                        if (size_bracket_open) {
-                            char *size_bracket_close = strchr(size_bracket_open, ']');
-                            if (size_bracket_close && size_bracket_close > size_bracket_open) {
-                                char *size_start = size_bracket_open + 1;
-                                int size_len = size_bracket_close - size_start;
-                                if (size_len > 0 && size_len < sizeof(size_str)) {
-                                    strncpy(size_str, size_start, size_len);
-                                    size_str[size_len] = '\0';
-                                    
-                                    // Agregar la variable dinámica al pool
-                                    GlobalVariable *temp = realloc(var_pool->vars, (var_pool->count + 1) * sizeof(GlobalVariable));
-                                    if (temp) {
-                                        var_pool->vars = temp;
-                                        var_pool->vars[var_pool->count].name = (char*)malloc(strlen(var_name) + 1);
-                                        if (var_pool->vars[var_pool->count].name) {
-                                            strcpy(var_pool->vars[var_pool->count].name, var_name);
-                                            var_pool->vars[var_pool->count].type = 'b';  // 'b' para array dinámico
-                                            var_pool->vars[var_pool->count].array_element_type = element_type;
-                                            var_pool->vars[var_pool->count].array_size = 0;  // Size será determinado en runtime
-                                            var_pool->vars[var_pool->count].value = 0;
-                                            var_pool->vars[var_pool->count].str_val = NULL;
-                                            int var_idx = var_pool->count;
-                                            var_pool->count++;
-                                            
-                                            // Emitir PUSH_VALUE con el tamaño
-                                            instr.opcode = 0x06;  // OPCODE_PUSH_VALUE
-                                            uint16_t size_pool_idx = string_pool->count;
-                                            if (string_pool->count < 1024) {
-                                                string_pool->strings = (char**)realloc(string_pool->strings, 
-                                                                                        (string_pool->count + 1) * sizeof(char*));
-                                                string_pool->strings[string_pool->count] = malloc(strlen(size_str) + 1);
-                                                strcpy(string_pool->strings[string_pool->count], size_str);
-                                                string_pool->count++;
-                                            }
-                                            instr.arg1 = size_pool_idx;
-                                            instr.arg2 = 0;
-                                            (*instruction_count)++;
-                                            fwrite(&instr, sizeof(Instruction), 1, out);
-                                            
-                                            // Emitir ARRAY_NEW con el índice de la variable
-                                            instr.opcode = 0x0E;  // OPCODE_ARRAY_NEW
-                                            instr.arg1 = var_idx;  // Índice en var_pool
-                                            instr.arg2 = element_type;  // Tipo de elemento
-                                            (*instruction_count)++;
-                                            fwrite(&instr, sizeof(Instruction), 1, out);
-                                        }
-                                    }
-                                }
-                            }
-                        }
-                    }
-                }
+            int interpolated = strchr(trimmed, '"') ?
+                compile_interpolation(ir, string_pool, var_pool, class_pool, &scopes, source_file,
+                                      printf_index + local_printf_count, 0) : 0;
+            if (interpolated < 0) status = EXIT_FAILURE;
+            if (interpolated == 0) {
+                instr.opcode = 0x01;
+                instr.arg1 = printf_index + local_printf_count;
+                ir_emit(ir, instr);
             }
+            local_printf_count++;
         } else if (strstr(trimmed, "new ")) {
             // Parsear: ClassName obj = new ClassName();
             char class_name[256] = {0};
@@ -1195,28 +2602,43 @@ static int compile_file_internal(const char *source_file, const char *project_di
                     strncpy(class_name, start, len);
                     class_name[len] = '\0';
                     
-                    // Generar instrucción NEW_INSTANCE
+                    int class_idx = class_pool ? get_class_index(class_pool, class_name) : -1;
+                    if (class_idx < 0) {
+                        fprintf(stderr, "Error: %s: clase '%s' no definida\n", source_file, class_name);
+                        status = EXIT_FAILURE;
+                        continue;
+                    }
+                    int obj_idx = declare_object_variable(var_pool, class_pool, source_file,
+                                                          trimmed, strstr(trimmed, "new "), class_idx);
+                    if (obj_idx < 0) {
+                        status = EXIT_FAILURE;
+                        continue;
+                    }
+                    
+                    // Generar instrucción NEW_INSTANCE: arg1 = clase, arg2 = variable destino
                     instr.opcode = 0x02;  // OPCODE_NEW_INSTANCE
-                    // arg1 será el índice de la clase (0 por ahora, se resolvería mejor)
-                    (*instruction_count)++;
-                    fwrite(&instr, sizeof(Instruction), 1, out);
+                    instr.arg1 = class_idx;
+                    instr.arg2 = obj_idx;
+                    ir_emit(ir, instr);
                 }
             }
         } else if (strstr(trimmed, "return")) {
             instr.opcode = 0xFF;
-            (*instruction_count)++;
-            fwrite(&instr, sizeof(Instruction), 1, out);
+            ir_emit(ir, instr);
         }
     }
 
     fclose(src);
+    ir_set_function(ir, 0);
+    scopes.base_depth = -1;
+    scopes_sync(&scopes, 0);
 
     for (int i = 0; i < temp_pool.count; i++) {
         free(temp_pool.strings[i]);
     }
     free(temp_pool.strings);
 
-    return EXIT_SUCCESS;
+    return status;
 }
 
 static int compile_file(const char *source_file, const char *project_dir, StringPool *string_pool) {
@@ -1254,54 +2676,46 @@ static int compile_file(const char *source_file, const char *project_dir, String
 
     // Primero recopilar todo
     StringPool temp_pool = {NULL, 0};
-    int instruction_count = 0;
-
-    FILE *temp = tmpfile();
-    if (!temp) {
-        fprintf(stderr, "Error: No se puede crear archivo temporal\n");
+    CodeBuffer code = {NULL, 0, 0};
+    IRProgram ir;
+    if (ir_init(&ir) != 0) {
+        fprintf(stderr, "Error: No hay memoria suficiente\n");
         free_project_config(config);
         return EXIT_FAILURE;
     }
 
-    // Compilar archivo con imports recursivos a archivo temporal
-    compile_file_internal(source_file, project_dir, temp, &temp_pool, NULL, &instruction_count);
-
-    // Ahora escribir correctamente al archivo final
-    FILE *out = fopen(output_file, "wb");
-    if (!out) {
-        fprintf(stderr, "Error: No se puede crear '%s'\n", output_file);
-        fclose(temp);
-        free_project_config(config);
-        return EXIT_FAILURE;
-    }
+    // Compilar archivo con imports recursivos a memoria
+    compile_file_internal(source_file, project_dir, &ir, &temp_pool, NULL, NULL);
+    ir_lower(&ir, &code, NULL);
+    ir_free(&ir);
 
     // Header
-    fprintf(out, "GOLD");
+    ByteBuffer image = {NULL, 0, 0};
+    byte_buffer_append(&image, "GOLD", 4);
     uint8_t version = 1;
-    fwrite(&version, 1, 1, out);
+    byte_buffer_append(&image, &version, 1);
 
     // Cantidad de strings
     uint16_t string_count = temp_pool.count;
-    fwrite(&string_count, sizeof(uint16_t), 1, out);
+    byte_buffer_append(&image, &string_count, sizeof(uint16_t));
 
     // Strings
     for (int i = 0; i < temp_pool.count; i++) {
         uint16_t str_len = strlen(temp_pool.strings[i]);
-        fwrite(&str_len, sizeof(uint16_t), 1, out);
-        fwrite(temp_pool.strings[i], 1, str_len, out);
+        byte_buffer_append(&image, &str_len, sizeof(uint16_t));
+        byte_buffer_append(&image, temp_pool.strings[i], str_len);
     }
 
-    // Instrucciones desde archivo temporal
-    rewind(temp);
-    char buffer[sizeof(Instruction)];
-    while (fread(buffer, sizeof(Instruction), 1, temp)) {
-        fwrite(buffer, sizeof(Instruction), 1, out);
+    // Cabecera e instrucciones en una sola escritura
+    int status = write_image(output_file, &image, &code);
+    free(image.data);
+    free(code.code);
+    if (status != 0) {
+        free_project_config(config);
+        return EXIT_FAILURE;
     }
 
-    fclose(temp);
-    fclose(out);
-
-    printf("  ✓ %s -> %s (%d instrucciones, %d strings)\n", source_file, output_file, instruction_count, string_count);
+    printf("  ✓ %s -> %s (%d instrucciones, %d strings)\n", source_file, output_file, code.count, string_count);
 
     for (int i = 0; i < temp_pool.count; i++) {
         free(temp_pool.strings[i]);
@@ -1312,7 +2726,7 @@ static int compile_file(const char *source_file, const char *project_dir, String
     return EXIT_SUCCESS;
 }
 
-int build_project(const char *project_dir) {
+int build_project(const char *project_dir, int optimize) {
     printf("Compiling project '%s'...\n", project_dir);
 
     // Leer configuración del proyecto
@@ -1337,8 +2751,10 @@ int build_project(const char *project_dir) {
     int file_count = 0;
     char **files = NULL;
     char *main_file = NULL;
-    VariablePool var_pool = {NULL, 0};
-    ClassPool class_pool = {NULL, 0};
+    VariablePool var_pool = {.vars = NULL, .count = 0};
+    ClassPool class_pool = {.classes = NULL, .count = 0};
+    PendingInitList pending = {NULL, 0};
+    int global_errors = 0;
 
     while ((entry = readdir(dir)) != NULL) {
         if (strstr(entry->d_name, ".gsf")) {
@@ -1346,7 +2762,9 @@ int build_project(const char *project_dir) {
             snprintf(full_path, sizeof(full_path), "%s/%s", src_dir, entry->d_name);
             
             // Extraer variables globales
-            extract_global_variables(full_path, &var_pool);
+            if (extract_global_variables(full_path, &var_pool, &pending) < 0) {
+                global_errors++;
+            }
             
             // Extraer clases
             extract_classes(full_path, &class_pool);
@@ -1369,6 +2787,16 @@ int build_project(const char *project_dir) {
     }
     closedir(dir);
 
+    // Inicializadores que dependen de globales de otros archivos
+    global_errors += resolve_pending_initializers(&pending, &var_pool);
+    free_pending_initializers(&pending);
+
+    if (global_errors > 0) {
+        fprintf(stderr, "✗ Compilation failed\n");
+        free_project_config(config);
+        return EXIT_FAILURE;
+    }
+
     if (file_count == 0) {
         fprintf(stderr, "✗ No se encontraron archivos .gsf\n");
         free_project_config(config);
@@ -1377,10 +2805,10 @@ int build_project(const char *project_dir) {
 
     // Compilar todos los archivos a un único bytecode
     StringPool combined_pool = {NULL, 0};
-    int total_instructions = 0;
-    FILE *temp = tmpfile();
-    if (!temp) {
-        fprintf(stderr, "Error: No se puede crear archivo temporal\n");
+    CodeBuffer code = {NULL, 0, 0};
+    IRProgram ir;
+    if (ir_init(&ir) != 0) {
+        fprintf(stderr, "Error: No hay memoria suficiente\n");
         free_project_config(config);
         return EXIT_FAILURE;
     }
@@ -1393,16 +2821,69 @@ int build_project(const char *project_dir) {
     }
 
     // Empezar por main.gsf si existe
+    int status = EXIT_SUCCESS;
     if (main_file) {
-        compile_file_internal(main_file, project_dir, temp, &combined_pool, &var_pool, &total_instructions);
+        status = compile_file_internal(main_file, project_dir, &ir, &combined_pool, &var_pool, &class_pool);
     }
 
     // Compilar el resto
-    for (int i = 0; i < file_count; i++) {
+    for (int i = 0; i < file_count && status == EXIT_SUCCESS; i++) {
         if (files[i] != main_file) {
-            compile_file_internal(files[i], project_dir, temp, &combined_pool, &var_pool, &total_instructions);
+            status = compile_file_internal(files[i], project_dir, &ir, &combined_pool, &var_pool, &class_pool);
+        }
+    }
+
+    // Optimizaciones sobre la IR (-O)
+    int removed_instructions = 0;
+    if (status == EXIT_SUCCESS && optimize) {
+        removed_instructions = optimize_peephole(&ir, &combined_pool, &var_pool);
+        if (removed_instructions < 0) status = EXIT_FAILURE;
+    }
+
+    // Eliminar lo que no se alcanza desde main. Las librerías exportan todo lo
+    // que definen, así que en ellas no hay nada muerto que descartar.
+    DceStats dce = {0, 0, 0, 0, 0};
+    int is_library = strcmp(config->type, "static_lib") == 0 || strcmp(config->type, "dynamic_lib") == 0;
+    if (status == EXIT_SUCCESS && !is_library &&
+        eliminate_dead_code(&ir, &combined_pool, &var_pool, &class_pool, &dce) != 0) {
+        status = EXIT_FAILURE;
+    }
+
+    // Codificar la IR a instrucciones de 3 bytes y asignar los rangos de los métodos
+    if (status == EXIT_SUCCESS && ir_lower(&ir, &code, &class_pool) != 0) {
+        status = EXIT_FAILURE;
+    }
+    uint16_t entry_locals = ir.functions[0].local_count;
+
+    // Librerías: tipo de cada local, para que el enlazador conserve los
+    // opcodes tipados (ver LIBRARY_IMAGE_VERSION)
+    ByteBuffer local_types = {NULL, 0, 0};
+    if (status == EXIT_SUCCESS && is_library) {
+        byte_buffer_append(&local_types, ir.functions[0].local_types, entry_locals);
+        for (int i = 0; i < class_pool.count; i++) {
+            for (int j = 0; j < class_pool.classes[i].method_count; j++) {
+                const IRFunction *fn = NULL;
+                for (int f = 1; f < ir.count && !fn; f++) {
+                    if (ir.functions[f].class_index == i && ir.functions[f].method_index == j) fn = &ir.functions[f];
+                }
+                int count = class_pool.classes[i].methods[j].local_count;
+                if (fn && count <= fn->local_count) {
+                    byte_buffer_append(&local_types, fn->local_types, count);
+                } else {
+                    for (int k = 0; k < count; k++) byte_buffer_append(&local_types, "d", 1);
+                }
+            }
         }
     }
+    ir_free(&ir);
+
+    if (status != EXIT_SUCCESS) {
+        fprintf(stderr, "✗ Compilation failed\n");
+        free(code.code);
+        free(local_types.data);
+        free_project_config(config);
+        return EXIT_FAILURE;
+    }
 
     // Determinar extensión según tipo de proyecto
     const char *extension = ".gld";  // Por defecto para ejecutables
@@ -1415,83 +2896,87 @@ int build_project(const char *project_dir) {
     char output_file[256];
     snprintf(output_file, sizeof(output_file), "%s/%s%s", project_dir, config->name[0] ? config->name : "output", extension);
 
-    // Escribir archivo final
-    FILE *out = fopen(output_file, "wb");
-    if (!out) {
-        fprintf(stderr, "Error: No se puede crear '%s'\n", output_file);
-        fclose(temp);
-        free_project_config(config);
-        return EXIT_FAILURE;
-    }
+    // Serializar cabecera en memoria
+    ByteBuffer image = {NULL, 0, 0};
 
     // Header
-    fprintf(out, "GOLD");
-    uint8_t version = 1;
-    fwrite(&version, 1, 1, out);
+    byte_buffer_append(&image, "GOLD", 4);
+    uint8_t version = is_library ? LIBRARY_IMAGE_VERSION : 1;
+    byte_buffer_append(&image, &version, 1);
 
     // Escribir configuración de ventana
     uint8_t window_title_len = strlen(config->window_title);
-    fwrite(&window_title_len, 1, 1, out);
-    fwrite(config->window_title, 1, window_title_len, out);
+    byte_buffer_append(&image, &window_title_len, 1);
+    byte_buffer_append(&image, config->window_title, window_title_len);
     
     uint16_t window_width = config->window_width;
-    fwrite(&window_width, sizeof(uint16_t), 1, out);
+    byte_buffer_append(&image, &window_width, sizeof(uint16_t));
     
     uint16_t window_height = config->window_height;
-    fwrite(&window_height, sizeof(uint16_t), 1, out);
+    byte_buffer_append(&image, &window_height, sizeof(uint16_t));
     
     uint8_t window_resizable = config->window_resizable;
-    fwrite(&window_resizable, 1, 1, out);
+    byte_buffer_append(&image, &window_resizable, 1);
     
     uint8_t window_mode_len = strlen(config->window_mode);
-    fwrite(&window_mode_len, 1, 1, out);
-    fwrite(config->window_mode, 1, window_mode_len, out);
+    byte_buffer_append(&image, &window_mode_len, 1);
+    byte_buffer_append(&image, config->window_mode, window_mode_len);
 
     // Escribir renderer
     uint8_t renderer_len = strlen(config->renderer);
-    fwrite(&renderer_len, 1, 1, out);
-    fwrite(config->renderer, 1, renderer_len, out);
+    byte_buffer_append(&image, &renderer_len, 1);
+    byte_buffer_append(&image, config->renderer, renderer_len);
 
     // Escribir fps
     uint16_t fps = config->fps;
-    fwrite(&fps, sizeof(uint16_t), 1, out);
+    byte_buffer_append(&image, &fps, sizeof(uint16_t));
 
     // Cantidad de variables globales
     uint16_t var_count = var_pool.count;
-    fwrite(&var_count, sizeof(uint16_t), 1, out);
+    byte_buffer_append(&image, &var_count, sizeof(uint16_t));
 
     // Variables globales (optimizado con tipo)
     for (int i = 0; i < var_pool.count; i++) {
         uint8_t name_len = strlen(var_pool.vars[i].name);
-        fwrite(&name_len, 1, 1, out);
-        fwrite(var_pool.vars[i].name, 1, name_len, out);
+        byte_buffer_append(&image, &name_len, 1);
+        byte_buffer_append(&image, var_pool.vars[i].name, name_len);
         
         // Escribir tipo de variable
         uint8_t var_type = var_pool.vars[i].type;
-        fwrite(&var_type, 1, 1, out);
+        byte_buffer_append(&image, &var_type, 1);
         
         // Escribir valor según tipo
         if (var_type == 's') {
             // String: escribir longitud + contenido
             uint16_t str_len = strlen(var_pool.vars[i].str_val);
-            fwrite(&str_len, sizeof(uint16_t), 1, out);
-            fwrite(var_pool.vars[i].str_val, 1, str_len, out);
+            byte_buffer_append(&image, &str_len, sizeof(uint16_t));
+            byte_buffer_append(&image, var_pool.vars[i].str_val, str_len);
         } else if (var_type == 'a') {
-            // Array estático: escribir tipo de elemento y tamaño
-            fwrite(&var_pool.vars[i].array_element_type, 1, 1, out);
-            fwrite(&var_pool.vars[i].array_size, sizeof(int), 1, out);
+            // Array estático: escribir tipo de elemento y tamaño (y las dimensiones)
+            uint8_t dims = (uint8_t)array_dims(&var_pool, i);
+            uint8_t element_type = (uint8_t)var_pool.vars[i].array_element_type | (dims > 1 ? ARRAY_SHAPED : 0);
+            byte_buffer_append(&image, &element_type, 1);
+            byte_buffer_append(&image, &var_pool.vars[i].array_size, sizeof(int));
+            if (dims > 1) {
+                byte_buffer_append(&image, &dims, 1);
+                byte_buffer_append(&image, var_pool.vars[i].array_shape, dims * sizeof(int));
+            }
         } else if (var_type == 'b') {
             // Array dinámico: escribir tipo de elemento (tamaño es 0)
-            fwrite(&var_pool.vars[i].array_element_type, 1, 1, out);
+            byte_buffer_append(&image, &var_pool.vars[i].array_element_type, 1);
+        } else if (var_type == 'o') {
+            // Objeto: índice de su clase (la instancia se crea con NEW_INSTANCE)
+            uint16_t obj_class = (uint16_t)var_pool.vars[i].value;
+            byte_buffer_append(&image, &obj_class, sizeof(uint16_t));
         } else {
             // Numeric: escribir double
-            fwrite(&var_pool.vars[i].value, sizeof(double), 1, out);
+            byte_buffer_append(&image, &var_pool.vars[i].value, sizeof(double));
         }
     }
 
     // Cantidad de clases
     uint16_t class_count = class_pool.count;
-    fwrite(&class_count, sizeof(uint16_t), 1, out);
+    byte_buffer_append(&image, &class_count, sizeof(uint16_t));
 
     // Escribir clases
     for (int i = 0; i < class_pool.count; i++) {
@@ -1499,24 +2984,24 @@ int build_project(const char *project_dir) {
         
         // Nombre de clase
         uint8_t name_len = strlen(cls->name);
-        fwrite(&name_len, 1, 1, out);
-        fwrite(cls->name, 1, name_len, out);
+        byte_buffer_append(&image, &name_len, 1);
+        byte_buffer_append(&image, cls->name, name_len);
         
         // Cantidad de variables de instancia
         uint8_t ivar_count = cls->var_count;
-        fwrite(&ivar_count, 1, 1, out);
+        byte_buffer_append(&image, &ivar_count, 1);
         
         // Variables de instancia
         for (int j = 0; j < cls->var_count; j++) {
             uint8_t var_name_len = strlen(cls->var_names[j]);
-            fwrite(&var_name_len, 1, 1, out);
-            fwrite(cls->var_names[j], 1, var_name_len, out);
-            fwrite(&cls->var_types[j], 1, 1, out);
+            byte_buffer_append(&image, &var_name_len, 1);
+            byte_buffer_append(&image, cls->var_names[j], var_name_len);
+            byte_buffer_append(&image, &cls->var_types[j], 1);
         }
         
         // Cantidad de métodos
         uint8_t method_count = cls->method_count;
-        fwrite(&method_count, 1, 1, out);
+        byte_buffer_append(&image, &method_count, 1);
         
         // Métodos
         for (int j = 0; j < cls->method_count; j++) {
@@ -1524,42 +3009,62 @@ int build_project(const char *project_dir) {
             
             // Nombre del método
             uint8_t method_name_len = strlen(method->name);
-            fwrite(&method_name_len, 1, 1, out);
-            fwrite(method->name, 1, method_name_len, out);
+            byte_buffer_append(&image, &method_name_len, 1);
+            byte_buffer_append(&image, method->name, method_name_len);
             
             // Información del método
-            fwrite(&method->is_public, 1, 1, out);
-            fwrite(&method->start_instruction, sizeof(int), 1, out);
-            fwrite(&method->instruction_count, sizeof(int), 1, out);
-            fwrite(&method->param_count, 1, 1, out);
+            byte_buffer_append(&image, &method->is_public, 1);
+            byte_buffer_append(&image, &method->start_instruction, sizeof(int));
+            byte_buffer_append(&image, &method->instruction_count, sizeof(int));
+            byte_buffer_append(&image, &method->param_count, 1);
+            uint16_t local_count = method->local_count;
+            byte_buffer_append(&image, &local_count, sizeof(uint16_t));
         }
     }
 
     // Cantidad de strings
     uint16_t string_count = combined_pool.count;
-    fwrite(&string_count, sizeof(uint16_t), 1, out);
+    byte_buffer_append(&image, &string_count, sizeof(uint16_t));
 
     // Strings
     for (int i = 0; i < combined_pool.count; i++) {
         uint16_t str_len = strlen(combined_pool.strings[i]);
-        fwrite(&str_len, sizeof(uint16_t), 1, out);
-        fwrite(combined_pool.strings[i], 1, str_len, out);
+        byte_buffer_append(&image, &str_len, sizeof(uint16_t));
+        byte_buffer_append(&image, combined_pool.strings[i], str_len);
     }
 
-    // Instrucciones desde archivo temporal
-    rewind(temp);
-    char buffer[sizeof(Instruction)];
-    while (fread(buffer, sizeof(Instruction), 1, temp)) {
-        fwrite(buffer, sizeof(Instruction), 1, out);
+    // Slots del frame de la entrada
+    byte_buffer_append(&image, &entry_locals, sizeof(uint16_t));
+    if (local_types.size > 0) {
+        byte_buffer_append(&image, local_types.data, local_types.size);
+    }
+    free(local_types.data);
+    for (int i = 0; is_library && i < var_pool.count; i++) {
+        if (var_pool.vars[i].type == 'i') {
+            byte_buffer_append(&image, &var_pool.vars[i].int_value, sizeof(int64_t));
+        }
     }
 
-    fclose(temp);
-    fclose(out);
+    // Cabecera e instrucciones en una sola escritura
+    status = write_image(output_file, &image, &code) == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+    free(image.data);
+    if (status != EXIT_SUCCESS) {
+        free(code.code);
+        free_project_config(config);
+        return EXIT_FAILURE;
+    }
 
     printf("✓ Compilation completed successfully\n");
     printf("  Output: %s\n", output_file);
     printf("  Files compiled: %d\n", file_count);
-    printf("  Instructions: %d\n", total_instructions);
+    printf("  Instructions: %d\n", code.count);
+    if (optimize) {
+        printf("  Peephole: %d instrucciones eliminadas\n", removed_instructions);
+    }
+    if (dce.globals || dce.classes || dce.methods || dce.strings || dce.instructions) {
+        printf("  Código muerto: %d globales, %d clases, %d métodos, %d strings, %d instrucciones\n",
+               dce.globals, dce.classes, dce.methods, dce.strings, dce.instructions);
+    }
     printf("  Strings: %d\n", string_count);
     printf("  Global variables: %d\n", var_count);
     printf("  Classes: %d\n", class_count);
@@ -1574,6 +3079,7 @@ int build_project(const char *project_dir) {
         free(var_pool.vars[i].name);
     }
     free(var_pool.vars);
+    symtab_free(&var_pool.names);
 
     for (int i = 0; i < class_pool.count; i++) {
         free(class_pool.classes[i].name);
@@ -1583,13 +3089,17 @@ int build_project(const char *project_dir) {
         free(class_pool.classes[i].var_names);
         free(class_pool.classes[i].var_types);
         free(class_pool.classes[i].methods);
+        symtab_free(&class_pool.classes[i].field_names);
+        symtab_free(&class_pool.classes[i].method_names);
     }
     free(class_pool.classes);
+    symtab_free(&class_pool.names);
 
     for (int i = 0; i < file_count; i++) {
         free(files[i]);
     }
     free(files);
+    free(code.code);
     free_project_config(config);
 
     return EXIT_SUCCESS;
@@ -2,20 +2,152 @@
 #define COMPILER_H
 
 #include <stdint.h>
+#include "symtab.h"
+
+// Opcodes (deben coincidir con vm/src/vm.h)
+#define OPCODE_PRINT        0x01
+#define OPCODE_NEW_INSTANCE 0x02
+#define OPCODE_CALL_METHOD  0x03
+#define OPCODE_GET_FIELD    0x04
+#define OPCODE_SET_FIELD    0x05
+#define OPCODE_PUSH_VALUE   0x06
+#define OPCODE_POP_VALUE    0x07
+#define OPCODE_PRINTLN      0x08
+#define OPCODE_PRINTCHR     0x09
+#define OPCODE_GET_GLOBAL   0x0A
+#define OPCODE_ARRAY_DECL   0x0B
+#define OPCODE_ARRAY_SET    0x0C
+#define OPCODE_ARRAY_GET    0x0D
+#define OPCODE_ARRAY_NEW    0x0E
+#define OPCODE_ARRAY_LEN    0x0F
+#define OPCODE_ARRAY_CLEAR  0x10
+#define OPCODE_LOAD_LOCAL   0x11
+#define OPCODE_STORE_LOCAL  0x12
+#define OPCODE_PUSH_INT     0x13
+#define OPCODE_I2F          0x14
+#define OPCODE_F2I          0x15
+#define OPCODE_ADD_I64      0x16
+#define OPCODE_SUB_I64      0x17
+#define OPCODE_MUL_I64      0x18
+#define OPCODE_DIV_I64      0x19
+#define OPCODE_MOD_I64      0x1A
+#define OPCODE_NEG_I64      0x1B
+#define OPCODE_ADD_F64      0x1C
+#define OPCODE_SUB_F64      0x1D
+#define OPCODE_MUL_F64      0x1E
+#define OPCODE_DIV_F64      0x1F
+#define OPCODE_MOD_F64      0x20
+#define OPCODE_NEG_F64      0x21
+#define OPCODE_PRINTLN_I64  0x22
+#define OPCODE_ARRAY_GET_I64 0x23
+#define OPCODE_ARRAY_SET_I64 0x24
+#define OPCODE_EQ_I64       0x25
+#define OPCODE_NE_I64       0x26
+#define OPCODE_LT_I64       0x27
+#define OPCODE_LE_I64       0x28
+#define OPCODE_GT_I64       0x29
+#define OPCODE_GE_I64       0x2A
+#define OPCODE_EQ_F64       0x2B
+#define OPCODE_NE_F64       0x2C
+#define OPCODE_LT_F64       0x2D
+#define OPCODE_LE_F64       0x2E
+#define OPCODE_GT_F64       0x2F
+#define OPCODE_GE_F64       0x30
+#define OPCODE_NOT          0x31
+#define OPCODE_AND          0x32
+#define OPCODE_OR           0x33
+#define OPCODE_MULADD_I64   0x34
+#define OPCODE_MULADD_F64   0x35
+#define OPCODE_JUMP_UNLESS_EQ_I64 0x36
+#define OPCODE_JUMP_UNLESS_NE_I64 0x37
+#define OPCODE_JUMP_UNLESS_LT_I64 0x38
+#define OPCODE_JUMP_UNLESS_LE_I64 0x39
+#define OPCODE_JUMP_UNLESS_GT_I64 0x3A
+#define OPCODE_JUMP_UNLESS_GE_I64 0x3B
+#define OPCODE_JUMP_UNLESS_EQ_F64 0x3C
+#define OPCODE_JUMP_UNLESS_NE_F64 0x3D
+#define OPCODE_JUMP_UNLESS_LT_F64 0x3E
+#define OPCODE_JUMP_UNLESS_LE_F64 0x3F
+#define OPCODE_JUMP_UNLESS_GT_F64 0x40
+#define OPCODE_JUMP_UNLESS_GE_F64 0x41
+#define OPCODE_JUMP          0x42
+#define OPCODE_JUMP_IF_FALSE 0x43
+#define OPCODE_LOOP          0x44
+#define OPCODE_FLUSH         0x45
+#define OPCODE_FORMAT_PRINT  0x46  // Plantilla arg1 con arg2 valores del stack
+#define OPCODE_ARRAY_GET_INT 0x47  // Arrays de int/long/byte/bool: índice y valor int64
+#define OPCODE_ARRAY_SET_INT 0x48
+#define OPCODE_ARRAY_PUSH    0x49  // push/pop/reserve/resize/copy de arrays dinámicos
+#define OPCODE_ARRAY_POP     0x4A
+#define OPCODE_ARRAY_RESERVE 0x4B
+#define OPCODE_ARRAY_RESIZE  0x4C
+#define OPCODE_ARRAY_COPY    0x4D  // arg1 destino, arg2 origen (globales)
+#define OPCODE_ARRAY_FILL    0x4E  // Operaciones sobre el array completo arg1
+#define OPCODE_ARRAY_ADD     0x4F  // arg2: segundo array de add/mul/axpy/dot
+#define OPCODE_ARRAY_MUL     0x50
+#define OPCODE_ARRAY_SCALE   0x51
+#define OPCODE_ARRAY_AXPY    0x52
+#define OPCODE_ARRAY_SUM     0x53
+#define OPCODE_ARRAY_MIN     0x54
+#define OPCODE_ARRAY_MAX     0x55
+#define OPCODE_ARRAY_DOT     0x56
+#define OPCODE_PARALLEL_FOR  0x57  // arg1 índice (el final en arg1 + 1); cuerpo
+#define OPCODE_PARALLEL_END  0x58  // hasta el PARALLEL_END con el mismo arg1
+#define OPCODE_ARRAY_SORT      0x59
+#define OPCODE_ARRAY_SORT_DESC 0x5A
+#define OPCODE_ARRAY_SEARCH    0x5B  // binary_search(valor): índice o -1
+#define OPCODE_ARRAY_UNIQUE    0x5C
+#define OPCODE_ARRAY_ROW       0x5D  // arg1 = vista, arg2 = origen; pop índice
+#define OPCODE_ARRAY_COL       0x5E
+#define OPCODE_ARRAY_SLICE     0x5F  // Pop hasta y desde
+#define OPCODE_PUSH_I64        0x60  // arg1 = string del pool con el entero
+
+// Hueco de una plantilla de FORMAT_PRINT: seguido de 'i' (int64) o 'f'
+// (double); repetido, el propio byte
+#define FORMAT_HOLE          '\x01'
+#define OPCODE_RETURN       0xFF
+
+typedef struct {
+    uint8_t opcode;
+    uint8_t arg1;
+    uint8_t arg2;
+} Instruction;
+
+typedef struct {
+    char **strings;
+    int count;
+} StringPool;
+
+// Código generado en memoria (crece geométricamente)
+typedef struct {
+    Instruction *code;
+    int count;
+    int capacity;
+} CodeBuffer;
+
+// Dimensiones de un array estático (int grid[640][480];). En la imagen, el
+// tipo de elemento lleva ARRAY_SHAPED si tras el tamaño siguen las
+// dimensiones (1 byte) y el tamaño de cada una (int).
+#define ARRAY_MAX_DIMS 4
+#define ARRAY_SHAPED   0x80
 
 typedef struct {
     char *name;
     char type;      // 'i' = int, 'd' = double, 's' = string, 'a' = array estático, 'b' = array dinámico
     double value;   // Para int/double
+    int64_t int_value;  // Para int (e int64): valor exacto; 'value' lo aproxima
     char *str_val;  // Para string
     int array_size; // Para arrays: tamaño
     int dynamic_array_size;  // Para arrays dinámicos: tamaño inicial
-    char array_element_type; // Para arrays: tipo de elemento
+    char array_element_type; // Para arrays: 'd' double, 'l' long, 'i' int (32 bits), 'u' byte, 'z' bool (1 bit)
+    int array_dims;          // Para arrays estáticos: dimensiones (1 = normal) y
+    int array_shape[ARRAY_MAX_DIMS];  // tamaño de cada una, row-major
 } GlobalVariable;
 
 typedef struct {
     GlobalVariable *vars;
     int count;
+    SymbolTable names;      // Índice por nombre (ver var_pool_find)
 } VariablePool;
 
 typedef struct {
@@ -23,6 +155,7 @@ typedef struct {
     int start_instruction;
     int instruction_count;
     int param_count;
+    int local_count;    // Slots del frame (LOAD_LOCAL / STORE_LOCAL)
     uint8_t is_public;  // 1 = public, 0 = private
 } ClassMethod;
 
@@ -33,13 +166,32 @@ typedef struct {
     int var_count;  // Number of instance variables
     char **var_names;
     uint8_t *var_types;  // 'd' for double, 'i' for int
+    SymbolTable field_names;
+    SymbolTable method_names;
 } ClassDefinition;
 
 typedef struct {
     ClassDefinition *classes;
     int count;
+    SymbolTable names;
 } ClassPool;
 
-int build_project(const char *project_dir);
+// Búsquedas por nombre a través de tablas hash. Las entradas que se añaden al
+// array se indexan en la siguiente búsqueda; si el array se compacta, el
+// índice se reconstruye. 'len' < 0 usa strlen(name). Devuelven -1 si no existe.
+int var_pool_find(VariablePool *pool, const char *name, int len);
+int class_pool_find(ClassPool *pool, const char *name, int len);
+int class_find_field(ClassDefinition *cls, const char *name, int len);
+int class_find_method(ClassDefinition *cls, const char *name, int len);
+
+// Tipo en el stack de los elementos del array global 'var': 'd' si son
+// double; 'i' (int64) los enteros y bool, con ARRAY_GET_INT / ARRAY_SET_INT
+char array_value_type(const VariablePool *pool, int var);
+
+// Dimensiones del array global 'var': 1 salvo en los estáticos de varias
+int array_dims(const VariablePool *pool, int var);
+
+int emit_instruction(CodeBuffer *buffer, Instruction instr);
+int build_project(const char *project_dir, int optimize);
 
 #endif
@@ -0,0 +1,227 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+#include "consteval.h"
+
+typedef double (*MathFn1)(double);
+typedef double (*MathFn2)(double, double);
+
+typedef struct {
+    const char *name;
+    int arity;
+    MathFn1 fn1;
+    MathFn2 fn2;
+} PureFunction;
+
+static const PureFunction pure_functions[] = {
+    {"sqrt", 1, sqrt, NULL},   {"cbrt", 1, cbrt, NULL},
+    {"sin", 1, sin, NULL},     {"cos", 1, cos, NULL},     {"tan", 1, tan, NULL},
+    {"asin", 1, asin, NULL},   {"acos", 1, acos, NULL},   {"atan", 1, atan, NULL},
+    {"exp", 1, exp, NULL},     {"log", 1, log, NULL},
+    {"log2", 1, log2, NULL},   {"log10", 1, log10, NULL},
+    {"floor", 1, floor, NULL}, {"ceil", 1, ceil, NULL},
+    {"round", 1, round, NULL}, {"trunc", 1, trunc, NULL},
+    {"pow", 2, NULL, pow},     {"atan2", 2, NULL, atan2}, {"fmod", 2, NULL, fmod},
+};
+
+// Resultado entero: exacto en 'integer' y aproximado en 'value'
+static void set_integer(ConstValue *out, int64_t value) {
+    out->integer = value;
+    out->value = (double)value;
+    out->is_int = 1;
+}
+
+static ConstStatus eval_call(const ExprNode *node, VariablePool *var_pool,
+                             ConstValue *out, const char **unresolved) {
+    ConstValue args[2];
+    if (node->arg_count > 2) return CONST_NOT_CONSTANT;
+    for (int i = 0; i < node->arg_count; i++) {
+        ConstStatus status = const_eval(node->args[i], var_pool, &args[i], unresolved);
+        if (status != CONST_OK) return status;
+    }
+
+    // abs/min/max conservan el tipo entero
+    if (strcmp(node->name, "abs") == 0 && node->arg_count == 1) {
+        if (args[0].is_int) {
+            set_integer(out, args[0].integer < 0 ? (int64_t)(0 - (uint64_t)args[0].integer) : args[0].integer);
+        } else {
+            out->value = fabs(args[0].value);
+            out->is_int = 0;
+        }
+        return CONST_OK;
+    }
+    if ((strcmp(node->name, "min") == 0 || strcmp(node->name, "max") == 0) && node->arg_count == 2) {
+        int is_min = node->name[1] == 'i';
+        if (args[0].is_int && args[1].is_int) {
+            set_integer(out, (args[0].integer < args[1].integer) == is_min ? args[0].integer : args[1].integer);
+        } else {
+            out->value = (args[0].value < args[1].value) == is_min ? args[0].value : args[1].value;
+            out->is_int = 0;
+        }
+        return CONST_OK;
+    }
+
+    for (size_t i = 0; i < sizeof(pure_functions) / sizeof(pure_functions[0]); i++) {
+        const PureFunction *fn = &pure_functions[i];
+        if (strcmp(fn->name, node->name) != 0 || fn->arity != node->arg_count) continue;
+
+        out->value = fn->arity == 1 ? fn->fn1(args[0].value) : fn->fn2(args[0].value, args[1].value);
+        out->is_int = 0;
+        return CONST_OK;
+    }
+
+    if (unresolved) *unresolved = node->name;
+    return CONST_NOT_CONSTANT;
+}
+
+static ConstStatus eval_binary(char op, ConstValue a, ConstValue b, ConstValue *out) {
+    // Comparaciones y lógicos: 0/1 entero (los enteros se comparan como int64)
+    if (expr_is_comparison(op) || expr_is_logical(op)) {
+        int both_int = a.is_int && b.is_int;
+        int lt = both_int ? a.integer < b.integer : a.value < b.value;
+        int gt = both_int ? a.integer > b.integer : a.value > b.value;
+        int eq = both_int ? a.integer == b.integer : a.value == b.value;
+        int x = a.is_int ? a.integer != 0 : a.value != 0;
+        int y = b.is_int ? b.integer != 0 : b.value != 0;
+        int result = 0;
+        switch (op) {
+            case '<':         result = lt; break;
+            case '>':         result = gt; break;
+            case EXPR_OP_LE:  result = lt || eq; break;
+            case EXPR_OP_GE:  result = gt || eq; break;
+            case EXPR_OP_EQ:  result = eq; break;
+            case EXPR_OP_NE:  result = !eq; break;
+            case EXPR_OP_AND: result = x && y; break;
+            default:          result = x || y; break;
+        }
+        set_integer(out, result);
+        return CONST_OK;
+    }
+
+    out->is_int = a.is_int && b.is_int;
+
+    if (out->is_int) {
+        // Como ADD_I64...: aritmética int64 con desbordamiento circular
+        uint64_t x = (uint64_t)a.integer;
+        uint64_t y = (uint64_t)b.integer;
+        switch (op) {
+            case '+': set_integer(out, (int64_t)(x + y)); return CONST_OK;
+            case '-': set_integer(out, (int64_t)(x - y)); return CONST_OK;
+            case '*': set_integer(out, (int64_t)(x * y)); return CONST_OK;
+            case '/':
+            case '%':
+                if (b.integer == 0) return CONST_DOMAIN_ERROR;
+                if (b.integer == -1) {
+                    // INT64_MIN / -1 no cabe
+                    set_integer(out, op == '/' ? (int64_t)(0 - x) : 0);
+                } else {
+                    set_integer(out, op == '/' ? a.integer / b.integer : a.integer % b.integer);
+                }
+                return CONST_OK;
+        }
+        return CONST_NOT_CONSTANT;
+    }
+
+    // Operandos mixtos: el entero pasa a double
+    if (a.is_int) a.value = (double)a.integer;
+    if (b.is_int) b.value = (double)b.integer;
+
+    // En double, como DIV_F64 y MOD_F64: x / 0 da inf o nan y fmod(x, 0) nan
+    switch (op) {
+        case '+': out->value = a.value + b.value; return CONST_OK;
+        case '-': out->value = a.value - b.value; return CONST_OK;
+        case '*': out->value = a.value * b.value; return CONST_OK;
+        case '/': out->value = a.value / b.value; return CONST_OK;
+        case '%': out->value = fmod(a.value, b.value); return CONST_OK;
+    }
+    return CONST_NOT_CONSTANT;
+}
+
+ConstStatus const_eval(const ExprNode *node, VariablePool *var_pool,
+                       ConstValue *out, const char **unresolved) {
+    ConstValue a, b;
+    ConstStatus status;
+
+    switch (node->kind) {
+        case EXPR_NUMBER:
+            if (node->is_int) {
+                set_integer(out, node->integer);
+            } else {
+                out->value = node->number;
+                out->is_int = 0;
+            }
+            return CONST_OK;
+
+        case EXPR_NAME: {
+            int idx = var_pool ? var_pool_find(var_pool, node->name, -1) : -1;
+            if (idx < 0) {
+                if (unresolved) *unresolved = node->name;
+                return CONST_UNRESOLVED;
+            }
+            const GlobalVariable *var = &var_pool->vars[idx];
+            if (var->type != 'i' && var->type != 'd') {
+                if (unresolved) *unresolved = node->name;
+                return CONST_NOT_CONSTANT;
+            }
+            if (var->type == 'i') {
+                set_integer(out, var->int_value);
+            } else {
+                out->value = var->value;
+                out->is_int = 0;
+            }
+            return CONST_OK;
+        }
+
+        case EXPR_UNARY:
+            status = const_eval(node->left, var_pool, &a, unresolved);
+            if (status != CONST_OK) return status;
+            *out = a;
+            if (node->op == '-') {
+                if (a.is_int) set_integer(out, (int64_t)(0 - (uint64_t)a.integer));
+                else out->value = -a.value;
+            }
+            if (node->op == '!') set_integer(out, a.is_int ? a.integer == 0 : a.value == 0);
+            return CONST_OK;
+
+        case EXPR_BINARY:
+            status = const_eval(node->left, var_pool, &a, unresolved);
+            if (status != CONST_OK) return status;
+            status = const_eval(node->right, var_pool, &b, unresolved);
+            if (status != CONST_OK) return status;
+            return eval_binary(node->op, a, b, out);
+
+        case EXPR_CALL:
+            return eval_call(node, var_pool, out, unresolved);
+
+        case EXPR_INDEX:
+            if (unresolved) *unresolved = node->name;
+            return CONST_NOT_CONSTANT;
+    }
+    return CONST_NOT_CONSTANT;
+}
+
+ConstStatus const_eval_string(const char *src, VariablePool *var_pool,
+                              ConstValue *out, const char **unresolved) {
+    const char *end = NULL;
+    if (unresolved) *unresolved = NULL;
+
+    ExprNode *root = expr_parse(src, &end);
+    if (!root || (*end && *end != ';' && *end != '\n' && *end != '\r' && *end != '/')) {
+        expr_free(root);
+        if (unresolved) *unresolved = NULL;
+        return CONST_NOT_CONSTANT;
+    }
+
+    ConstStatus status = const_eval(root, var_pool, out, unresolved);
+
+    // 'unresolved' apunta dentro del árbol: copiarlo antes de liberarlo
+    static char name[256];
+    if (unresolved && *unresolved && status != CONST_OK) {
+        snprintf(name, sizeof(name), "%s", *unresolved);
+        *unresolved = name;
+    }
+    expr_free(root);
+    return status;
+}
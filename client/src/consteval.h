@@ -0,0 +1,31 @@
+#ifndef CONSTEVAL_H
+#define CONSTEVAL_H
+
+#include "compiler.h"
+#include "expr.h"
+
+// Evaluación en tiempo de compilación de expresiones constantes: literales,
+// globales numéricas ya resueltas y funciones matemáticas puras.
+
+typedef struct {
+    double value;
+    int is_int;         // Aritmética entera (división truncada, % entero)
+    int64_t integer;    // Valor exacto si is_int; 'value' es su aproximación
+} ConstValue;
+
+typedef enum {
+    CONST_OK = 0,
+    CONST_UNRESOLVED,   // Nombra una global que aún no está en el pool
+    CONST_NOT_CONSTANT, // Función no pura, string, array...
+    CONST_DOMAIN_ERROR  // División o resto enteros por cero
+} ConstStatus;
+
+// 'unresolved' (opcional) recibe el primer nombre que impidió la evaluación.
+ConstStatus const_eval(const ExprNode *node, VariablePool *var_pool,
+                       ConstValue *out, const char **unresolved);
+
+// Parsea y evalúa 'src' hasta ';' o fin de línea.
+ConstStatus const_eval_string(const char *src, VariablePool *var_pool,
+                              ConstValue *out, const char **unresolved);
+
+#endif
@@ -0,0 +1,372 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "dce.h"
+
+typedef struct {
+    IRProgram *ir;
+    ClassPool *class_pool;
+    int global_count;
+    int class_count;
+
+    uint8_t *fn_live;
+    uint8_t *global_live;
+    uint8_t *class_live;
+    uint8_t **method_live;      // Por clase
+    int *worklist;
+    int work_count;
+} Reachability;
+
+static int find_method_function(const IRProgram *ir, int class_index, int method_index) {
+    for (int i = 1; i < ir->count; i++) {
+        if (ir->functions[i].class_index == class_index && ir->functions[i].method_index == method_index) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static void enqueue_function(Reachability *r, int fn) {
+    if (fn < 0 || r->fn_live[fn]) return;
+    r->fn_live[fn] = 1;
+    r->worklist[r->work_count++] = fn;
+}
+
+static void mark_function(Reachability *r, const IRFunction *fn) {
+    for (int b = 0; b < fn->block_count; b++) {
+        const IRBlock *block = &fn->blocks[b];
+        for (int i = 0; i < block->count; i++) {
+            const IRInstr *instr = &block->instrs[i];
+
+            switch (ir_operand_kind(instr->opcode)) {
+                case IR_OPERAND_GLOBAL:
+                    // ARRAY_NEW solo inicializa: no mantiene viva la global por sí mismo
+                    if (instr->opcode != OPCODE_ARRAY_NEW && instr->arg1 >= 0 && instr->arg1 < r->global_count) {
+                        r->global_live[instr->arg1] = 1;
+                    }
+                    if (ir_second_global(instr->opcode) && instr->arg2 >= 0 && instr->arg2 < r->global_count) {
+                        r->global_live[instr->arg2] = 1;
+                    }
+                    break;
+                case IR_OPERAND_CLASS:
+                    if (instr->opcode == OPCODE_NEW_INSTANCE && instr->arg2 >= 0 && instr->arg2 < r->global_count) {
+                        r->global_live[instr->arg2] = 1;
+                    }
+                    if (instr->arg1 < 0 || instr->arg1 >= r->class_count) break;
+                    r->class_live[instr->arg1] = 1;
+                    if (instr->opcode == OPCODE_CALL_METHOD &&
+                        instr->arg2 >= 0 && instr->arg2 < r->class_pool->classes[instr->arg1].method_count) {
+                        r->method_live[instr->arg1][instr->arg2] = 1;
+                        enqueue_function(r, find_method_function(r->ir, instr->arg1, instr->arg2));
+                    }
+                    break;
+                default:
+                    break;
+            }
+        }
+    }
+}
+
+// Quita ARRAY_NEW (y el PUSH_VALUE de su tamaño) de arrays que nadie usa
+static int remove_dead_initializers(IRFunction *fn, const uint8_t *global_live, int global_count) {
+    int removed = 0;
+    for (int b = 0; b < fn->block_count; b++) {
+        IRBlock *block = &fn->blocks[b];
+        int out = 0;
+        for (int i = 0; i < block->count; i++) {
+            IRInstr instr = block->instrs[i];
+            if (instr.opcode == OPCODE_ARRAY_NEW && instr.arg1 >= 0 && instr.arg1 < global_count &&
+                !global_live[instr.arg1]) {
+                removed++;
+                if (out > 0 && block->instrs[out - 1].opcode == OPCODE_PUSH_VALUE) {
+                    out--;
+                    removed++;
+                }
+                continue;
+            }
+            block->instrs[out++] = instr;
+        }
+        block->count = out;
+    }
+    return removed;
+}
+
+static void free_function(IRFunction *fn) {
+    for (int b = 0; b < fn->block_count; b++) {
+        free(fn->blocks[b].instrs);
+    }
+    free(fn->blocks);
+    free(fn->name);
+}
+
+static int *compact_globals(VariablePool *var_pool, const uint8_t *live, int *removed) {
+    int *map = (int*)malloc((var_pool->count + 1) * sizeof(int));
+    if (!map) return NULL;
+
+    int out = 0;
+    for (int i = 0; i < var_pool->count; i++) {
+        if (!live[i]) {
+            map[i] = -1;
+            free(var_pool->vars[i].name);
+            free(var_pool->vars[i].str_val);
+            (*removed)++;
+            continue;
+        }
+        map[i] = out;
+        var_pool->vars[out++] = var_pool->vars[i];
+    }
+    var_pool->count = out;
+    symtab_clear(&var_pool->names);
+    return map;
+}
+
+static void free_class(ClassDefinition *cls) {
+    free(cls->name);
+    for (int j = 0; j < cls->var_count; j++) {
+        free(cls->var_names[j]);
+    }
+    free(cls->var_names);
+    free(cls->var_types);
+    for (int j = 0; j < cls->method_count; j++) {
+        free(cls->methods[j].name);
+    }
+    free(cls->methods);
+    symtab_free(&cls->field_names);
+    symtab_free(&cls->method_names);
+}
+
+// Compacta clases y métodos. method_map[c][m] queda indexado por los índices originales.
+static int *compact_classes(ClassPool *class_pool, const uint8_t *class_live, uint8_t **method_live,
+                            int **method_map, DceStats *stats) {
+    int *map = (int*)malloc((class_pool->count + 1) * sizeof(int));
+    if (!map) return NULL;
+
+    int out = 0;
+    for (int i = 0; i < class_pool->count; i++) {
+        ClassDefinition *cls = &class_pool->classes[i];
+        if (!class_live[i]) {
+            map[i] = -1;
+            stats->classes++;
+            stats->methods += cls->method_count;
+            free_class(cls);
+            continue;
+        }
+
+        int kept = 0;
+        for (int j = 0; j < cls->method_count; j++) {
+            if (!method_live[i][j]) {
+                method_map[i][j] = -1;
+                free(cls->methods[j].name);
+                stats->methods++;
+                continue;
+            }
+            method_map[i][j] = kept;
+            cls->methods[kept++] = cls->methods[j];
+        }
+        cls->method_count = kept;
+        symtab_clear(&cls->method_names);
+
+        map[i] = out;
+        class_pool->classes[out++] = *cls;
+    }
+    class_pool->count = out;
+    symtab_clear(&class_pool->names);
+    return map;
+}
+
+static void mark_strings(const IRProgram *ir, uint8_t *string_live, int string_count) {
+    for (int f = 0; f < ir->count; f++) {
+        const IRFunction *fn = &ir->functions[f];
+        for (int b = 0; b < fn->block_count; b++) {
+            for (int i = 0; i < fn->blocks[b].count; i++) {
+                const IRInstr *instr = &fn->blocks[b].instrs[i];
+                if (ir_operand_kind(instr->opcode) == IR_OPERAND_STRING &&
+                    instr->arg1 >= 0 && instr->arg1 < string_count) {
+                    string_live[instr->arg1] = 1;
+                }
+            }
+        }
+    }
+}
+
+static int *compact_strings(StringPool *string_pool, const uint8_t *live, int *removed) {
+    int *map = (int*)malloc((string_pool->count + 1) * sizeof(int));
+    if (!map) return NULL;
+
+    int out = 0;
+    for (int i = 0; i < string_pool->count; i++) {
+        if (!live[i]) {
+            map[i] = -1;
+            free(string_pool->strings[i]);
+            (*removed)++;
+            continue;
+        }
+        map[i] = out;
+        string_pool->strings[out++] = string_pool->strings[i];
+    }
+    string_pool->count = out;
+    return map;
+}
+
+static void remap_program(IRProgram *ir, const int *global_map, int global_count,
+                          const int *class_map, int class_count, int **method_map,
+                          const int *string_map, int string_count) {
+    for (int f = 0; f < ir->count; f++) {
+        IRFunction *fn = &ir->functions[f];
+        for (int b = 0; b < fn->block_count; b++) {
+            for (int i = 0; i < fn->blocks[b].count; i++) {
+                IRInstr *instr = &fn->blocks[b].instrs[i];
+                int arg1 = instr->arg1;
+
+                switch (ir_operand_kind(instr->opcode)) {
+                    case IR_OPERAND_STRING:
+                        if (string_map && arg1 >= 0 && arg1 < string_count && string_map[arg1] >= 0) {
+                            instr->arg1 = string_map[arg1];
+                        }
+                        break;
+                    case IR_OPERAND_GLOBAL:
+                        if (global_map && arg1 >= 0 && arg1 < global_count && global_map[arg1] >= 0) {
+                            instr->arg1 = global_map[arg1];
+                        }
+                        if (ir_second_global(instr->opcode) && global_map &&
+                            instr->arg2 >= 0 && instr->arg2 < global_count && global_map[instr->arg2] >= 0) {
+                            instr->arg2 = global_map[instr->arg2];
+                        }
+                        break;
+                    case IR_OPERAND_CLASS:
+                        if (!class_map || arg1 < 0 || arg1 >= class_count || class_map[arg1] < 0) break;
+                        if (instr->opcode == OPCODE_CALL_METHOD && method_map[arg1] && instr->arg2 >= 0) {
+                            instr->arg2 = method_map[arg1][instr->arg2];
+                        }
+                        if (instr->opcode == OPCODE_NEW_INSTANCE && global_map &&
+                            instr->arg2 >= 0 && instr->arg2 < global_count && global_map[instr->arg2] >= 0) {
+                            instr->arg2 = global_map[instr->arg2];
+                        }
+                        instr->arg1 = class_map[arg1];
+                        break;
+                    default:
+                        break;
+                }
+            }
+        }
+    }
+}
+
+int eliminate_dead_code(IRProgram *ir, StringPool *string_pool, VariablePool *var_pool,
+                        ClassPool *class_pool, DceStats *stats) {
+    memset(stats, 0, sizeof(DceStats));
+
+    Reachability r;
+    memset(&r, 0, sizeof(r));
+    r.ir = ir;
+    r.class_pool = class_pool;
+    r.global_count = var_pool ? var_pool->count : 0;
+    r.class_count = class_pool ? class_pool->count : 0;
+
+    int status = -1;
+    int *global_map = NULL;
+    int *class_map = NULL;
+    int *string_map = NULL;
+    int **method_map = NULL;
+    uint8_t *string_live = NULL;
+
+    r.fn_live = (uint8_t*)calloc(ir->count + 1, 1);
+    r.worklist = (int*)malloc((ir->count + 1) * sizeof(int));
+    r.global_live = (uint8_t*)calloc(r.global_count + 1, 1);
+    r.class_live = (uint8_t*)calloc(r.class_count + 1, 1);
+    r.method_live = (uint8_t**)calloc(r.class_count + 1, sizeof(uint8_t*));
+    method_map = (int**)calloc(r.class_count + 1, sizeof(int*));
+    if (!r.fn_live || !r.worklist || !r.global_live || !r.class_live || !r.method_live || !method_map) {
+        goto done;
+    }
+    for (int i = 0; i < r.class_count; i++) {
+        int methods = class_pool->classes[i].method_count;
+        r.method_live[i] = (uint8_t*)calloc(methods + 1, 1);
+        method_map[i] = (int*)malloc((methods + 1) * sizeof(int));
+        if (!r.method_live[i] || !method_map[i]) goto done;
+    }
+
+    // 1) Alcanzabilidad desde la entrada (y funciones libres, que no son métodos)
+    for (int f = 0; f < ir->count; f++) {
+        if (f == 0 || ir->functions[f].class_index < 0) enqueue_function(&r, f);
+    }
+    while (r.work_count > 0) {
+        int fn = r.worklist[--r.work_count];
+        mark_function(&r, &ir->functions[fn]);
+    }
+
+    // Una global objeto viva mantiene viva su clase
+    for (int i = 0; i < r.global_count; i++) {
+        int cls = (int)var_pool->vars[i].value;
+        if (r.global_live[i] && var_pool->vars[i].type == 'o' && cls >= 0 && cls < r.class_count) {
+            r.class_live[cls] = 1;
+        }
+    }
+
+    // 2) Código inalcanzable: métodos sin llamadas y ARRAY_NEW de arrays sin uso
+    int out = 0;
+    for (int f = 0; f < ir->count; f++) {
+        IRFunction *fn = &ir->functions[f];
+        if (!r.fn_live[f]) {
+            for (int b = 0; b < fn->block_count; b++) {
+                stats->instructions += fn->blocks[b].count;
+            }
+            free_function(fn);
+            continue;
+        }
+        stats->instructions += remove_dead_initializers(fn, r.global_live, r.global_count);
+        ir->functions[out++] = *fn;
+    }
+    ir->count = out;
+    ir->current = 0;
+
+    // 3) Compactar tablas y reescribir operandos
+    if (var_pool && !(global_map = compact_globals(var_pool, r.global_live, &stats->globals))) goto done;
+    if (class_pool && !(class_map = compact_classes(class_pool, r.class_live, r.method_live, method_map, stats))) {
+        goto done;
+    }
+
+    for (int f = 0; f < ir->count; f++) {
+        IRFunction *fn = &ir->functions[f];
+        if (fn->class_index < 0 || fn->class_index >= r.class_count) continue;
+        int method = fn->method_index;
+        fn->method_index = method >= 0 ? method_map[fn->class_index][method] : -1;
+        fn->class_index = class_map[fn->class_index];
+    }
+
+    remap_program(ir, global_map, r.global_count, class_map, r.class_count, method_map, NULL, 0);
+    for (int i = 0; var_pool && class_map && i < var_pool->count; i++) {
+        if (var_pool->vars[i].type == 'o') {
+            var_pool->vars[i].value = class_map[(int)var_pool->vars[i].value];
+        }
+    }
+
+    // 4) Strings: se marcan al final, sobre el código que sobrevivió
+    int string_count = string_pool->count;
+    string_live = (uint8_t*)calloc(string_count + 1, 1);
+    if (!string_live) goto done;
+    mark_strings(ir, string_live, string_count);
+    if (!(string_map = compact_strings(string_pool, string_live, &stats->strings))) goto done;
+    remap_program(ir, NULL, 0, NULL, 0, NULL, string_map, string_count);
+
+    status = 0;
+
+done:
+    if (status != 0) fprintf(stderr, "Error: No hay memoria suficiente\n");
+    for (int i = 0; i < r.class_count; i++) {
+        if (r.method_live) free(r.method_live[i]);
+        if (method_map) free(method_map[i]);
+    }
+    free(r.method_live);
+    free(method_map);
+    free(r.fn_live);
+    free(r.worklist);
+    free(r.global_live);
+    free(r.class_live);
+    free(global_map);
+    free(class_map);
+    free(string_map);
+    free(string_live);
+    return status;
+}
@@ -0,0 +1,22 @@
+#ifndef DCE_H
+#define DCE_H
+
+#include "compiler.h"
+#include "ir.h"
+
+// Eliminación de código muerto sobre el programa enlazado completo: parte de
+// la entrada y descarta las globales, clases, métodos y strings del pool que
+// no se alcanzan, compactando los índices restantes.
+
+typedef struct {
+    int globals;
+    int classes;
+    int methods;
+    int strings;
+    int instructions;
+} DceStats;
+
+int eliminate_dead_code(IRProgram *ir, StringPool *string_pool, VariablePool *var_pool,
+                        ClassPool *class_pool, DceStats *stats);
+
+#endif
@@ -0,0 +1,331 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include "expr.h"
+
+typedef struct {
+    const char *p;
+    int error;
+} ExprParser;
+
+static ExprNode *parse_or(ExprParser *parser);
+
+static void skip_spaces(ExprParser *parser) {
+    while (*parser->p == ' ' || *parser->p == '\t') parser->p++;
+}
+
+static ExprNode *new_node(ExprParser *parser, ExprKind kind) {
+    ExprNode *node = (ExprNode*)calloc(1, sizeof(ExprNode));
+    if (!node) parser->error = 1;
+    else node->kind = kind;
+    return node;
+}
+
+static ExprNode *parse_number(ExprParser *parser) {
+    const char *start = parser->p;
+    char *end = NULL;
+    ExprNode *node = new_node(parser, EXPR_NUMBER);
+    if (!node) return NULL;
+
+    if (start[0] == '0' && (start[1] == 'x' || start[1] == 'X')) {
+        node->integer = strtoll(start, &end, 16);
+        node->number = (double)node->integer;
+        node->is_int = 1;
+    } else {
+        node->number = strtod(start, &end);
+        node->is_int = 1;
+        for (const char *c = start; c < end; c++) {
+            if (*c == '.' || *c == 'e' || *c == 'E') node->is_int = 0;
+        }
+        // Por encima de 2^53 el double no es exacto: el entero se lee aparte
+        if (node->is_int) node->integer = strtoll(start, NULL, 10);
+    }
+
+    if (end == start) {
+        parser->error = 1;
+        free(node);
+        return NULL;
+    }
+    parser->p = end;
+    return node;
+}
+
+static int add_argument(ExprNode *call, ExprNode *arg) {
+    ExprNode **temp = realloc(call->args, (call->arg_count + 1) * sizeof(ExprNode*));
+    if (!temp) return -1;
+    call->args = temp;
+    call->args[call->arg_count++] = arg;
+    return 0;
+}
+
+static ExprNode *parse_name(ExprParser *parser) {
+    const char *start = parser->p;
+    while (isalnum((unsigned char)*parser->p) || *parser->p == '_') parser->p++;
+    // Acceso a campo: obj.campo forma un único nombre
+    if (*parser->p == '.' && (isalpha((unsigned char)parser->p[1]) || parser->p[1] == '_')) {
+        parser->p++;
+        while (isalnum((unsigned char)*parser->p) || *parser->p == '_') parser->p++;
+    }
+    int len = parser->p - start;
+
+    skip_spaces(parser);
+    ExprKind kind = EXPR_NAME;
+    if (*parser->p == '(') kind = EXPR_CALL;
+    else if (*parser->p == '[') kind = EXPR_INDEX;
+    ExprNode *node = new_node(parser, kind);
+    if (!node) return NULL;
+
+    node->name = (char*)malloc(len + 1);
+    if (!node->name) {
+        parser->error = 1;
+        return node;
+    }
+    memcpy(node->name, start, len);
+    node->name[len] = '\0';
+
+    if (node->kind == EXPR_INDEX) {
+        parser->p++;  // '['
+        node->left = parse_or(parser);
+        skip_spaces(parser);
+        if (!node->left || *parser->p != ']') {
+            parser->error = 1;
+            return node;
+        }
+        parser->p++;
+        // grid[y][x]: los índices siguientes van en args
+        skip_spaces(parser);
+        while (*parser->p == '[') {
+            parser->p++;
+            ExprNode *index = parse_or(parser);
+            skip_spaces(parser);
+            if (!index || *parser->p != ']' || add_argument(node, index) != 0) {
+                expr_free(index);
+                parser->error = 1;
+                return node;
+            }
+            parser->p++;
+            skip_spaces(parser);
+        }
+        return node;
+    }
+
+    if (node->kind == EXPR_CALL) {
+        parser->p++;  // '('
+        skip_spaces(parser);
+        if (*parser->p == ')') {
+            parser->p++;
+            return node;
+        }
+        while (!parser->error) {
+            ExprNode *arg = parse_or(parser);
+            if (!arg || add_argument(node, arg) != 0) {
+                expr_free(arg);
+                parser->error = 1;
+                break;
+            }
+            skip_spaces(parser);
+            if (*parser->p == ',') {
+                parser->p++;
+            } else if (*parser->p == ')') {
+                parser->p++;
+                break;
+            } else {
+                parser->error = 1;
+            }
+        }
+    }
+    return node;
+}
+
+static ExprNode *parse_primary(ExprParser *parser) {
+    skip_spaces(parser);
+    char c = *parser->p;
+
+    if (c == '(') {
+        parser->p++;
+        ExprNode *inner = parse_or(parser);
+        skip_spaces(parser);
+        if (*parser->p != ')') {
+            parser->error = 1;
+            return inner;
+        }
+        parser->p++;
+        return inner;
+    }
+    if (isdigit((unsigned char)c) || (c == '.' && isdigit((unsigned char)parser->p[1]))) {
+        return parse_number(parser);
+    }
+    if (isalpha((unsigned char)c) || c == '_') {
+        return parse_name(parser);
+    }
+
+    parser->error = 1;
+    return NULL;
+}
+
+static ExprNode *parse_unary(ExprParser *parser) {
+    skip_spaces(parser);
+    char c = *parser->p;
+    if (c == '-' || c == '+' || (c == '!' && parser->p[1] != '=')) {
+        parser->p++;
+        ExprNode *node = new_node(parser, EXPR_UNARY);
+        if (!node) return NULL;
+        node->op = c;
+        node->left = parse_unary(parser);
+        if (!node->left) parser->error = 1;
+        return node;
+    }
+    return parse_primary(parser);
+}
+
+static ExprNode *parse_multiplicative(ExprParser *parser) {
+    ExprNode *left = parse_unary(parser);
+    while (!parser->error) {
+        skip_spaces(parser);
+        char c = *parser->p;
+        if (c != '*' && c != '/' && c != '%') break;
+        parser->p++;
+
+        ExprNode *node = new_node(parser, EXPR_BINARY);
+        if (!node) break;
+        node->op = c;
+        node->left = left;
+        node->right = parse_unary(parser);
+        if (!node->right) parser->error = 1;
+        left = node;
+    }
+    return left;
+}
+
+static ExprNode *parse_additive(ExprParser *parser) {
+    ExprNode *left = parse_multiplicative(parser);
+    while (!parser->error) {
+        skip_spaces(parser);
+        char c = *parser->p;
+        if (c != '+' && c != '-') break;
+        parser->p++;
+
+        ExprNode *node = new_node(parser, EXPR_BINARY);
+        if (!node) break;
+        node->op = c;
+        node->left = left;
+        node->right = parse_multiplicative(parser);
+        if (!node->right) parser->error = 1;
+        left = node;
+    }
+    return left;
+}
+
+// Lee un operador de comparación en la posición actual. 0 si no hay.
+static char match_comparison(ExprParser *parser, int equality) {
+    const char *p = parser->p;
+    char op = 0;
+    int len = 1;
+
+    if (equality) {
+        if (p[0] == '=' && p[1] == '=') { op = EXPR_OP_EQ; len = 2; }
+        else if (p[0] == '!' && p[1] == '=') { op = EXPR_OP_NE; len = 2; }
+    } else if (p[0] == '<' || p[0] == '>') {
+        op = p[0];
+        if (p[1] == '=') {
+            op = p[0] == '<' ? EXPR_OP_LE : EXPR_OP_GE;
+            len = 2;
+        }
+    }
+
+    if (op) parser->p += len;
+    return op;
+}
+
+static ExprNode *new_binary(ExprParser *parser, char op, ExprNode *left, ExprNode *right) {
+    ExprNode *node = new_node(parser, EXPR_BINARY);
+    if (!node) {
+        expr_free(left);
+        expr_free(right);
+        return NULL;
+    }
+    node->op = op;
+    node->left = left;
+    node->right = right;
+    if (!left || !right) parser->error = 1;
+    return node;
+}
+
+static ExprNode *parse_relational(ExprParser *parser) {
+    ExprNode *left = parse_additive(parser);
+    while (!parser->error) {
+        skip_spaces(parser);
+        char op = match_comparison(parser, 0);
+        if (!op) break;
+        left = new_binary(parser, op, left, parse_additive(parser));
+    }
+    return left;
+}
+
+static ExprNode *parse_equality(ExprParser *parser) {
+    ExprNode *left = parse_relational(parser);
+    while (!parser->error) {
+        skip_spaces(parser);
+        char op = match_comparison(parser, 1);
+        if (!op) break;
+        left = new_binary(parser, op, left, parse_relational(parser));
+    }
+    return left;
+}
+
+static ExprNode *parse_and(ExprParser *parser) {
+    ExprNode *left = parse_equality(parser);
+    while (!parser->error) {
+        skip_spaces(parser);
+        if (parser->p[0] != '&' || parser->p[1] != '&') break;
+        parser->p += 2;
+        left = new_binary(parser, EXPR_OP_AND, left, parse_equality(parser));
+    }
+    return left;
+}
+
+static ExprNode *parse_or(ExprParser *parser) {
+    ExprNode *left = parse_and(parser);
+    while (!parser->error) {
+        skip_spaces(parser);
+        if (parser->p[0] != '|' || parser->p[1] != '|') break;
+        parser->p += 2;
+        left = new_binary(parser, EXPR_OP_OR, left, parse_and(parser));
+    }
+    return left;
+}
+
+int expr_is_comparison(char op) {
+    return op == '<' || op == '>' || op == EXPR_OP_LE || op == EXPR_OP_GE ||
+           op == EXPR_OP_EQ || op == EXPR_OP_NE;
+}
+
+int expr_is_logical(char op) {
+    return op == EXPR_OP_AND || op == EXPR_OP_OR;
+}
+
+ExprNode *expr_parse(const char *src, const char **end) {
+    ExprParser parser = {src, 0};
+    ExprNode *root = parse_or(&parser);
+    skip_spaces(&parser);
+
+    if (end) *end = parser.p;
+    if (parser.error || !root) {
+        expr_free(root);
+        return NULL;
+    }
+    return root;
+}
+
+void expr_free(ExprNode *node) {
+    if (!node) return;
+    expr_free(node->left);
+    expr_free(node->right);
+    for (int i = 0; i < node->arg_count; i++) {
+        expr_free(node->args[i]);
+    }
+    free(node->args);
+    free(node->name);
+    free(node);
+}
@@ -0,0 +1,49 @@
+#ifndef EXPR_H
+#define EXPR_H
+
+#include <stdint.h>
+
+// Árbol de expresiones del lenguaje: literales, nombres, acceso a arrays,
+// operadores unarios/binarios y llamadas a función.
+
+typedef enum {
+    EXPR_NUMBER,
+    EXPR_NAME,
+    EXPR_UNARY,     // op: '-', '+', '!'
+    EXPR_BINARY,    // op: aritméticos, comparaciones y lógicos (ver EXPR_OP_*)
+    EXPR_CALL,
+    EXPR_INDEX      // name[left], o name[left][args[0]]... con varias dimensiones
+} ExprKind;
+
+// Operadores de dos caracteres; el resto se representa con su propio carácter
+// ('+', '-', '*', '/', '%', '<', '>')
+#define EXPR_OP_LE  'l'     // <=
+#define EXPR_OP_GE  'g'     // >=
+#define EXPR_OP_EQ  'e'     // ==
+#define EXPR_OP_NE  'n'     // !=
+#define EXPR_OP_AND '&'     // &&
+#define EXPR_OP_OR  '|'     // ||
+
+typedef struct ExprNode {
+    ExprKind kind;
+    char op;
+    double number;
+    int is_int;                 // Literal entero (sin punto ni exponente)
+    int64_t integer;            // Valor exacto del literal entero
+    char *name;                 // EXPR_NAME ("x" u "obj.campo") / EXPR_CALL / EXPR_INDEX
+    struct ExprNode *left;      // Operando (unario), operando izquierdo o índice
+    struct ExprNode *right;
+    struct ExprNode **args;     // Argumentos de EXPR_CALL; índices siguientes de EXPR_INDEX
+    int arg_count;
+} ExprNode;
+
+// Parsea una expresión desde 'src'. Si 'end' no es NULL recibe la posición
+// donde terminó el parseo. Devuelve NULL si hay un error de sintaxis.
+ExprNode *expr_parse(const char *src, const char **end);
+void expr_free(ExprNode *node);
+
+// Comparación (<, <=, >, >=, ==, !=) o lógico (&&, ||): el resultado es 0/1
+int expr_is_comparison(char op);
+int expr_is_logical(char op);
+
+#endif
@@ -55,13 +55,19 @@ FileList* extract_imports(const char *source_file, const char *project_dir) {
                     strcpy(basename, import_file);
                     
                     // Si no tiene extensión, intentar .sblas
-                    if (!strstr(basename, ".bsf") && !strstr(basename, ".sblas")) {
+                    if (!strstr(basename, ".bsf") && !strstr(basename, ".sblas") && !strstr(basename, ".slibgld")) {
                         snprintf(stdlib_path, sizeof(stdlib_path), "%s/stdlib/%s.sblas", cwd, basename);
                         if (access(stdlib_path, F_OK) == 0) {
                             strcpy(full_path, stdlib_path);
                         } else {
-                            // Si no existe, mantener ruta original
-                            snprintf(full_path, sizeof(full_path), "%s/src/%s", project_dir, import_file);
+                            // Intentar con una librería estática precompilada (.slibgld)
+                            snprintf(stdlib_path, sizeof(stdlib_path), "%s/stdlib/%s.slibgld", cwd, basename);
+                            if (access(stdlib_path, F_OK) == 0) {
+                                strcpy(full_path, stdlib_path);
+                            } else {
+                                // Si no existe, mantener ruta original
+                                snprintf(full_path, sizeof(full_path), "%s/src/%s", project_dir, import_file);
+                            }
                         }
                     }
                 }
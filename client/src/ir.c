@@ -0,0 +1,260 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "ir.h"
+
+int ir_init(IRProgram *ir) {
+    ir->functions = NULL;
+    ir->count = 0;
+    ir->current = 0;
+
+    // La función 0 recibe el código de nivel superior y el cuerpo de main()
+    return ir_begin_function(ir, "main", -1, -1) == 0 ? 0 : -1;
+}
+
+void ir_free(IRProgram *ir) {
+    for (int i = 0; i < ir->count; i++) {
+        IRFunction *fn = &ir->functions[i];
+        for (int j = 0; j < fn->block_count; j++) {
+            free(fn->blocks[j].instrs);
+        }
+        free(fn->blocks);
+        free(fn->name);
+    }
+    free(ir->functions);
+    ir->functions = NULL;
+    ir->count = 0;
+}
+
+int ir_begin_function(IRProgram *ir, const char *name, int class_index, int method_index) {
+    IRFunction *temp = realloc(ir->functions, (ir->count + 1) * sizeof(IRFunction));
+    if (!temp) return -1;
+    ir->functions = temp;
+
+    IRFunction *fn = &ir->functions[ir->count];
+    memset(fn, 0, sizeof(IRFunction));
+    fn->name = (char*)malloc(strlen(name) + 1);
+    if (!fn->name) return -1;
+    strcpy(fn->name, name);
+    fn->class_index = class_index;
+    fn->method_index = method_index;
+
+    ir->current = ir->count++;
+    if (ir_new_block(ir) < 0) return -1;
+    return ir->current;
+}
+
+void ir_set_function(IRProgram *ir, int function) {
+    if (function >= 0 && function < ir->count) {
+        ir->current = function;
+    }
+}
+
+int ir_new_block(IRProgram *ir) {
+    IRFunction *fn = &ir->functions[ir->current];
+    IRBlock *temp = realloc(fn->blocks, (fn->block_count + 1) * sizeof(IRBlock));
+    if (!temp) return -1;
+    fn->blocks = temp;
+
+    memset(&fn->blocks[fn->block_count], 0, sizeof(IRBlock));
+    fn->current_block = fn->block_count;
+    return fn->block_count++;
+}
+
+void ir_set_block(IRProgram *ir, int block) {
+    IRFunction *fn = &ir->functions[ir->current];
+    if (block >= 0 && block < fn->block_count) {
+        fn->current_block = block;
+    }
+}
+
+int ir_add_local(IRProgram *ir, char type) {
+    IRFunction *fn = &ir->functions[ir->current];
+    if (fn->local_count >= IR_MAX_LOCALS) return -1;
+    fn->local_types[fn->local_count] = type;
+    return fn->local_count++;
+}
+
+int ir_emit(IRProgram *ir, IRInstr instr) {
+    IRFunction *fn = &ir->functions[ir->current];
+    IRBlock *block = &fn->blocks[fn->current_block];
+
+    if (block->count >= block->capacity) {
+        int capacity = block->capacity ? block->capacity * 2 : 16;
+        IRInstr *temp = realloc(block->instrs, capacity * sizeof(IRInstr));
+        if (!temp) {
+            fprintf(stderr, "Error: No hay memoria suficiente\n");
+            return -1;
+        }
+        block->instrs = temp;
+        block->capacity = capacity;
+    }
+    block->instrs[block->count] = instr;
+    return block->count++;
+}
+
+IROperandKind ir_operand_kind(uint8_t opcode) {
+    switch (opcode) {
+        case OPCODE_PRINT:
+        case OPCODE_PRINTLN:        // Salvo PRINTLN de un valor del stack (arg1 ficticio)
+        case OPCODE_PUSH_VALUE:
+        case OPCODE_PUSH_I64:
+        case OPCODE_FORMAT_PRINT:
+            return IR_OPERAND_STRING;
+        case OPCODE_GET_GLOBAL:
+        case OPCODE_ARRAY_DECL:
+        case OPCODE_ARRAY_SET:
+        case OPCODE_ARRAY_GET:
+        case OPCODE_ARRAY_SET_I64:
+        case OPCODE_ARRAY_GET_I64:
+        case OPCODE_ARRAY_SET_INT:
+        case OPCODE_ARRAY_GET_INT:
+        case OPCODE_ARRAY_PUSH:
+        case OPCODE_ARRAY_POP:
+        case OPCODE_ARRAY_RESERVE:
+        case OPCODE_ARRAY_RESIZE:
+        case OPCODE_ARRAY_COPY:
+        case OPCODE_ARRAY_FILL:
+        case OPCODE_ARRAY_ADD:
+        case OPCODE_ARRAY_MUL:
+        case OPCODE_ARRAY_SCALE:
+        case OPCODE_ARRAY_AXPY:
+        case OPCODE_ARRAY_SUM:
+        case OPCODE_ARRAY_MIN:
+        case OPCODE_ARRAY_MAX:
+        case OPCODE_ARRAY_DOT:
+        case OPCODE_ARRAY_SORT:
+        case OPCODE_ARRAY_SORT_DESC:
+        case OPCODE_ARRAY_SEARCH:
+        case OPCODE_ARRAY_UNIQUE:
+        case OPCODE_ARRAY_ROW:
+        case OPCODE_ARRAY_COL:
+        case OPCODE_ARRAY_SLICE:
+        case OPCODE_ARRAY_NEW:
+        case OPCODE_ARRAY_LEN:
+        case OPCODE_ARRAY_CLEAR:
+        case OPCODE_GET_FIELD:
+        case OPCODE_SET_FIELD:
+            return IR_OPERAND_GLOBAL;
+        case OPCODE_NEW_INSTANCE:
+        case OPCODE_CALL_METHOD:
+            return IR_OPERAND_CLASS;
+        case OPCODE_LOAD_LOCAL:
+        case OPCODE_STORE_LOCAL:
+        case OPCODE_PARALLEL_FOR:
+        case OPCODE_PARALLEL_END:
+            return IR_OPERAND_LOCAL;
+        default:
+            return IR_OPERAND_NONE;
+    }
+}
+
+int ir_second_global(uint8_t opcode) {
+    return opcode == OPCODE_ARRAY_COPY || opcode == OPCODE_ARRAY_ADD || opcode == OPCODE_ARRAY_MUL ||
+           opcode == OPCODE_ARRAY_AXPY || opcode == OPCODE_ARRAY_DOT || opcode == OPCODE_ARRAY_ROW ||
+           opcode == OPCODE_ARRAY_COL || opcode == OPCODE_ARRAY_SLICE;
+}
+
+int ir_is_jump(uint8_t opcode) {
+    return (opcode >= OPCODE_JUMP_UNLESS_EQ_I64 && opcode <= OPCODE_JUMP_UNLESS_GE_F64) ||
+           opcode == OPCODE_JUMP || opcode == OPCODE_JUMP_IF_FALSE || opcode == OPCODE_LOOP;
+}
+
+int ir_instruction_count(const IRProgram *ir) {
+    int total = 0;
+    for (int i = 0; i < ir->count; i++) {
+        for (int j = 0; j < ir->functions[i].block_count; j++) {
+            total += ir->functions[i].blocks[j].count;
+        }
+    }
+    return total;
+}
+
+static int lower_instruction(const IRFunction *fn, IRInstr instr, CodeBuffer *code) {
+    if (instr.arg1 < 0 || instr.arg1 > 0xFF || instr.arg2 < 0 || instr.arg2 > 0xFF) {
+        fprintf(stderr, "Error: Operando fuera de rango en '%s' (opcode 0x%02X, %d, %d)\n",
+                fn->name, instr.opcode, instr.arg1, instr.arg2);
+        return -1;
+    }
+
+    Instruction out = {instr.opcode, (uint8_t)instr.arg1, (uint8_t)instr.arg2};
+    return emit_instruction(code, out) < 0 ? -1 : 0;
+}
+
+static int lower_function(const IRFunction *fn, CodeBuffer *code) {
+    // Posición final de cada bloque (y del final de la función) para los saltos
+    int *block_start = (int*)malloc((fn->block_count + 1) * sizeof(int));
+    if (!block_start) {
+        fprintf(stderr, "Error: No hay memoria suficiente\n");
+        return -1;
+    }
+    block_start[0] = code->count;
+    for (int b = 0; b < fn->block_count; b++) {
+        block_start[b + 1] = block_start[b] + fn->blocks[b].count;
+    }
+
+    int status = 0;
+    for (int b = 0; b < fn->block_count && status == 0; b++) {
+        const IRBlock *block = &fn->blocks[b];
+        for (int i = 0; i < block->count && status == 0; i++) {
+            IRInstr instr = block->instrs[i];
+            if (ir_is_jump(instr.opcode)) {
+                if (instr.arg1 < 0 || instr.arg1 > fn->block_count) {
+                    fprintf(stderr, "Error: Salto a un bloque inexistente en '%s'\n", fn->name);
+                    status = -1;
+                    break;
+                }
+                int offset = block_start[instr.arg1] - (code->count + 1);
+                if (offset < INT16_MIN || offset > INT16_MAX) {
+                    fprintf(stderr, "Error: Salto demasiado largo en '%s'\n", fn->name);
+                    status = -1;
+                    break;
+                }
+                instr.arg1 = offset & 0xFF;
+                instr.arg2 = (offset >> 8) & 0xFF;
+            }
+            status = lower_instruction(fn, instr, code);
+        }
+    }
+
+    free(block_start);
+    return status;
+}
+
+static const IRInstr *last_instruction(const IRFunction *fn) {
+    for (int b = fn->block_count - 1; b >= 0; b--) {
+        if (fn->blocks[b].count > 0) {
+            return &fn->blocks[b].instrs[fn->blocks[b].count - 1];
+        }
+    }
+    return NULL;
+}
+
+int ir_lower(const IRProgram *ir, CodeBuffer *code, ClassPool *class_pool) {
+    for (int i = 0; i < ir->count; i++) {
+        const IRFunction *fn = &ir->functions[i];
+        int start = code->count;
+
+        if (lower_function(fn, code) != 0) return -1;
+
+        // La entrada no debe caer en el código de los métodos que la siguen, y
+        // cada método vuelve a quien lo llamó aunque no tenga 'return'
+        if ((i == 0 && ir->count > 1) || fn->class_index >= 0) {
+            const IRInstr *last = last_instruction(fn);
+            if (!last || last->opcode != OPCODE_RETURN) {
+                IRInstr ret = {OPCODE_RETURN, 0, 0};
+                if (lower_instruction(fn, ret, code) != 0) return -1;
+            }
+        }
+
+        if (fn->class_index >= 0 && class_pool && fn->class_index < class_pool->count) {
+            ClassDefinition *cls = &class_pool->classes[fn->class_index];
+            if (fn->method_index >= 0 && fn->method_index < cls->method_count) {
+                cls->methods[fn->method_index].start_instruction = start;
+                cls->methods[fn->method_index].instruction_count = code->count - start;
+                cls->methods[fn->method_index].local_count = fn->local_count;
+            }
+        }
+    }
+    return 0;
+}
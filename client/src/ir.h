@@ -0,0 +1,82 @@
+#ifndef IR_H
+#define IR_H
+
+#include <stdint.h>
+#include "compiler.h"
+
+// Representación intermedia lineal: instrucciones de pila con operandos anchos
+// agrupadas en bloques básicos, una función IR por función o método fuente.
+// Todas las pasadas del back-end trabajan sobre esta forma y ir_lower la
+// codifica a instrucciones de 3 bytes al final.
+
+typedef struct {
+    uint8_t opcode;
+    int32_t arg1;
+    int32_t arg2;
+} IRInstr;
+
+typedef struct {
+    IRInstr *instrs;
+    int count;
+    int capacity;
+} IRBlock;
+
+// Slots de frame direccionables con un operando de 8 bits
+#define IR_MAX_LOCALS 256
+
+typedef struct {
+    char *name;          // "main", "funcion" o "Clase.metodo"
+    int class_index;     // Índice en ClassPool (-1 si no es método)
+    int method_index;    // Índice del método dentro de la clase
+    IRBlock *blocks;
+    int block_count;
+    int current_block;   // Bloque donde se emite
+    int local_count;     // Slots de frame asignados a variables locales
+    char local_types[IR_MAX_LOCALS];  // 'i' o 'd' por slot
+} IRFunction;
+
+typedef struct {
+    IRFunction *functions;  // functions[0] es el punto de entrada
+    int count;
+    int current;            // Función donde se emite
+} IRProgram;
+
+int ir_init(IRProgram *ir);
+void ir_free(IRProgram *ir);
+
+int ir_begin_function(IRProgram *ir, const char *name, int class_index, int method_index);
+void ir_set_function(IRProgram *ir, int function);
+int ir_new_block(IRProgram *ir);
+void ir_set_block(IRProgram *ir, int block);
+
+// Reserva un slot de frame en la función actual. -1 si no quedan.
+int ir_add_local(IRProgram *ir, char type);
+
+int ir_emit(IRProgram *ir, IRInstr instr);
+
+// Tabla a la que apunta arg1 de cada opcode (enlazador y pasadas globales).
+// Además, arg2 de NEW_INSTANCE es la global objeto que recibe la instancia.
+typedef enum {
+    IR_OPERAND_NONE,
+    IR_OPERAND_STRING,
+    IR_OPERAND_GLOBAL,
+    IR_OPERAND_CLASS,
+    IR_OPERAND_LOCAL        // Slot del frame de la función
+} IROperandKind;
+
+IROperandKind ir_operand_kind(uint8_t opcode);
+
+// Opcodes de arrays cuyo arg2 es otra global array (copy, add, mul, axpy, dot
+// y el origen de las vistas)
+int ir_second_global(uint8_t opcode);
+
+// Saltos: en el IR arg1 es el bloque destino dentro de la función; ir_lower lo
+// convierte en un desplazamiento relativo de 16 bits (arg1 | arg2 << 8).
+int ir_is_jump(uint8_t opcode);
+int ir_instruction_count(const IRProgram *ir);
+
+// Codifica el programa en 'code' (entrada primero) y rellena start_instruction /
+// instruction_count de los métodos en class_pool.
+int ir_lower(const IRProgram *ir, CodeBuffer *code, ClassPool *class_pool);
+
+#endif
@@ -0,0 +1,644 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "linker.h"
+
+// Secciones de una librería estática tal como las escribe build_project
+typedef struct {
+    VariablePool vars;
+    ClassPool classes;
+    StringPool strings;
+    Instruction *code;
+    int code_count;
+    uint16_t entry_locals;  // Slots del frame de su entrada
+    char *local_types;      // Tipo de cada local: los de la entrada y luego los
+                            // de cada método en orden (ver LIBRARY_IMAGE_VERSION)
+} StaticLibrary;
+
+static int read_exact(FILE *f, void *dst, size_t len) {
+    return fread(dst, 1, len, f) == len ? 0 : -1;
+}
+
+// Lee un string con prefijo de longitud de 8 bits
+static char* read_short_string(FILE *f) {
+    uint8_t len = 0;
+    if (read_exact(f, &len, 1) != 0) return NULL;
+
+    char *str = (char*)malloc(len + 1);
+    if (!str) return NULL;
+    if (read_exact(f, str, len) != 0) {
+        free(str);
+        return NULL;
+    }
+    str[len] = '\0';
+    return str;
+}
+
+// Lee un string con prefijo de longitud de 16 bits
+static char* read_long_string(FILE *f) {
+    uint16_t len = 0;
+    if (read_exact(f, &len, sizeof(uint16_t)) != 0) return NULL;
+
+    char *str = (char*)malloc(len + 1);
+    if (!str) return NULL;
+    if (read_exact(f, str, len) != 0) {
+        free(str);
+        return NULL;
+    }
+    str[len] = '\0';
+    return str;
+}
+
+static int skip_short_string(FILE *f) {
+    char *str = read_short_string(f);
+    if (!str) return -1;
+    free(str);
+    return 0;
+}
+
+static int skip_window_config(FILE *f) {
+    uint8_t buffer[5];
+
+    if (skip_short_string(f) != 0) return -1;       // window_title
+    if (read_exact(f, buffer, 5) != 0) return -1;   // width, height, resizable
+    if (skip_short_string(f) != 0) return -1;       // window_mode
+    if (skip_short_string(f) != 0) return -1;       // renderer
+    if (read_exact(f, buffer, 2) != 0) return -1;   // fps
+    return 0;
+}
+
+static int read_globals(FILE *f, VariablePool *vars) {
+    uint16_t count = 0;
+    if (read_exact(f, &count, sizeof(uint16_t)) != 0) return -1;
+
+    vars->vars = (GlobalVariable*)calloc(count ? count : 1, sizeof(GlobalVariable));
+    if (!vars->vars) return -1;
+
+    for (int i = 0; i < count; i++) {
+        GlobalVariable *var = &vars->vars[i];
+        var->name = read_short_string(f);
+        if (!var->name) return -1;
+        vars->count++;
+
+        uint8_t type = 0;
+        if (read_exact(f, &type, 1) != 0) return -1;
+        var->type = type;
+
+        if (type == 's') {
+            var->str_val = read_long_string(f);
+            if (!var->str_val) return -1;
+        } else if (type == 'a') {
+            uint8_t dims = 1;
+            if (read_exact(f, &var->array_element_type, 1) != 0 ||
+                read_exact(f, &var->array_size, sizeof(int)) != 0) return -1;
+            var->array_shape[0] = var->array_size;
+            if ((uint8_t)var->array_element_type & ARRAY_SHAPED) {
+                var->array_element_type = (char)((uint8_t)var->array_element_type & ~ARRAY_SHAPED);
+                if (read_exact(f, &dims, 1) != 0 || dims < 2 || dims > ARRAY_MAX_DIMS ||
+                    read_exact(f, var->array_shape, dims * sizeof(int)) != 0) return -1;
+            }
+            var->array_dims = dims;
+        } else if (type == 'b') {
+            if (read_exact(f, &var->array_element_type, 1) != 0) return -1;
+        } else if (type == 'o') {
+            uint16_t class_index = 0;
+            if (read_exact(f, &class_index, sizeof(uint16_t)) != 0) return -1;
+            var->value = class_index;
+        } else {
+            if (read_exact(f, &var->value, sizeof(double)) != 0) return -1;
+            if (type == 'i') var->int_value = (int64_t)var->value;
+        }
+    }
+    return 0;
+}
+
+static int read_classes(FILE *f, ClassPool *classes) {
+    uint16_t count = 0;
+    if (read_exact(f, &count, sizeof(uint16_t)) != 0) return -1;
+
+    classes->classes = (ClassDefinition*)calloc(count ? count : 1, sizeof(ClassDefinition));
+    if (!classes->classes) return -1;
+
+    for (int i = 0; i < count; i++) {
+        ClassDefinition *cls = &classes->classes[i];
+        cls->name = read_short_string(f);
+        if (!cls->name) return -1;
+        classes->count++;
+
+        uint8_t ivar_count = 0;
+        if (read_exact(f, &ivar_count, 1) != 0) return -1;
+        if (ivar_count > 0) {
+            cls->var_names = (char**)calloc(ivar_count, sizeof(char*));
+            cls->var_types = (uint8_t*)calloc(ivar_count, sizeof(uint8_t));
+            if (!cls->var_names || !cls->var_types) return -1;
+        }
+        for (int j = 0; j < ivar_count; j++) {
+            cls->var_names[j] = read_short_string(f);
+            if (!cls->var_names[j]) return -1;
+            cls->var_count++;
+            if (read_exact(f, &cls->var_types[j], 1) != 0) return -1;
+        }
+
+        uint8_t method_count = 0;
+        if (read_exact(f, &method_count, 1) != 0) return -1;
+        if (method_count > 0) {
+            cls->methods = (ClassMethod*)calloc(method_count, sizeof(ClassMethod));
+            if (!cls->methods) return -1;
+        }
+        for (int j = 0; j < method_count; j++) {
+            ClassMethod *method = &cls->methods[j];
+            method->name = read_short_string(f);
+            if (!method->name) return -1;
+            cls->method_count++;
+
+            uint8_t param_count = 0;
+            uint16_t local_count = 0;
+            if (read_exact(f, &method->is_public, 1) != 0 ||
+                read_exact(f, &method->start_instruction, sizeof(int)) != 0 ||
+                read_exact(f, &method->instruction_count, sizeof(int)) != 0 ||
+                read_exact(f, &param_count, 1) != 0 ||
+                read_exact(f, &local_count, sizeof(uint16_t)) != 0) return -1;
+            method->param_count = param_count;
+            method->local_count = local_count;
+        }
+    }
+    return 0;
+}
+
+static int read_strings(FILE *f, StringPool *strings) {
+    uint16_t count = 0;
+    if (read_exact(f, &count, sizeof(uint16_t)) != 0) return -1;
+
+    strings->strings = (char**)calloc(count ? count : 1, sizeof(char*));
+    if (!strings->strings) return -1;
+
+    for (int i = 0; i < count; i++) {
+        strings->strings[i] = read_long_string(f);
+        if (!strings->strings[i]) return -1;
+        strings->count++;
+    }
+    return 0;
+}
+
+static int read_code(FILE *f, StaticLibrary *lib) {
+    Instruction instr;
+    int capacity = 0;
+
+    while (fread(&instr, sizeof(Instruction), 1, f) == 1) {
+        if (lib->code_count >= capacity) {
+            capacity = capacity ? capacity * 2 : 64;
+            Instruction *temp = realloc(lib->code, capacity * sizeof(Instruction));
+            if (!temp) return -1;
+            lib->code = temp;
+        }
+        lib->code[lib->code_count++] = instr;
+    }
+    return 0;
+}
+
+static void free_library(StaticLibrary *lib) {
+    for (int i = 0; i < lib->vars.count; i++) {
+        free(lib->vars.vars[i].name);
+        free(lib->vars.vars[i].str_val);
+    }
+    free(lib->vars.vars);
+
+    for (int i = 0; i < lib->classes.count; i++) {
+        ClassDefinition *cls = &lib->classes.classes[i];
+        free(cls->name);
+        for (int j = 0; j < cls->var_count; j++) {
+            free(cls->var_names[j]);
+        }
+        free(cls->var_names);
+        free(cls->var_types);
+        for (int j = 0; j < cls->method_count; j++) {
+            free(cls->methods[j].name);
+        }
+        free(cls->methods);
+    }
+    free(lib->classes.classes);
+
+    for (int i = 0; i < lib->strings.count; i++) {
+        free(lib->strings.strings[i]);
+    }
+    free(lib->strings.strings);
+    free(lib->code);
+    free(lib->local_types);
+}
+
+// Valor exacto de las globales enteras (versión 3); antes, el del double
+static int read_int_globals(FILE *f, uint8_t version, VariablePool *vars) {
+    for (int i = 0; version >= 3 && i < vars->count; i++) {
+        if (vars->vars[i].type == 'i' && read_exact(f, &vars->vars[i].int_value, sizeof(int64_t)) != 0) return -1;
+    }
+    return 0;
+}
+
+// Tipos de las locales: leídos desde la versión 2, double en las anteriores
+static int read_local_types(FILE *f, uint8_t version, StaticLibrary *lib) {
+    size_t count = lib->entry_locals;
+    for (int i = 0; i < lib->classes.count; i++) {
+        for (int j = 0; j < lib->classes.classes[i].method_count; j++) {
+            count += lib->classes.classes[i].methods[j].local_count;
+        }
+    }
+    lib->local_types = (char*)malloc(count + 1);
+    if (!lib->local_types) return -1;
+    memset(lib->local_types, 'd', count);
+    return version >= 2 ? read_exact(f, lib->local_types, count) : 0;
+}
+
+static int load_library(const char *lib_file, StaticLibrary *lib) {
+    FILE *f = fopen(lib_file, "rb");
+    if (!f) {
+        fprintf(stderr, "Error: No se puede abrir librería '%s'\n", lib_file);
+        return -1;
+    }
+
+    char header[4];
+    uint8_t version = 0;
+    if (read_exact(f, header, 4) != 0 || strncmp(header, "GOLD", 4) != 0 ||
+        read_exact(f, &version, 1) != 0) {
+        fprintf(stderr, "Error: '%s' no es una librería válida (header incorrecto)\n", lib_file);
+        fclose(f);
+        return -1;
+    }
+
+    if (skip_window_config(f) != 0 || read_globals(f, &lib->vars) != 0 ||
+        read_classes(f, &lib->classes) != 0 || read_strings(f, &lib->strings) != 0 ||
+        read_exact(f, &lib->entry_locals, sizeof(uint16_t)) != 0 ||
+        read_local_types(f, version, lib) != 0 || read_int_globals(f, version, &lib->vars) != 0 ||
+        read_code(f, lib) != 0) {
+        fprintf(stderr, "Error: Librería '%s' truncada o corrupta\n", lib_file);
+        fclose(f);
+        return -1;
+    }
+
+    fclose(f);
+    return 0;
+}
+
+static int find_string(const StringPool *pool, const char *str) {
+    for (int i = 0; i < pool->count; i++) {
+        if (strcmp(pool->strings[i], str) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static int append_string(StringPool *pool, const char *str) {
+    char **temp = realloc(pool->strings, (pool->count + 1) * sizeof(char*));
+    if (!temp) return -1;
+
+    pool->strings = temp;
+    pool->strings[pool->count] = (char*)malloc(strlen(str) + 1);
+    if (!pool->strings[pool->count]) return -1;
+
+    strcpy(pool->strings[pool->count], str);
+    return pool->count++;
+}
+
+static char* copy_string(const char *str) {
+    char *copy = (char*)malloc(strlen(str) + 1);
+    if (copy) strcpy(copy, str);
+    return copy;
+}
+
+static int merge_strings(const StaticLibrary *lib, StringPool *pool, int *map) {
+    for (int i = 0; i < lib->strings.count; i++) {
+        int idx = find_string(pool, lib->strings.strings[i]);
+        if (idx < 0) idx = append_string(pool, lib->strings.strings[i]);
+        if (idx < 0) return -1;
+        map[i] = idx;
+    }
+    return 0;
+}
+
+// Se enlaza después de las clases: las globales objeto guardan un índice de clase
+static int merge_globals(const StaticLibrary *lib, VariablePool *pool, const int *class_map, int *map) {
+    for (int i = 0; i < lib->vars.count; i++) {
+        const GlobalVariable *var = &lib->vars.vars[i];
+        double value = var->value;
+        if (var->type == 'o') {
+            int cls = (int)var->value;
+            if (cls < 0 || cls >= lib->classes.count) {
+                fprintf(stderr, "Error: La global '%s' de la librería apunta a una clase inexistente\n", var->name);
+                return -1;
+            }
+            value = class_map[cls];
+        }
+
+        int idx = var_pool_find(pool, var->name, -1);
+
+        if (idx >= 0) {
+            if (pool->vars[idx].type != var->type || (var->type == 'o' && pool->vars[idx].value != value)) {
+                fprintf(stderr, "Error: La global '%s' de la librería choca con otra de distinto tipo\n", var->name);
+                return -1;
+            }
+            map[i] = idx;
+            continue;
+        }
+
+        GlobalVariable *temp = realloc(pool->vars, (pool->count + 1) * sizeof(GlobalVariable));
+        if (!temp) return -1;
+        pool->vars = temp;
+
+        GlobalVariable *copy = &pool->vars[pool->count];
+        *copy = *var;
+        copy->value = value;
+        copy->name = copy_string(var->name);
+        copy->str_val = var->str_val ? copy_string(var->str_val) : NULL;
+        if (!copy->name) return -1;
+
+        // La librería ya contiene su propio ARRAY_NEW; el host no debe volver a emitirlo
+        if (copy->type == 'b') copy->dynamic_array_size = -1;
+
+        map[i] = pool->count++;
+    }
+    return 0;
+}
+
+// added[i] indica si la clase i es nueva; si ya existía, manda la definición del host
+static int merge_classes(const StaticLibrary *lib, ClassPool *pool, int *map, uint8_t *added) {
+    for (int i = 0; i < lib->classes.count; i++) {
+        const ClassDefinition *cls = &lib->classes.classes[i];
+
+        int idx = class_pool_find(pool, cls->name, -1);
+
+        if (idx >= 0) {
+            if (pool->classes[idx].var_count != cls->var_count) {
+                fprintf(stderr, "Error: La clase '%s' de la librería no coincide con la del programa\n", cls->name);
+                return -1;
+            }
+            map[i] = idx;
+            added[i] = 0;
+            continue;
+        }
+
+        ClassDefinition *temp = realloc(pool->classes, (pool->count + 1) * sizeof(ClassDefinition));
+        if (!temp) return -1;
+        pool->classes = temp;
+
+        ClassDefinition *copy = &pool->classes[pool->count];
+        memset(copy, 0, sizeof(ClassDefinition));
+        copy->name = copy_string(cls->name);
+        if (!copy->name) return -1;
+
+        if (cls->var_count > 0) {
+            copy->var_names = (char**)malloc(cls->var_count * sizeof(char*));
+            copy->var_types = (uint8_t*)malloc(cls->var_count * sizeof(uint8_t));
+            if (!copy->var_names || !copy->var_types) return -1;
+            for (int j = 0; j < cls->var_count; j++) {
+                copy->var_names[j] = copy_string(cls->var_names[j]);
+                copy->var_types[j] = cls->var_types[j];
+            }
+            copy->var_count = cls->var_count;
+        }
+
+        if (cls->method_count > 0) {
+            copy->methods = (ClassMethod*)malloc(cls->method_count * sizeof(ClassMethod));
+            if (!copy->methods) return -1;
+            for (int j = 0; j < cls->method_count; j++) {
+                ClassMethod *method = &copy->methods[j];
+                *method = cls->methods[j];
+                method->name = copy_string(cls->methods[j].name);
+
+                // ir_lower asigna la posición definitiva del método
+                method->start_instruction = 0;
+                method->instruction_count = 0;
+            }
+            copy->method_count = cls->method_count;
+        }
+
+        added[i] = 1;
+        map[i] = pool->count++;
+    }
+    return 0;
+}
+
+static int relocate_operand(int32_t *operand, const int *map, int map_count, const char *kind, const char *lib_file) {
+    if (*operand < 0 || *operand >= map_count) {
+        fprintf(stderr, "Error: Índice de %s %d fuera de rango en '%s'\n", kind, *operand, lib_file);
+        return -1;
+    }
+    *operand = map[*operand];
+    return 0;
+}
+
+// Si la clase ya existía en el programa, su tabla de métodos manda: el slot
+// de la librería se traduce por nombre al slot del programa.
+static int relocate_method_slot(const StaticLibrary *lib, ClassPool *pool, int lib_class, int class_idx,
+                                int32_t *slot, const char *lib_file) {
+    const ClassDefinition *cls = &lib->classes.classes[lib_class];
+    if (*slot < 0 || *slot >= cls->method_count) {
+        fprintf(stderr, "Error: Slot de método %d fuera de rango en '%s'\n", *slot, lib_file);
+        return -1;
+    }
+
+    int target = class_find_method(&pool->classes[class_idx], cls->methods[*slot].name, -1);
+    if (target < 0) {
+        fprintf(stderr, "Error: La clase '%s' del programa no define el método '%s' que usa '%s'\n",
+                cls->name, cls->methods[*slot].name, lib_file);
+        return -1;
+    }
+    *slot = target;
+    return 0;
+}
+
+// Asigna cada instrucción de la librería a la función IR donde debe emitirse:
+// el código de los métodos de clases nuevas va a su propia función, el resto a
+// la función actual. -1 = descartar.
+static int assign_owners(const StaticLibrary *lib, IRProgram *ir, const int *class_map,
+                         const uint8_t *class_added, int *owner) {
+    int entry = ir->current;
+    const char *types = lib->local_types + lib->entry_locals;
+
+    for (int pc = 0; pc < lib->code_count; pc++) {
+        // El RETURN de la librería terminaría el programa host: se descarta al enlazar
+        owner[pc] = lib->code[pc].opcode == OPCODE_RETURN ? -1 : entry;
+    }
+
+    for (int i = 0; i < lib->classes.count; i++) {
+        const ClassDefinition *cls = &lib->classes.classes[i];
+        for (int j = 0; j < cls->method_count; j++) {
+            const ClassMethod *method = &cls->methods[j];
+            const char *method_types = types;
+            types += method->local_count;
+            int start = method->start_instruction;
+            int end = start + method->instruction_count;
+            if (method->instruction_count <= 0 || start < 0 || end > lib->code_count) continue;
+
+            int fn = -1;
+            if (class_added[i]) {
+                char name[512];
+                snprintf(name, sizeof(name), "%s.%s", cls->name, method->name);
+                fn = ir_begin_function(ir, name, class_map[i], j);
+                if (fn < 0) return -1;
+                ir->functions[fn].local_count = method->local_count;
+                memcpy(ir->functions[fn].local_types, method_types, method->local_count);
+            }
+            for (int pc = start; pc < end; pc++) {
+                owner[pc] = fn;
+            }
+        }
+    }
+
+    ir_set_function(ir, entry);
+    return 0;
+}
+
+// Los saltos de la librería llegan como desplazamientos relativos; en la IR
+// apuntan a bloques. Cada destino abre un bloque nuevo en la función dueña.
+typedef struct {
+    int target_fn;      // Función que salta a esta instrucción (-1 = no es destino)
+    int block;          // Bloque IR que empieza aquí
+    int jump_block;     // Posición IR del salto emitido desde esta instrucción
+    int jump_index;
+} JumpLink;
+
+static int mark_jump_targets(const StaticLibrary *lib, const int *owner, JumpLink *jumps, const char *lib_file) {
+    for (int pc = 0; pc <= lib->code_count; pc++) {
+        jumps[pc].target_fn = -1;
+        jumps[pc].block = -1;
+        jumps[pc].jump_index = -1;
+    }
+    for (int pc = 0; pc < lib->code_count; pc++) {
+        Instruction instr = lib->code[pc];
+        if (owner[pc] < 0 || !ir_is_jump(instr.opcode)) continue;
+
+        int target = pc + 1 + (int16_t)(instr.arg1 | (instr.arg2 << 8));
+        if (target < 0 || target > lib->code_count) {
+            fprintf(stderr, "Error: Salto fuera del código en '%s' (PC %d)\n", lib_file, pc);
+            return -1;
+        }
+        jumps[target].target_fn = owner[pc];
+    }
+    return 0;
+}
+
+int link_static_library(const char *lib_file, IRProgram *ir, StringPool *string_pool,
+                        VariablePool *var_pool, ClassPool *class_pool) {
+    StaticLibrary lib;
+    memset(&lib, 0, sizeof(lib));
+
+    if (load_library(lib_file, &lib) != 0) {
+        free_library(&lib);
+        return EXIT_FAILURE;
+    }
+
+    if ((lib.vars.count > 0 && !var_pool) || (lib.classes.count > 0 && !class_pool)) {
+        fprintf(stderr, "Error: La librería '%s' define globales o clases y no hay tabla destino\n", lib_file);
+        free_library(&lib);
+        return EXIT_FAILURE;
+    }
+
+    int *string_map = (int*)malloc((lib.strings.count + 1) * sizeof(int));
+    int *var_map = (int*)malloc((lib.vars.count + 1) * sizeof(int));
+    int *class_map = (int*)malloc((lib.classes.count + 1) * sizeof(int));
+    uint8_t *class_added = (uint8_t*)calloc(lib.classes.count + 1, 1);
+    int *owner = (int*)malloc((lib.code_count + 1) * sizeof(int));
+    JumpLink *jumps = (JumpLink*)malloc((lib.code_count + 1) * sizeof(JumpLink));
+    int entry = ir->current;
+    int linked = 0;
+    int status = EXIT_FAILURE;
+
+    // Las locales de la entrada de la librería van detrás de las del programa
+    int local_base = ir->functions[entry].local_count;
+    if (local_base + lib.entry_locals > IR_MAX_LOCALS) {
+        fprintf(stderr, "Error: Demasiadas variables locales al enlazar '%s'\n", lib_file);
+        goto done;
+    }
+
+    if (!string_map || !var_map || !class_map || !class_added || !owner || !jumps) {
+        fprintf(stderr, "Error: No hay memoria suficiente\n");
+        goto done;
+    }
+
+    if (merge_strings(&lib, string_pool, string_map) != 0 ||
+        (class_pool && merge_classes(&lib, class_pool, class_map, class_added) != 0) ||
+        (var_pool && merge_globals(&lib, var_pool, class_map, var_map) != 0) ||
+        assign_owners(&lib, ir, class_map, class_added, owner) != 0 ||
+        mark_jump_targets(&lib, owner, jumps, lib_file) != 0) {
+        goto done;
+    }
+
+    for (int i = 0; i <= lib.code_count; i++) {
+        if (jumps[i].target_fn >= 0) {
+            ir_set_function(ir, jumps[i].target_fn);
+            jumps[i].block = ir_new_block(ir);
+            if (jumps[i].block < 0) goto done;
+        }
+        if (i == lib.code_count || owner[i] < 0) continue;
+
+        IRInstr instr = {lib.code[i].opcode, lib.code[i].arg1, lib.code[i].arg2};
+        int ok = 0;
+
+        switch (ir_operand_kind(instr.opcode)) {
+            case IR_OPERAND_STRING:
+                // PRINTLN de un valor del stack lleva un arg1 ficticio que no se reubica
+                if (instr.opcode == OPCODE_PRINTLN && instr.arg1 >= lib.strings.count) break;
+                ok = relocate_operand(&instr.arg1, string_map, lib.strings.count, "string", lib_file);
+                break;
+            case IR_OPERAND_GLOBAL:
+                ok = relocate_operand(&instr.arg1, var_map, lib.vars.count, "global", lib_file);
+                if (ok == 0 && ir_second_global(instr.opcode)) {
+                    ok = relocate_operand(&instr.arg2, var_map, lib.vars.count, "global", lib_file);
+                }
+                break;
+            case IR_OPERAND_LOCAL:
+                if (owner[i] == entry) instr.arg1 += local_base;
+                break;
+            case IR_OPERAND_CLASS:
+                ok = relocate_operand(&instr.arg1, class_map, lib.classes.count, "clase", lib_file);
+                if (ok == 0 && instr.opcode == OPCODE_NEW_INSTANCE) {
+                    ok = relocate_operand(&instr.arg2, var_map, lib.vars.count, "global", lib_file);
+                }
+                if (ok == 0 && instr.opcode == OPCODE_CALL_METHOD) {
+                    ok = relocate_method_slot(&lib, class_pool, lib.code[i].arg1, instr.arg1, &instr.arg2, lib_file);
+                }
+                break;
+            default:
+                break;
+        }
+
+        if (ok != 0) goto done;
+
+        ir_set_function(ir, owner[i]);
+        int index = ir_emit(ir, instr);
+        if (index < 0) goto done;
+        if (ir_is_jump(instr.opcode)) {
+            jumps[i].jump_block = ir->functions[owner[i]].current_block;
+            jumps[i].jump_index = index;
+        }
+        linked++;
+    }
+
+    // Destino de cada salto: el bloque abierto en la instrucción apuntada
+    for (int i = 0; i < lib.code_count; i++) {
+        if (jumps[i].jump_index < 0) continue;
+        int target = i + 1 + (int16_t)(lib.code[i].arg1 | (lib.code[i].arg2 << 8));
+        IRBlock *block = &ir->functions[owner[i]].blocks[jumps[i].jump_block];
+        block->instrs[jumps[i].jump_index].arg1 = jumps[target].block;
+        block->instrs[jumps[i].jump_index].arg2 = 0;
+    }
+
+    memcpy(ir->functions[entry].local_types + local_base, lib.local_types, lib.entry_locals);
+    ir->functions[entry].local_count += lib.entry_locals;
+
+    printf("  (enlazada %s: %d instrucciones, %d strings, %d globales, %d clases)\n",
+           lib_file, linked, lib.strings.count, lib.vars.count, lib.classes.count);
+    status = EXIT_SUCCESS;
+
+done:
+    ir_set_function(ir, entry);
+    free(string_map);
+    free(var_map);
+    free(class_map);
+    free(class_added);
+    free(owner);
+    free(jumps);
+    free_library(&lib);
+    return status;
+}
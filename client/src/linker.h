@@ -0,0 +1,22 @@
+#ifndef LINKER_H
+#define LINKER_H
+
+#include "compiler.h"
+#include "ir.h"
+
+// Las librerías se escriben con la versión 3 de la imagen. Tras los slots de
+// la entrada llevan el tipo ('i' o 'd') de cada local, primero los de la
+// entrada y después los de cada método, en el orden de las clases (desde la
+// versión 2), y el valor int64 exacto de cada global entera, en el orden de
+// las globales (desde la 3; la tabla de globales solo tiene su double). En
+// las versiones anteriores las locales se enlazan como double y las globales
+// enteras salen del double.
+#define LIBRARY_IMAGE_VERSION 3
+
+// Enlaza una librería estática (.slibgld) dentro del programa en construcción:
+// fusiona sus pools (strings, globales, clases) con deduplicación y reubica los
+// operandos de sus instrucciones antes de emitirlas en 'ir'.
+int link_static_library(const char *lib_file, IRProgram *ir, StringPool *string_pool,
+                        VariablePool *var_pool, ClassPool *class_pool);
+
+#endif
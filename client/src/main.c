@@ -13,6 +13,8 @@ void print_usage(const char *program_name) {
     printf("  clean               Clean compiled files\n");
     printf("  --version           Show version\n");
     printf("  --help              Show this help\n");
+    printf("\nBuild options:\n");
+    printf("  -O                  Enable bytecode optimizations\n");
 }
 
 int main(int argc, char *argv[]) {
@@ -43,12 +45,23 @@ int main(int argc, char *argv[]) {
     }
 
     if (strcmp(command, "build") == 0) {
-        if (argc < 3) {
+        const char *project_dir = NULL;
+        int optimize = 0;
+
+        for (int i = 2; i < argc; i++) {
+            if (strcmp(argv[i], "-O") == 0) {
+                optimize = 1;
+            } else if (!project_dir) {
+                project_dir = argv[i];
+            }
+        }
+
+        if (!project_dir) {
             fprintf(stderr, "Error: Project directory is required\n");
-            fprintf(stderr, "Usage: %s build <directory>\n", argv[0]);
+            fprintf(stderr, "Usage: %s build [-O] <directory>\n", argv[0]);
             return EXIT_FAILURE;
         }
-        return build_project(argv[2]);
+        return build_project(project_dir, optimize);
     }
 
     if (strcmp(command, "clean") == 0) {
@@ -0,0 +1,347 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "optimizer.h"
+
+// Profundidad del stack desconocida (p. ej. GET_GLOBAL numérico)
+#define DEPTH_UNKNOWN -1
+
+typedef struct {
+    IRInstr *out;           // Instrucciones resultantes del bloque
+    int out_count;
+
+    // Texto constante pendiente de imprimir (PRINT / PRINTCHR / PRINTLN literal)
+    char *text;
+    int text_len;
+    int text_capacity;
+    int text_start;         // Posición en el bloque de la primera instrucción acumulada
+    int text_instrs;        // Cantidad de instrucciones acumuladas
+
+    const IRBlock *block;
+    StringPool *string_pool;
+} PeepholeState;
+
+static int append_text(PeepholeState *state, const char *str, int len) {
+    if (state->text_len + len + 1 > state->text_capacity) {
+        int capacity = state->text_capacity ? state->text_capacity : 64;
+        while (state->text_len + len + 1 > capacity) capacity *= 2;
+        char *temp = realloc(state->text, capacity);
+        if (!temp) return -1;
+        state->text = temp;
+        state->text_capacity = capacity;
+    }
+    memcpy(state->text + state->text_len, str, len);
+    state->text_len += len;
+    state->text[state->text_len] = '\0';
+    return 0;
+}
+
+static int find_or_add_string(StringPool *pool, const char *str) {
+    for (int i = 0; i < pool->count; i++) {
+        if (strcmp(pool->strings[i], str) == 0) return i;
+    }
+
+    char **temp = realloc(pool->strings, (pool->count + 1) * sizeof(char*));
+    if (!temp) return -1;
+    pool->strings = temp;
+    pool->strings[pool->count] = (char*)malloc(strlen(str) + 1);
+    if (!pool->strings[pool->count]) return -1;
+    strcpy(pool->strings[pool->count], str);
+    return pool->count++;
+}
+
+// Emite el texto acumulado como una sola instrucción PRINT con un string del
+// pool. Si solo había una instrucción, o el índice nuevo no cabe en arg1, se
+// conservan las instrucciones originales.
+static int flush_text(PeepholeState *state) {
+    if (state->text_instrs == 0) return 0;
+
+    int idx = -1;
+    if (state->text_instrs > 1) {
+        idx = find_or_add_string(state->string_pool, state->text);
+        if (idx < 0) return -1;
+    }
+
+    if (idx >= 0 && idx <= 0xFF) {
+        IRInstr instr = {OPCODE_PRINT, idx, 0};
+        state->out[state->out_count++] = instr;
+    } else {
+        for (int i = 0; i < state->text_instrs; i++) {
+            state->out[state->out_count++] = state->block->instrs[state->text_start + i];
+        }
+    }
+
+    state->text_len = 0;
+    state->text_instrs = 0;
+    return 0;
+}
+
+// Intenta fusionar un POP_VALUE con la instrucción anterior que produjo el valor
+static int fold_pop(PeepholeState *state) {
+    while (state->out_count > 0) {
+        IRInstr *last = &state->out[state->out_count - 1];
+        if (last->opcode == OPCODE_PUSH_VALUE || last->opcode == OPCODE_PUSH_INT ||
+            last->opcode == OPCODE_PUSH_I64 || last->opcode == OPCODE_ARRAY_LEN) {
+            // Push de un valor que nadie usa: eliminar ambos
+            state->out_count--;
+            return 1;
+        }
+        if (last->opcode == OPCODE_ARRAY_GET || last->opcode == OPCODE_ARRAY_GET_I64 ||
+            last->opcode == OPCODE_ARRAY_GET_INT) {
+            // La lectura se descarta: basta con sacar el índice
+            state->out_count--;
+            continue;
+        }
+        break;
+    }
+    return 0;
+}
+
+// Optimiza un bloque in situ. 'depth' entra con la profundidad conocida del
+// stack al inicio del bloque y 'array_clean' se arrastra entre bloques.
+// Una escritura en 'var' la ensucia; con vistas abiertas en el bloque puede
+// tocar los datos de otro array, así que se ensucian todos.
+static void mark_written(uint8_t *array_clean, int var_count, int var, int viewing) {
+    if (viewing) {
+        memset(array_clean, 0, var_count);
+    } else if (var < var_count) {
+        array_clean[var] = 0;
+    }
+}
+
+static int optimize_block(IRBlock *block, PeepholeState *state, const VariablePool *var_pool,
+                          uint8_t *array_clean, int depth) {
+    int var_count = var_pool ? var_pool->count : 0;
+    StringPool *string_pool = state->string_pool;
+    int pending_global = 0;     // GET_GLOBAL de string pendiente de PRINTLN
+    int viewing = 0;            // Ya se ha tomado alguna vista en el bloque
+
+    IRInstr *out = (IRInstr*)malloc((block->count + 1) * sizeof(IRInstr));
+    if (!out) {
+        fprintf(stderr, "Error: No hay memoria suficiente\n");
+        return -1;
+    }
+    state->out = out;
+    state->out_count = 0;
+    state->block = block;
+    state->text_len = 0;
+    state->text_instrs = 0;
+
+    for (int pc = 0; pc < block->count; pc++) {
+        IRInstr instr = block->instrs[pc];
+
+        // 1) Texto constante: acumular mientras se pueda
+        const char *text = NULL;
+        char chr[2] = {0, 0};
+        int has_newline = 0;
+
+        if (instr.opcode == OPCODE_PRINT && instr.arg1 < string_pool->count) {
+            text = string_pool->strings[instr.arg1];
+        } else if (instr.opcode == OPCODE_PRINTCHR && instr.arg1 != 0) {
+            chr[0] = (char)instr.arg1;
+            text = chr;
+        } else if (instr.opcode == OPCODE_PRINTLN && depth == 0 && !pending_global &&
+                   instr.arg1 < string_pool->count) {
+            text = string_pool->strings[instr.arg1];
+            has_newline = 1;
+        }
+
+        if (text) {
+            if (state->text_instrs == 0) state->text_start = pc;
+            if (append_text(state, text, strlen(text)) != 0 ||
+                (has_newline && append_text(state, "\n", 1) != 0)) {
+                free(out);
+                return -1;
+            }
+            state->text_instrs++;
+            continue;
+        }
+
+        if (flush_text(state) != 0) {
+            free(out);
+            return -1;
+        }
+
+        // 2) Pares push/pop muertos y ARRAY_CLEAR redundantes
+        switch (instr.opcode) {
+            case OPCODE_POP_VALUE:
+                if (depth > 0) depth--;
+                if (fold_pop(state)) continue;
+                break;
+            case OPCODE_PUSH_VALUE:
+            case OPCODE_PUSH_INT:
+            case OPCODE_PUSH_I64:
+            case OPCODE_ARRAY_LEN:
+            case OPCODE_ARRAY_POP:
+            case OPCODE_ARRAY_SUM:
+            case OPCODE_ARRAY_MIN:
+            case OPCODE_ARRAY_MAX:
+            case OPCODE_ARRAY_DOT:
+            case OPCODE_ARRAY_UNIQUE:
+            case OPCODE_GET_FIELD:
+            case OPCODE_LOAD_LOCAL:
+                if (depth != DEPTH_UNKNOWN) depth++;
+                break;
+            case OPCODE_SET_FIELD:
+            case OPCODE_STORE_LOCAL:
+            case OPCODE_ADD_I64: case OPCODE_SUB_I64: case OPCODE_MUL_I64:
+            case OPCODE_DIV_I64: case OPCODE_MOD_I64:
+            case OPCODE_ADD_F64: case OPCODE_SUB_F64: case OPCODE_MUL_F64:
+            case OPCODE_DIV_F64: case OPCODE_MOD_F64:
+            case OPCODE_PRINTLN_I64:
+            case OPCODE_JUMP_IF_FALSE:
+            case OPCODE_EQ_I64: case OPCODE_NE_I64: case OPCODE_LT_I64:
+            case OPCODE_LE_I64: case OPCODE_GT_I64: case OPCODE_GE_I64:
+            case OPCODE_EQ_F64: case OPCODE_NE_F64: case OPCODE_LT_F64:
+            case OPCODE_LE_F64: case OPCODE_GT_F64: case OPCODE_GE_F64:
+            case OPCODE_AND:
+            case OPCODE_OR:
+                if (depth != DEPTH_UNKNOWN && depth > 0) depth--;
+                break;
+            case OPCODE_ARRAY_SET:
+            case OPCODE_ARRAY_SET_I64:
+            case OPCODE_ARRAY_SET_INT:
+                if (depth != DEPTH_UNKNOWN) depth = depth >= 2 ? depth - 2 : 0;
+                mark_written(array_clean, var_count, instr.arg1, viewing);
+                break;
+            case OPCODE_ARRAY_PUSH:
+            case OPCODE_ARRAY_RESIZE:
+            case OPCODE_ARRAY_FILL:
+            case OPCODE_ARRAY_SCALE:
+            case OPCODE_ARRAY_AXPY:
+                if (depth != DEPTH_UNKNOWN && depth > 0) depth--;
+                mark_written(array_clean, var_count, instr.arg1, viewing);
+                break;
+            case OPCODE_ARRAY_RESERVE:
+                if (depth != DEPTH_UNKNOWN && depth > 0) depth--;
+                break;
+            case OPCODE_ARRAY_COPY:
+            case OPCODE_ARRAY_ADD:
+            case OPCODE_ARRAY_MUL:
+            case OPCODE_ARRAY_SORT:
+            case OPCODE_ARRAY_SORT_DESC:
+                mark_written(array_clean, var_count, instr.arg1, viewing);
+                break;
+            case OPCODE_ARRAY_ROW:
+            case OPCODE_ARRAY_COL:
+                if (depth != DEPTH_UNKNOWN && depth > 0) depth--;
+                viewing = 1;
+                memset(array_clean, 0, var_count);
+                break;
+            case OPCODE_ARRAY_SLICE:
+                if (depth != DEPTH_UNKNOWN) depth = depth >= 2 ? depth - 2 : 0;
+                viewing = 1;
+                memset(array_clean, 0, var_count);
+                break;
+            case OPCODE_MULADD_I64:
+            case OPCODE_MULADD_F64:
+            case OPCODE_JUMP_UNLESS_EQ_I64: case OPCODE_JUMP_UNLESS_NE_I64:
+            case OPCODE_JUMP_UNLESS_LT_I64: case OPCODE_JUMP_UNLESS_LE_I64:
+            case OPCODE_JUMP_UNLESS_GT_I64: case OPCODE_JUMP_UNLESS_GE_I64:
+            case OPCODE_JUMP_UNLESS_EQ_F64: case OPCODE_JUMP_UNLESS_NE_F64:
+            case OPCODE_JUMP_UNLESS_LT_F64: case OPCODE_JUMP_UNLESS_LE_F64:
+            case OPCODE_JUMP_UNLESS_GT_F64: case OPCODE_JUMP_UNLESS_GE_F64:
+                if (depth != DEPTH_UNKNOWN) depth = depth >= 2 ? depth - 2 : 0;
+                break;
+            case OPCODE_FORMAT_PRINT:
+                if (depth != DEPTH_UNKNOWN) depth = depth >= instr.arg2 ? depth - instr.arg2 : 0;
+                break;
+            case OPCODE_ARRAY_NEW:
+                if (depth != DEPTH_UNKNOWN && depth > 0) depth--;
+                if (instr.arg1 < var_count) array_clean[instr.arg1] = 1;
+                break;
+            case OPCODE_ARRAY_CLEAR:
+                if (instr.arg1 < var_count) {
+                    if (array_clean[instr.arg1]) continue;
+                    array_clean[instr.arg1] = 1;
+                }
+                break;
+            case OPCODE_PRINTLN:
+                if (depth > 0) depth--;
+                else pending_global = 0;
+                break;
+            case OPCODE_GET_GLOBAL:
+                if (instr.arg1 < var_count && var_pool->vars[instr.arg1].type == 's') {
+                    pending_global = 1;
+                } else {
+                    depth = DEPTH_UNKNOWN;
+                }
+                break;
+            case OPCODE_PRINT:
+            case OPCODE_PRINTCHR:
+            case OPCODE_FLUSH:
+            case OPCODE_NEW_INSTANCE:
+            case OPCODE_I2F: case OPCODE_F2I:
+            case OPCODE_NEG_I64: case OPCODE_NEG_F64: case OPCODE_NOT:
+            case OPCODE_ARRAY_GET: case OPCODE_ARRAY_GET_I64: case OPCODE_ARRAY_GET_INT:
+            case OPCODE_ARRAY_SEARCH:
+            case OPCODE_JUMP:
+            case OPCODE_LOOP:
+                // No escriben en ningún array
+                break;
+            default:
+                // CALL_METHOD y el resto: un método puede escribir cualquier array global
+                memset(array_clean, 0, var_count);
+                break;
+        }
+
+        out[state->out_count++] = instr;
+    }
+
+    if (flush_text(state) != 0) {
+        free(out);
+        return -1;
+    }
+
+    int removed = block->count - state->out_count;
+    free(block->instrs);
+    block->instrs = out;
+    block->count = state->out_count;
+    block->capacity = block->count + 1;
+    return removed;
+}
+
+int optimize_peephole(IRProgram *ir, StringPool *string_pool, const VariablePool *var_pool) {
+    PeepholeState state;
+    memset(&state, 0, sizeof(state));
+    state.string_pool = string_pool;
+
+    int var_count = var_pool ? var_pool->count : 0;
+    uint8_t *array_clean = (uint8_t*)calloc(var_count + 1, 1);
+    if (!array_clean) {
+        fprintf(stderr, "Error: No hay memoria suficiente\n");
+        return -1;
+    }
+
+    int removed = 0;
+    for (int f = 0; f < ir->count; f++) {
+        IRFunction *fn = &ir->functions[f];
+
+        // Solo al entrar al programa se sabe que los arrays estáticos están a cero;
+        // un método puede ejecutarse después de cualquier escritura.
+        for (int i = 0; i < var_count; i++) {
+            array_clean[i] = f == 0 && var_pool->vars[i].type == 'a';
+        }
+
+        for (int b = 0; b < fn->block_count; b++) {
+            if (b > 0) {
+                // Un bloque puede alcanzarse desde varios sitios
+                memset(array_clean, 0, var_count);
+            }
+            // Los bloques empiezan en una frontera de sentencia: stack vacío
+            int depth = 0;
+            int n = optimize_block(&fn->blocks[b], &state, var_pool, array_clean, depth);
+            if (n < 0) {
+                free(state.text);
+                free(array_clean);
+                return -1;
+            }
+            removed += n;
+        }
+    }
+
+    free(state.text);
+    free(array_clean);
+    return removed;
+}
@@ -0,0 +1,11 @@
+#ifndef OPTIMIZER_H
+#define OPTIMIZER_H
+
+#include "compiler.h"
+#include "ir.h"
+
+// Optimizador peephole sobre la IR, bloque a bloque (gld build -O).
+// Devuelve la cantidad de instrucciones eliminadas o -1 si hubo un error.
+int optimize_peephole(IRProgram *ir, StringPool *string_pool, const VariablePool *var_pool);
+
+#endif
@@ -0,0 +1,106 @@
+#include <stdlib.h>
+#include <string.h>
+#include "symtab.h"
+
+// FNV-1a de 32 bits
+static unsigned int hash_name(const char *key, int len) {
+    unsigned int hash = 2166136261u;
+    for (int i = 0; i < len; i++) {
+        hash ^= (unsigned char)key[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static SymbolEntry *find_slot(SymbolEntry *entries, int capacity, const char *key, int len, unsigned int hash) {
+    unsigned int mask = (unsigned int)capacity - 1;
+    for (unsigned int i = hash & mask;; i = (i + 1) & mask) {
+        SymbolEntry *entry = &entries[i];
+        if (!entry->key) return entry;
+        if (entry->hash == hash && strncmp(entry->key, key, len) == 0 && entry->key[len] == '\0') {
+            return entry;
+        }
+    }
+}
+
+static int grow(SymbolTable *table) {
+    int capacity = table->capacity ? table->capacity * 2 : 16;
+    SymbolEntry *entries = (SymbolEntry*)calloc(capacity, sizeof(SymbolEntry));
+    if (!entries) return -1;
+
+    for (int i = 0; i < table->capacity; i++) {
+        SymbolEntry *old = &table->entries[i];
+        if (!old->key) continue;
+        *find_slot(entries, capacity, old->key, strlen(old->key), old->hash) = *old;
+    }
+
+    free(table->entries);
+    table->entries = entries;
+    table->capacity = capacity;
+    return 0;
+}
+
+void symtab_init(SymbolTable *table, SymbolTable *parent) {
+    memset(table, 0, sizeof(SymbolTable));
+    table->parent = parent;
+}
+
+void symtab_clear(SymbolTable *table) {
+    for (int i = 0; i < table->capacity; i++) {
+        free(table->entries[i].key);
+        table->entries[i].key = NULL;
+    }
+    table->count = 0;
+    table->indexed = 0;
+}
+
+void symtab_free(SymbolTable *table) {
+    symtab_clear(table);
+    free(table->entries);
+    table->entries = NULL;
+    table->capacity = 0;
+}
+
+static int insert(SymbolTable *table, const char *key, int value, int replace) {
+    // Factor de carga máximo 1/2
+    if ((table->count + 1) * 2 > table->capacity && grow(table) != 0) return -1;
+
+    int len = strlen(key);
+    unsigned int hash = hash_name(key, len);
+    SymbolEntry *entry = find_slot(table->entries, table->capacity, key, len, hash);
+
+    if (entry->key) {
+        if (replace) entry->value = value;
+        return 0;
+    }
+
+    entry->key = (char*)malloc(len + 1);
+    if (!entry->key) return -1;
+    memcpy(entry->key, key, len + 1);
+    entry->hash = hash;
+    entry->value = value;
+    table->count++;
+    return 0;
+}
+
+int symtab_put(SymbolTable *table, const char *key, int value) {
+    return insert(table, key, value, 1);
+}
+
+int symtab_put_if_absent(SymbolTable *table, const char *key, int value) {
+    return insert(table, key, value, 0);
+}
+
+int symtab_get(const SymbolTable *table, const char *key, int len) {
+    if (table->count == 0) return -1;
+    SymbolEntry *entry = find_slot(table->entries, table->capacity, key, len, hash_name(key, len));
+    return entry->key ? entry->value : -1;
+}
+
+int symtab_lookup(const SymbolTable *table, const char *key, int len) {
+    for (; table; table = table->parent) {
+        int value = symtab_get(table, key, len);
+        if (value >= 0) return value;
+    }
+    return -1;
+}
@@ -0,0 +1,36 @@
+#ifndef SYMTAB_H
+#define SYMTAB_H
+
+// Tabla hash nombre -> índice (direccionamiento abierto, sondeo lineal).
+// Las tablas se pueden anidar: symtab_lookup busca en la tabla y luego en
+// sus padres, para ámbitos locales dentro de funciones y métodos.
+
+typedef struct {
+    char *key;          // NULL = hueco libre
+    unsigned int hash;
+    int value;
+} SymbolEntry;
+
+typedef struct SymbolTable {
+    SymbolEntry *entries;
+    int capacity;       // Potencia de 2 (0 mientras esté vacía)
+    int count;
+    int indexed;        // Entradas del array asociado ya volcadas en la tabla
+    struct SymbolTable *parent;
+} SymbolTable;
+
+void symtab_init(SymbolTable *table, SymbolTable *parent);
+void symtab_free(SymbolTable *table);
+void symtab_clear(SymbolTable *table);
+
+// Inserta o reemplaza. Devuelve 0, o -1 si no hay memoria.
+int symtab_put(SymbolTable *table, const char *key, int value);
+
+// Inserta solo si la clave no existe (conserva la primera definición)
+int symtab_put_if_absent(SymbolTable *table, const char *key, int value);
+
+// Buscan 'len' bytes de 'key' (no hace falta que termine en '\0'). -1 si no está.
+int symtab_get(const SymbolTable *table, const char *key, int len);
+int symtab_lookup(const SymbolTable *table, const char *key, int len);
+
+#endif
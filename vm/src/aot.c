@@ -0,0 +1,650 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "aot.h"
+#include "runtime.h"
+
+// Estado de la traducción: la imagen ya cargada en un VMState (para conocer
+// tipos de globales, vtables y tamaños de frame) y qué PCs necesitan etiqueta.
+//
+// El código se reparte en funciones de AOT_CHUNK instrucciones: cc no aguanta
+// una única función con cientos de miles de etiquetas. Dentro de un trozo los
+// saltos son goto; para salir se devuelve el PC de destino y run() llama al
+// trozo que lo contiene.
+#define AOT_CHUNK 1024
+
+#define AOT_LABEL 1        // Destino de un goto dentro de su trozo
+#define AOT_ENTRY 2        // Se puede entrar desde fuera del trozo
+
+typedef struct {
+    FILE *out;
+    VMState vm;
+    uint8_t *labels;       // AOT_LABEL | AOT_ENTRY por PC
+    int *frame_sizes;      // Slots del frame al que pertenece cada PC
+} AotContext;
+
+static int same_chunk(int pc, int target) {
+    return pc / AOT_CHUNK == target / AOT_CHUNK;
+}
+
+// Marca 'target' como destino de una transferencia desde 'pc'
+static void mark_target(AotContext *ctx, int pc, int target) {
+    if (target >= ctx->vm.instruction_count) return;
+    ctx->labels[target] |= same_chunk(pc, target) ? AOT_LABEL : AOT_ENTRY;
+}
+
+// PC de destino de un salto relativo; instruction_count = fin del programa
+static int jump_target(const AotContext *ctx, int pc, Instruction instr) {
+    int target = pc + 1 + (int16_t)(instr.arg1 | (instr.arg2 << 8));
+    return target >= 0 && target <= ctx->vm.instruction_count ? target : ctx->vm.instruction_count;
+}
+
+static int is_jump(uint8_t opcode) {
+    return (opcode >= OPCODE_JUMP_UNLESS_EQ_I64 && opcode <= OPCODE_JUMP_UNLESS_GE_F64) ||
+           opcode == OPCODE_JUMP || opcode == OPCODE_JUMP_IF_FALSE || opcode == OPCODE_LOOP;
+}
+
+// PARALLEL_END de un PARALLEL_FOR (buscando hacia delante) o PARALLEL_FOR de
+// un PARALLEL_END (hacia atrás): el más cercano con el mismo índice. -1 si no hay.
+static int parallel_partner(const AotContext *ctx, int pc) {
+    const VMState *vm = &ctx->vm;
+    Instruction instr = vm->instructions[pc];
+    int forward = instr.opcode == OPCODE_PARALLEL_FOR;
+    uint8_t wanted = forward ? OPCODE_PARALLEL_END : OPCODE_PARALLEL_FOR;
+    for (int k = forward ? pc + 1 : pc - 1; k >= 0 && k < vm->instruction_count; k += forward ? 1 : -1) {
+        if (vm->instructions[k].opcode == wanted && vm->instructions[k].arg1 == instr.arg1) return k;
+    }
+    return -1;
+}
+
+// Entrada del método 'slot' de la clase, o -1 si la llamada es inválida
+static int method_entry(const AotContext *ctx, Instruction instr) {
+    const ClassPool *pool = &ctx->vm.class_pool;
+    if (instr.arg1 >= pool->class_count || instr.arg2 >= pool->classes[instr.arg1].method_count) return -1;
+    int entry = pool->classes[instr.arg1].vtable[instr.arg2];
+    return entry >= 0 && entry < ctx->vm.instruction_count ? entry : -1;
+}
+
+// Marca los destinos de saltos, llamadas y retornos, y el frame de cada PC
+static void analyze(AotContext *ctx) {
+    const VMState *vm = &ctx->vm;
+    for (int pc = 0; pc < vm->instruction_count; pc++) {
+        ctx->frame_sizes[pc] = vm->frame_size;
+    }
+    for (int i = 0; i < vm->class_pool.class_count; i++) {
+        const ClassDefinition *cls = &vm->class_pool.classes[i];
+        for (int j = 0; j < cls->method_count; j++) {
+            const ClassMethod *method = &cls->methods[j];
+            for (int k = 0; k < method->instruction_count; k++) {
+                int pc = method->start_instruction + k;
+                if (pc >= 0 && pc < vm->instruction_count) ctx->frame_sizes[pc] = method->local_count;
+            }
+        }
+    }
+
+    for (int pc = 0; pc < vm->instruction_count; pc++) {
+        Instruction instr = vm->instructions[pc];
+        if (is_jump(instr.opcode)) {
+            mark_target(ctx, pc, jump_target(ctx, pc, instr));
+        } else if (instr.opcode == OPCODE_CALL_METHOD && method_entry(ctx, instr) >= 0) {
+            mark_target(ctx, pc, method_entry(ctx, instr));
+            // RETURN vuelve siempre a través de run()
+            if (pc + 1 < vm->instruction_count) ctx->labels[pc + 1] |= AOT_ENTRY;
+        } else if (instr.opcode == OPCODE_PARALLEL_FOR && parallel_partner(ctx, pc) >= 0) {
+            mark_target(ctx, pc, parallel_partner(ctx, pc) + 1);
+        } else if (instr.opcode == OPCODE_PARALLEL_END && parallel_partner(ctx, pc) >= 0) {
+            mark_target(ctx, pc, parallel_partner(ctx, pc) + 1);
+        }
+    }
+}
+
+// Transferencia de 'pc' a 'target': goto si está en el mismo trozo; si no,
+// se devuelve el PC a run(). El fin del programa es 'halt'.
+static void emit_goto(AotContext *ctx, int pc, int target) {
+    if (target >= ctx->vm.instruction_count) {
+        fprintf(ctx->out, "goto halt;");
+    } else if (same_chunk(pc, target)) {
+        fprintf(ctx->out, "goto L%d;", target);
+    } else {
+        fprintf(ctx->out, "{ vm->sp = sp; return %d; }", target);
+    }
+}
+
+static const char *const compare_ops[] = { "==", "!=", "<", "<=", ">", ">=" };
+
+// Acceso a un array: 'a' tiene índice fijo en vm->arrays; 'b' se lee de su
+// variable en cada ejecución. 0 si la variable no es un array (no se emite nada).
+static int emit_array_open(AotContext *ctx, int var) {
+    const VMState *vm = &ctx->vm;
+    if (var >= vm->variable_count) return 0;
+    if (vm->variables[var].type == 'a') {
+        fprintf(ctx->out, "{ Array *arr = &vm->arrays[%d]; ", (int)vm->variables[var].value);
+        return 1;
+    }
+    if (vm->variables[var].type == 'b') {
+        fprintf(ctx->out, "{ int k = vm_dynamic_array(vm, %d); if (k >= 0) { Array *arr = &vm->arrays[k]; ", var);
+        return 2;
+    }
+    return 0;
+}
+
+static void emit_array_close(AotContext *ctx, int kind) {
+    fprintf(ctx->out, kind == 2 ? "} }" : "}");
+}
+
+// Tipo C de los elementos de un array estático, para acceder a ellos sin
+// pasar por vm_array_get_*; NULL si no se conoce o son bits (bool)
+static const char *static_element_type(const AotContext *ctx, int var) {
+    const VMState *vm = &ctx->vm;
+    if (var >= vm->variable_count || vm->variables[var].type != 'a') return NULL;
+    switch (vm->arrays[(int)vm->variables[var].value].type) {
+        case 'd': return "double";
+        case 'i': return "int32_t";
+        case 'l': return "int64_t";
+        case 'u': return "uint8_t";
+        default:  return NULL;
+    }
+}
+
+// Acceso a arr->data[i] de un array estático de double o entero
+static void emit_static_load(AotContext *ctx, const char *c_type, const char *slot) {
+    fprintf(ctx->out, "stack[sp - 1].%s = i >= 0 && i < arr->size ? ((%s*)arr->data)[i] : 0; ", slot, c_type);
+}
+
+static void emit_static_store(AotContext *ctx, const char *c_type, const char *slot) {
+    fprintf(ctx->out, "if (i >= 0 && i < arr->size) ((%s*)arr->data)[i] = (%s)stack[sp - 1].%s; sp -= 2; ",
+            c_type, c_type, slot);
+}
+
+static void emit_instruction(AotContext *ctx, int pc) {
+    FILE *out = ctx->out;
+    VMState *vm = &ctx->vm;
+    Instruction instr = vm->instructions[pc];
+    int a = instr.arg1, b = instr.arg2;
+
+    switch (instr.opcode) {
+        case OPCODE_PRINT:
+            if (a < vm->string_pool.string_count) fprintf(out, "output_string(&vm->out, vm->string_pool.strings[%d]);", a);
+            break;
+
+        case OPCODE_PRINTLN:
+            // Igual que el intérprete: lo decide el estado en tiempo de ejecución
+            fprintf(out, "if (sp > 0) vm_println_number(vm, stack[--sp].f); "
+                         "else if (vm->pending_string) { output_string(&vm->out, vm->pending_string); "
+                         "output_char(&vm->out, '\\n'); vm->pending_string = NULL; }");
+            if (a < vm->string_pool.string_count) {
+                fprintf(out, " else { output_string(&vm->out, vm->string_pool.strings[%d]); "
+                             "output_char(&vm->out, '\\n'); }", a);
+            }
+            break;
+
+        case OPCODE_PRINTCHR:
+            fprintf(out, "output_char(&vm->out, %d);", a);
+            break;
+
+        case OPCODE_PRINTLN_I64:
+            fprintf(out, "vm_println_int(vm, stack[--sp].i);");
+            break;
+
+        case OPCODE_FORMAT_PRINT:
+            if (a < vm->string_pool.string_count) {
+                fprintf(out, "if (sp >= %d) { sp -= %d; vm_format_print(vm, vm->string_pool.strings[%d], &stack[sp]); }",
+                        b, b, a);
+            }
+            break;
+
+        case OPCODE_FLUSH:
+            fprintf(out, "output_flush(&vm->out);");
+            break;
+
+        case OPCODE_GET_GLOBAL:
+            if (a >= vm->variable_count) break;
+            if (vm->variables[a].type == 's') {
+                fprintf(out, "vm->pending_string = vm->variables[%d].str_val;", a);
+            } else {
+                fprintf(out, "PUSH_F(vm->variables[%d].value);", a);
+            }
+            break;
+
+        case OPCODE_PUSH_VALUE:
+            if (a < vm->string_pool.string_count) {
+                double value = atof(vm->string_pool.strings[a]);
+                if (isfinite(value)) {
+                    fprintf(out, "PUSH_F(%.17g);", value);
+                } else {
+                    fprintf(out, "PUSH_F(atof(vm->string_pool.strings[%d]));", a);
+                }
+            }
+            break;
+
+        case OPCODE_PUSH_INT:
+            fprintf(out, "PUSH_I(%d);", (int16_t)(a | (b << 8)));
+            break;
+
+        case OPCODE_PUSH_I64:
+            if (a < vm->string_pool.string_count) {
+                // Como unsigned: -2^63 no se puede escribir como literal con signo
+                uint64_t bits = (uint64_t)strtoll(vm->string_pool.strings[a], NULL, 10);
+                fprintf(out, "PUSH_I((int64_t)%lluULL);", (unsigned long long)bits);
+            }
+            break;
+
+        case OPCODE_POP_VALUE:
+            fprintf(out, "if (sp > 0) sp--;");
+            break;
+
+        case OPCODE_NEW_INSTANCE:
+            if (a < vm->class_pool.class_count) fprintf(out, "vm_new_instance(vm, %d, %d);", a, b);
+            break;
+
+        case OPCODE_GET_FIELD:
+        case OPCODE_SET_FIELD:
+            if (a >= vm->variable_count || vm->variables[a].type != 'o') break;
+            fprintf(out, "{ ObjectInstance *obj = vm_resolve_object(vm, %d); if (obj && %d < obj->field_count) ", a, b);
+            if (instr.opcode == OPCODE_GET_FIELD) {
+                fprintf(out, "PUSH_RAW(obj->field_values[%d]); }", b);
+            } else {
+                fprintf(out, "obj->field_values[%d] = stack[--sp]; }", b);
+            }
+            break;
+
+        case OPCODE_CALL_METHOD: {
+            int entry = method_entry(ctx, instr);
+            if (entry < 0) break;
+            fprintf(out, "vm->pc = %d; if (vm_enter_method(vm, %d, %d, %d) < 0) goto halt; "
+                         "frame = vm->locals + vm->fp; ", pc, a, b, pc + 1);
+            emit_goto(ctx, pc, entry);
+            break;
+        }
+
+        case OPCODE_RETURN:
+            // Vuelve al llamador, o -1 (fin) en la entrada
+            fprintf(out, "vm->sp = sp; return vm_leave_method(vm);");
+            break;
+
+        case OPCODE_LOAD_LOCAL:
+        case OPCODE_STORE_LOCAL: {
+            // Fuera del frame conocido se mantiene la comprobación del intérprete
+            int known = a < ctx->frame_sizes[pc];
+            if (!known) fprintf(out, "if (%d < vm->frame_size) ", a);
+            if (instr.opcode == OPCODE_LOAD_LOCAL) {
+                fprintf(out, "PUSH_RAW(frame[%d]);", a);
+            } else {
+                fprintf(out, "frame[%d] = stack[--sp];", a);
+            }
+            break;
+        }
+
+        case OPCODE_ARRAY_GET:
+        case OPCODE_ARRAY_GET_I64: {
+            int kind = emit_array_open(ctx, a);
+            if (!kind) break;
+            const char *c_type = static_element_type(ctx, a);
+            fprintf(out, "int64_t i = %s; ",
+                    instr.opcode == OPCODE_ARRAY_GET_I64 ? "stack[sp - 1].i" : "(int64_t)stack[sp - 1].f");
+            if (c_type && strcmp(c_type, "double") == 0) {
+                emit_static_load(ctx, c_type, "f");
+            } else {
+                fprintf(out, "stack[sp - 1].f = vm_array_get_f64(arr, i); ");
+            }
+            emit_array_close(ctx, kind);
+            break;
+        }
+
+        case OPCODE_ARRAY_SET:
+        case OPCODE_ARRAY_SET_I64: {
+            int kind = emit_array_open(ctx, a);
+            if (!kind) break;
+            const char *c_type = static_element_type(ctx, a);
+            fprintf(out, "int64_t i = %s; ",
+                    instr.opcode == OPCODE_ARRAY_SET_I64 ? "stack[sp - 2].i" : "(int64_t)stack[sp - 2].f");
+            if (c_type && strcmp(c_type, "double") == 0) {
+                emit_static_store(ctx, c_type, "f");
+            } else {
+                fprintf(out, "vm_array_set_f64(arr, i, stack[sp - 1].f); sp -= 2; ");
+            }
+            emit_array_close(ctx, kind);
+            break;
+        }
+
+        case OPCODE_ARRAY_GET_INT: {
+            int kind = emit_array_open(ctx, a);
+            if (!kind) break;
+            const char *c_type = static_element_type(ctx, a);
+            fprintf(out, "int64_t i = stack[sp - 1].i; ");
+            if (c_type && strcmp(c_type, "double") != 0) {
+                emit_static_load(ctx, c_type, "i");
+            } else {
+                fprintf(out, "stack[sp - 1].i = vm_array_get_int(arr, i); ");
+            }
+            emit_array_close(ctx, kind);
+            break;
+        }
+
+        case OPCODE_ARRAY_SET_INT: {
+            int kind = emit_array_open(ctx, a);
+            if (!kind) break;
+            const char *c_type = static_element_type(ctx, a);
+            fprintf(out, "int64_t i = stack[sp - 2].i; ");
+            if (c_type && strcmp(c_type, "double") != 0) {
+                emit_static_store(ctx, c_type, "i");
+            } else {
+                fprintf(out, "vm_array_set_int(arr, i, stack[sp - 1].i); sp -= 2; ");
+            }
+            emit_array_close(ctx, kind);
+            break;
+        }
+
+        case OPCODE_ARRAY_NEW:
+            if (a < vm->variable_count) fprintf(out, "vm_array_new(vm, %d, %d, (int)stack[--sp].f);", a, b);
+            break;
+
+        case OPCODE_ARRAY_PUSH:
+            fprintf(out, "vm->pc = %d; sp--; if (vm_array_push(vm, %d, stack[sp]) != 0) goto halt;", pc, a);
+            break;
+
+        case OPCODE_ARRAY_POP:
+            fprintf(out, "vm->pc = %d; if (vm_array_pop(vm, %d, &stack[sp]) != 0) goto halt; sp++;", pc, a);
+            break;
+
+        case OPCODE_ARRAY_RESERVE:
+        case OPCODE_ARRAY_RESIZE:
+            fprintf(out, "vm->pc = %d; sp--; if (vm_array_%s(vm, %d, stack[sp].i) != 0) goto halt;",
+                    pc, instr.opcode == OPCODE_ARRAY_RESERVE ? "reserve" : "resize", a);
+            break;
+
+        case OPCODE_ARRAY_COPY:
+            fprintf(out, "vm->pc = %d; if (vm_array_copy(vm, %d, %d) != 0) goto halt;", pc, a, b);
+            break;
+
+        case OPCODE_ARRAY_FILL:
+        case OPCODE_ARRAY_SCALE:
+        case OPCODE_ARRAY_AXPY:
+            fprintf(out, "vm->pc = %d; if (vm_array_bulk(vm, 0x%02X, %d, %d, &stack[sp - 1]) != 0) goto halt; sp--;",
+                    pc, instr.opcode, a, b);
+            break;
+
+        case OPCODE_ARRAY_ADD:
+        case OPCODE_ARRAY_MUL:
+            fprintf(out, "vm->pc = %d; if (vm_array_bulk(vm, 0x%02X, %d, %d, &stack[sp]) != 0) goto halt;",
+                    pc, instr.opcode, a, b);
+            break;
+
+        case OPCODE_ARRAY_SUM:
+        case OPCODE_ARRAY_MIN:
+        case OPCODE_ARRAY_MAX:
+        case OPCODE_ARRAY_DOT:
+            fprintf(out, "vm->pc = %d; if (vm_array_bulk(vm, 0x%02X, %d, %d, &stack[sp]) != 0) goto halt; sp++;",
+                    pc, instr.opcode, a, b);
+            break;
+
+        case OPCODE_ARRAY_SORT:
+        case OPCODE_ARRAY_SORT_DESC:
+            fprintf(out, "vm->pc = %d; if (vm_array_sort(vm, %d, %d) != 0) goto halt;",
+                    pc, a, instr.opcode == OPCODE_ARRAY_SORT_DESC);
+            break;
+
+        case OPCODE_ARRAY_SEARCH:
+            fprintf(out, "vm->pc = %d; if (vm_array_search(vm, %d, &stack[sp - 1]) != 0) goto halt;", pc, a);
+            break;
+
+        case OPCODE_ARRAY_UNIQUE:
+            fprintf(out, "vm->pc = %d; if (vm_array_unique(vm, %d, &stack[sp]) != 0) goto halt; sp++;", pc, a);
+            break;
+
+        case OPCODE_ARRAY_ROW:
+        case OPCODE_ARRAY_COL:
+            fprintf(out, "vm->pc = %d; sp--; if (vm_array_view(vm, 0x%02X, %d, %d, stack[sp].i, 0) != 0) goto halt;",
+                    pc, instr.opcode, a, b);
+            break;
+
+        case OPCODE_ARRAY_SLICE:
+            fprintf(out, "vm->pc = %d; sp -= 2; if (vm_array_view(vm, 0x%02X, %d, %d, stack[sp].i, stack[sp + 1].i) != 0) goto halt;",
+                    pc, instr.opcode, a, b);
+            break;
+
+        case OPCODE_ARRAY_LEN: {
+            int kind = emit_array_open(ctx, a);
+            if (!kind) break;
+            fprintf(out, "PUSH_I(arr->size); ");
+            emit_array_close(ctx, kind);
+            break;
+        }
+
+        case OPCODE_ARRAY_CLEAR: {
+            int kind = emit_array_open(ctx, a);
+            if (!kind) break;
+            fprintf(out, "vm_array_clear(vm, (int)(arr - vm->arrays)); ");
+            emit_array_close(ctx, kind);
+            break;
+        }
+
+        case OPCODE_I2F:
+            fprintf(out, "stack[sp - 1].f = (double)stack[sp - 1].i;");
+            break;
+
+        case OPCODE_F2I:
+            fprintf(out, "stack[sp - 1].i = (int64_t)stack[sp - 1].f;");
+            break;
+
+        case OPCODE_NEG_I64:
+            fprintf(out, "stack[sp - 1].i = -stack[sp - 1].i;");
+            break;
+
+        case OPCODE_NEG_F64:
+            fprintf(out, "stack[sp - 1].f = -stack[sp - 1].f;");
+            break;
+
+        case OPCODE_ADD_I64: fprintf(out, "sp--; stack[sp - 1].i += stack[sp].i;"); break;
+        case OPCODE_SUB_I64: fprintf(out, "sp--; stack[sp - 1].i -= stack[sp].i;"); break;
+        case OPCODE_MUL_I64: fprintf(out, "sp--; stack[sp - 1].i *= stack[sp].i;"); break;
+        case OPCODE_ADD_F64: fprintf(out, "sp--; stack[sp - 1].f += stack[sp].f;"); break;
+        case OPCODE_SUB_F64: fprintf(out, "sp--; stack[sp - 1].f -= stack[sp].f;"); break;
+        case OPCODE_MUL_F64: fprintf(out, "sp--; stack[sp - 1].f *= stack[sp].f;"); break;
+        case OPCODE_DIV_F64: fprintf(out, "sp--; stack[sp - 1].f /= stack[sp].f;"); break;
+        case OPCODE_MOD_F64: fprintf(out, "sp--; stack[sp - 1].f = fmod(stack[sp - 1].f, stack[sp].f);"); break;
+
+        case OPCODE_DIV_I64:
+        case OPCODE_MOD_I64:
+            fprintf(out, "sp--; if (stack[sp].i == 0) { vm->pc = %d; vm_fail(vm, \"División entera por cero\"); goto halt; } "
+                         "if (stack[sp].i == -1) stack[sp - 1].i = %s; else stack[sp - 1].i %s= stack[sp].i;", pc,
+                    instr.opcode == OPCODE_DIV_I64 ? "(int64_t)(0 - (uint64_t)stack[sp - 1].i)" : "0",
+                    instr.opcode == OPCODE_DIV_I64 ? "/" : "%");
+            break;
+
+        case OPCODE_EQ_I64: case OPCODE_NE_I64: case OPCODE_LT_I64:
+        case OPCODE_LE_I64: case OPCODE_GT_I64: case OPCODE_GE_I64:
+            fprintf(out, "sp--; stack[sp - 1].i = stack[sp - 1].i %s stack[sp].i;",
+                    compare_ops[instr.opcode - OPCODE_EQ_I64]);
+            break;
+
+        case OPCODE_EQ_F64: case OPCODE_NE_F64: case OPCODE_LT_F64:
+        case OPCODE_LE_F64: case OPCODE_GT_F64: case OPCODE_GE_F64:
+            fprintf(out, "sp--; stack[sp - 1].i = stack[sp - 1].f %s stack[sp].f;",
+                    compare_ops[instr.opcode - OPCODE_EQ_F64]);
+            break;
+
+        case OPCODE_NOT:
+            fprintf(out, "stack[sp - 1].i = !stack[sp - 1].i;");
+            break;
+
+        case OPCODE_AND:
+        case OPCODE_OR:
+            fprintf(out, "sp--; stack[sp - 1].i = stack[sp - 1].i %s stack[sp].i;",
+                    instr.opcode == OPCODE_AND ? "&&" : "||");
+            break;
+
+        case OPCODE_MULADD_I64:
+            fprintf(out, "sp -= 2; stack[sp - 1].i = stack[sp - 1].i * stack[sp].i + stack[sp + 1].i;");
+            break;
+
+        case OPCODE_MULADD_F64:
+            fprintf(out, "sp -= 2; stack[sp - 1].f = stack[sp - 1].f * stack[sp].f + stack[sp + 1].f;");
+            break;
+
+        case OPCODE_JUMP_UNLESS_EQ_I64: case OPCODE_JUMP_UNLESS_NE_I64:
+        case OPCODE_JUMP_UNLESS_LT_I64: case OPCODE_JUMP_UNLESS_LE_I64:
+        case OPCODE_JUMP_UNLESS_GT_I64: case OPCODE_JUMP_UNLESS_GE_I64:
+            fprintf(out, "sp -= 2; if (!(stack[sp].i %s stack[sp + 1].i)) ",
+                    compare_ops[instr.opcode - OPCODE_JUMP_UNLESS_EQ_I64]);
+            emit_goto(ctx, pc, jump_target(ctx, pc, instr));
+            break;
+
+        case OPCODE_JUMP_UNLESS_EQ_F64: case OPCODE_JUMP_UNLESS_NE_F64:
+        case OPCODE_JUMP_UNLESS_LT_F64: case OPCODE_JUMP_UNLESS_LE_F64:
+        case OPCODE_JUMP_UNLESS_GT_F64: case OPCODE_JUMP_UNLESS_GE_F64:
+            fprintf(out, "sp -= 2; if (!(stack[sp].f %s stack[sp + 1].f)) ",
+                    compare_ops[instr.opcode - OPCODE_JUMP_UNLESS_EQ_F64]);
+            emit_goto(ctx, pc, jump_target(ctx, pc, instr));
+            break;
+
+        case OPCODE_JUMP:
+        case OPCODE_LOOP:
+            emit_goto(ctx, pc, jump_target(ctx, pc, instr));
+            break;
+
+        case OPCODE_JUMP_IF_FALSE:
+            fprintf(out, "if (stack[--sp].i == 0) ");
+            emit_goto(ctx, pc, jump_target(ctx, pc, instr));
+            break;
+
+        // parallel for en serie: un bucle corriente sobre [frame[a], frame[a + 1]).
+        // Lo que la VM prohíbe dentro de la región aquí no se comprueba.
+        case OPCODE_PARALLEL_FOR: {
+            int end = parallel_partner(ctx, pc);
+            if (end < 0) {
+                fprintf(out, "vm->pc = %d; vm_fail(vm, \"parallel for sin PARALLEL_END\"); goto halt;", pc);
+                break;
+            }
+            fprintf(out, "if (frame[%d].i >= frame[%d].i) ", a, a + 1);
+            emit_goto(ctx, pc, end + 1);
+            break;
+        }
+
+        case OPCODE_PARALLEL_END: {
+            int head = parallel_partner(ctx, pc);
+            if (head < 0) break;
+            fprintf(out, "if (++frame[%d].i < frame[%d].i) ", a, a + 1);
+            emit_goto(ctx, pc, head + 1);
+            break;
+        }
+
+        default:
+            fprintf(out, "/* opcode 0x%02x sin efecto */", instr.opcode);
+            break;
+    }
+}
+
+static void emit_program(AotContext *ctx, const char *bytecode_file, const uint8_t *image, size_t image_size) {
+    FILE *out = ctx->out;
+    VMState *vm = &ctx->vm;
+
+    fprintf(out, "// Generado por 'gldvm aot' desde %s. No editar.\n", bytecode_file);
+    fprintf(out, "// cc -O2 -I <vm/src> <este fichero> <vm/src>/runtime.c <vm/src>/output.c <vm/src>/format.c <vm/src>/simd.c <vm/src>/sort.c <vm/src>/parallel.c -lm -lpthread\n");
+    fprintf(out, "#include <stdio.h>\n#include <stdlib.h>\n#include <math.h>\n#include \"runtime.h\"\n\n");
+
+    // La imagen completa: vm_load_image reconstruye globales, clases y strings
+    fprintf(out, "static const uint8_t image[%zu] = {", image_size);
+    for (size_t i = 0; i < image_size; i++) {
+        fprintf(out, "%s%u,", i % 20 == 0 ? "\n    " : "", image[i]);
+    }
+    fprintf(out, "\n};\n\n");
+
+    fprintf(out, "#define PUSH_F(x) do { if (sp < 256) stack[sp++].f = (x); } while (0)\n");
+    fprintf(out, "#define PUSH_I(x) do { if (sp < 256) stack[sp++].i = (x); } while (0)\n");
+    fprintf(out, "#define PUSH_RAW(x) do { if (sp < 256) stack[sp++] = (x); } while (0)\n\n");
+
+    int chunk_count = (vm->instruction_count + AOT_CHUNK - 1) / AOT_CHUNK;
+    for (int chunk = 0; chunk < chunk_count; chunk++) {
+        int start = chunk * AOT_CHUNK;
+        int end = start + AOT_CHUNK < vm->instruction_count ? start + AOT_CHUNK : vm->instruction_count;
+
+        fprintf(out, "static int chunk%d(VMState *vm, int pc) {\n", chunk);
+        fprintf(out, "    Value *stack = vm->stack;\n");
+        fprintf(out, "    Value *frame = vm->locals + vm->fp;\n");
+        fprintf(out, "    int sp = vm->sp;\n");
+        fprintf(out, "    (void)stack;\n");
+        fprintf(out, "    (void)frame;\n");
+        fprintf(out, "    switch (pc) {\n");
+        fprintf(out, "        case %d: goto L%d;\n", start, start);
+        for (int pc = start + 1; pc < end; pc++) {
+            if (ctx->labels[pc] & AOT_ENTRY) fprintf(out, "        case %d: goto L%d;\n", pc, pc);
+        }
+        fprintf(out, "        default: goto halt;\n");
+        fprintf(out, "    }\n\n");
+
+        for (int pc = start; pc < end; pc++) {
+            if (pc == start || ctx->labels[pc]) fprintf(out, "L%d:\n", pc);
+            fprintf(out, "    ");
+            emit_instruction(ctx, pc);
+            fprintf(out, "\n");
+        }
+        fprintf(out, "    vm->sp = sp;\n");
+        fprintf(out, "    return %d;\n", end);
+        fprintf(out, "halt:\n");
+        fprintf(out, "    vm->sp = sp;\n");
+        fprintf(out, "    return -1;\n");
+        fprintf(out, "}\n\n");
+    }
+
+    // Trampolín: cada trozo devuelve el PC por el que seguir (-1 = fin)
+    fprintf(out, "static void run(VMState *vm) {\n");
+    if (chunk_count > 0) {
+        fprintf(out, "    static int (*const chunks[])(VMState *, int) = {");
+        for (int chunk = 0; chunk < chunk_count; chunk++) {
+            fprintf(out, "%schunk%d,", chunk % 8 == 0 ? "\n        " : " ", chunk);
+        }
+        fprintf(out, "\n    };\n");
+        fprintf(out, "    int pc = 0;\n");
+        fprintf(out, "    while (pc >= 0 && pc < %d) pc = chunks[pc / %d](vm, pc);\n",
+                vm->instruction_count, AOT_CHUNK);
+    } else {
+        fprintf(out, "    (void)vm;\n");
+    }
+    fprintf(out, "}\n\n");
+
+    fprintf(out, "int main(void) {\n");
+    fprintf(out, "    VMState vm;\n");
+    fprintf(out, "    if (vm_load_image(&vm, image, sizeof(image), 0) != 0) return EXIT_FAILURE;\n");
+    fprintf(out, "    output_init(&vm.out, 1, OUTPUT_DEFAULT_CAPACITY);\n");
+    fprintf(out, "    run(&vm);\n");
+    fprintf(out, "    vm_release(&vm);\n");
+    fprintf(out, "    return vm.failed ? EXIT_FAILURE : EXIT_SUCCESS;\n");
+    fprintf(out, "}\n");
+}
+
+int aot_translate(const char *bytecode_file, const char *output_file) {
+    size_t image_size = 0;
+    uint8_t *image = vm_read_file(bytecode_file, &image_size);
+    if (!image) return -1;
+
+    AotContext ctx;
+    memset(&ctx, 0, sizeof(ctx));
+    if (vm_load_image(&ctx.vm, image, image_size, 0) != 0) {
+        free(image);
+        return -1;
+    }
+
+    ctx.labels = (uint8_t*)calloc(ctx.vm.instruction_count + 1, 1);
+    ctx.frame_sizes = (int*)calloc(ctx.vm.instruction_count + 1, sizeof(int));
+    ctx.out = fopen(output_file, "w");
+    int status = -1;
+    if (!ctx.labels || !ctx.frame_sizes) {
+        fprintf(stderr, "Error: No hay memoria suficiente\n");
+    } else if (!ctx.out) {
+        fprintf(stderr, "Error: No se puede crear '%s'\n", output_file);
+    } else {
+        analyze(&ctx);
+        emit_program(&ctx, bytecode_file, image, image_size);
+        status = ferror(ctx.out) ? -1 : 0;
+        if (status != 0) fprintf(stderr, "Error: No se puede escribir '%s'\n", output_file);
+    }
+
+    if (ctx.out) fclose(ctx.out);
+    free(ctx.labels);
+    free(ctx.frame_sizes);
+    vm_release(&ctx.vm);
+    free(image);
+    return status;
+}
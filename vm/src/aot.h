@@ -0,0 +1,17 @@
+#ifndef AOT_H
+#define AOT_H
+
+// Traducción anticipada (gldvm aot): convierte el bytecode de un .gld en un
+// fuente C equivalente. Cada instrucción se vuelve unas pocas líneas de C con
+// los operandos ya resueltos y los saltos como goto, sin bucle de despacho.
+// El fuente lleva la imagen .gld embebida (globales, clases, strings) y se
+// enlaza con runtime.c, output.c, format.c, simd.c, sort.c y parallel.c:
+//
+//     cc -O2 -I vm/src prog.c vm/src/runtime.c vm/src/output.c vm/src/format.c vm/src/simd.c vm/src/sort.c vm/src/parallel.c -lm -lpthread -o prog
+//
+// El ejecutable corre siempre en modo consola.
+
+// Escribe en 'output_file' el C de 'bytecode_file'. 0 o -1 (ya informado).
+int aot_translate(const char *bytecode_file, const char *output_file);
+
+#endif
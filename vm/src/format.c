@@ -0,0 +1,383 @@
+#include <string.h>
+#include "format.h"
+
+static const char DIGIT_PAIRS[201] =
+    "0001020304050607080910111213141516171819"
+    "2021222324252627282930313233343536373839"
+    "4041424344454647484950515253545556575859"
+    "6061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+
+static const uint64_t POW10[20] = {
+    1ull, 10ull, 100ull, 1000ull, 10000ull, 100000ull, 1000000ull, 10000000ull,
+    100000000ull, 1000000000ull, 10000000000ull, 100000000000ull, 1000000000000ull,
+    10000000000000ull, 100000000000000ull, 1000000000000000ull, 10000000000000000ull,
+    100000000000000000ull, 1000000000000000000ull, 10000000000000000000ull
+};
+
+static int leading_zeros64(uint64_t value) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_clzll(value);
+#else
+    int count = 0;
+    while (!(value & (1ull << 63))) {
+        value <<= 1;
+        count++;
+    }
+    return count;
+#endif
+}
+
+// Dígitos decimales de 'value' (1 para el 0): log10 aproximado a partir del
+// bit más alto (1233 / 4096 ~ log10(2)) y una comparación para corregirlo
+static int digit_count(uint64_t value) {
+    value |= 1;  // No cruza ninguna potencia de 10 y evita clz(0)
+    int t = ((64 - leading_zeros64(value)) * 1233) >> 12;
+    return t + (value >= POW10[t]);
+}
+
+// Escribe 'value' hacia atrás terminando justo antes de 'end', de dos en dos
+static void write_digits(char *end, uint64_t value) {
+    while (value >= 100) {
+        unsigned pair = (unsigned)(value % 100);
+        value /= 100;
+        end -= 2;
+        memcpy(end, DIGIT_PAIRS + 2 * pair, 2);
+    }
+    if (value >= 10) {
+        memcpy(end - 2, DIGIT_PAIRS + 2 * value, 2);
+    } else {
+        end[-1] = (char)('0' + value);
+    }
+}
+
+int format_int64(char *dst, int64_t value) {
+    // Valor absoluto y signo sin saltos: el '-' se escribe siempre y solo
+    // se avanza sobre él si el número es negativo
+    uint64_t mask = (uint64_t)0 - (uint64_t)(value < 0);
+    uint64_t magnitude = ((uint64_t)value ^ mask) - mask;
+    int negative = (int)(mask & 1);
+    dst[0] = '-';
+    int length = negative + digit_count(magnitude);
+    write_digits(dst + length, magnitude);
+    return length;
+}
+
+// ---------------------------------------------------------------------------
+// Ryu: dígitos más cortos de un double (d2s de la implementación de
+// referencia con la tabla completa). Las tablas de potencias de 5 se calculan
+// la primera vez con aritmética exacta en vez de llevarlas en el fuente.
+
+#define DOUBLE_MANTISSA_BITS 52
+#define DOUBLE_EXPONENT_BITS 11
+#define DOUBLE_BIAS          1023
+#define POW5_INV_BITCOUNT    125
+#define POW5_BITCOUNT        125
+#define POW5_INV_TABLE_SIZE  342
+#define POW5_TABLE_SIZE      326
+
+// floor(2^j / 5^q) + 1 y 5^i normalizado a 125 bits, como {bajo, alto}
+static uint64_t pow5_inv_split[POW5_INV_TABLE_SIZE][2];
+static uint64_t pow5_split[POW5_TABLE_SIZE][2];
+static int tables_ready = 0;
+
+// Entero sin signo de precisión fija: hasta 2^1024 y 5^341 (792 bits)
+#define BIG_LIMBS 34
+#define BIG_INV_BITS 1024
+
+typedef struct {
+    uint32_t limb[BIG_LIMBS];  // Little-endian
+} BigNum;
+
+static void big_mul_small(BigNum *b, uint32_t factor) {
+    uint64_t carry = 0;
+    for (int i = 0; i < BIG_LIMBS; i++) {
+        uint64_t t = (uint64_t)b->limb[i] * factor + carry;
+        b->limb[i] = (uint32_t)t;
+        carry = t >> 32;
+    }
+}
+
+static void big_div_small(BigNum *b, uint32_t divisor) {
+    uint64_t rem = 0;
+    for (int i = BIG_LIMBS - 1; i >= 0; i--) {
+        uint64_t cur = (rem << 32) | b->limb[i];
+        b->limb[i] = (uint32_t)(cur / divisor);
+        rem = cur % divisor;
+    }
+}
+
+static int big_bit_length(const BigNum *b) {
+    for (int i = BIG_LIMBS - 1; i >= 0; i--) {
+        if (b->limb[i]) return i * 32 + 64 - leading_zeros64(b->limb[i]);
+    }
+    return 0;
+}
+
+// Los 128 bits de 'b' que empiezan en el bit 'shift' (negativo = desplazar a
+// la izquierda)
+static void big_bits(const BigNum *b, int shift, uint64_t out[2]) {
+    out[0] = out[1] = 0;
+    for (int k = 0; k < 128; k++) {
+        int src = shift + k;
+        if (src < 0 || src >= BIG_LIMBS * 32) continue;
+        if ((b->limb[src >> 5] >> (src & 31)) & 1) out[k >> 6] |= 1ull << (k & 63);
+    }
+}
+
+static void init_tables(void) {
+    BigNum pow5, inv;
+    memset(&pow5, 0, sizeof(pow5));
+    memset(&inv, 0, sizeof(inv));
+    pow5.limb[0] = 1;
+    inv.limb[BIG_INV_BITS / 32] = 1;  // 2^1024; tras q divisiones, floor(2^1024 / 5^q)
+
+    for (int q = 0; q < POW5_INV_TABLE_SIZE; q++) {
+        int length = big_bit_length(&pow5);
+        if (q < POW5_TABLE_SIZE) big_bits(&pow5, length - POW5_BITCOUNT, pow5_split[q]);
+        // floor(2^j / 5^q) = floor(2^1024 / 5^q) >> (1024 - j)
+        int j = length - 1 + POW5_INV_BITCOUNT;
+        uint64_t *entry = pow5_inv_split[q];
+        big_bits(&inv, BIG_INV_BITS - j, entry);
+        if (++entry[0] == 0) entry[1]++;
+        big_mul_small(&pow5, 5);
+        big_div_small(&inv, 5);
+    }
+    tables_ready = 1;
+}
+
+// ceil(log2(5^e)) para e > 0; 1 para e = 0
+static int pow5bits(int e) {
+    return (int)(((uint32_t)e * 1217359) >> 19) + 1;
+}
+
+// floor(log10(2^e))
+static int log10_pow2(int e) {
+    return (int)(((uint32_t)e * 78913) >> 18);
+}
+
+// floor(log10(5^e))
+static int log10_pow5(int e) {
+    return (int)(((uint32_t)e * 732923) >> 20);
+}
+
+static int pow5_factor(uint64_t value) {
+    int count = 0;
+    while (value % 5 == 0) {
+        value /= 5;
+        count++;
+    }
+    return count;
+}
+
+#if !defined(__SIZEOF_INT128__)
+// Producto completo de 64x64 bits por mitades de 32; devuelve la parte baja
+static uint64_t umul128(uint64_t a, uint64_t b, uint64_t *high) {
+    uint64_t b00 = (a & 0xFFFFFFFFu) * (b & 0xFFFFFFFFu);
+    uint64_t b01 = (a & 0xFFFFFFFFu) * (b >> 32);
+    uint64_t b10 = (a >> 32) * (b & 0xFFFFFFFFu);
+    uint64_t b11 = (a >> 32) * (b >> 32);
+    uint64_t mid1 = b10 + (b00 >> 32);
+    uint64_t mid2 = b01 + (mid1 & 0xFFFFFFFFu);
+    *high = b11 + (mid1 >> 32) + (mid2 >> 32);
+    return (mid2 << 32) | (b00 & 0xFFFFFFFFu);
+}
+#endif
+
+// (m * mul) >> j, con mul de 128 bits y 64 <= j < 128
+static uint64_t mul_shift64(uint64_t m, const uint64_t mul[2], int j) {
+#if defined(__SIZEOF_INT128__)
+    unsigned __int128 b0 = (unsigned __int128)m * mul[0];
+    unsigned __int128 b2 = (unsigned __int128)m * mul[1];
+    return (uint64_t)(((b0 >> 64) + b2) >> (j - 64));
+#else
+    uint64_t high0, high1;
+    umul128(m, mul[0], &high0);
+    uint64_t low1 = umul128(m, mul[1], &high1);
+    uint64_t sum = high0 + low1;
+    if (sum < high0) high1++;
+    int dist = j - 64;
+    return dist == 0 ? sum : (high1 << (64 - dist)) | (sum >> dist);
+#endif
+}
+
+// Dígitos más cortos 'output' y exponente decimal: value = output * 10^exponent
+static uint64_t shortest_digits(uint64_t ieee_mantissa, uint32_t ieee_exponent, int *exponent) {
+    int e2;
+    uint64_t m2;
+    if (ieee_exponent == 0) {
+        e2 = 1 - DOUBLE_BIAS - DOUBLE_MANTISSA_BITS - 2;
+        m2 = ieee_mantissa;
+    } else {
+        e2 = (int)ieee_exponent - DOUBLE_BIAS - DOUBLE_MANTISSA_BITS - 2;
+        m2 = (1ull << DOUBLE_MANTISSA_BITS) | ieee_mantissa;
+    }
+    int accept_bounds = (m2 & 1) == 0;
+
+    // Intervalo de los reales que se redondean a este double: [mm, mp] / 4
+    uint64_t mv = 4 * m2;
+    uint32_t mm_shift = ieee_mantissa != 0 || ieee_exponent <= 1;
+
+    uint64_t vr, vp, vm;
+    int e10;
+    int vm_is_trailing_zeros = 0, vr_is_trailing_zeros = 0;
+    if (e2 >= 0) {
+        int q = log10_pow2(e2) - (e2 > 3);
+        e10 = q;
+        int k = POW5_INV_BITCOUNT + pow5bits(q) - 1;
+        int i = -e2 + q + k;
+        vr = mul_shift64(4 * m2, pow5_inv_split[q], i);
+        vp = mul_shift64(4 * m2 + 2, pow5_inv_split[q], i);
+        vm = mul_shift64(4 * m2 - 1 - mm_shift, pow5_inv_split[q], i);
+        if (q <= 21) {
+            // Solo aquí puede quedar un resultado exacto con ceros finales
+            if (mv % 5 == 0) {
+                vr_is_trailing_zeros = pow5_factor(mv) >= q;
+            } else if (accept_bounds) {
+                vm_is_trailing_zeros = pow5_factor(mv - 1 - mm_shift) >= q;
+            } else {
+                vp -= pow5_factor(mv + 2) >= q;
+            }
+        }
+    } else {
+        int q = log10_pow5(-e2) - (-e2 > 1);
+        e10 = q + e2;
+        int i = -e2 - q;
+        int k = pow5bits(i) - POW5_BITCOUNT;
+        int j = q - k;
+        vr = mul_shift64(4 * m2, pow5_split[i], j);
+        vp = mul_shift64(4 * m2 + 2, pow5_split[i], j);
+        vm = mul_shift64(4 * m2 - 1 - mm_shift, pow5_split[i], j);
+        if (q <= 1) {
+            vr_is_trailing_zeros = 1;
+            if (accept_bounds) {
+                vm_is_trailing_zeros = mm_shift == 1;
+            } else {
+                vp--;
+            }
+        } else if (q < 63) {
+            vr_is_trailing_zeros = (mv & ((1ull << q) - 1)) == 0;
+        }
+    }
+
+    // Quitar dígitos mientras el intervalo siga conteniendo un solo candidato
+    int removed = 0;
+    uint8_t last_removed_digit = 0;
+    uint64_t output;
+    if (vm_is_trailing_zeros || vr_is_trailing_zeros) {
+        // Caso general (poco frecuente)
+        while (vp / 10 > vm / 10) {
+            vm_is_trailing_zeros &= vm % 10 == 0;
+            vr_is_trailing_zeros &= last_removed_digit == 0;
+            last_removed_digit = (uint8_t)(vr % 10);
+            vr /= 10;
+            vp /= 10;
+            vm /= 10;
+            removed++;
+        }
+        if (vm_is_trailing_zeros) {
+            while (vm % 10 == 0) {
+                vr_is_trailing_zeros &= last_removed_digit == 0;
+                last_removed_digit = (uint8_t)(vr % 10);
+                vr /= 10;
+                vp /= 10;
+                vm /= 10;
+                removed++;
+            }
+        }
+        if (vr_is_trailing_zeros && last_removed_digit == 5 && vr % 2 == 0) {
+            last_removed_digit = 4;  // Empate exacto: redondeo a par
+        }
+        output = vr + ((vr == vm && (!accept_bounds || !vm_is_trailing_zeros)) || last_removed_digit >= 5);
+    } else {
+        int round_up = 0;
+        if (vp / 100 > vm / 100) {
+            round_up = vr % 100 >= 50;
+            vr /= 100;
+            vp /= 100;
+            vm /= 100;
+            removed += 2;
+        }
+        while (vp / 10 > vm / 10) {
+            round_up = vr % 10 >= 5;
+            vr /= 10;
+            vp /= 10;
+            vm /= 10;
+            removed++;
+        }
+        output = vr + (vr == vm || round_up);
+    }
+    *exponent = e10 + removed;
+    return output;
+}
+
+int format_double(char *dst, double value) {
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    int negative = (int)(bits >> 63);
+    uint64_t ieee_mantissa = bits & ((1ull << DOUBLE_MANTISSA_BITS) - 1);
+    uint32_t ieee_exponent = (uint32_t)(bits >> DOUBLE_MANTISSA_BITS) & ((1u << DOUBLE_EXPONENT_BITS) - 1);
+
+    if (ieee_exponent == (1u << DOUBLE_EXPONENT_BITS) - 1) {
+        if (ieee_mantissa) {
+            memcpy(dst, "nan", 3);
+            return 3;
+        }
+        if (negative) {
+            memcpy(dst, "-inf", 4);
+            return 4;
+        }
+        memcpy(dst, "inf", 3);
+        return 3;
+    }
+
+    // Enteros exactos (|value| <= 2^53, también -0): sin pasar por Ryu
+    if (value >= -9007199254740992.0 && value <= 9007199254740992.0 &&
+        value == (double)(int64_t)value) {
+        return format_int64(dst, (int64_t)value);
+    }
+
+    if (!tables_ready) init_tables();
+    int exponent;
+    uint64_t output = shortest_digits(ieee_mantissa, ieee_exponent, &exponent);
+
+    char digits[20];
+    int count = digit_count(output);
+    write_digits(digits + count, output);
+
+    // 'point' = dígitos antes de la coma: value = 0.digits * 10^point
+    int point = count + exponent;
+    char *p = dst;
+    *p = '-';
+    p += negative;
+    if (point > 0 && point <= 21) {
+        if (count <= point) {
+            memcpy(p, digits, count);
+            memset(p + count, '0', point - count);
+            p += point;
+        } else {
+            memcpy(p, digits, point);
+            p[point] = '.';
+            memcpy(p + point + 1, digits + point, count - point);
+            p += count + 1;
+        }
+    } else if (point <= 0 && point > -6) {
+        p[0] = '0';
+        p[1] = '.';
+        memset(p + 2, '0', -point);
+        memcpy(p + 2 - point, digits, count);
+        p += 2 - point + count;
+    } else {
+        *p++ = digits[0];
+        if (count > 1) {
+            *p++ = '.';
+            memcpy(p, digits + 1, count - 1);
+            p += count - 1;
+        }
+        int e = point - 1;
+        *p++ = 'e';
+        *p++ = e < 0 ? '-' : '+';
+        p += format_int64(p, e < 0 ? -e : e);
+    }
+    return (int)(p - dst);
+}
@@ -0,0 +1,22 @@
+#ifndef FORMAT_H
+#define FORMAT_H
+
+#include <stdint.h>
+
+// Conversión de números a texto para PRINTLN, sin printf ni locale.
+//
+// Los enteros se escriben de dos en dos dígitos desde una tabla. Los double
+// con el algoritmo Ryu (Ulf Adams, PLDI 2018): la secuencia de dígitos más
+// corta que vuelve a leerse como el mismo double. La notación sigue a
+// JavaScript: "3", "0.1", "1.5e+300", "1e-7"; los valores enteros de menos de
+// 1e21 van sin decimales, "nan", "inf" y "-inf" para los no finitos.
+
+// Bytes que puede ocupar cualquier número (sin '\0')
+#define FORMAT_NUMBER_MAX 32
+
+// Escriben en 'dst' (al menos FORMAT_NUMBER_MAX bytes, sin '\0') y devuelven
+// la longitud
+int format_int64(char *dst, int64_t value);
+int format_double(char *dst, double value);
+
+#endif
@@ -0,0 +1,751 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "jit.h"
+
+#if defined(__x86_64__) && defined(__linux__)
+
+#include <stddef.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+// Registros del código generado (todos callee-saved):
+//   rbx = &vm->stack[sp] (siguiente slot libre)
+//   r12 = vm->stack
+//   r13 = frame de locales
+//   r14 = vm
+// rax, rcx, rdx, xmm0 son temporales de cada plantilla.
+
+#define JIT_NOT_TRIED 0
+#define JIT_FAILED    1
+#define JIT_READY     2
+
+typedef struct {
+    void *memory;
+    size_t size;
+} JitRegion;
+
+struct JitState {
+    uint8_t *status;       // Por PC de LOOP: JIT_NOT_TRIED / JIT_FAILED / JIT_READY
+    JitCode *code;         // Por PC de LOOP
+    JitRegion *regions;
+    int region_count;
+    FILE *perf_map;
+    int debug;
+};
+
+// Buffer de emisión con los saltos pendientes de resolver
+typedef struct {
+    uint8_t *bytes;
+    size_t size;
+    size_t capacity;
+    int failed;
+
+    int head;              // Primer PC de la región
+    int end;               // Último PC (el LOOP)
+    size_t *offsets;       // Desplazamiento del código de cada PC de la región
+
+    struct {
+        size_t at;         // Posición del rel32
+        int target;        // PC de destino
+    } *fixups;
+    int fixup_count;
+    int fixup_capacity;
+} Emitter;
+
+static void emit_bytes(Emitter *e, const uint8_t *bytes, size_t count) {
+    if (e->size + count > e->capacity) {
+        size_t capacity = e->capacity ? e->capacity * 2 : 4096;
+        while (capacity < e->size + count) capacity *= 2;
+        uint8_t *temp = realloc(e->bytes, capacity);
+        if (!temp) {
+            e->failed = 1;
+            return;
+        }
+        e->bytes = temp;
+        e->capacity = capacity;
+    }
+    memcpy(e->bytes + e->size, bytes, count);
+    e->size += count;
+}
+
+#define EMIT(e, ...) do { \
+        static const uint8_t code_[] = { __VA_ARGS__ }; \
+        emit_bytes((e), code_, sizeof(code_)); \
+    } while (0)
+
+static void emit_u32(Emitter *e, uint32_t value) {
+    uint8_t bytes[4] = { value, value >> 8, value >> 16, value >> 24 };
+    emit_bytes(e, bytes, 4);
+}
+
+static void emit_u64(Emitter *e, uint64_t value) {
+    emit_u32(e, (uint32_t)value);
+    emit_u32(e, (uint32_t)(value >> 32));
+}
+
+// rel32 hacia el código del PC 'target' (se resuelve al terminar)
+static void emit_target(Emitter *e, int target) {
+    if (e->fixup_count >= e->fixup_capacity) {
+        int capacity = e->fixup_capacity ? e->fixup_capacity * 2 : 64;
+        void *temp = realloc(e->fixups, capacity * sizeof(*e->fixups));
+        if (!temp) {
+            e->failed = 1;
+            return;
+        }
+        e->fixups = temp;
+        e->fixup_capacity = capacity;
+    }
+    e->fixups[e->fixup_count].at = e->size;
+    e->fixups[e->fixup_count].target = target;
+    e->fixup_count++;
+    emit_u32(e, 0);
+}
+
+// Salida al intérprete: eax = PC, y al epílogo común (al final del código)
+static void emit_exit(Emitter *e, int pc) {
+    EMIT(e, 0xB8);                              // mov eax, pc
+    emit_u32(e, (uint32_t)pc);
+    EMIT(e, 0xE9);                              // jmp epílogo
+    emit_target(e, -1);
+}
+
+// jmp / jcc rel32 a un PC: dentro de la región es un salto directo; fuera,
+// a una salida que devuelve ese PC
+static void emit_jump(Emitter *e, const uint8_t *opcode, size_t opcode_size, int target) {
+    emit_bytes(e, opcode, opcode_size);
+    emit_target(e, target >= e->head && target <= e->end ? target : -2 - target);
+}
+
+static void emit_jmp(Emitter *e, int target) {
+    static const uint8_t jmp[] = { 0xE9 };
+    emit_jump(e, jmp, 1, target);
+}
+
+static void emit_jcc(Emitter *e, uint8_t cc, int target) {
+    uint8_t jcc[] = { 0x0F, cc };
+    emit_jump(e, jcc, 2, target);
+}
+
+static void emit_push_rax(Emitter *e) {
+    EMIT(e, 0x48, 0x89, 0x03,                   // mov [rbx], rax
+            0x48, 0x83, 0xC3, 0x08);            // add rbx, 8
+}
+
+// Tope ← rax como 0/1 a partir de al, quitando un operando
+static void emit_store_flag(Emitter *e) {
+    EMIT(e, 0x0F, 0xB6, 0xC0,                   // movzx eax, al
+            0x48, 0x83, 0xEB, 0x08,             // sub rbx, 8
+            0x48, 0x89, 0x43, 0xF8);            // mov [rbx-8], rax
+}
+
+// al = comparación (orden EQ, NE, LT, LE, GT, GE) de [rbx-16] con [rbx-8]
+static void emit_compare_i64(Emitter *e, int op) {
+    static const uint8_t setcc[] = { 0x94, 0x95, 0x9C, 0x9E, 0x9F, 0x9D };
+    EMIT(e, 0x48, 0x8B, 0x43, 0xF0,             // mov rax, [rbx-16]
+            0x48, 0x3B, 0x43, 0xF8);            // cmp rax, [rbx-8]
+    uint8_t set[] = { 0x0F, setcc[op], 0xC0 };  // setcc al
+    emit_bytes(e, set, 3);
+}
+
+// Como emit_compare_i64 en double. Con NaN todas son falsas salvo NE, igual
+// que en C; LT/LE se hacen con los operandos cambiados para usar seta/setae.
+static void emit_compare_f64(Emitter *e, int op) {
+    if (op == 2 || op == 3) {
+        EMIT(e, 0xF2, 0x0F, 0x10, 0x43, 0xF8,   // movsd xmm0, [rbx-8]
+                0x66, 0x0F, 0x2E, 0x43, 0xF0);  // ucomisd xmm0, [rbx-16]
+    } else {
+        EMIT(e, 0xF2, 0x0F, 0x10, 0x43, 0xF0,   // movsd xmm0, [rbx-16]
+                0x66, 0x0F, 0x2E, 0x43, 0xF8);  // ucomisd xmm0, [rbx-8]
+    }
+    switch (op) {
+        case 0: EMIT(e, 0x0F, 0x94, 0xC0, 0x0F, 0x9B, 0xC1, 0x20, 0xC8); break;  // sete; setnp; and
+        case 1: EMIT(e, 0x0F, 0x95, 0xC0, 0x0F, 0x9A, 0xC1, 0x08, 0xC8); break;  // setne; setp; or
+        case 2: case 4: EMIT(e, 0x0F, 0x97, 0xC0); break;                         // seta
+        default: EMIT(e, 0x0F, 0x93, 0xC0); break;                                // setae
+    }
+}
+
+// Array estático que accede un ARRAY_GET/SET (genérico o acelerado), o NULL
+static const Array *static_array(const VMState *vm, Instruction instr) {
+    int index = -1;
+    switch (instr.opcode) {
+        case OPCODE_ARRAY_GET: case OPCODE_ARRAY_GET_I64:
+        case OPCODE_ARRAY_SET: case OPCODE_ARRAY_SET_I64:
+        case OPCODE_ARRAY_GET_INT: case OPCODE_ARRAY_SET_INT:
+            if (instr.arg1 < vm->variable_count && vm->variables[instr.arg1].type == 'a') {
+                index = (int)vm->variables[instr.arg1].value;
+            }
+            break;
+        case OPCODE_ARRAY_GET_STATIC: case OPCODE_ARRAY_GET_STATIC_I64:
+        case OPCODE_ARRAY_SET_STATIC: case OPCODE_ARRAY_SET_STATIC_I64:
+        case OPCODE_ARRAY_GET_INT_STATIC: case OPCODE_ARRAY_SET_INT_STATIC:
+            index = instr.arg1;
+            break;
+    }
+    return index >= 0 && index < vm->array_count ? &vm->arrays[index] : NULL;
+}
+
+static int is_int_index(uint8_t opcode) {
+    return opcode == OPCODE_ARRAY_GET_I64 || opcode == OPCODE_ARRAY_SET_I64 ||
+           opcode == OPCODE_ARRAY_GET_STATIC_I64 || opcode == OPCODE_ARRAY_SET_STATIC_I64;
+}
+
+// Carga de data[rax] en rdx (load) o guardado de rdx en data[rax] (store)
+// para un array de enteros del tipo dado, con rcx = data. 'size' recibe los
+// bytes de la secuencia; NULL si el tipo no es entero. En los hilos de
+// parallel for ('atomic') los bool se guardan con lock bts/btr: el byte es
+// de 8 elementos que pueden escribir hilos distintos.
+static const uint8_t *int_element_access(char type, int store, int atomic, uint8_t *size) {
+    static const uint8_t load_int32[] = { 0x48, 0x63, 0x14, 0x81 };        // movsxd rdx, [rcx + rax*4]
+    static const uint8_t load_int64[] = { 0x48, 0x8B, 0x14, 0xC1 };        // mov rdx, [rcx + rax*8]
+    static const uint8_t load_uint8[] = { 0x0F, 0xB6, 0x14, 0x01 };        // movzx edx, byte [rcx + rax]
+    static const uint8_t load_bit[] = { 0x48, 0x0F, 0xA3, 0x01,            // bt [rcx], rax
+                                        0x0F, 0x92, 0xC2 };                // setc dl
+    static const uint8_t store_int32[] = { 0x89, 0x14, 0x81 };             // mov [rcx + rax*4], edx
+    static const uint8_t store_int64[] = { 0x48, 0x89, 0x14, 0xC1 };       // mov [rcx + rax*8], rdx
+    static const uint8_t store_uint8[] = { 0x88, 0x14, 0x01 };             // mov [rcx + rax], dl
+    static const uint8_t store_bit[] = { 0x48, 0x85, 0xD2,                 // test rdx, rdx
+                                         0x74, 0x06,                       // jz +6
+                                         0x48, 0x0F, 0xAB, 0x01,           // bts [rcx], rax
+                                         0xEB, 0x04,                       // jmp +4
+                                         0x48, 0x0F, 0xB3, 0x01 };         // btr [rcx], rax
+    static const uint8_t store_bit_atomic[] = { 0x48, 0x85, 0xD2,          // test rdx, rdx
+                                                0x74, 0x07,                // jz +7
+                                                0xF0, 0x48, 0x0F, 0xAB, 0x01,  // lock bts [rcx], rax
+                                                0xEB, 0x05,                // jmp +5
+                                                0xF0, 0x48, 0x0F, 0xB3, 0x01 };  // lock btr [rcx], rax
+    switch (type) {
+        case 'i': *size = store ? sizeof(store_int32) : sizeof(load_int32); return store ? store_int32 : load_int32;
+        case 'l': *size = store ? sizeof(store_int64) : sizeof(load_int64); return store ? store_int64 : load_int64;
+        case 'u': *size = store ? sizeof(store_uint8) : sizeof(load_uint8); return store ? store_uint8 : load_uint8;
+        case 'z':
+            if (store && atomic) {
+                *size = sizeof(store_bit_atomic);
+                return store_bit_atomic;
+            }
+            *size = store ? sizeof(store_bit) : sizeof(load_bit);
+            return store ? store_bit : load_bit;
+        default:  return NULL;
+    }
+}
+
+// rax = índice del elemento en [rbx+disp]
+static void emit_index(Emitter *e, int int_index, uint8_t disp) {
+    if (int_index) {
+        uint8_t mov[] = { 0x48, 0x8B, 0x43, disp };               // mov rax, [rbx+disp]
+        emit_bytes(e, mov, 4);
+    } else {
+        uint8_t cvt[] = { 0xF2, 0x48, 0x0F, 0x2C, 0x43, disp };   // cvttsd2si rax, [rbx+disp]
+        emit_bytes(e, cvt, 6);
+    }
+}
+
+// Plantilla de una instrucción; 0 si no tiene (se emite una salida)
+static int emit_instruction(Emitter *e, const VMState *vm, int pc) {
+    Instruction instr = vm->instructions[pc];
+    int target = pc + 1 + (int16_t)(instr.arg1 | (instr.arg2 << 8));
+
+    switch (instr.opcode) {
+        case OPCODE_PUSH_INT:
+            EMIT(e, 0x48, 0xC7, 0xC0);          // mov rax, imm32
+            emit_u32(e, (uint32_t)(int32_t)(int16_t)(instr.arg1 | (instr.arg2 << 8)));
+            emit_push_rax(e);
+            return 1;
+
+        case OPCODE_PUSH_I64:
+            if (instr.arg1 >= vm->string_pool.string_count) return 0;
+            EMIT(e, 0x48, 0xB8);                // mov rax, imm64
+            emit_u64(e, (uint64_t)strtoll(vm->string_pool.strings[instr.arg1], NULL, 10));
+            emit_push_rax(e);
+            return 1;
+
+        case OPCODE_PUSH_VALUE: {
+            if (instr.arg1 >= vm->string_pool.string_count) return 0;
+            double value = atof(vm->string_pool.strings[instr.arg1]);
+            uint64_t bits;
+            memcpy(&bits, &value, sizeof(bits));
+            EMIT(e, 0x48, 0xB8);                // mov rax, imm64
+            emit_u64(e, bits);
+            emit_push_rax(e);
+            return 1;
+        }
+
+        case OPCODE_GET_GLOBAL:
+        case OPCODE_GET_GLOBAL_NUMBER:
+            if (instr.arg1 >= vm->variable_count || vm->variables[instr.arg1].type == 's') return 0;
+            EMIT(e, 0x48, 0xB8);                // mov rax, &variables[arg1].value
+            emit_u64(e, (uint64_t)(uintptr_t)&vm->variables[instr.arg1].value);
+            EMIT(e, 0x48, 0x8B, 0x00);          // mov rax, [rax]
+            emit_push_rax(e);
+            return 1;
+
+        case OPCODE_POP_VALUE:
+            EMIT(e, 0x4C, 0x39, 0xE3,           // cmp rbx, r12
+                    0x76, 0x04,                 // jbe +4 (stack vacío)
+                    0x48, 0x83, 0xEB, 0x08);    // sub rbx, 8
+            return 1;
+
+        case OPCODE_LOAD_LOCAL:
+            if (instr.arg1 >= vm->frame_size) return 0;
+            EMIT(e, 0x49, 0x8B, 0x85);          // mov rax, [r13 + disp32]
+            emit_u32(e, instr.arg1 * sizeof(Value));
+            emit_push_rax(e);
+            return 1;
+
+        case OPCODE_STORE_LOCAL:
+            if (instr.arg1 >= vm->frame_size) return 0;
+            EMIT(e, 0x48, 0x83, 0xEB, 0x08,     // sub rbx, 8
+                    0x48, 0x8B, 0x03,           // mov rax, [rbx]
+                    0x49, 0x89, 0x85);          // mov [r13 + disp32], rax
+            emit_u32(e, instr.arg1 * sizeof(Value));
+            return 1;
+
+        case OPCODE_ADD_I64:
+        case OPCODE_SUB_I64:
+            EMIT(e, 0x48, 0x8B, 0x43, 0xF8,     // mov rax, [rbx-8]
+                    0x48, 0x83, 0xEB, 0x08);    // sub rbx, 8
+            if (instr.opcode == OPCODE_ADD_I64) {
+                EMIT(e, 0x48, 0x01, 0x43, 0xF8);    // add [rbx-8], rax
+            } else {
+                EMIT(e, 0x48, 0x29, 0x43, 0xF8);    // sub [rbx-8], rax
+            }
+            return 1;
+
+        case OPCODE_MUL_I64:
+            EMIT(e, 0x48, 0x8B, 0x43, 0xF8,     // mov rax, [rbx-8]
+                    0x48, 0x83, 0xEB, 0x08,     // sub rbx, 8
+                    0x48, 0x0F, 0xAF, 0x43, 0xF8,   // imul rax, [rbx-8]
+                    0x48, 0x89, 0x43, 0xF8);    // mov [rbx-8], rax
+            return 1;
+
+        case OPCODE_DIV_I64:
+        case OPCODE_MOD_I64: {
+            // Divisor 0: sale sin tocar el stack y el intérprete da el error.
+            // Divisor -1: sin idiv, que con INT64_MIN lanza SIGFPE (ver vm_step)
+            EMIT(e, 0x48, 0x8B, 0x4B, 0xF8,     // mov rcx, [rbx-8]
+                    0x48, 0x85, 0xC9);          // test rcx, rcx
+            uint8_t jz[] = { 0x0F, 0x84 };
+            emit_bytes(e, jz, 2);
+            emit_target(e, -2 - pc);
+            EMIT(e, 0x48, 0x83, 0xEB, 0x08,     // sub rbx, 8
+                    0x48, 0x83, 0xF9, 0xFF);    // cmp rcx, -1
+            if (instr.opcode == OPCODE_DIV_I64) {
+                EMIT(e, 0x75, 0x06,                 // jne +6
+                        0x48, 0xF7, 0x5B, 0xF8);    // neg qword [rbx-8]
+            } else {
+                EMIT(e, 0x75, 0x0A,                 // jne +10
+                        0x48, 0xC7, 0x43, 0xF8, 0x00, 0x00, 0x00, 0x00);  // mov qword [rbx-8], 0
+            }
+            EMIT(e, 0xEB, 0x0D,                 // jmp +13
+                    0x48, 0x8B, 0x43, 0xF8,     // mov rax, [rbx-8]
+                    0x48, 0x99,                 // cqo
+                    0x48, 0xF7, 0xF9);          // idiv rcx
+            if (instr.opcode == OPCODE_DIV_I64) {
+                EMIT(e, 0x48, 0x89, 0x43, 0xF8);    // mov [rbx-8], rax
+            } else {
+                EMIT(e, 0x48, 0x89, 0x53, 0xF8);    // mov [rbx-8], rdx
+            }
+            return 1;
+        }
+
+        case OPCODE_NEG_I64:
+            EMIT(e, 0x48, 0xF7, 0x5B, 0xF8);    // neg qword [rbx-8]
+            return 1;
+
+        case OPCODE_ADD_F64:
+        case OPCODE_SUB_F64:
+        case OPCODE_MUL_F64:
+        case OPCODE_DIV_F64: {
+            static const uint8_t sse[] = { 0x58, 0x5C, 0x59, 0x5E };   // addsd, subsd, mulsd, divsd
+            EMIT(e, 0xF2, 0x0F, 0x10, 0x43, 0xF0);  // movsd xmm0, [rbx-16]
+            uint8_t op[] = { 0xF2, 0x0F, sse[instr.opcode - OPCODE_ADD_F64], 0x43, 0xF8 };
+            emit_bytes(e, op, 5);               // op xmm0, [rbx-8]
+            EMIT(e, 0xF2, 0x0F, 0x11, 0x43, 0xF0,   // movsd [rbx-16], xmm0
+                    0x48, 0x83, 0xEB, 0x08);    // sub rbx, 8
+            return 1;
+        }
+
+        case OPCODE_NEG_F64:
+            EMIT(e, 0x48, 0xB8);                // mov rax, bit de signo
+            emit_u64(e, 0x8000000000000000ULL);
+            EMIT(e, 0x48, 0x31, 0x43, 0xF8);    // xor [rbx-8], rax
+            return 1;
+
+        case OPCODE_I2F:
+            EMIT(e, 0xF2, 0x48, 0x0F, 0x2A, 0x43, 0xF8,     // cvtsi2sd xmm0, qword [rbx-8]
+                    0xF2, 0x0F, 0x11, 0x43, 0xF8);          // movsd [rbx-8], xmm0
+            return 1;
+
+        case OPCODE_F2I:
+            EMIT(e, 0xF2, 0x48, 0x0F, 0x2C, 0x43, 0xF8,     // cvttsd2si rax, [rbx-8]
+                    0x48, 0x89, 0x43, 0xF8);                // mov [rbx-8], rax
+            return 1;
+
+        case OPCODE_EQ_I64: case OPCODE_NE_I64: case OPCODE_LT_I64:
+        case OPCODE_LE_I64: case OPCODE_GT_I64: case OPCODE_GE_I64:
+            emit_compare_i64(e, instr.opcode - OPCODE_EQ_I64);
+            emit_store_flag(e);
+            return 1;
+
+        case OPCODE_EQ_F64: case OPCODE_NE_F64: case OPCODE_LT_F64:
+        case OPCODE_LE_F64: case OPCODE_GT_F64: case OPCODE_GE_F64:
+            emit_compare_f64(e, instr.opcode - OPCODE_EQ_F64);
+            emit_store_flag(e);
+            return 1;
+
+        case OPCODE_NOT:
+            EMIT(e, 0x48, 0x83, 0x7B, 0xF8, 0x00,   // cmp qword [rbx-8], 0
+                    0x0F, 0x94, 0xC0,           // sete al
+                    0x0F, 0xB6, 0xC0,           // movzx eax, al
+                    0x48, 0x89, 0x43, 0xF8);    // mov [rbx-8], rax
+            return 1;
+
+        case OPCODE_AND:
+        case OPCODE_OR:
+            EMIT(e, 0x48, 0x83, 0x7B, 0xF0, 0x00,   // cmp qword [rbx-16], 0
+                    0x0F, 0x95, 0xC0,           // setne al
+                    0x48, 0x83, 0x7B, 0xF8, 0x00,   // cmp qword [rbx-8], 0
+                    0x0F, 0x95, 0xC1);          // setne cl
+            if (instr.opcode == OPCODE_AND) {
+                EMIT(e, 0x20, 0xC8);            // and al, cl
+            } else {
+                EMIT(e, 0x08, 0xC8);            // or al, cl
+            }
+            emit_store_flag(e);
+            return 1;
+
+        case OPCODE_MULADD_I64:
+            EMIT(e, 0x48, 0x8B, 0x43, 0xE8,     // mov rax, [rbx-24]
+                    0x48, 0x0F, 0xAF, 0x43, 0xF0,   // imul rax, [rbx-16]
+                    0x48, 0x03, 0x43, 0xF8,     // add rax, [rbx-8]
+                    0x48, 0x83, 0xEB, 0x10,     // sub rbx, 16
+                    0x48, 0x89, 0x43, 0xF8);    // mov [rbx-8], rax
+            return 1;
+
+        case OPCODE_MULADD_F64:
+            EMIT(e, 0xF2, 0x0F, 0x10, 0x43, 0xE8,   // movsd xmm0, [rbx-24]
+                    0xF2, 0x0F, 0x59, 0x43, 0xF0,   // mulsd xmm0, [rbx-16]
+                    0xF2, 0x0F, 0x58, 0x43, 0xF8,   // addsd xmm0, [rbx-8]
+                    0x48, 0x83, 0xEB, 0x10,     // sub rbx, 16
+                    0xF2, 0x0F, 0x11, 0x43, 0xF8);  // movsd [rbx-8], xmm0
+            return 1;
+
+        case OPCODE_JUMP_UNLESS_EQ_I64: case OPCODE_JUMP_UNLESS_NE_I64:
+        case OPCODE_JUMP_UNLESS_LT_I64: case OPCODE_JUMP_UNLESS_LE_I64:
+        case OPCODE_JUMP_UNLESS_GT_I64: case OPCODE_JUMP_UNLESS_GE_I64: {
+            // jcc con la condición contraria: jne, je, jge, jg, jle, jl
+            static const uint8_t jcc[] = { 0x85, 0x84, 0x8D, 0x8F, 0x8E, 0x8C };
+            EMIT(e, 0x48, 0x8B, 0x43, 0xF0,     // mov rax, [rbx-16]
+                    0x48, 0x3B, 0x43, 0xF8,     // cmp rax, [rbx-8]
+                    0x48, 0x8D, 0x5B, 0xF0);    // lea rbx, [rbx-16] (no toca flags)
+            emit_jcc(e, jcc[instr.opcode - OPCODE_JUMP_UNLESS_EQ_I64], target);
+            return 1;
+        }
+
+        case OPCODE_JUMP_UNLESS_EQ_F64: case OPCODE_JUMP_UNLESS_NE_F64:
+        case OPCODE_JUMP_UNLESS_LT_F64: case OPCODE_JUMP_UNLESS_LE_F64:
+        case OPCODE_JUMP_UNLESS_GT_F64: case OPCODE_JUMP_UNLESS_GE_F64:
+            emit_compare_f64(e, instr.opcode - OPCODE_JUMP_UNLESS_EQ_F64);
+            EMIT(e, 0x48, 0x8D, 0x5B, 0xF0,     // lea rbx, [rbx-16]
+                    0x84, 0xC0);                // test al, al
+            emit_jcc(e, 0x84, target);          // jz
+            return 1;
+
+        case OPCODE_JUMP:
+            emit_jmp(e, target);
+            return 1;
+
+        case OPCODE_JUMP_IF_FALSE:
+            EMIT(e, 0x48, 0x83, 0xEB, 0x08,     // sub rbx, 8
+                    0x48, 0x83, 0x3B, 0x00);    // cmp qword [rbx], 0
+            emit_jcc(e, 0x84, target);          // je
+            return 1;
+
+        case OPCODE_LOOP:
+            // Se sigue contando para --profile
+            EMIT(e, 0x48, 0xB8);                // mov rax, &loop_counters[pc]
+            emit_u64(e, (uint64_t)(uintptr_t)&vm->loop_counters[pc]);
+            EMIT(e, 0x48, 0xFF, 0x00);          // inc qword [rax]
+            emit_jmp(e, target);
+            return 1;
+
+        case OPCODE_ARRAY_GET: case OPCODE_ARRAY_GET_I64:
+        case OPCODE_ARRAY_GET_STATIC: case OPCODE_ARRAY_GET_STATIC_I64: {
+            // Los arrays estáticos no se mueven: data y size son constantes
+            const Array *arr = static_array(vm, instr);
+            if (!arr || arr->type != 'd') return 0;
+            emit_index(e, is_int_index(instr.opcode), 0xF8);
+            EMIT(e, 0x48, 0xB9);                // mov rcx, data
+            emit_u64(e, (uint64_t)(uintptr_t)arr->data);
+            EMIT(e, 0x31, 0xD2,                 // xor edx, edx (fuera de rango = 0.0)
+                    0x48, 0x3D);                // cmp rax, size
+            emit_u32(e, (uint32_t)arr->size);
+            EMIT(e, 0x73, 0x04,                 // jae +4
+                    0x48, 0x8B, 0x14, 0xC1,     // mov rdx, [rcx + rax*8]
+                    0x48, 0x89, 0x53, 0xF8);    // mov [rbx-8], rdx
+            return 1;
+        }
+
+        case OPCODE_ARRAY_SET: case OPCODE_ARRAY_SET_I64:
+        case OPCODE_ARRAY_SET_STATIC: case OPCODE_ARRAY_SET_STATIC_I64: {
+            const Array *arr = static_array(vm, instr);
+            if (!arr || arr->type != 'd') return 0;
+            emit_index(e, is_int_index(instr.opcode), 0xF0);
+            EMIT(e, 0x48, 0x8B, 0x53, 0xF8,     // mov rdx, [rbx-8]
+                    0x48, 0x83, 0xEB, 0x10,     // sub rbx, 16
+                    0x48, 0xB9);                // mov rcx, data
+            emit_u64(e, (uint64_t)(uintptr_t)arr->data);
+            EMIT(e, 0x48, 0x3D);                // cmp rax, size
+            emit_u32(e, (uint32_t)arr->size);
+            EMIT(e, 0x73, 0x04,                 // jae +4
+                    0x48, 0x89, 0x14, 0xC1);    // mov [rcx + rax*8], rdx
+            return 1;
+        }
+
+        case OPCODE_ARRAY_GET_INT: case OPCODE_ARRAY_GET_INT_STATIC: {
+            const Array *arr = static_array(vm, instr);
+            uint8_t size = 0;
+            const uint8_t *load = arr ? int_element_access(arr->type, 0, 0, &size) : NULL;
+            if (!load) return 0;
+            emit_index(e, 1, 0xF8);
+            EMIT(e, 0x48, 0xB9);                // mov rcx, data
+            emit_u64(e, (uint64_t)(uintptr_t)arr->data);
+            EMIT(e, 0x31, 0xD2,                 // xor edx, edx (fuera de rango = 0)
+                    0x48, 0x3D);                // cmp rax, size
+            emit_u32(e, (uint32_t)arr->size);
+            uint8_t skip[] = { 0x73, size };    // jae (salta la carga)
+            emit_bytes(e, skip, 2);
+            emit_bytes(e, load, size);
+            EMIT(e, 0x48, 0x89, 0x53, 0xF8);    // mov [rbx-8], rdx
+            return 1;
+        }
+
+        case OPCODE_ARRAY_SET_INT: case OPCODE_ARRAY_SET_INT_STATIC: {
+            const Array *arr = static_array(vm, instr);
+            uint8_t size = 0;
+            const uint8_t *store = arr ? int_element_access(arr->type, 1, vm->parallel_worker, &size) : NULL;
+            if (!store) return 0;
+            emit_index(e, 1, 0xF0);
+            EMIT(e, 0x48, 0x8B, 0x53, 0xF8,     // mov rdx, [rbx-8]
+                    0x48, 0x83, 0xEB, 0x10,     // sub rbx, 16
+                    0x48, 0xB9);                // mov rcx, data
+            emit_u64(e, (uint64_t)(uintptr_t)arr->data);
+            EMIT(e, 0x48, 0x3D);                // cmp rax, size
+            emit_u32(e, (uint32_t)arr->size);
+            uint8_t skip[] = { 0x73, size };    // jae (salta el guardado)
+            emit_bytes(e, skip, 2);
+            emit_bytes(e, store, size);
+            return 1;
+        }
+
+        default:
+            return 0;
+    }
+}
+
+// Traduce [head, loop_pc] a código máquina en e->bytes
+static int compile_region(Emitter *e, const VMState *vm, int head, int loop_pc) {
+    e->head = head;
+    e->end = loop_pc;
+    e->offsets = (size_t*)calloc(loop_pc - head + 1, sizeof(size_t));
+    if (!e->offsets) return -1;
+
+    // Prólogo
+    EMIT(e, 0x53,                               // push rbx
+            0x41, 0x54,                         // push r12
+            0x41, 0x55,                         // push r13
+            0x41, 0x56,                         // push r14
+            0x49, 0x89, 0xFE,                   // mov r14, rdi
+            0x49, 0x89, 0xF5,                   // mov r13, rsi
+            0x4C, 0x8D, 0xA7);                  // lea r12, [rdi + stack]
+    emit_u32(e, offsetof(VMState, stack));
+    EMIT(e, 0x48, 0x63, 0x87);                  // movsxd rax, dword [rdi + sp]
+    emit_u32(e, offsetof(VMState, sp));
+    EMIT(e, 0x49, 0x8D, 0x1C, 0xC4);            // lea rbx, [r12 + rax*8]
+
+    int supported = 0;
+    for (int pc = head; pc <= loop_pc; pc++) {
+        e->offsets[pc - head] = e->size;
+        if (emit_instruction(e, vm, pc)) {
+            supported++;
+        } else {
+            emit_exit(e, pc);
+        }
+    }
+    // Sin ninguna plantilla no compensa entrar
+    if (supported == 0) return -1;
+
+    // Salidas a PCs fuera de la región: una por destino
+    int exit_count = e->fixup_count;
+    size_t *exit_offsets = (size_t*)malloc((exit_count + 1) * sizeof(size_t));
+    int *exit_pcs = (int*)malloc((exit_count + 1) * sizeof(int));
+    int exits = 0;
+    if (!exit_offsets || !exit_pcs) {
+        free(exit_offsets);
+        free(exit_pcs);
+        return -1;
+    }
+    for (int i = 0; i < exit_count; i++) {
+        if (e->fixups[i].target > -2) continue;
+        int pc = -2 - e->fixups[i].target;
+        int known = 0;
+        for (int j = 0; j < exits; j++) {
+            if (exit_pcs[j] == pc) known = 1;
+        }
+        if (known) continue;
+        exit_pcs[exits] = pc;
+        exit_offsets[exits] = e->size;
+        exits++;
+        emit_exit(e, pc);
+    }
+
+    // Epílogo: vm->sp = (rbx - r12) / 8 y devolver eax
+    size_t epilogue = e->size;
+    EMIT(e, 0x48, 0x89, 0xD9,                   // mov rcx, rbx
+            0x4C, 0x29, 0xE1,                   // sub rcx, r12
+            0x48, 0xC1, 0xF9, 0x03,             // sar rcx, 3
+            0x41, 0x89, 0x8E);                  // mov [r14 + sp], ecx
+    emit_u32(e, offsetof(VMState, sp));
+    EMIT(e, 0x41, 0x5E,                         // pop r14
+            0x41, 0x5D,                         // pop r13
+            0x41, 0x5C,                         // pop r12
+            0x5B,                               // pop rbx
+            0xC3);                              // ret
+
+    if (e->failed) {
+        free(exit_offsets);
+        free(exit_pcs);
+        return -1;
+    }
+
+    // Resolver los rel32
+    for (int i = 0; i < e->fixup_count; i++) {
+        int target = e->fixups[i].target;
+        size_t destination = epilogue;
+        if (target >= 0) {
+            destination = e->offsets[target - head];
+        } else if (target <= -2) {
+            for (int j = 0; j < exits; j++) {
+                if (exit_pcs[j] == -2 - target) destination = exit_offsets[j];
+            }
+        }
+        int32_t rel = (int32_t)((int64_t)destination - (int64_t)(e->fixups[i].at + 4));
+        memcpy(e->bytes + e->fixups[i].at, &rel, 4);
+    }
+
+    free(exit_offsets);
+    free(exit_pcs);
+    return 0;
+}
+
+// Copia el código a páginas ejecutables (W^X: se escriben y luego se protegen)
+static void *install_code(JitState *jit, const uint8_t *bytes, size_t size) {
+    long page = sysconf(_SC_PAGESIZE);
+    size_t length = (size + page - 1) / page * page;
+    void *memory = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (memory == MAP_FAILED) return NULL;
+    memcpy(memory, bytes, size);
+    if (mprotect(memory, length, PROT_READ | PROT_EXEC) != 0) {
+        munmap(memory, length);
+        return NULL;
+    }
+
+    JitRegion *temp = realloc(jit->regions, (jit->region_count + 1) * sizeof(JitRegion));
+    if (!temp) {
+        munmap(memory, length);
+        return NULL;
+    }
+    jit->regions = temp;
+    jit->regions[jit->region_count].memory = memory;
+    jit->regions[jit->region_count].size = length;
+    jit->region_count++;
+    return memory;
+}
+
+JitState *jit_create(const VMState *vm, int debug) {
+    JitState *jit = (JitState*)calloc(1, sizeof(JitState));
+    if (!jit) return NULL;
+    jit->status = (uint8_t*)calloc(vm->instruction_count + 1, 1);
+    jit->code = (JitCode*)calloc(vm->instruction_count + 1, sizeof(JitCode));
+    if (!jit->status || !jit->code) {
+        jit_free(jit);
+        return NULL;
+    }
+    jit->debug = debug;
+    return jit;
+}
+
+JitCode jit_loop_code(VMState *vm, int loop_pc, int head) {
+    JitState *jit = vm->jit;
+    if (jit->status[loop_pc] == JIT_READY) return jit->code[loop_pc];
+    if (jit->status[loop_pc] == JIT_FAILED) return NULL;
+    if (vm->loop_counters[loop_pc] < VM_HOT_LOOP_THRESHOLD) return NULL;
+
+    jit->status[loop_pc] = JIT_FAILED;
+    if (head < 0 || head > loop_pc) return NULL;
+
+    Emitter e;
+    memset(&e, 0, sizeof(e));
+    void *memory = NULL;
+    if (compile_region(&e, vm, head, loop_pc) == 0) {
+        memory = install_code(jit, e.bytes, e.size);
+    }
+    if (memory) {
+        jit->status[loop_pc] = JIT_READY;
+        jit->code[loop_pc] = (JitCode)memory;
+        // Mapa de símbolos para perf: "inicio tamaño nombre" por región
+        if (!jit->perf_map) {
+            char path[64];
+            snprintf(path, sizeof(path), "/tmp/perf-%d.map", (int)getpid());
+            jit->perf_map = fopen(path, "w");
+        }
+        if (jit->perf_map) {
+            fprintf(jit->perf_map, "%lx %zx gld_loop_pc%d_%d\n", (unsigned long)(uintptr_t)memory,
+                    e.size, head, loop_pc);
+            fflush(jit->perf_map);
+        }
+        if (jit->debug) fprintf(stderr, "[VM] JIT: bucle PC %d-%d compilado (%zu bytes)\n", head, loop_pc, e.size);
+    } else if (jit->debug) {
+        fprintf(stderr, "[VM] JIT: bucle PC %d-%d sin compilar\n", head, loop_pc);
+    }
+
+    free(e.bytes);
+    free(e.offsets);
+    free(e.fixups);
+    return jit->code[loop_pc];
+}
+
+void jit_free(JitState *jit) {
+    if (!jit) return;
+    for (int i = 0; i < jit->region_count; i++) {
+        munmap(jit->regions[i].memory, jit->regions[i].size);
+    }
+    free(jit->regions);
+    free(jit->status);
+    free(jit->code);
+    if (jit->perf_map) fclose(jit->perf_map);
+    free(jit);
+}
+
+#else
+
+JitState *jit_create(const VMState *vm, int debug) {
+    (void)vm;
+    (void)debug;
+    fprintf(stderr, "Aviso: --jit solo está disponible en Linux x86-64; se usa el intérprete\n");
+    return NULL;
+}
+
+JitCode jit_loop_code(VMState *vm, int loop_pc, int head) {
+    (void)vm;
+    (void)loop_pc;
+    (void)head;
+    return NULL;
+}
+
+void jit_free(JitState *jit) {
+    (void)jit;
+}
+
+#endif
@@ -0,0 +1,27 @@
+#ifndef JIT_H
+#define JIT_H
+
+#include "vm.h"
+
+// JIT de plantillas para Linux x86-64 (gldvm run --jit). Cuando un LOOP
+// supera VM_HOT_LOOP_THRESHOLD iteraciones, su cuerpo [cabecera, LOOP] se
+// traduce cosiendo un fragmento de máquina por instrucción en páginas mmap.
+// Las instrucciones sin plantilla son salidas: el código nativo devuelve su PC
+// y el intérprete sigue desde ahí hasta volver a entrar por el LOOP.
+// Cada región compilada se anota en /tmp/perf-<pid>.map para perf.
+
+// Código nativo de un bucle: ejecuta desde la cabecera y devuelve el PC por el
+// que debe seguir el intérprete. 'frame' es vm->locals + vm->fp.
+typedef int (*JitCode)(VMState *vm, Value *frame);
+
+// NULL (ya informado) si la plataforma no lo admite
+JitState *jit_create(const VMState *vm, int debug);
+
+// Código del bucle cuyo LOOP está en 'loop_pc' y salta a 'head'. Lo compila
+// la primera vez que el bucle está caliente; NULL mientras no lo esté o si no
+// se pudo compilar.
+JitCode jit_loop_code(VMState *vm, int loop_pc, int head);
+
+void jit_free(JitState *jit);
+
+#endif
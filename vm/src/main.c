@@ -2,14 +2,22 @@
 #include <stdlib.h>
 #include <string.h>
 #include "vm.h"
+#include "aot.h"
 
 void print_usage(const char *program_name) {
     printf("Usage: %s <command> [arguments]\n", program_name);
     printf("\nAvailable commands:\n");
     printf("  run <file.gld>          Run bytecode\n");
+    printf("  aot <file.gld> [-o <file.c>]\n");
+    printf("                          Translate bytecode to C (build with runtime.c)\n");
     printf("\nOptions:\n");
     printf("  --debug                 Run with debug information\n");
     printf("  --renderer <type>       Specify renderer (opengl, none)\n");
+    printf("  --profile               Report loop iteration counts on exit\n");
+    printf("  --no-quicken            Disable in-place opcode specialization\n");
+    printf("  --jit                   Compile hot loops to x86-64 (Linux)\n");
+    printf("  --output-buffer <bytes> Program output buffer size (0 = unbuffered)\n");
+    printf("  --threads <n>           Threads for 'parallel for' (default: all cores)\n");
     printf("  --version               Show version\n");
     printf("  --help                  Show this help\n");
     printf("\nSupported renderers:\n");
@@ -24,15 +32,28 @@ int main(int argc, char *argv[]) {
     }
 
     const char *command = argv[1];
-    int debug = 0;
-    const char *override_renderer = NULL;
+    VMOptions options = {0};
+    options.output_buffer = OUTPUT_DEFAULT_CAPACITY;
 
-    // Find --debug and --renderer flags
+    // Find --debug, --profile, --no-quicken, --jit, --output-buffer, --threads and --renderer flags
     for (int i = 1; i < argc; i++) {
         if (strcmp(argv[i], "--debug") == 0) {
-            debug = 1;
+            options.debug = 1;
+        } else if (strcmp(argv[i], "--profile") == 0) {
+            options.profile = 1;
+        } else if (strcmp(argv[i], "--no-quicken") == 0) {
+            options.no_quicken = 1;
+        } else if (strcmp(argv[i], "--jit") == 0) {
+            options.jit = 1;
+        } else if (strcmp(argv[i], "--output-buffer") == 0 && i + 1 < argc) {
+            long bytes = strtol(argv[i + 1], NULL, 10);
+            options.output_buffer = bytes > 0 ? (size_t)bytes : 0;
+            i++;  // Skip next argument
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            options.threads = atoi(argv[i + 1]);
+            i++;  // Skip next argument
         } else if (strcmp(argv[i], "--renderer") == 0 && i + 1 < argc) {
-            override_renderer = argv[i + 1];
+            options.override_renderer = argv[i + 1];
             i++;  // Skip next argument
         }
     }
@@ -50,10 +71,36 @@ int main(int argc, char *argv[]) {
     if (strcmp(command, "run") == 0) {
         if (argc < 3) {
             fprintf(stderr, "Error: Bytecode file is required\n");
-            fprintf(stderr, "Usage: %s run <file.gld> [--debug] [--renderer <type>]\n", argv[0]);
+            fprintf(stderr, "Usage: %s run <file.gld> [--debug] [--profile] [--no-quicken] [--jit] [--output-buffer <bytes>] [--threads <n>] [--renderer <type>]\n", argv[0]);
             return EXIT_FAILURE;
         }
-        return execute_bytecode(argv[2], debug, override_renderer);
+        return execute_bytecode(argv[2], &options);
+    }
+
+    if (strcmp(command, "aot") == 0) {
+        if (argc < 3) {
+            fprintf(stderr, "Error: Bytecode file is required\n");
+            fprintf(stderr, "Usage: %s aot <file.gld> [-o <file.c>]\n", argv[0]);
+            return EXIT_FAILURE;
+        }
+        
+        // Por defecto, el mismo nombre con extensión .c
+        char output[1024];
+        const char *output_file = NULL;
+        for (int i = 3; i + 1 < argc; i++) {
+            if (strcmp(argv[i], "-o") == 0) output_file = argv[i + 1];
+        }
+        if (!output_file) {
+            snprintf(output, sizeof(output), "%s", argv[2]);
+            char *ext = strrchr(output, '.');
+            if (ext && strcmp(ext, ".gld") == 0) *ext = '\0';
+            strncat(output, ".c", sizeof(output) - strlen(output) - 1);
+            output_file = output;
+        }
+        
+        if (aot_translate(argv[2], output_file) != 0) return EXIT_FAILURE;
+        printf("C generado: %s\n", output_file);
+        return EXIT_SUCCESS;
     }
 
     fprintf(stderr, "Error: Unknown command '%s'\n", command);
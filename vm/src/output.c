@@ -0,0 +1,90 @@
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include "output.h"
+
+#ifdef _WIN32
+#include <io.h>
+#define write _write
+#define isatty _isatty
+#else
+#include <unistd.h>
+#endif
+
+// write() completo: reintenta tras EINTR y escrituras parciales
+static void write_all(OutputBuffer *out, const char *data, size_t length) {
+    while (length > 0 && !out->error) {
+        long written = (long)write(out->fd, data, (unsigned)length);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            out->error = 1;
+        } else {
+            data += written;
+            length -= (size_t)written;
+        }
+    }
+}
+
+void output_init(OutputBuffer *out, int fd, size_t capacity) {
+    out->data = capacity > 0 ? (char*)malloc(capacity) : NULL;
+    out->size = 0;
+    out->capacity = out->data ? capacity : 0;
+    out->fd = fd;
+    out->line_buffered = isatty(fd);
+    out->error = 0;
+}
+
+int output_flush(OutputBuffer *out) {
+    if (out->size > 0) {
+        write_all(out, out->data, out->size);
+        out->size = 0;
+    }
+    return out->error ? -1 : 0;
+}
+
+void output_write(OutputBuffer *out, const char *data, size_t length) {
+    if (length > out->capacity - out->size) {
+        output_flush(out);
+        // Lo que no cabe ni en el buffer vacío sale directamente
+        if (length >= out->capacity) {
+            write_all(out, data, length);
+            return;
+        }
+    }
+    memcpy(out->data + out->size, data, length);
+    out->size += length;
+    if (out->line_buffered && memchr(data, '\n', length)) output_flush(out);
+}
+
+void output_string(OutputBuffer *out, const char *text) {
+    output_write(out, text, strlen(text));
+}
+
+void output_char(OutputBuffer *out, char c) {
+    if (out->size == out->capacity) {
+        output_write(out, &c, 1);
+        return;
+    }
+    out->data[out->size++] = c;
+    if (c == '\n' && out->line_buffered) output_flush(out);
+}
+
+char *output_reserve(OutputBuffer *out, size_t length) {
+    if (length > out->capacity) return NULL;
+    if (length > out->capacity - out->size) output_flush(out);
+    return out->data + out->size;
+}
+
+void output_commit(OutputBuffer *out, size_t length) {
+    char *start = out->data + out->size;
+    out->size += length;
+    if (out->line_buffered && memchr(start, '\n', length)) output_flush(out);
+}
+
+void output_free(OutputBuffer *out) {
+    output_flush(out);
+    free(out->data);
+    out->data = NULL;
+    out->size = 0;
+    out->capacity = 0;
+}
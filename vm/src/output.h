@@ -0,0 +1,43 @@
+#ifndef OUTPUT_H
+#define OUTPUT_H
+
+#include <stddef.h>
+
+// Salida del programa. PRINT, PRINTLN y PRINTCHR escriben en un buffer propio
+// de la VM que se vuelca con write() cuando se llena, con el opcode FLUSH y al
+// terminar. Si el descriptor es una terminal se vuelca además en cada salto de
+// línea. La salida de --debug va a stderr y no pasa por aquí.
+
+// Tamaño por defecto (gldvm run --output-buffer <bytes>)
+#define OUTPUT_DEFAULT_CAPACITY (64 * 1024)
+
+typedef struct {
+    char *data;
+    size_t size;
+    size_t capacity;    // 0 = sin buffer: cada escritura va directa a write()
+    int fd;
+    int line_buffered;  // Volcar en cada '\n' (el descriptor es una terminal)
+    int error;          // Falló algún write(); el resto de la salida se descarta
+} OutputBuffer;
+
+// Prepara el buffer sobre 'fd'. Si no hay memoria para 'capacity' bytes se
+// queda sin buffer. Nunca falla.
+void output_init(OutputBuffer *out, int fd, size_t capacity);
+
+void output_write(OutputBuffer *out, const char *data, size_t length);
+void output_string(OutputBuffer *out, const char *text);
+void output_char(OutputBuffer *out, char c);
+
+// Hueco de 'length' bytes al final del buffer, volcándolo antes si hace
+// falta, para formatear directamente en él; NULL si el buffer es más pequeño.
+// Se confirma con output_commit indicando los bytes usados.
+char *output_reserve(OutputBuffer *out, size_t length);
+void output_commit(OutputBuffer *out, size_t length);
+
+// Escribe lo pendiente. 0, o -1 si algún write() ha fallado.
+int output_flush(OutputBuffer *out);
+
+// Vuelca y libera el buffer
+void output_free(OutputBuffer *out);
+
+#endif
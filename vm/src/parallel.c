@@ -0,0 +1,256 @@
+#include <stdlib.h>
+#include "parallel.h"
+
+#ifndef _WIN32
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <unistd.h>
+
+// Índices pendientes [next, end) de un hilo. Cada tramo ocupa su propia
+// línea de caché: los hilos actualizan el suyo en cada trozo.
+typedef struct {
+    pthread_mutex_t lock;
+    int64_t next;
+    int64_t end;
+} WorkRange;
+
+typedef union {
+    WorkRange range;
+    char padding[128];
+} PaddedRange;
+
+typedef struct {
+    ParallelPool *pool;
+    int index;
+} WorkerArg;
+
+struct ParallelPool {
+    int threads;
+    pthread_t *handles;        // threads - 1 (el hilo 0 es el que llama)
+    WorkerArg *args;
+    PaddedRange *ranges;       // Uno por hilo
+
+    pthread_mutex_t lock;
+    pthread_cond_t start;      // Hay región nueva (generation cambia) o shutdown
+    pthread_cond_t done;       // running llegó a 0
+    uint64_t generation;
+    int running;               // Hilos del pool que no han acabado la región
+    int shutdown;
+
+    // Región en curso
+    ParallelBody body;
+    void *context;
+    int64_t grain;             // Índices por trozo
+    atomic_int cancelled;
+};
+
+// Siguiente trozo del tramo propio. 0 si está vacío.
+static int take_own(ParallelPool *pool, int worker, int64_t *first, int64_t *last) {
+    WorkRange *own = &pool->ranges[worker].range;
+    int found = 0;
+    pthread_mutex_lock(&own->lock);
+    if (own->next < own->end) {
+        *first = own->next;
+        *last = own->end - own->next > pool->grain ? own->next + pool->grain : own->end;
+        own->next = *last;
+        found = 1;
+    }
+    pthread_mutex_unlock(&own->lock);
+    return found;
+}
+
+// Roba la mitad final del tramo de otro hilo (todo si es un solo trozo) y la
+// convierte en el tramo propio. 0 si no queda trabajo en ningún tramo.
+static int steal(ParallelPool *pool, int worker) {
+    for (int k = 1; k < pool->threads; k++) {
+        WorkRange *victim = &pool->ranges[(worker + k) % pool->threads].range;
+        int64_t first = 0, last = 0;
+        pthread_mutex_lock(&victim->lock);
+        int64_t remaining = victim->end - victim->next;
+        if (remaining > 0) {
+            last = victim->end;
+            first = remaining > pool->grain ? victim->next + remaining / 2 : victim->next;
+            victim->end = first;
+        }
+        pthread_mutex_unlock(&victim->lock);
+        if (first < last) {
+            WorkRange *own = &pool->ranges[worker].range;
+            pthread_mutex_lock(&own->lock);
+            own->next = first;
+            own->end = last;
+            pthread_mutex_unlock(&own->lock);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static void work(ParallelPool *pool, int worker) {
+    int64_t first, last;
+    while (!parallel_cancelled(pool)) {
+        if (take_own(pool, worker, &first, &last)) {
+            pool->body(pool->context, worker, first, last);
+        } else if (!steal(pool, worker)) {
+            break;
+        }
+    }
+}
+
+static void *worker_main(void *arg) {
+    ParallelPool *pool = ((WorkerArg*)arg)->pool;
+    int index = ((WorkerArg*)arg)->index;
+    uint64_t seen = 0;
+
+    pthread_mutex_lock(&pool->lock);
+    for (;;) {
+        while (!pool->shutdown && pool->generation == seen) pthread_cond_wait(&pool->start, &pool->lock);
+        if (pool->shutdown) break;
+        seen = pool->generation;
+        pthread_mutex_unlock(&pool->lock);
+
+        work(pool, index);
+
+        pthread_mutex_lock(&pool->lock);
+        if (--pool->running == 0) pthread_cond_signal(&pool->done);
+    }
+    pthread_mutex_unlock(&pool->lock);
+    return NULL;
+}
+
+static int available_cores(void) {
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    return cores > 0 ? (int)cores : 1;
+}
+
+ParallelPool *parallel_create(int threads) {
+    if (threads <= 0) threads = available_cores();
+    ParallelPool *pool = (ParallelPool*)calloc(1, sizeof(ParallelPool));
+    if (!pool) return NULL;
+    pool->handles = (pthread_t*)calloc(threads, sizeof(pthread_t));
+    pool->args = (WorkerArg*)calloc(threads, sizeof(WorkerArg));
+    pool->ranges = (PaddedRange*)calloc(threads, sizeof(PaddedRange));
+    if (!pool->handles || !pool->args || !pool->ranges) {
+        free(pool->handles);
+        free(pool->args);
+        free(pool->ranges);
+        free(pool);
+        return NULL;
+    }
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->start, NULL);
+    pthread_cond_init(&pool->done, NULL);
+    for (int i = 0; i < threads; i++) pthread_mutex_init(&pool->ranges[i].range.lock, NULL);
+    atomic_init(&pool->cancelled, 0);
+
+    pool->threads = 1;
+    for (int i = 1; i < threads; i++) {
+        pool->args[i].pool = pool;
+        pool->args[i].index = i;
+        if (pthread_create(&pool->handles[i], NULL, worker_main, &pool->args[i]) != 0) break;
+        pool->threads++;
+    }
+    return pool;
+}
+
+void parallel_free(ParallelPool *pool) {
+    if (!pool) return;
+    pthread_mutex_lock(&pool->lock);
+    pool->shutdown = 1;
+    pthread_cond_broadcast(&pool->start);
+    pthread_mutex_unlock(&pool->lock);
+    for (int i = 1; i < pool->threads; i++) pthread_join(pool->handles[i], NULL);
+
+    for (int i = 0; i < pool->threads; i++) pthread_mutex_destroy(&pool->ranges[i].range.lock);
+    pthread_mutex_destroy(&pool->lock);
+    pthread_cond_destroy(&pool->start);
+    pthread_cond_destroy(&pool->done);
+    free(pool->handles);
+    free(pool->args);
+    free(pool->ranges);
+    free(pool);
+}
+
+int parallel_thread_count(const ParallelPool *pool) {
+    return pool->threads;
+}
+
+void parallel_run(ParallelPool *pool, int64_t start, int64_t end, ParallelBody body, void *context) {
+    atomic_store(&pool->cancelled, 0);
+    if (end <= start) return;
+    int64_t count = end - start;
+    if (pool->threads == 1 || count == 1) {
+        body(context, 0, start, end);
+        return;
+    }
+
+    // Unos 64 trozos por hilo: suficientes para equilibrar sin que tomar
+    // cada trozo pese
+    pool->body = body;
+    pool->context = context;
+    pool->grain = count / ((int64_t)pool->threads * 64);
+    if (pool->grain < 1) pool->grain = 1;
+    int64_t share = count / pool->threads, extra = count % pool->threads;
+    int64_t next = start;
+    for (int i = 0; i < pool->threads; i++) {
+        WorkRange *range = &pool->ranges[i].range;
+        range->next = next;
+        next += share + (i < extra ? 1 : 0);
+        range->end = next;
+    }
+
+    pthread_mutex_lock(&pool->lock);
+    pool->running = pool->threads - 1;
+    pool->generation++;
+    pthread_cond_broadcast(&pool->start);
+    pthread_mutex_unlock(&pool->lock);
+
+    work(pool, 0);
+
+    pthread_mutex_lock(&pool->lock);
+    while (pool->running > 0) pthread_cond_wait(&pool->done, &pool->lock);
+    pthread_mutex_unlock(&pool->lock);
+}
+
+void parallel_cancel(ParallelPool *pool) {
+    atomic_store(&pool->cancelled, 1);
+}
+
+int parallel_cancelled(const ParallelPool *pool) {
+    return atomic_load(&((ParallelPool*)pool)->cancelled);
+}
+
+#else  // _WIN32: sin hilos
+
+struct ParallelPool {
+    int cancelled;
+};
+
+ParallelPool *parallel_create(int threads) {
+    (void)threads;
+    return (ParallelPool*)calloc(1, sizeof(ParallelPool));
+}
+
+void parallel_free(ParallelPool *pool) {
+    free(pool);
+}
+
+int parallel_thread_count(const ParallelPool *pool) {
+    (void)pool;
+    return 1;
+}
+
+void parallel_run(ParallelPool *pool, int64_t start, int64_t end, ParallelBody body, void *context) {
+    pool->cancelled = 0;
+    if (end > start) body(context, 0, start, end);
+}
+
+void parallel_cancel(ParallelPool *pool) {
+    pool->cancelled = 1;
+}
+
+int parallel_cancelled(const ParallelPool *pool) {
+    return pool->cancelled;
+}
+
+#endif
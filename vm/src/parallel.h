@@ -0,0 +1,37 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <stdint.h>
+
+// Pool de hilos de las regiones 'parallel for'. Los hilos se crean una vez y
+// esperan entre región y región. parallel_run reparte [start, end) en un
+// tramo contiguo por hilo; cada hilo toma trozos del principio del suyo y,
+// cuando lo acaba, roba la mitad final del tramo que le quede a otro (work
+// stealing), así que un reparto desigual del coste se equilibra solo.
+// Sin pthreads (Windows) todo se ejecuta en el hilo que llama.
+
+typedef struct ParallelPool ParallelPool;
+
+// Ejecuta los índices [first, last) en el hilo 'worker' (0 = el que llamó a
+// parallel_run; el resto, 1 .. hilos - 1). Puede llamarse varias veces por
+// hilo y región.
+typedef void (*ParallelBody)(void *context, int worker, int64_t first, int64_t last);
+
+// 'threads' hilos en total contando el que llama; <= 0 = los núcleos
+// disponibles. Si no se pueden crear todos se queda con los que haya. NULL
+// sin memoria.
+ParallelPool *parallel_create(int threads);
+void parallel_free(ParallelPool *pool);
+
+int parallel_thread_count(const ParallelPool *pool);
+
+// Ejecuta 'body' sobre todos los índices de [start, end) y vuelve cuando han
+// terminado. No es reentrante: una región no puede abrir otra.
+void parallel_run(ParallelPool *pool, int64_t start, int64_t end, ParallelBody body, void *context);
+
+// Desde 'body': los hilos dejan de tomar trozos nuevos (un error en la
+// región). Se rearma al empezar la siguiente.
+void parallel_cancel(ParallelPool *pool);
+int parallel_cancelled(const ParallelPool *pool);
+
+#endif
@@ -0,0 +1,1252 @@
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "runtime.h"
+#include "format.h"
+#include "simd.h"
+#include "sort.h"
+
+// Lectura secuencial de la imagen en memoria
+typedef struct {
+    const uint8_t *data;
+    size_t size;
+    size_t pos;
+} ImageReader;
+
+static int image_read(ImageReader *reader, void *dst, size_t count) {
+    if (count > reader->size - reader->pos) return 0;
+    memcpy(dst, reader->data + reader->pos, count);
+    reader->pos += count;
+    return 1;
+}
+
+uint8_t *vm_read_file(const char *path, size_t *size) {
+    FILE *file = fopen(path, "rb");
+    if (!file) {
+        fprintf(stderr, "Error: No se puede abrir '%s'\n", path);
+        return NULL;
+    }
+    
+    fseek(file, 0, SEEK_END);
+    long length = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    
+    uint8_t *data = length >= 0 ? (uint8_t*)malloc(length > 0 ? length : 1) : NULL;
+    if (!data || fread(data, 1, length, file) != (size_t)length) {
+        fprintf(stderr, "Error: No se puede leer '%s'\n", path);
+        free(data);
+        fclose(file);
+        return NULL;
+    }
+    
+    fclose(file);
+    *size = (size_t)length;
+    return data;
+}
+
+int vm_resolve_array(const VMState *vm, int var) {
+    if (var >= vm->variable_count) return -1;
+    const Variable *v = &vm->variables[var];
+    if (v->type != 'a' && v->type != 'b') return -1;
+    int index = (int)v->value;
+    return index >= 0 && index < vm->array_count ? index : -1;
+}
+
+int vm_dynamic_array(const VMState *vm, int var) {
+    int index = (int)vm->variables[var].value;
+    return index >= 0 && index < vm->array_count ? index : -1;
+}
+
+ObjectInstance *vm_resolve_object(VMState *vm, int var) {
+    if (var >= vm->variable_count || vm->variables[var].type != 'o') return NULL;
+    int index = (int)vm->variables[var].value;
+    return index >= 0 && index < vm->object_count ? &vm->objects[index] : NULL;
+}
+
+int vm_reserve_locals(VMState *vm, int count) {
+    int needed = vm->fp + vm->frame_size + count;
+    if (needed > vm->locals_capacity) {
+        int capacity = vm->locals_capacity ? vm->locals_capacity : 64;
+        while (capacity < needed) capacity *= 2;
+        Value *temp = realloc(vm->locals, capacity * sizeof(Value));
+        if (!temp) return -1;
+        vm->locals = temp;
+        vm->locals_capacity = capacity;
+    }
+    memset(vm->locals + vm->fp + vm->frame_size, 0, count * sizeof(Value));
+    return 0;
+}
+
+int vm_new_instance(VMState *vm, int class_index, int var) {
+    ClassDefinition *cls = &vm->class_pool.classes[class_index];
+    
+    if (vm->object_count >= vm->object_capacity) {
+        int capacity = vm->object_capacity ? vm->object_capacity * 2 : 16;
+        ObjectInstance *temp = realloc(vm->objects, capacity * sizeof(ObjectInstance));
+        if (!temp) {
+            fprintf(stderr, "Error: No hay memoria para objetos\n");
+            return -1;
+        }
+        vm->objects = temp;
+        vm->object_capacity = capacity;
+    }
+    
+    // Campos inicializados a 0
+    ObjectInstance *obj = &vm->objects[vm->object_count];
+    obj->class_index = class_index;
+    obj->field_count = cls->var_count;
+    obj->field_values = (Value*)calloc(cls->var_count > 0 ? cls->var_count : 1, sizeof(Value));
+    if (!obj->field_values) {
+        fprintf(stderr, "Error: No hay memoria para objetos\n");
+        return -1;
+    }
+    
+    if (var < vm->variable_count && vm->variables[var].type == 'o') {
+        vm->variables[var].value = (double)vm->object_count;
+    }
+    return vm->object_count++;
+}
+
+size_t vm_array_bytes(char type, int size) {
+    switch (type) {
+        case 'i': return (size_t)size * sizeof(int32_t);
+        case 'u': return (size_t)size;
+        case 'z': return ((size_t)size + 7) / 8;
+        default:  return (size_t)size * 8;
+    }
+}
+
+// Reserva los elementos a cero. Un tipo desconocido (imágenes anteriores a
+// los arrays tipados) se guarda como double. 0 o -1.
+static int array_init(Array *arr, const char *name, char element_type, int size) {
+    if (element_type != 'i' && element_type != 'l' && element_type != 'u' && element_type != 'z') {
+        element_type = 'd';
+    }
+    size_t bytes = vm_array_bytes(element_type, size);
+    arr->name = (char*)name;
+    arr->type = element_type;
+    arr->data = calloc(bytes > 0 ? bytes : 1, 1);
+    arr->size = arr->data ? size : 0;
+    arr->capacity = arr->size;
+    arr->str_data = NULL;
+    arr->dims = 1;
+    arr->shape[0] = arr->size;
+    arr->stride = 1;
+    arr->first_bit = 0;
+    arr->parent = -1;
+    return arr->data ? 0 : -1;
+}
+
+// Elementos seguidos en data desde data: se puede operar sobre ellos con
+// memset, memcpy o los núcleos de simd.h (todo array salvo algunas vistas)
+static int array_contiguous(const Array *arr) {
+    return arr->stride == 1 && arr->first_bit == 0;
+}
+
+int vm_array_new(VMState *vm, int var, char element_type, int size) {
+    if (size < 0) size = 0;
+    
+    // Otro ARRAY_NEW sobre la misma variable reemplaza su array en el sitio
+    int index = vm->variables[var].type == 'b' ? vm_dynamic_array(vm, var) : -1;
+    if (index >= 0) {
+        // Los datos de una vista son de su array de origen
+        if (vm->arrays[index].parent < 0) free(vm->arrays[index].data);
+        return array_init(&vm->arrays[index], vm->variables[var].name, element_type, size) == 0 ? index : -1;
+    }
+    
+    Array *temp = realloc(vm->arrays, (vm->array_count + 1) * sizeof(Array));
+    if (!temp) return -1;
+    vm->arrays = temp;
+    
+    if (array_init(&vm->arrays[vm->array_count], vm->variables[var].name, element_type, size) != 0) return -1;
+    
+    // Almacenar el índice del array en la variable como referencia
+    vm->variables[var].value = (double)vm->array_count;
+    return vm->array_count++;
+}
+
+void vm_array_clear(VMState *vm, int array_index) {
+    Array *arr = &vm->arrays[array_index];
+    if (!array_contiguous(arr)) {
+        for (int i = 0; i < arr->size; i++) vm_array_set_int(arr, i, 0);
+        return;
+    }
+    memset(arr->data, 0, vm_array_bytes(arr->type, arr->size));
+    // Si hay strings, limpiarlos también
+    if (arr->str_data) {
+        for (int i = 0; i < arr->size; i++) {
+            free(arr->str_data[i]);
+            arr->str_data[i] = NULL;
+        }
+    }
+}
+
+// Array de la variable 'var' para sus métodos, o NULL tras vm_fail. Solo los
+// dinámicos cambian de tamaño: el JIT da por fijos data y size de los estáticos.
+static Array *method_array(VMState *vm, int var) {
+    if (var >= vm->variable_count || vm->variables[var].type != 'b') {
+        vm_fail(vm, "push, pop, reserve, resize, copy y unique solo existen en arrays dinámicos");
+        return NULL;
+    }
+    int index = vm_dynamic_array(vm, var);
+    if (index < 0) {
+        vm_fail(vm, "Array dinámico sin crear");
+        return NULL;
+    }
+    if (vm->arrays[index].parent >= 0) {
+        vm_fail(vm, "Una vista no cambia de tamaño");
+        return NULL;
+    }
+    return &vm->arrays[index];
+}
+
+// Capacidad tras crecer para 'needed' elementos: el doble, con un mínimo
+static int64_t grown_capacity(const Array *arr, int64_t needed) {
+    int64_t capacity = arr->capacity < 8 ? 8 : (int64_t)arr->capacity * 2;
+    if (capacity > INT_MAX) capacity = INT_MAX;
+    return capacity > needed ? capacity : needed;
+}
+
+// Amplía data a 'capacity' elementos, a cero. Nunca reduce. 0 o -1.
+static int array_grow(Array *arr, int64_t capacity) {
+    if (capacity <= arr->capacity) return 0;
+    if (capacity > INT_MAX) return -1;
+    size_t old_bytes = vm_array_bytes(arr->type, arr->capacity);
+    size_t bytes = vm_array_bytes(arr->type, (int)capacity);
+    void *data = realloc(arr->data, bytes);
+    if (!data) return -1;
+    memset((uint8_t*)data + old_bytes, 0, bytes - old_bytes);
+    arr->data = data;
+    arr->capacity = (int)capacity;
+    return 0;
+}
+
+// Pone a cero los elementos [from, to), que están por debajo de size
+static void array_zero(Array *arr, int from, int to) {
+    if (arr->type == 'z') {
+        while (from < to && (from & 7)) vm_array_set_int(arr, from++, 0);
+        while (to > from && (to & 7)) vm_array_set_int(arr, --to, 0);
+        memset((uint8_t*)arr->data + from / 8, 0, (size_t)(to - from) / 8);
+        return;
+    }
+    size_t element = vm_array_bytes(arr->type, 1);
+    memset((uint8_t*)arr->data + (size_t)from * element, 0, (size_t)(to - from) * element);
+}
+
+static int out_of_memory(VMState *vm) {
+    vm_fail(vm, "No hay memoria para el array");
+    return -1;
+}
+
+int vm_array_push(VMState *vm, int var, Value value) {
+    Array *arr = method_array(vm, var);
+    if (!arr) return -1;
+    if (arr->size == arr->capacity && array_grow(arr, grown_capacity(arr, (int64_t)arr->size + 1)) != 0) {
+        return out_of_memory(vm);
+    }
+    arr->size++;
+    if (arr->type == 'd') {
+        vm_array_set_f64(arr, arr->size - 1, value.f);
+    } else {
+        vm_array_set_int(arr, arr->size - 1, value.i);
+    }
+    return 0;
+}
+
+int vm_array_pop(VMState *vm, int var, Value *value) {
+    Array *arr = method_array(vm, var);
+    if (!arr) return -1;
+    if (arr->size == 0) {
+        vm_fail(vm, "pop() de un array vacío");
+        return -1;
+    }
+    int last = arr->size - 1;
+    if (arr->type == 'd') {
+        value->f = vm_array_get_f64(arr, last);
+    } else {
+        value->i = vm_array_get_int(arr, last);
+    }
+    array_zero(arr, last, arr->size);
+    arr->size = last;
+    return 0;
+}
+
+int vm_array_reserve(VMState *vm, int var, int64_t capacity) {
+    Array *arr = method_array(vm, var);
+    if (!arr) return -1;
+    return array_grow(arr, capacity) == 0 ? 0 : out_of_memory(vm);
+}
+
+int vm_array_resize(VMState *vm, int var, int64_t size) {
+    Array *arr = method_array(vm, var);
+    if (!arr) return -1;
+    if (size < 0) {
+        vm_fail(vm, "resize() con un tamaño negativo");
+        return -1;
+    }
+    if (size > arr->capacity && array_grow(arr, grown_capacity(arr, size)) != 0) return out_of_memory(vm);
+    if (size < arr->size) array_zero(arr, (int)size, arr->size);
+    arr->size = (int)size;
+    return 0;
+}
+
+int vm_array_copy(VMState *vm, int var, int source_var) {
+    Array *dst = method_array(vm, var);
+    if (!dst) return -1;
+    int source = vm_resolve_array(vm, source_var);
+    if (source < 0) {
+        vm_fail(vm, "copy() de un array sin crear");
+        return -1;
+    }
+    const Array *src = &vm->arrays[source];
+    if (src == dst) return 0;
+
+    array_zero(dst, 0, dst->size);
+    dst->size = 0;
+    if (array_grow(dst, src->size) != 0) return out_of_memory(vm);
+    dst->size = src->size;
+    if (src->type == dst->type && array_contiguous(src)) {
+        memcpy(dst->data, src->data, vm_array_bytes(src->type, src->size));
+    } else if (dst->type == 'd') {
+        for (int i = 0; i < src->size; i++) vm_array_set_f64(dst, i, vm_array_get_f64(src, i));
+    } else {
+        for (int i = 0; i < src->size; i++) vm_array_set_int(dst, i, vm_array_get_int(src, i));
+    }
+    return 0;
+}
+
+static int bulk_has_other(uint8_t opcode) {
+    return opcode == OPCODE_ARRAY_ADD || opcode == OPCODE_ARRAY_MUL ||
+           opcode == OPCODE_ARRAY_AXPY || opcode == OPCODE_ARRAY_DOT;
+}
+
+// sum, min, max y dot: dejan el resultado en 'value'
+static int bulk_reduces(uint8_t opcode) {
+    return opcode == OPCODE_ARRAY_SUM || opcode == OPCODE_ARRAY_MIN ||
+           opcode == OPCODE_ARRAY_MAX || opcode == OPCODE_ARRAY_DOT;
+}
+
+// Arrays de double (y 'other' también de double)
+static void bulk_f64(uint8_t opcode, Array *arr, const Array *other, size_t n, Value *value) {
+    const SimdKernels *k = simd_kernels();
+    double *data = (double*)arr->data;
+    const double *x = other ? (const double*)other->data : NULL;
+    switch (opcode) {
+        case OPCODE_ARRAY_FILL:  k->fill_f64(data, value->f, n); break;
+        case OPCODE_ARRAY_ADD:   k->add_f64(data, x, n); break;
+        case OPCODE_ARRAY_MUL:   k->mul_f64(data, x, n); break;
+        case OPCODE_ARRAY_SCALE: k->scale_f64(data, value->f, n); break;
+        case OPCODE_ARRAY_AXPY:  k->axpy_f64(data, value->f, x, n); break;
+        case OPCODE_ARRAY_SUM:   value->f = k->sum_f64(data, n); break;
+        case OPCODE_ARRAY_MIN:   value->f = k->min_f64(data, n); break;
+        case OPCODE_ARRAY_MAX:   value->f = k->max_f64(data, n); break;
+        case OPCODE_ARRAY_DOT:   value->f = k->dot_f64(data, x, n); break;
+    }
+}
+
+// Arrays de int (int32). Los operandos se truncan a 32 bits como al guardar:
+// los 32 bits bajos del resultado no dependen de los altos.
+static void bulk_i32(uint8_t opcode, Array *arr, const Array *other, size_t n, Value *value) {
+    const SimdKernels *k = simd_kernels();
+    int32_t *data = (int32_t*)arr->data;
+    const int32_t *x = other ? (const int32_t*)other->data : NULL;
+    switch (opcode) {
+        case OPCODE_ARRAY_FILL:  k->fill_i32(data, (int32_t)value->i, n); break;
+        case OPCODE_ARRAY_ADD:   k->add_i32(data, x, n); break;
+        case OPCODE_ARRAY_MUL:   k->mul_i32(data, x, n); break;
+        case OPCODE_ARRAY_SCALE: k->scale_i32(data, (int32_t)value->i, n); break;
+        case OPCODE_ARRAY_AXPY:  k->axpy_i32(data, (int32_t)value->i, x, n); break;
+        case OPCODE_ARRAY_SUM:   value->i = k->sum_i32(data, n); break;
+        case OPCODE_ARRAY_MIN:   value->i = k->min_i32(data, n); break;
+        case OPCODE_ARRAY_MAX:   value->i = k->max_i32(data, n); break;
+        case OPCODE_ARRAY_DOT:   value->i = k->dot_i32(data, x, n); break;
+    }
+}
+
+// Cualquier otra combinación, elemento a elemento con las conversiones de
+// ARRAY_GET/SET. En int64 se opera en uint64 para que el desbordamiento dé la
+// vuelta en vez de ser indefinido.
+static void bulk_generic(uint8_t opcode, Array *arr, const Array *other, size_t n, Value *value) {
+    if (arr->type == 'd') {
+        double result = opcode == OPCODE_ARRAY_MIN || opcode == OPCODE_ARRAY_MAX ? vm_array_get_f64(arr, 0) : 0;
+        for (size_t i = 0; i < n; i++) {
+            double v = vm_array_get_f64(arr, i);
+            double x = other ? vm_array_get_f64(other, i) : 0;
+            switch (opcode) {
+                case OPCODE_ARRAY_FILL:  vm_array_set_f64(arr, i, value->f); break;
+                case OPCODE_ARRAY_ADD:   vm_array_set_f64(arr, i, v + x); break;
+                case OPCODE_ARRAY_MUL:   vm_array_set_f64(arr, i, v * x); break;
+                case OPCODE_ARRAY_SCALE: vm_array_set_f64(arr, i, v * value->f); break;
+                case OPCODE_ARRAY_AXPY:  vm_array_set_f64(arr, i, v + value->f * x); break;
+                case OPCODE_ARRAY_SUM:   result += v; break;
+                case OPCODE_ARRAY_MIN:   result = v < result ? v : result; break;
+                case OPCODE_ARRAY_MAX:   result = v > result ? v : result; break;
+                case OPCODE_ARRAY_DOT:   result += v * x; break;
+            }
+        }
+        if (bulk_reduces(opcode)) value->f = result;
+        return;
+    }
+
+    uint64_t result = opcode == OPCODE_ARRAY_MIN || opcode == OPCODE_ARRAY_MAX ? (uint64_t)vm_array_get_int(arr, 0) : 0;
+    uint64_t operand = (uint64_t)value->i;
+    for (size_t i = 0; i < n; i++) {
+        int64_t v = vm_array_get_int(arr, i);
+        uint64_t x = other ? (uint64_t)vm_array_get_int(other, i) : 0;
+        switch (opcode) {
+            case OPCODE_ARRAY_FILL:  vm_array_set_int(arr, i, value->i); break;
+            case OPCODE_ARRAY_ADD:   vm_array_set_int(arr, i, (int64_t)((uint64_t)v + x)); break;
+            case OPCODE_ARRAY_MUL:   vm_array_set_int(arr, i, (int64_t)((uint64_t)v * x)); break;
+            case OPCODE_ARRAY_SCALE: vm_array_set_int(arr, i, (int64_t)((uint64_t)v * operand)); break;
+            case OPCODE_ARRAY_AXPY:  vm_array_set_int(arr, i, (int64_t)((uint64_t)v + operand * x)); break;
+            case OPCODE_ARRAY_SUM:   result += (uint64_t)v; break;
+            case OPCODE_ARRAY_MIN:   result = v < (int64_t)result ? (uint64_t)v : result; break;
+            case OPCODE_ARRAY_MAX:   result = v > (int64_t)result ? (uint64_t)v : result; break;
+            case OPCODE_ARRAY_DOT:   result += (uint64_t)v * x; break;
+        }
+    }
+    if (bulk_reduces(opcode)) value->i = (int64_t)result;
+}
+
+int vm_array_bulk(VMState *vm, uint8_t opcode, int var, int other_var, Value *value) {
+    int index = vm_resolve_array(vm, var);
+    int other_index = bulk_has_other(opcode) ? vm_resolve_array(vm, other_var) : index;
+    if (index < 0 || other_index < 0) {
+        vm_fail(vm, "Operación sobre un array sin crear");
+        return -1;
+    }
+    Array *arr = &vm->arrays[index];
+    const Array *other = bulk_has_other(opcode) ? &vm->arrays[other_index] : NULL;
+    size_t n = (size_t)arr->size;
+    if (other && (size_t)other->size < n) n = (size_t)other->size;
+    if ((opcode == OPCODE_ARRAY_MIN || opcode == OPCODE_ARRAY_MAX) && n == 0) {
+        vm_fail(vm, "min() o max() de un array vacío");
+        return -1;
+    }
+
+    if ((other && other->type != arr->type) || !array_contiguous(arr) || (other && !array_contiguous(other))) {
+        bulk_generic(opcode, arr, other, n, value);
+    } else if (arr->type == 'd') {
+        bulk_f64(opcode, arr, other, n, value);
+    } else if (arr->type == 'i') {
+        bulk_i32(opcode, arr, other, n, value);
+    } else {
+        bulk_generic(opcode, arr, other, n, value);
+    }
+    return 0;
+}
+
+// Copia los elementos de 'src' en 'dst' (del mismo tipo, sin bits)
+static void array_copy_elements(Array *dst, const Array *src) {
+    for (int i = 0; i < src->size; i++) {
+        if (src->type == 'd') vm_array_set_f64(dst, i, vm_array_get_f64(src, i));
+        else vm_array_set_int(dst, i, vm_array_get_int(src, i));
+    }
+}
+
+int vm_array_sort(VMState *vm, int var, int descending) {
+    int index = vm_resolve_array(vm, var);
+    if (index < 0) {
+        vm_fail(vm, "Operación sobre un array sin crear");
+        return -1;
+    }
+    Array *arr = &vm->arrays[index];
+    if (arr->type == 'z') {
+        // Bits: basta con contar los true y escribirlos juntos
+        int ones = 0;
+        for (int i = 0; i < arr->size; i++) ones += vm_array_get_int(arr, i) != 0;
+        for (int i = 0; i < arr->size; i++) {
+            vm_array_set_int(arr, i, descending ? i < ones : i >= arr->size - ones);
+        }
+        return 0;
+    }
+
+    // Una vista de columna se ordena en una copia contigua que luego se
+    // devuelve a su sitio
+    Array sorted = *arr;
+    if (!array_contiguous(arr)) {
+        sorted.data = malloc(vm_array_bytes(arr->type, arr->size) + 1);
+        if (!sorted.data) return out_of_memory(vm);
+        sorted.stride = 1;
+        array_copy_elements(&sorted, arr);
+    }
+    size_t n = (size_t)arr->size;
+    int status = 0;
+    switch (arr->type) {
+        case 'd': status = sort_f64((double*)sorted.data, n, descending, vm->parallel_threads); break;
+        case 'l': status = sort_i64((int64_t*)sorted.data, n, descending, vm->parallel_threads); break;
+        case 'i': status = sort_i32((int32_t*)sorted.data, n, descending, vm->parallel_threads); break;
+        case 'u': sort_u8((uint8_t*)sorted.data, n, descending); break;
+    }
+    if (sorted.data != arr->data) {
+        if (status == 0) array_copy_elements(arr, &sorted);
+        free(sorted.data);
+    }
+    return status == 0 ? 0 : out_of_memory(vm);
+}
+
+int vm_array_search(VMState *vm, int var, Value *value) {
+    int index = vm_resolve_array(vm, var);
+    if (index < 0) {
+        vm_fail(vm, "Operación sobre un array sin crear");
+        return -1;
+    }
+    const Array *arr = &vm->arrays[index];
+    int lo = 0, hi = arr->size;
+    if (arr->type == 'd') {
+        const double *data = (const double*)arr->data;
+        double wanted = value->f;
+        while (lo < hi) {
+            int mid = lo + (hi - lo) / 2;
+            if (data[mid] < wanted) lo = mid + 1;
+            else hi = mid;
+        }
+        value->i = lo < arr->size && data[lo] == wanted ? lo : -1;
+    } else {
+        int64_t wanted = value->i;
+        while (lo < hi) {
+            int mid = lo + (hi - lo) / 2;
+            if (vm_array_get_int(arr, mid) < wanted) lo = mid + 1;
+            else hi = mid;
+        }
+        value->i = lo < arr->size && vm_array_get_int(arr, lo) == wanted ? lo : -1;
+    }
+    return 0;
+}
+
+int vm_array_unique(VMState *vm, int var, Value *value) {
+    Array *arr = method_array(vm, var);
+    if (!arr) return -1;
+    size_t n = (size_t)arr->size, kept = 0;
+    switch (arr->type) {
+        case 'd': kept = unique_f64((double*)arr->data, n); break;
+        case 'l': kept = unique_i64((int64_t*)arr->data, n); break;
+        case 'i': kept = unique_i32((int32_t*)arr->data, n); break;
+        case 'u': kept = unique_u8((uint8_t*)arr->data, n); break;
+        case 'z':
+            for (int i = 0; i < arr->size; i++) {
+                int64_t bit = vm_array_get_int(arr, i);
+                if (kept == 0 || bit != vm_array_get_int(arr, (int64_t)kept - 1)) {
+                    vm_array_set_int(arr, (int64_t)kept++, bit);
+                }
+            }
+            break;
+    }
+    array_zero(arr, (int)kept, arr->size);
+    arr->size = (int)kept;
+    value->i = (int64_t)kept;
+    return 0;
+}
+
+int vm_array_view(VMState *vm, uint8_t opcode, int var, int source_var, int64_t from, int64_t to) {
+    int source = vm_resolve_array(vm, source_var);
+    if (source < 0 || var >= vm->variable_count || vm->variables[var].type != 'b') {
+        vm_fail(vm, "Operación sobre un array sin crear");
+        return -1;
+    }
+    const Array *src = &vm->arrays[source];
+    if (vm->variables[source_var].type == 'b' && src->parent < 0) {
+        vm_fail(vm, "Las vistas solo se toman de arrays estáticos o de otras vistas");
+        return -1;
+    }
+    if (opcode != OPCODE_ARRAY_SLICE && src->dims < 2) {
+        vm_fail(vm, "row() y col() necesitan un array de varias dimensiones");
+        return -1;
+    }
+
+    // La vista son 'count' elementos de src desde 'first', de 'step' en 'step'
+    int rows = src->shape[0];
+    int64_t row_size = rows > 0 ? src->size / rows : 0;
+    int64_t first = 0, count = 0, step = 1;
+    Array view = *src;
+    if (opcode == OPCODE_ARRAY_SLICE) {
+        if (from < 0 || from > to || to > rows) {
+            vm_fail(vm, "slice() fuera de rango");
+            return -1;
+        }
+        first = from * row_size;
+        count = (to - from) * row_size;
+        view.shape[0] = (int)(to - from);
+    } else {
+        int last = src->shape[src->dims - 1];
+        if (from < 0 || from >= (opcode == OPCODE_ARRAY_ROW ? rows : last)) {
+            vm_fail(vm, opcode == OPCODE_ARRAY_ROW ? "row() fuera de rango" : "col() fuera de rango");
+            return -1;
+        }
+        view.dims = src->dims - 1;
+        if (opcode == OPCODE_ARRAY_ROW) {
+            first = from * row_size;
+            count = row_size;
+            memmove(view.shape, view.shape + 1, view.dims * sizeof(int));
+        } else {
+            first = from;
+            count = src->size / last;
+            step = last;
+        }
+    }
+
+    view.name = vm->variables[var].name;
+    view.size = view.capacity = (int)count;
+    view.str_data = NULL;
+    view.stride = (int)(src->stride * step);
+    view.parent = src->parent >= 0 ? src->parent : source;
+    if (src->type == 'z') {
+        view.first_bit = (int)(src->first_bit + first * src->stride);
+    } else {
+        view.data = (uint8_t*)src->data + (size_t)(first * src->stride) * vm_array_bytes(src->type, 1);
+    }
+
+    // Como ARRAY_NEW: la entrada de la variable se reutiliza
+    int index = vm_dynamic_array(vm, var);
+    if (index < 0) {
+        Array *temp = realloc(vm->arrays, (vm->array_count + 1) * sizeof(Array));
+        if (!temp) return out_of_memory(vm);
+        vm->arrays = temp;
+        index = vm->array_count++;
+        vm->variables[var].value = (double)index;
+    } else if (vm->arrays[index].parent < 0) {
+        free(vm->arrays[index].data);
+    }
+    vm->arrays[index] = view;
+    return 0;
+}
+
+int vm_enter_method(VMState *vm, int class_index, int slot, int return_pc) {
+    ClassDefinition *cls = &vm->class_pool.classes[class_index];
+    int local_count = cls->methods[slot].local_count;
+    if (vm->call_sp >= 64 || vm_reserve_locals(vm, local_count) != 0) {
+        fprintf(stderr, "Error: Desbordamiento de la pila de llamadas\n");
+        vm->failed = 1;
+        return -1;
+    }
+    
+    // El frame del método empieza tras el del llamador
+    CallFrame *frame = &vm->call_stack[vm->call_sp++];
+    frame->return_pc = return_pc;
+    frame->fp = vm->fp;
+    frame->frame_size = vm->frame_size;
+    vm->fp += vm->frame_size;
+    vm->frame_size = local_count;
+    return cls->vtable[slot];
+}
+
+int vm_leave_method(VMState *vm) {
+    if (vm->call_sp == 0) return -1;
+    CallFrame *frame = &vm->call_stack[--vm->call_sp];
+    vm->fp = frame->fp;
+    vm->frame_size = frame->frame_size;
+    return frame->return_pc;
+}
+
+// Los números se formatean directamente en el buffer de salida o, si este es
+// más pequeño que un número, en 'scratch'
+static char *number_slot(VMState *vm, char *scratch) {
+    char *dst = output_reserve(&vm->out, FORMAT_NUMBER_MAX + 1);
+    return dst ? dst : scratch;
+}
+
+static void number_done(VMState *vm, char *text, const char *scratch, int length, int newline) {
+    if (newline) text[length++] = '\n';
+    if (text == scratch) {
+        output_write(&vm->out, scratch, (size_t)length);
+    } else {
+        output_commit(&vm->out, (size_t)length);
+    }
+}
+
+static void print_double(VMState *vm, double value, int newline) {
+    char scratch[FORMAT_NUMBER_MAX + 1];
+    char *text = number_slot(vm, scratch);
+    number_done(vm, text, scratch, format_double(text, value), newline);
+}
+
+static void print_int(VMState *vm, int64_t value, int newline) {
+    char scratch[FORMAT_NUMBER_MAX + 1];
+    char *text = number_slot(vm, scratch);
+    number_done(vm, text, scratch, format_int64(text, value), newline);
+}
+
+void vm_println_number(VMState *vm, double value) {
+    print_double(vm, value, 1);
+}
+
+void vm_println_int(VMState *vm, int64_t value) {
+    print_int(vm, value, 1);
+}
+
+void vm_format_print(VMState *vm, const char *template_text, const Value *values) {
+    const char *text = template_text;
+    for (;;) {
+        const char *hole = strchr(text, FORMAT_HOLE);
+        if (!hole) {
+            output_string(&vm->out, text);
+            return;
+        }
+        output_write(&vm->out, text, (size_t)(hole - text));
+        switch (hole[1]) {
+            case 'i': print_int(vm, (values++)->i, 0); break;
+            case 'f': print_double(vm, (values++)->f, 0); break;
+            case FORMAT_HOLE: output_char(&vm->out, FORMAT_HOLE); break;
+            default: return;  // Plantilla truncada
+        }
+        text = hole + 2;
+    }
+}
+
+void vm_fail(VMState *vm, const char *message) {
+    // Lo ya impreso debe aparecer antes que el error
+    output_flush(&vm->out);
+    fprintf(stderr, "Error: %s (PC %d)\n", message, vm->pc);
+    vm->pc = vm->instruction_count;
+    vm->failed = 1;
+}
+
+int vm_load_image(VMState *vm, const uint8_t *data, size_t size, int debug) {
+    ImageReader reader = { data, size, 0 };
+
+    // Leer header
+    char header[4];
+    if (!image_read(&reader, header, 4)) {
+        fprintf(stderr, "Error: No se puede leer header del bytecode\n");
+        return -1;
+    }
+    
+    if (strncmp(header, "GOLD", 4) != 0) {
+        fprintf(stderr, "Error: Bytecode inválido (header incorrecto)\n");
+        return -1;
+    }
+
+    // Leer versión
+    uint8_t version;
+    if (!image_read(&reader, &version, 1)) {
+        fprintf(stderr, "Error: No se puede leer versión del bytecode\n");
+        return -1;
+    }
+    
+    if (debug) fprintf(stderr, "[VM] Bytecode version: %d\n", version);
+
+    // Leer configuración de ventana
+    WindowConfig window_config = {0};
+    strcpy(window_config.window_title, "Golden Application");
+    window_config.window_width = 800;
+    window_config.window_height = 600;
+    window_config.window_resizable = 0;
+    strcpy(window_config.window_mode, "windowed");
+    strcpy(window_config.renderer, "auto");
+    
+    uint8_t window_title_len = 0;
+    if (!image_read(&reader, &window_title_len, 1)) {
+        fprintf(stderr, "Error: No se puede leer longitud del título de ventana\n");
+        return -1;
+    }
+    if (window_title_len > 0 && window_title_len < 256) {
+        if (!image_read(&reader, window_config.window_title, window_title_len)) {
+            fprintf(stderr, "Error: No se puede leer título de ventana\n");
+            return -1;
+        }
+        window_config.window_title[window_title_len] = '\0';
+    }
+    
+    if (!image_read(&reader, &window_config.window_width, sizeof(uint16_t))) {
+        fprintf(stderr, "Error: No se puede leer ancho de ventana\n");
+        return -1;
+    }
+    
+    if (!image_read(&reader, &window_config.window_height, sizeof(uint16_t))) {
+        fprintf(stderr, "Error: No se puede leer alto de ventana\n");
+        return -1;
+    }
+    
+    if (!image_read(&reader, &window_config.window_resizable, 1)) {
+        fprintf(stderr, "Error: No se puede leer resizable de ventana\n");
+        return -1;
+    }
+    
+    uint8_t window_mode_len = 0;
+    if (!image_read(&reader, &window_mode_len, 1)) {
+        fprintf(stderr, "Error: No se puede leer longitud del modo de ventana\n");
+        return -1;
+    }
+    if (window_mode_len > 0 && window_mode_len < 32) {
+        if (!image_read(&reader, window_config.window_mode, window_mode_len)) {
+            fprintf(stderr, "Error: No se puede leer modo de ventana\n");
+            return -1;
+        }
+        window_config.window_mode[window_mode_len] = '\0';
+    }
+    
+    // Leer renderer
+    uint8_t renderer_len = 0;
+    if (!image_read(&reader, &renderer_len, 1)) {
+        fprintf(stderr, "Error: No se puede leer longitud del renderer\n");
+        return -1;
+    }
+    if (renderer_len > 0 && renderer_len < 32) {
+        if (!image_read(&reader, window_config.renderer, renderer_len)) {
+            fprintf(stderr, "Error: No se puede leer renderer\n");
+            return -1;
+        }
+        window_config.renderer[renderer_len] = '\0';
+    }
+    
+    // Leer fps
+    uint16_t fps = 60;  // Valor por defecto
+    if (!image_read(&reader, &fps, sizeof(uint16_t))) {
+        fprintf(stderr, "Error: No se puede leer fps\n");
+        return -1;
+    }
+    if (fps < 1 || fps > 240) {
+        fps = 60;  // Validar rango
+    }
+    window_config.fps = fps;
+    
+    if (debug) {
+        fprintf(stderr, "[VM] Window configuration:\n");
+        fprintf(stderr, "  Title: %s\n", window_config.window_title);
+        fprintf(stderr, "  Resolution: %d x %d\n", window_config.window_width, window_config.window_height);
+        fprintf(stderr, "  Resizable: %s\n", window_config.window_resizable ? "Yes" : "No");
+        fprintf(stderr, "  Mode: %s\n", window_config.window_mode);
+        fprintf(stderr, "  Renderer: %s\n", window_config.renderer);
+        fprintf(stderr, "  FPS: %d\n", window_config.fps);
+    }
+
+    // Leer cantidad de variables globales
+    uint16_t var_count = 0;
+    if (!image_read(&reader, &var_count, sizeof(uint16_t))) {
+        fprintf(stderr, "Error: No se puede leer cantidad de variables\n");
+        return -1;
+    }
+
+    if (debug) fprintf(stderr, "[VM] Global variables: %d\n", var_count);
+
+    // Leer variables globales (optimizado con tipo)
+    Variable *variables = NULL;
+    if (var_count > 0) {
+        variables = (Variable*)malloc(var_count * sizeof(Variable));
+        if (!variables) {
+            fprintf(stderr, "Error: No hay memoria suficiente\n");
+            return -1;
+        }
+
+        for (int i = 0; i < var_count; i++) {
+            uint8_t name_len = 0;
+            if (!image_read(&reader, &name_len, 1)) {
+                fprintf(stderr, "Error: No se puede leer nombre de variable\n");
+                return -1;
+            }
+
+            variables[i].name = (char*)malloc(name_len + 1);
+            if (!variables[i].name) {
+                fprintf(stderr, "Error: No hay memoria suficiente\n");
+                return -1;
+            }
+            variables[i].element_type = 0;
+
+            if (!image_read(&reader, variables[i].name, name_len)) {
+                fprintf(stderr, "Error: No se puede leer nombre de variable\n");
+                return -1;
+            }
+            variables[i].name[name_len] = '\0';
+
+            // Leer tipo de variable
+            uint8_t var_type = 0;
+            if (!image_read(&reader, &var_type, 1)) {
+                fprintf(stderr, "Error: No se puede leer tipo de variable\n");
+                return -1;
+            }
+            variables[i].type = var_type;
+
+            // Leer valor según tipo
+            if (var_type == 's') {
+                // String: leer longitud + contenido
+                uint16_t str_len = 0;
+                if (!image_read(&reader, &str_len, sizeof(uint16_t))) {
+                    fprintf(stderr, "Error: No se puede leer longitud de string\n");
+                    return -1;
+                }
+                
+                variables[i].str_val = (char*)malloc(str_len + 1);
+                if (!variables[i].str_val) {
+                    fprintf(stderr, "Error: No hay memoria suficiente\n");
+                    return -1;
+                }
+                
+                if (!image_read(&reader, variables[i].str_val, str_len)) {
+                    fprintf(stderr, "Error: No se puede leer contenido de string\n");
+                    return -1;
+                }
+                variables[i].str_val[str_len] = '\0';
+                variables[i].value = 0;
+                
+                if (debug) fprintf(stderr, "[VM] Variable %d (string): %s = \"%s\"\n", i, variables[i].name, variables[i].str_val);
+            } else if (var_type == 'a') {
+                // Array estático: leer tipo de elemento, tamaño y, si tiene
+                // varias dimensiones, el tamaño de cada una
+                uint8_t element_type = 0;
+                int array_size = 0;
+                if (!image_read(&reader, &element_type, 1) || 
+                    !image_read(&reader, &array_size, sizeof(int))) {
+                    fprintf(stderr, "Error: No se puede leer información del array\n");
+                    return -1;
+                }
+                variables[i].dims = 1;
+                variables[i].shape[0] = array_size;
+                if (element_type & ARRAY_SHAPED) {
+                    uint8_t dims = 0;
+                    element_type &= (uint8_t)~ARRAY_SHAPED;
+                    if (!image_read(&reader, &dims, 1) || dims < 2 || dims > ARRAY_MAX_DIMS ||
+                        !image_read(&reader, variables[i].shape, dims * sizeof(int))) {
+                        fprintf(stderr, "Error: No se puede leer información del array\n");
+                        return -1;
+                    }
+                    variables[i].dims = dims;
+                }
+                // El array se crea al terminar la carga, con este tamaño y tipo
+                variables[i].value = (double)array_size;
+                variables[i].element_type = (char)element_type;
+                variables[i].str_val = NULL;
+                
+                if (debug) fprintf(stderr, "[VM] Variable %d (array estático): %s[%d] (tipo: %c)\n", i, variables[i].name, array_size, element_type);
+            } else if (var_type == 'b') {
+                // Array dinámico: leer tipo de elemento (tamaño será 0)
+                uint8_t element_type = 0;
+                if (!image_read(&reader, &element_type, 1)) {
+                    fprintf(stderr, "Error: No se puede leer tipo de array dinámico\n");
+                    return -1;
+                }
+                // El tipo de elemento llega también en el ARRAY_NEW
+                variables[i].element_type = (char)element_type;
+                variables[i].str_val = NULL;
+                
+                if (debug) fprintf(stderr, "[VM] Variable %d (array dinámico): %s (tipo elemento: %c)\n", i, variables[i].name, element_type);
+            } else if (var_type == 'o') {
+                // Objeto: índice de su clase; la instancia se crea con NEW_INSTANCE
+                uint16_t class_index = 0;
+                if (!image_read(&reader, &class_index, sizeof(uint16_t))) {
+                    fprintf(stderr, "Error: No se puede leer clase de variable objeto\n");
+                    return -1;
+                }
+                variables[i].value = -1;
+                variables[i].str_val = NULL;
+                
+                if (debug) fprintf(stderr, "[VM] Variable %d (objeto): %s (clase %d)\n", i, variables[i].name, class_index);
+            } else {
+                // Numeric: leer double
+                variables[i].str_val = NULL;
+                if (!image_read(&reader, &variables[i].value, sizeof(double))) {
+                    fprintf(stderr, "Error: No se puede leer valor de variable\n");
+                    return -1;
+                }
+
+                if (debug) fprintf(stderr, "[VM] Variable %d (%c): %s = %f\n", i, var_type, variables[i].name, variables[i].value);
+            }
+        }
+    }
+
+    // Leer cantidad de clases
+    uint16_t class_count = 0;
+    if (!image_read(&reader, &class_count, sizeof(uint16_t))) {
+        fprintf(stderr, "Error: No se puede leer cantidad de clases\n");
+        return -1;
+    }
+
+    if (debug) fprintf(stderr, "[VM] Classes: %d\n", class_count);
+
+    // Leer definiciones de clases
+    ClassDefinition *classes = NULL;
+    if (class_count > 0) {
+        classes = (ClassDefinition*)malloc(class_count * sizeof(ClassDefinition));
+        if (!classes) {
+            fprintf(stderr, "Error: No hay memoria suficiente\n");
+            return -1;
+        }
+
+        for (int i = 0; i < class_count; i++) {
+            // Leer nombre de clase
+            uint8_t name_len = 0;
+            if (!image_read(&reader, &name_len, 1)) {
+                fprintf(stderr, "Error: No se puede leer nombre de clase\n");
+                return -1;
+            }
+
+            classes[i].name = (char*)malloc(name_len + 1);
+            if (!classes[i].name) {
+                fprintf(stderr, "Error: No hay memoria suficiente\n");
+                return -1;
+            }
+
+            if (!image_read(&reader, classes[i].name, name_len)) {
+                fprintf(stderr, "Error: No se puede leer nombre de clase\n");
+                return -1;
+            }
+            classes[i].name[name_len] = '\0';
+
+            // Leer cantidad de variables de instancia
+            uint8_t ivar_count = 0;
+            if (!image_read(&reader, &ivar_count, 1)) {
+                fprintf(stderr, "Error: No se puede leer cantidad de variables de instancia\n");
+                return -1;
+            }
+
+            classes[i].var_count = ivar_count;
+            classes[i].var_names = NULL;
+            classes[i].var_types = NULL;
+
+            if (ivar_count > 0) {
+                classes[i].var_names = (char**)malloc(ivar_count * sizeof(char*));
+                classes[i].var_types = (uint8_t*)malloc(ivar_count * sizeof(uint8_t));
+
+                if (!classes[i].var_names || !classes[i].var_types) {
+                    fprintf(stderr, "Error: No hay memoria suficiente\n");
+                    return -1;
+                }
+
+                for (int j = 0; j < ivar_count; j++) {
+                    uint8_t var_name_len = 0;
+                    if (!image_read(&reader, &var_name_len, 1)) {
+                        fprintf(stderr, "Error: No se puede leer nombre de variable de instancia\n");
+                        return -1;
+                    }
+
+                    classes[i].var_names[j] = (char*)malloc(var_name_len + 1);
+                    if (!classes[i].var_names[j]) {
+                        fprintf(stderr, "Error: No hay memoria suficiente\n");
+                        return -1;
+                    }
+
+                    if (!image_read(&reader, classes[i].var_names[j], var_name_len)) {
+                        fprintf(stderr, "Error: No se puede leer nombre de variable de instancia\n");
+                        return -1;
+                    }
+                    classes[i].var_names[j][var_name_len] = '\0';
+
+                    if (!image_read(&reader, &classes[i].var_types[j], 1)) {
+                        fprintf(stderr, "Error: No se puede leer tipo de variable de instancia\n");
+                        return -1;
+                    }
+
+                    if (debug) fprintf(stderr, "[VM] Clase '%s' variable %d: %s (tipo: %c)\n", 
+                                    classes[i].name, j, classes[i].var_names[j], classes[i].var_types[j]);
+                }
+            }
+
+            // Leer cantidad de métodos
+            uint8_t method_count = 0;
+            if (!image_read(&reader, &method_count, 1)) {
+                fprintf(stderr, "Error: No se puede leer cantidad de métodos\n");
+                return -1;
+            }
+            
+            classes[i].method_count = method_count;
+            if (method_count > 0) {
+                classes[i].methods = (ClassMethod*)malloc(method_count * sizeof(ClassMethod));
+                classes[i].vtable = (int*)malloc(method_count * sizeof(int));
+            } else {
+                classes[i].methods = NULL;
+                classes[i].vtable = NULL;
+            }
+            
+            // Leer métodos
+            for (int j = 0; j < method_count; j++) {
+                // Leer nombre del método
+                uint8_t method_name_len = 0;
+                if (!image_read(&reader, &method_name_len, 1)) {
+                    fprintf(stderr, "Error: No se puede leer longitud de nombre de método\n");
+                    return -1;
+                }
+                
+                char method_name[256] = {0};
+                if (!image_read(&reader, method_name, method_name_len)) {
+                    fprintf(stderr, "Error: No se puede leer nombre de método\n");
+                    return -1;
+                }
+                
+                classes[i].methods[j].name = (char*)malloc(method_name_len + 1);
+                strncpy(classes[i].methods[j].name, method_name, method_name_len);
+                classes[i].methods[j].name[method_name_len] = '\0';
+                
+                // Leer información del método
+                uint16_t local_count = 0;
+                if (!image_read(&reader, &classes[i].methods[j].is_public, 1) ||
+                    !image_read(&reader, &classes[i].methods[j].start_instruction, sizeof(int)) ||
+                    !image_read(&reader, &classes[i].methods[j].instruction_count, sizeof(int)) ||
+                    !image_read(&reader, &classes[i].methods[j].param_count, 1) ||
+                    !image_read(&reader, &local_count, sizeof(uint16_t))) {
+                    fprintf(stderr, "Error: No se puede leer información del método\n");
+                    return -1;
+                }
+                
+                classes[i].methods[j].local_count = local_count;
+                
+                // Slot j de la vtable de la clase, compartida por todas sus instancias
+                classes[i].vtable[j] = classes[i].methods[j].start_instruction;
+                
+                if (debug) fprintf(stderr, "[VM] Clase '%s' método %d: %s (%s)\n", 
+                                classes[i].name, j, classes[i].methods[j].name,
+                                classes[i].methods[j].is_public ? "public" : "private");
+            }
+        }
+    }
+
+    // Leer cantidad de strings
+    uint16_t string_count = 0;
+    if (!image_read(&reader, &string_count, sizeof(uint16_t))) {
+        fprintf(stderr, "Error: No se puede leer cantidad de strings\n");
+        return -1;
+    }
+
+    if (debug) fprintf(stderr, "[VM] Strings: %d\n", string_count);
+
+    // Leer strings
+    char **strings = NULL;
+    if (string_count > 0) {
+        strings = (char**)malloc(string_count * sizeof(char*));
+        if (!strings) {
+            fprintf(stderr, "Error: No hay memoria suficiente\n");
+            return -1;
+        }
+
+        for (int i = 0; i < string_count; i++) {
+            uint16_t str_len = 0;
+            if (!image_read(&reader, &str_len, sizeof(uint16_t))) {
+                fprintf(stderr, "Error: No se puede leer longitud de string\n");
+                return -1;
+            }
+
+            strings[i] = (char*)malloc(str_len + 1);
+            if (!strings[i]) {
+                fprintf(stderr, "Error: No hay memoria suficiente\n");
+                return -1;
+            }
+
+            if (!image_read(&reader, strings[i], str_len)) {
+                fprintf(stderr, "Error: No se puede leer string\n");
+                return -1;
+            }
+            strings[i][str_len] = '\0';
+
+            if (debug) fprintf(stderr, "[VM] String %d: '%s'\n", i, strings[i]);
+        }
+    }
+
+    // Slots del frame de la entrada
+    uint16_t entry_locals = 0;
+    if (!image_read(&reader, &entry_locals, sizeof(uint16_t))) {
+        fprintf(stderr, "Error: No se puede leer el tamaño del frame de entrada\n");
+        return -1;
+    }
+
+    // Instrucciones: el resto de la imagen, 3 bytes cada una
+    int instruction_count = (int)((reader.size - reader.pos) / sizeof(Instruction));
+    Instruction *instructions = (Instruction*)malloc((instruction_count > 0 ? instruction_count : 1) * sizeof(Instruction));
+    if (!instructions) {
+        fprintf(stderr, "Error: No hay memoria suficiente\n");
+        return -1;
+    }
+    image_read(&reader, instructions, instruction_count * sizeof(Instruction));
+
+    // Crear estado de la VM
+    memset(vm, 0, sizeof(*vm));
+    vm->instructions = instructions;
+    vm->instruction_count = instruction_count;
+    vm->string_pool.strings = strings;
+    vm->string_pool.string_count = string_count;
+    vm->variables = variables;
+    vm->variable_count = var_count;
+    vm->class_pool.classes = classes;
+    vm->class_pool.class_count = class_count;
+    vm->loop_counters = (uint64_t*)calloc(instruction_count + 1, sizeof(uint64_t));
+    if (!vm->loop_counters) {
+        fprintf(stderr, "Error: No hay memoria para los contadores de bucles\n");
+        return -1;
+    }
+    
+    // Almacenar configuración de ventana
+    vm->window_config = window_config;
+    
+    // Frame de la entrada
+    if (vm_reserve_locals(vm, entry_locals) != 0) {
+        fprintf(stderr, "Error: No hay memoria para variables locales\n");
+        return -1;
+    }
+    vm->frame_size = entry_locals;
+    
+    // Crear estructura de arrays basada en variables de tipo 'a'. Cada variable
+    // array guarda en 'value' su índice en vm->arrays (-1 si aún no existe).
+    for (int i = 0; i < var_count; i++) {
+        if (variables[i].type == 'b' || variables[i].type == 'o') {
+            // Arrays dinámicos y objetos se crean al ejecutar ARRAY_NEW / NEW_INSTANCE
+            variables[i].value = -1;
+        }
+        if (variables[i].type == 'a') {
+            Array *temp = realloc(vm->arrays, (vm->array_count + 1) * sizeof(Array));
+            if (!temp) {
+                fprintf(stderr, "Error: No hay memoria para arrays\n");
+                return -1;
+            }
+            vm->arrays = temp;
+            
+            int arr_size = (int)variables[i].value;
+            Array *arr = &vm->arrays[vm->array_count];
+            if (array_init(arr, variables[i].name, variables[i].element_type, arr_size) != 0) {
+                fprintf(stderr, "Error: No hay memoria para datos del array\n");
+                return -1;
+            }
+            arr->dims = variables[i].dims;
+            memcpy(arr->shape, variables[i].shape, sizeof(arr->shape));
+            
+            variables[i].value = (double)vm->array_count;
+            vm->array_count++;
+        }
+    }
+
+    return 0;
+}
+
+void vm_release(VMState *vm) {
+    output_free(&vm->out);
+    for (int i = 0; i < vm->string_pool.string_count; i++) {
+        free(vm->string_pool.strings[i]);
+    }
+    free(vm->string_pool.strings);
+    
+    for (int i = 0; i < vm->variable_count; i++) {
+        free(vm->variables[i].name);
+    }
+    free(vm->variables);
+    
+    ClassDefinition *classes = vm->class_pool.classes;
+    for (int i = 0; i < vm->class_pool.class_count; i++) {
+        free(classes[i].name);
+        for (int j = 0; j < classes[i].var_count; j++) {
+            free(classes[i].var_names[j]);
+        }
+        free(classes[i].var_names);
+        free(classes[i].var_types);
+        
+        // Liberar métodos
+        if (classes[i].methods) {
+            for (int j = 0; j < classes[i].method_count; j++) {
+                free(classes[i].methods[j].name);
+            }
+            free(classes[i].methods);
+            free(classes[i].vtable);
+        }
+    }
+    free(classes);
+    
+    // Liberar objetos y arrays
+    for (int i = 0; i < vm->object_count; i++) {
+        free(vm->objects[i].field_values);
+    }
+    free(vm->objects);
+    for (int i = 0; i < vm->array_count; i++) {
+        if (vm->arrays[i].parent < 0) free(vm->arrays[i].data);
+    }
+    free(vm->arrays);
+    free(vm->locals);
+    free(vm->loop_counters);
+    
+    free(vm->instructions);
+}
@@ -0,0 +1,175 @@
+#ifndef RUNTIME_H
+#define RUNTIME_H
+
+#include <stddef.h>
+#include "vm.h"
+
+// Runtime compartido por el intérprete (vm.c) y los ejecutables que genera
+// 'gldvm aot': carga de la imagen .gld y las operaciones que no merece la pena
+// emitir en línea. No depende de GLFW; la ventana es cosa del intérprete.
+
+// Lee el fichero completo. NULL (ya informado) si no se puede.
+uint8_t *vm_read_file(const char *path, size_t *size);
+
+// Inicializa 'vm' desde una imagen .gld en memoria: globales, clases,
+// strings, instrucciones, frame de entrada y arrays estáticos. El renderer
+// queda tal como viene en la imagen. 0 o -1 (ya informado).
+int vm_load_image(VMState *vm, const uint8_t *data, size_t size, int debug);
+
+// Vuelca la salida pendiente y libera todo lo que reservaron vm_load_image y
+// la ejecución
+void vm_release(VMState *vm);
+
+// Índice en vm->arrays de la variable array 'var', o -1
+int vm_resolve_array(const VMState *vm, int var);
+
+// Array dinámico al que apunta ahora la variable 'var' (ya sabido que es 'b')
+int vm_dynamic_array(const VMState *vm, int var);
+
+// Objeto referenciado por la variable 'var', o NULL si aún no se creó
+ObjectInstance *vm_resolve_object(VMState *vm, int var);
+
+// Garantiza 'count' slots a partir del final del frame actual, a cero
+int vm_reserve_locals(VMState *vm, int count);
+
+// Crea una instancia de la clase y la asigna a la variable objeto 'var'.
+// Índice del objeto o -1.
+int vm_new_instance(VMState *vm, int class_index, int var);
+
+// Crea un array dinámico de 'size' elementos y lo asigna a 'var'; si 'var'
+// ya tenía uno, lo libera y reutiliza su entrada. Índice del array o -1.
+int vm_array_new(VMState *vm, int var, char element_type, int size);
+
+// Pone a cero los elementos (y libera los strings) del array
+void vm_array_clear(VMState *vm, int array_index);
+
+// Bytes que ocupan 'size' elementos del tipo 'type' (ver Array)
+size_t vm_array_bytes(char type, int size);
+
+// push(), pop(), reserve(), resize() y copy() de un array dinámico ('var',
+// de tipo 'b'). La capacidad crece al doble cuando no cabe un elemento, así
+// que una serie de push() cuesta O(1) amortizado. 'value' es int64 o double
+// según el tipo del array. 0, o -1 tras vm_fail: sobre un array estático,
+// sin memoria, con un tamaño negativo o con pop() de un array vacío.
+int vm_array_push(VMState *vm, int var, Value value);
+int vm_array_pop(VMState *vm, int var, Value *value);
+int vm_array_reserve(VMState *vm, int var, int64_t capacity);
+int vm_array_resize(VMState *vm, int var, int64_t size);
+int vm_array_copy(VMState *vm, int var, int source_var);
+
+// Operación 'opcode' (ARRAY_FILL a ARRAY_DOT) sobre el array completo de
+// 'var'; 'other_var' es el segundo array de add, mul, axpy y dot, que recorren
+// los elementos que tienen los dos. Los arrays de double e int usan los
+// núcleos de simd.h; el resto, o dos arrays de distinto tipo, un bucle
+// elemento a elemento. 'value' es el operando de fill, scale y axpy o el
+// resultado de sum, min, max y dot, int64 o double según el tipo de 'var'.
+// 0, o -1 tras vm_fail si un array no existe o con min()/max() de uno vacío.
+int vm_array_bulk(VMState *vm, uint8_t opcode, int var, int other_var, Value *value);
+
+// sort() / sort_desc(), binary_search() y unique() (ver sort.h). Las
+// ordenaciones grandes se reparten entre vm->parallel_threads hilos.
+// binary_search espera el array ordenado de menor a mayor y cambia 'value'
+// (int64 o double según el array) por el índice del primer elemento igual, o
+// -1. unique, solo en arrays dinámicos, deja en 'value' el tamaño que queda.
+// 0, o -1 tras vm_fail si el array no existe, sin memoria o con unique()
+// sobre un array estático.
+int vm_array_sort(VMState *vm, int var, int descending);
+int vm_array_search(VMState *vm, int var, Value *value);
+int vm_array_unique(VMState *vm, int var, Value *value);
+
+// row(i), col(j) y slice(desde, hasta) de 'source_var' (ARRAY_ROW, ARRAY_COL
+// o ARRAY_SLICE; 'to' solo cuenta en slice): la variable de array dinámico
+// 'var' pasa a ser una vista que comparte los datos del origen, sin copiarlos.
+// row fija el primer índice y col el último (la vista tiene una dimensión
+// menos); slice toma las filas [from, to). El origen es un array estático u
+// otra vista, cuyos datos no se mueven nunca. 0, o -1 tras vm_fail fuera de
+// rango, con row()/col() de un array de una dimensión o sobre un array
+// dinámico.
+int vm_array_view(VMState *vm, uint8_t opcode, int var, int source_var, int64_t from, int64_t to);
+
+// Lectura y escritura de un elemento con conversión desde/hacia int64 o
+// double. Fuera de rango se lee 0 y no se escribe nada. Van en línea: las
+// usan el intérprete en cada ARRAY_GET/SET y el C que genera 'gldvm aot'.
+// En las vistas, el elemento i está en la posición i * stride de data.
+static inline int64_t vm_array_get_int(const Array *arr, int64_t index) {
+    if (index < 0 || index >= arr->size) return 0;
+    index *= arr->stride;
+    switch (arr->type) {
+        case 'i': return ((const int32_t*)arr->data)[index];
+        case 'l': return ((const int64_t*)arr->data)[index];
+        case 'u': return ((const uint8_t*)arr->data)[index];
+        case 'z':
+            index += arr->first_bit;
+            return (((const uint8_t*)arr->data)[index >> 3] >> (index & 7)) & 1;
+        default:  return (int64_t)((const double*)arr->data)[index];
+    }
+}
+
+static inline void vm_array_set_int(Array *arr, int64_t index, int64_t value) {
+    if (index < 0 || index >= arr->size) return;
+    index *= arr->stride;
+    switch (arr->type) {
+        case 'i': ((int32_t*)arr->data)[index] = (int32_t)value; break;
+        case 'l': ((int64_t*)arr->data)[index] = value; break;
+        case 'u': ((uint8_t*)arr->data)[index] = (uint8_t)value; break;
+        case 'z': {
+            index += arr->first_bit;
+            uint8_t *byte = (uint8_t*)arr->data + (index >> 3);
+            uint8_t bit = (uint8_t)(1u << (index & 7));
+            *byte = value ? (uint8_t)(*byte | bit) : (uint8_t)(*byte & ~bit);
+            break;
+        }
+        default:  ((double*)arr->data)[index] = (double)value; break;
+    }
+}
+
+// Escritura de un bool desde un hilo de parallel for: los 8 elementos de un
+// byte pueden caer en hilos distintos, así que el bit se cambia con un
+// read-modify-write atómico en lugar del de vm_array_set_int.
+static inline void vm_array_set_bit_atomic(Array *arr, int64_t index, int value) {
+    if (index < 0 || index >= arr->size) return;
+    index = index * arr->stride + arr->first_bit;
+    uint8_t *byte = (uint8_t*)arr->data + (index >> 3);
+    uint8_t bit = (uint8_t)(1u << (index & 7));
+    if (value) {
+        __atomic_fetch_or(byte, bit, __ATOMIC_RELAXED);
+    } else {
+        __atomic_fetch_and(byte, (uint8_t)~bit, __ATOMIC_RELAXED);
+    }
+}
+
+static inline double vm_array_get_f64(const Array *arr, int64_t index) {
+    if (arr->type != 'd') return (double)vm_array_get_int(arr, index);
+    return index >= 0 && index < arr->size ? ((const double*)arr->data)[index * arr->stride] : 0;
+}
+
+static inline void vm_array_set_f64(Array *arr, int64_t index, double value) {
+    if (arr->type != 'd') {
+        vm_array_set_int(arr, index, (int64_t)value);
+    } else if (index >= 0 && index < arr->size) {
+        ((double*)arr->data)[index * arr->stride] = value;
+    }
+}
+
+// Abre el frame del método 'slot' de la clase y devuelve su PC de entrada;
+// 'return_pc' es donde sigue el llamador. -1 si la pila de llamadas se desborda.
+int vm_enter_method(VMState *vm, int class_index, int slot, int return_pc);
+
+// Cierra el frame del método actual y devuelve el PC del llamador, o -1 si
+// no hay llamador (RETURN de la entrada).
+int vm_leave_method(VMState *vm);
+
+// PRINTLN de un valor numérico del stack en vm->out: sin decimales si es
+// entero y, si no, con los dígitos justos para recuperar el mismo double
+void vm_println_number(VMState *vm, double value);
+
+// PRINTLN_I64
+void vm_println_int(VMState *vm, int64_t value);
+
+// FORMAT_PRINT: imprime la plantilla tomando los huecos de 'values' en orden
+void vm_format_print(VMState *vm, const char *template_text, const Value *values);
+
+// Error de ejecución: se informa, se detiene la VM y la salida será EXIT_FAILURE
+void vm_fail(VMState *vm, const char *message);
+
+#endif
@@ -0,0 +1,519 @@
+#include "simd.h"
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define SIMD_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define SIMD_TARGET_AVX2
+#else
+#include <cpuid.h>
+#define SIMD_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+// ---------------------------------------------------------------------------
+// Escalar: la referencia, y lo que queda al final de los bucles vectoriales.
+// Las operaciones de int32 van en uint32 para que el desbordamiento dé la
+// vuelta sin comportamiento indefinido.
+
+static void fill_f64_scalar(double *dst, double value, size_t n) {
+    for (size_t i = 0; i < n; i++) dst[i] = value;
+}
+
+static void add_f64_scalar(double *dst, const double *src, size_t n) {
+    for (size_t i = 0; i < n; i++) dst[i] += src[i];
+}
+
+static void mul_f64_scalar(double *dst, const double *src, size_t n) {
+    for (size_t i = 0; i < n; i++) dst[i] *= src[i];
+}
+
+static void scale_f64_scalar(double *dst, double k, size_t n) {
+    for (size_t i = 0; i < n; i++) dst[i] *= k;
+}
+
+static void axpy_f64_scalar(double *dst, double k, const double *x, size_t n) {
+    for (size_t i = 0; i < n; i++) dst[i] += k * x[i];
+}
+
+static double sum_f64_scalar(const double *src, size_t n) {
+    double sum = 0;
+    for (size_t i = 0; i < n; i++) sum += src[i];
+    return sum;
+}
+
+static double min_f64_scalar(const double *src, size_t n) {
+    double m = src[0];
+    for (size_t i = 1; i < n; i++) m = src[i] < m ? src[i] : m;
+    return m;
+}
+
+static double max_f64_scalar(const double *src, size_t n) {
+    double m = src[0];
+    for (size_t i = 1; i < n; i++) m = src[i] > m ? src[i] : m;
+    return m;
+}
+
+static double dot_f64_scalar(const double *a, const double *b, size_t n) {
+    double sum = 0;
+    for (size_t i = 0; i < n; i++) sum += a[i] * b[i];
+    return sum;
+}
+
+static void fill_i32_scalar(int32_t *dst, int32_t value, size_t n) {
+    for (size_t i = 0; i < n; i++) dst[i] = value;
+}
+
+static void add_i32_scalar(int32_t *dst, const int32_t *src, size_t n) {
+    for (size_t i = 0; i < n; i++) dst[i] = (int32_t)((uint32_t)dst[i] + (uint32_t)src[i]);
+}
+
+static void mul_i32_scalar(int32_t *dst, const int32_t *src, size_t n) {
+    for (size_t i = 0; i < n; i++) dst[i] = (int32_t)((uint32_t)dst[i] * (uint32_t)src[i]);
+}
+
+static void scale_i32_scalar(int32_t *dst, int32_t k, size_t n) {
+    for (size_t i = 0; i < n; i++) dst[i] = (int32_t)((uint32_t)dst[i] * (uint32_t)k);
+}
+
+static void axpy_i32_scalar(int32_t *dst, int32_t k, const int32_t *x, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        dst[i] = (int32_t)((uint32_t)dst[i] + (uint32_t)k * (uint32_t)x[i]);
+    }
+}
+
+static int64_t sum_i32_scalar(const int32_t *src, size_t n) {
+    uint64_t sum = 0;
+    for (size_t i = 0; i < n; i++) sum += (uint64_t)(int64_t)src[i];
+    return (int64_t)sum;
+}
+
+static int32_t min_i32_scalar(const int32_t *src, size_t n) {
+    int32_t m = src[0];
+    for (size_t i = 1; i < n; i++) m = src[i] < m ? src[i] : m;
+    return m;
+}
+
+static int32_t max_i32_scalar(const int32_t *src, size_t n) {
+    int32_t m = src[0];
+    for (size_t i = 1; i < n; i++) m = src[i] > m ? src[i] : m;
+    return m;
+}
+
+static int64_t dot_i32_scalar(const int32_t *a, const int32_t *b, size_t n) {
+    uint64_t sum = 0;
+    for (size_t i = 0; i < n; i++) sum += (uint64_t)((int64_t)a[i] * b[i]);
+    return (int64_t)sum;
+}
+
+static const SimdKernels scalar_kernels = {
+    SIMD_SCALAR,
+    fill_f64_scalar, add_f64_scalar, mul_f64_scalar, scale_f64_scalar, axpy_f64_scalar,
+    sum_f64_scalar, min_f64_scalar, max_f64_scalar, dot_f64_scalar,
+    fill_i32_scalar, add_i32_scalar, mul_i32_scalar, scale_i32_scalar, axpy_i32_scalar,
+    sum_i32_scalar, min_i32_scalar, max_i32_scalar, dot_i32_scalar
+};
+
+#ifdef SIMD_X86
+
+// ---------------------------------------------------------------------------
+// SSE2: 2 doubles por registro. Las reducciones llevan dos acumuladores para
+// no esperar a la latencia de cada suma.
+
+static void fill_f64_sse2(double *dst, double value, size_t n) {
+    __m128d v = _mm_set1_pd(value);
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2) _mm_storeu_pd(dst + i, v);
+    fill_f64_scalar(dst + i, value, n - i);
+}
+
+static void add_f64_sse2(double *dst, const double *src, size_t n) {
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        _mm_storeu_pd(dst + i, _mm_add_pd(_mm_loadu_pd(dst + i), _mm_loadu_pd(src + i)));
+    }
+    add_f64_scalar(dst + i, src + i, n - i);
+}
+
+static void mul_f64_sse2(double *dst, const double *src, size_t n) {
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        _mm_storeu_pd(dst + i, _mm_mul_pd(_mm_loadu_pd(dst + i), _mm_loadu_pd(src + i)));
+    }
+    mul_f64_scalar(dst + i, src + i, n - i);
+}
+
+static void scale_f64_sse2(double *dst, double k, size_t n) {
+    __m128d vk = _mm_set1_pd(k);
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2) _mm_storeu_pd(dst + i, _mm_mul_pd(_mm_loadu_pd(dst + i), vk));
+    scale_f64_scalar(dst + i, k, n - i);
+}
+
+static void axpy_f64_sse2(double *dst, double k, const double *x, size_t n) {
+    __m128d vk = _mm_set1_pd(k);
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        __m128d product = _mm_mul_pd(vk, _mm_loadu_pd(x + i));
+        _mm_storeu_pd(dst + i, _mm_add_pd(_mm_loadu_pd(dst + i), product));
+    }
+    axpy_f64_scalar(dst + i, k, x + i, n - i);
+}
+
+// Suma horizontal, siempre en el mismo orden
+static double hsum_f64_sse2(__m128d v) {
+    double lanes[2];
+    _mm_storeu_pd(lanes, v);
+    return lanes[0] + lanes[1];
+}
+
+static double sum_f64_sse2(const double *src, size_t n) {
+    __m128d acc0 = _mm_setzero_pd(), acc1 = _mm_setzero_pd();
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        acc0 = _mm_add_pd(acc0, _mm_loadu_pd(src + i));
+        acc1 = _mm_add_pd(acc1, _mm_loadu_pd(src + i + 2));
+    }
+    return hsum_f64_sse2(_mm_add_pd(acc0, acc1)) + sum_f64_scalar(src + i, n - i);
+}
+
+static double min_f64_sse2(const double *src, size_t n) {
+    if (n < 2) return src[0];
+    __m128d m = _mm_loadu_pd(src);
+    size_t i = 2;
+    for (; i + 2 <= n; i += 2) m = _mm_min_pd(m, _mm_loadu_pd(src + i));
+    double lanes[2];
+    _mm_storeu_pd(lanes, m);
+    double result = lanes[0] < lanes[1] ? lanes[0] : lanes[1];
+    if (i < n && src[i] < result) result = src[i];
+    return result;
+}
+
+static double max_f64_sse2(const double *src, size_t n) {
+    if (n < 2) return src[0];
+    __m128d m = _mm_loadu_pd(src);
+    size_t i = 2;
+    for (; i + 2 <= n; i += 2) m = _mm_max_pd(m, _mm_loadu_pd(src + i));
+    double lanes[2];
+    _mm_storeu_pd(lanes, m);
+    double result = lanes[0] > lanes[1] ? lanes[0] : lanes[1];
+    if (i < n && src[i] > result) result = src[i];
+    return result;
+}
+
+static double dot_f64_sse2(const double *a, const double *b, size_t n) {
+    __m128d acc0 = _mm_setzero_pd(), acc1 = _mm_setzero_pd();
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        acc0 = _mm_add_pd(acc0, _mm_mul_pd(_mm_loadu_pd(a + i), _mm_loadu_pd(b + i)));
+        acc1 = _mm_add_pd(acc1, _mm_mul_pd(_mm_loadu_pd(a + i + 2), _mm_loadu_pd(b + i + 2)));
+    }
+    return hsum_f64_sse2(_mm_add_pd(acc0, acc1)) + dot_f64_scalar(a + i, b + i, n - i);
+}
+
+static void fill_i32_sse2(int32_t *dst, int32_t value, size_t n) {
+    __m128i v = _mm_set1_epi32(value);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) _mm_storeu_si128((__m128i*)(dst + i), v);
+    fill_i32_scalar(dst + i, value, n - i);
+}
+
+static void add_i32_sse2(int32_t *dst, const int32_t *src, size_t n) {
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128i a = _mm_loadu_si128((const __m128i*)(dst + i));
+        __m128i b = _mm_loadu_si128((const __m128i*)(src + i));
+        _mm_storeu_si128((__m128i*)(dst + i), _mm_add_epi32(a, b));
+    }
+    add_i32_scalar(dst + i, src + i, n - i);
+}
+
+// SSE2 no multiplica int32 ni tiene min/max de int32 (llegan con SSE4.1):
+// esos se quedan en la variante escalar
+static const SimdKernels sse2_kernels = {
+    SIMD_SSE2,
+    fill_f64_sse2, add_f64_sse2, mul_f64_sse2, scale_f64_sse2, axpy_f64_sse2,
+    sum_f64_sse2, min_f64_sse2, max_f64_sse2, dot_f64_sse2,
+    fill_i32_sse2, add_i32_sse2, mul_i32_scalar, scale_i32_scalar, axpy_i32_scalar,
+    sum_i32_scalar, min_i32_scalar, max_i32_scalar, dot_i32_scalar
+};
+
+// ---------------------------------------------------------------------------
+// AVX2: 4 doubles u 8 int32 por registro
+
+SIMD_TARGET_AVX2 static void fill_f64_avx2(double *dst, double value, size_t n) {
+    __m256d v = _mm256_set1_pd(value);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) _mm256_storeu_pd(dst + i, v);
+    fill_f64_scalar(dst + i, value, n - i);
+}
+
+SIMD_TARGET_AVX2 static void add_f64_avx2(double *dst, const double *src, size_t n) {
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        _mm256_storeu_pd(dst + i, _mm256_add_pd(_mm256_loadu_pd(dst + i), _mm256_loadu_pd(src + i)));
+    }
+    add_f64_scalar(dst + i, src + i, n - i);
+}
+
+SIMD_TARGET_AVX2 static void mul_f64_avx2(double *dst, const double *src, size_t n) {
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        _mm256_storeu_pd(dst + i, _mm256_mul_pd(_mm256_loadu_pd(dst + i), _mm256_loadu_pd(src + i)));
+    }
+    mul_f64_scalar(dst + i, src + i, n - i);
+}
+
+SIMD_TARGET_AVX2 static void scale_f64_avx2(double *dst, double k, size_t n) {
+    __m256d vk = _mm256_set1_pd(k);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) _mm256_storeu_pd(dst + i, _mm256_mul_pd(_mm256_loadu_pd(dst + i), vk));
+    scale_f64_scalar(dst + i, k, n - i);
+}
+
+SIMD_TARGET_AVX2 static void axpy_f64_avx2(double *dst, double k, const double *x, size_t n) {
+    __m256d vk = _mm256_set1_pd(k);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256d product = _mm256_mul_pd(vk, _mm256_loadu_pd(x + i));
+        _mm256_storeu_pd(dst + i, _mm256_add_pd(_mm256_loadu_pd(dst + i), product));
+    }
+    axpy_f64_scalar(dst + i, k, x + i, n - i);
+}
+
+SIMD_TARGET_AVX2 static double hsum_f64_avx2(__m256d v) {
+    double lanes[4];
+    _mm256_storeu_pd(lanes, v);
+    return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+}
+
+SIMD_TARGET_AVX2 static double sum_f64_avx2(const double *src, size_t n) {
+    __m256d acc0 = _mm256_setzero_pd(), acc1 = _mm256_setzero_pd();
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        acc0 = _mm256_add_pd(acc0, _mm256_loadu_pd(src + i));
+        acc1 = _mm256_add_pd(acc1, _mm256_loadu_pd(src + i + 4));
+    }
+    return hsum_f64_avx2(_mm256_add_pd(acc0, acc1)) + sum_f64_scalar(src + i, n - i);
+}
+
+SIMD_TARGET_AVX2 static double min_f64_avx2(const double *src, size_t n) {
+    if (n < 4) return min_f64_scalar(src, n);
+    __m256d m = _mm256_loadu_pd(src);
+    size_t i = 4;
+    for (; i + 4 <= n; i += 4) m = _mm256_min_pd(m, _mm256_loadu_pd(src + i));
+    double lanes[4];
+    _mm256_storeu_pd(lanes, m);
+    double result = min_f64_scalar(lanes, 4);
+    if (i < n) {
+        double tail = min_f64_scalar(src + i, n - i);
+        if (tail < result) result = tail;
+    }
+    return result;
+}
+
+SIMD_TARGET_AVX2 static double max_f64_avx2(const double *src, size_t n) {
+    if (n < 4) return max_f64_scalar(src, n);
+    __m256d m = _mm256_loadu_pd(src);
+    size_t i = 4;
+    for (; i + 4 <= n; i += 4) m = _mm256_max_pd(m, _mm256_loadu_pd(src + i));
+    double lanes[4];
+    _mm256_storeu_pd(lanes, m);
+    double result = max_f64_scalar(lanes, 4);
+    if (i < n) {
+        double tail = max_f64_scalar(src + i, n - i);
+        if (tail > result) result = tail;
+    }
+    return result;
+}
+
+SIMD_TARGET_AVX2 static double dot_f64_avx2(const double *a, const double *b, size_t n) {
+    __m256d acc0 = _mm256_setzero_pd(), acc1 = _mm256_setzero_pd();
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        acc0 = _mm256_add_pd(acc0, _mm256_mul_pd(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i)));
+        acc1 = _mm256_add_pd(acc1, _mm256_mul_pd(_mm256_loadu_pd(a + i + 4), _mm256_loadu_pd(b + i + 4)));
+    }
+    return hsum_f64_avx2(_mm256_add_pd(acc0, acc1)) + dot_f64_scalar(a + i, b + i, n - i);
+}
+
+SIMD_TARGET_AVX2 static void fill_i32_avx2(int32_t *dst, int32_t value, size_t n) {
+    __m256i v = _mm256_set1_epi32(value);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) _mm256_storeu_si256((__m256i*)(dst + i), v);
+    fill_i32_scalar(dst + i, value, n - i);
+}
+
+SIMD_TARGET_AVX2 static void add_i32_avx2(int32_t *dst, const int32_t *src, size_t n) {
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i a = _mm256_loadu_si256((const __m256i*)(dst + i));
+        __m256i b = _mm256_loadu_si256((const __m256i*)(src + i));
+        _mm256_storeu_si256((__m256i*)(dst + i), _mm256_add_epi32(a, b));
+    }
+    add_i32_scalar(dst + i, src + i, n - i);
+}
+
+SIMD_TARGET_AVX2 static void mul_i32_avx2(int32_t *dst, const int32_t *src, size_t n) {
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i a = _mm256_loadu_si256((const __m256i*)(dst + i));
+        __m256i b = _mm256_loadu_si256((const __m256i*)(src + i));
+        _mm256_storeu_si256((__m256i*)(dst + i), _mm256_mullo_epi32(a, b));
+    }
+    mul_i32_scalar(dst + i, src + i, n - i);
+}
+
+SIMD_TARGET_AVX2 static void scale_i32_avx2(int32_t *dst, int32_t k, size_t n) {
+    __m256i vk = _mm256_set1_epi32(k);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i a = _mm256_loadu_si256((const __m256i*)(dst + i));
+        _mm256_storeu_si256((__m256i*)(dst + i), _mm256_mullo_epi32(a, vk));
+    }
+    scale_i32_scalar(dst + i, k, n - i);
+}
+
+SIMD_TARGET_AVX2 static void axpy_i32_avx2(int32_t *dst, int32_t k, const int32_t *x, size_t n) {
+    __m256i vk = _mm256_set1_epi32(k);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i product = _mm256_mullo_epi32(vk, _mm256_loadu_si256((const __m256i*)(x + i)));
+        __m256i a = _mm256_loadu_si256((const __m256i*)(dst + i));
+        _mm256_storeu_si256((__m256i*)(dst + i), _mm256_add_epi32(a, product));
+    }
+    axpy_i32_scalar(dst + i, k, x + i, n - i);
+}
+
+SIMD_TARGET_AVX2 static int64_t hsum_i64_avx2(__m256i v) {
+    int64_t lanes[4];
+    _mm256_storeu_si256((__m256i*)lanes, v);
+    return (int64_t)((uint64_t)lanes[0] + (uint64_t)lanes[1] + (uint64_t)lanes[2] + (uint64_t)lanes[3]);
+}
+
+// Suma en int64: cada mitad de 4 int32 se extiende con signo antes de sumar
+SIMD_TARGET_AVX2 static int64_t sum_i32_avx2(const int32_t *src, size_t n) {
+    __m256i acc = _mm256_setzero_si256();
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m128i lo = _mm_loadu_si128((const __m128i*)(src + i));
+        __m128i hi = _mm_loadu_si128((const __m128i*)(src + i + 4));
+        acc = _mm256_add_epi64(acc, _mm256_cvtepi32_epi64(lo));
+        acc = _mm256_add_epi64(acc, _mm256_cvtepi32_epi64(hi));
+    }
+    return (int64_t)((uint64_t)hsum_i64_avx2(acc) + (uint64_t)sum_i32_scalar(src + i, n - i));
+}
+
+SIMD_TARGET_AVX2 static int32_t min_i32_avx2(const int32_t *src, size_t n) {
+    if (n < 8) return min_i32_scalar(src, n);
+    __m256i m = _mm256_loadu_si256((const __m256i*)src);
+    size_t i = 8;
+    for (; i + 8 <= n; i += 8) m = _mm256_min_epi32(m, _mm256_loadu_si256((const __m256i*)(src + i)));
+    int32_t lanes[8];
+    _mm256_storeu_si256((__m256i*)lanes, m);
+    int32_t result = min_i32_scalar(lanes, 8);
+    if (i < n) {
+        int32_t tail = min_i32_scalar(src + i, n - i);
+        if (tail < result) result = tail;
+    }
+    return result;
+}
+
+SIMD_TARGET_AVX2 static int32_t max_i32_avx2(const int32_t *src, size_t n) {
+    if (n < 8) return max_i32_scalar(src, n);
+    __m256i m = _mm256_loadu_si256((const __m256i*)src);
+    size_t i = 8;
+    for (; i + 8 <= n; i += 8) m = _mm256_max_epi32(m, _mm256_loadu_si256((const __m256i*)(src + i)));
+    int32_t lanes[8];
+    _mm256_storeu_si256((__m256i*)lanes, m);
+    int32_t result = max_i32_scalar(lanes, 8);
+    if (i < n) {
+        int32_t tail = max_i32_scalar(src + i, n - i);
+        if (tail > result) result = tail;
+    }
+    return result;
+}
+
+// Productos exactos en int64: _mm256_mul_epi32 multiplica los 32 bits bajos
+// de cada carril de 64, así que se extienden primero
+SIMD_TARGET_AVX2 static int64_t dot_i32_avx2(const int32_t *a, const int32_t *b, size_t n) {
+    __m256i acc = _mm256_setzero_si256();
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256i va = _mm256_cvtepi32_epi64(_mm_loadu_si128((const __m128i*)(a + i)));
+        __m256i vb = _mm256_cvtepi32_epi64(_mm_loadu_si128((const __m128i*)(b + i)));
+        acc = _mm256_add_epi64(acc, _mm256_mul_epi32(va, vb));
+    }
+    return (int64_t)((uint64_t)hsum_i64_avx2(acc) + (uint64_t)dot_i32_scalar(a + i, b + i, n - i));
+}
+
+static const SimdKernels avx2_kernels = {
+    SIMD_AVX2,
+    fill_f64_avx2, add_f64_avx2, mul_f64_avx2, scale_f64_avx2, axpy_f64_avx2,
+    sum_f64_avx2, min_f64_avx2, max_f64_avx2, dot_f64_avx2,
+    fill_i32_avx2, add_i32_avx2, mul_i32_avx2, scale_i32_avx2, axpy_i32_avx2,
+    sum_i32_avx2, min_i32_avx2, max_i32_avx2, dot_i32_avx2
+};
+
+// AVX2 necesita el bit de CPUID y que el sistema guarde los registros YMM en
+// los cambios de contexto (OSXSAVE y XCR0)
+static int cpu_has_avx2(void) {
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) return 0;
+    __cpuid(info, 1);
+    if (!(info[2] & (1 << 27)) || !(info[2] & (1 << 28))) return 0;
+    if ((_xgetbv(0) & 6) != 6) return 0;
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    unsigned int eax, ebx, ecx, edx;
+    if (__get_cpuid_max(0, NULL) < 7) return 0;
+    __cpuid(1, eax, ebx, ecx, edx);
+    if (!(ecx & (1u << 27)) || !(ecx & (1u << 28))) return 0;  // OSXSAVE, AVX
+    unsigned int xcr0_low, xcr0_high;
+    __asm__ volatile ("xgetbv" : "=a"(xcr0_low), "=d"(xcr0_high) : "c"(0));
+    (void)xcr0_high;
+    if ((xcr0_low & 6) != 6) return 0;  // Estado XMM e YMM
+    __cpuid_count(7, 0, eax, ebx, ecx, edx);
+    return (ebx & (1u << 5)) != 0;
+#endif
+}
+
+#endif  // SIMD_X86
+
+const SimdKernels *simd_kernels_for(SimdLevel level) {
+    switch (level) {
+        case SIMD_SCALAR:
+            return &scalar_kernels;
+#ifdef SIMD_X86
+        case SIMD_SSE2:
+            return &sse2_kernels;
+        case SIMD_AVX2:
+            return cpu_has_avx2() ? &avx2_kernels : NULL;
+#endif
+        default:
+            return NULL;
+    }
+}
+
+// Se elige una vez. Si dos hilos llegan a la vez, ambos escriben lo mismo.
+const SimdKernels *simd_kernels(void) {
+    static const SimdKernels *selected = NULL;
+    if (!selected) {
+        const SimdKernels *best = simd_kernels_for(SIMD_AVX2);
+        if (!best) best = simd_kernels_for(SIMD_SSE2);
+        selected = best ? best : &scalar_kernels;
+    }
+    return selected;
+}
+
+const char *simd_level_name(SimdLevel level) {
+    switch (level) {
+        case SIMD_AVX2: return "avx2";
+        case SIMD_SSE2: return "sse2";
+        default: return "escalar";
+    }
+}
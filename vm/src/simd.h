@@ -0,0 +1,58 @@
+#ifndef SIMD_H
+#define SIMD_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Núcleos para las operaciones sobre arrays completos (fill, add, mul, scale,
+// axpy, sum, min, max, dot) de double e int32. La primera llamada a
+// simd_kernels() elige, según CPUID, la mejor variante que admite la CPU:
+// AVX2, SSE2 (siempre presente en x86-64) o la escalar. Los de int32 no
+// tienen variante SSE2: sin AVX2 usan la escalar.
+//
+// Las operaciones elemento a elemento dan el mismo resultado en todas las
+// variantes (no se usa FMA). sum y dot de double acumulan por carriles, así
+// que pueden diferir en el último bit de una suma secuencial. Con int32 los
+// resultados de add, mul, scale y axpy se truncan a 32 bits, como al guardar
+// en el array; sum y dot se acumulan en int64.
+
+typedef enum {
+    SIMD_SCALAR,
+    SIMD_SSE2,
+    SIMD_AVX2
+} SimdLevel;
+
+typedef struct {
+    SimdLevel level;
+
+    void (*fill_f64)(double *dst, double value, size_t n);
+    void (*add_f64)(double *dst, const double *src, size_t n);   // dst += src
+    void (*mul_f64)(double *dst, const double *src, size_t n);   // dst *= src
+    void (*scale_f64)(double *dst, double k, size_t n);          // dst *= k
+    void (*axpy_f64)(double *dst, double k, const double *x, size_t n);  // dst += k * x
+    double (*sum_f64)(const double *src, size_t n);
+    double (*min_f64)(const double *src, size_t n);  // n > 0
+    double (*max_f64)(const double *src, size_t n);  // n > 0
+    double (*dot_f64)(const double *a, const double *b, size_t n);
+
+    void (*fill_i32)(int32_t *dst, int32_t value, size_t n);
+    void (*add_i32)(int32_t *dst, const int32_t *src, size_t n);
+    void (*mul_i32)(int32_t *dst, const int32_t *src, size_t n);
+    void (*scale_i32)(int32_t *dst, int32_t k, size_t n);
+    void (*axpy_i32)(int32_t *dst, int32_t k, const int32_t *x, size_t n);
+    int64_t (*sum_i32)(const int32_t *src, size_t n);
+    int32_t (*min_i32)(const int32_t *src, size_t n);  // n > 0
+    int32_t (*max_i32)(const int32_t *src, size_t n);  // n > 0
+    int64_t (*dot_i32)(const int32_t *a, const int32_t *b, size_t n);
+} SimdKernels;
+
+// Núcleos de la mejor variante disponible
+const SimdKernels *simd_kernels(void);
+
+// Núcleos de una variante concreta, o NULL si la CPU no la admite (para
+// comparar variantes en bench/simd.c)
+const SimdKernels *simd_kernels_for(SimdLevel level);
+
+const char *simd_level_name(SimdLevel level);
+
+#endif
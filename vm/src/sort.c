@@ -0,0 +1,367 @@
+#include <stdlib.h>
+#include <string.h>
+#include "sort.h"
+#include "parallel.h"
+
+// Tramos cortos: inserción (también el final del introsort)
+#define INSERTION_MAX 24
+
+typedef enum {
+    SORT_I32,
+    SORT_I64,
+    SORT_F64
+} SortType;
+
+// Lo que no depende del algoritmo, por tipo de elemento: inserción, mezcla de
+// un trozo de dos tramos ordenados, inversión y unique. La mezcla es estable
+// (con empate va primero el tramo izquierdo) y solo usa '<', así que la
+// bisección de corank y el bucle de merge eligen igual.
+#define SORT_HELPERS(S, T)                                                             \
+    static void insertion_##S(T *data, size_t n) {                                     \
+        for (size_t i = 1; i < n; i++) {                                               \
+            T value = data[i];                                                         \
+            size_t j = i;                                                              \
+            while (j > 0 && value < data[j - 1]) {                                     \
+                data[j] = data[j - 1];                                                 \
+                j--;                                                                   \
+            }                                                                          \
+            data[j] = value;                                                           \
+        }                                                                              \
+    }                                                                                  \
+                                                                                       \
+    /* Cuántos elementos de x hay entre los k primeros de la mezcla de x e y */        \
+    static size_t corank_##S(size_t k, const T *x, size_t lx, const T *y, size_t ly) { \
+        size_t lo = k > ly ? k - ly : 0;                                               \
+        size_t hi = k < lx ? k : lx;                                                   \
+        while (lo < hi) {                                                              \
+            size_t i = lo + (hi - lo) / 2;                                             \
+            if (!(y[k - i - 1] < x[i])) lo = i + 1;                                    \
+            else hi = i;                                                               \
+        }                                                                              \
+        return lo;                                                                     \
+    }                                                                                  \
+                                                                                       \
+    /* Salidas [k0, k1) de la mezcla de src[a, m) y src[m, b) en dst + a */            \
+    static void merge_##S(const T *src, T *dst, size_t a, size_t m, size_t b,          \
+                          size_t k0, size_t k1) {                                      \
+        const T *x = src + a, *y = src + m;                                            \
+        size_t lx = m - a, ly = b - m;                                                 \
+        size_t i = corank_##S(k0, x, lx, y, ly), j = k0 - i;                           \
+        size_t i_end = corank_##S(k1, x, lx, y, ly), j_end = k1 - i_end;               \
+        T *out = dst + a + k0;                                                         \
+        while (i < i_end && j < j_end) *out++ = y[j] < x[i] ? y[j++] : x[i++];         \
+        while (i < i_end) *out++ = x[i++];                                             \
+        while (j < j_end) *out++ = y[j++];                                             \
+    }                                                                                  \
+                                                                                       \
+    static void reverse_##S(T *data, size_t n) {                                       \
+        for (size_t i = 0, j = n; i + 1 < j; i++, j--) {                               \
+            T t = data[i];                                                             \
+            data[i] = data[j - 1];                                                     \
+            data[j - 1] = t;                                                           \
+        }                                                                              \
+    }                                                                                  \
+                                                                                       \
+    size_t unique_##S(T *data, size_t n) {                                             \
+        size_t k = 0;                                                                  \
+        for (size_t i = 0; i < n; i++) {                                               \
+            if (k == 0 || data[i] != data[k - 1]) data[k++] = data[i];                 \
+        }                                                                              \
+        return k;                                                                      \
+    }
+
+SORT_HELPERS(i32, int32_t)
+SORT_HELPERS(i64, int64_t)
+SORT_HELPERS(f64, double)
+
+// Radix LSD sobre la clave sin signo con el bit de signo invertido, que
+// ordena igual que el entero. Una sola lectura cuenta los dígitos de todas
+// las pasadas; 'tmp' tiene sitio para n elementos.
+static void radix_i32(int32_t *data, int32_t *tmp, size_t n) {
+    size_t count[4][256];
+    memset(count, 0, sizeof(count));
+    for (size_t i = 0; i < n; i++) {
+        uint32_t key = (uint32_t)data[i] ^ 0x80000000u;
+        for (int pass = 0; pass < 4; pass++) count[pass][(key >> (pass * 8)) & 0xFF]++;
+    }
+
+    int32_t *src = data, *dst = tmp;
+    for (int pass = 0; pass < 4; pass++) {
+        int shift = pass * 8;
+        size_t *offset = count[pass];
+        if (offset[(((uint32_t)src[0] ^ 0x80000000u) >> shift) & 0xFF] == n) continue;
+        size_t total = 0;
+        for (int d = 0; d < 256; d++) {
+            size_t c = offset[d];
+            offset[d] = total;
+            total += c;
+        }
+        for (size_t i = 0; i < n; i++) {
+            uint32_t key = (uint32_t)src[i] ^ 0x80000000u;
+            dst[offset[(key >> shift) & 0xFF]++] = src[i];
+        }
+        int32_t *t = src;
+        src = dst;
+        dst = t;
+    }
+    if (src != data) memcpy(data, src, n * sizeof(int32_t));
+}
+
+static void radix_i64(int64_t *data, int64_t *tmp, size_t n) {
+    size_t count[8][256];
+    memset(count, 0, sizeof(count));
+    for (size_t i = 0; i < n; i++) {
+        uint64_t key = (uint64_t)data[i] ^ 0x8000000000000000ull;
+        for (int pass = 0; pass < 8; pass++) count[pass][(key >> (pass * 8)) & 0xFF]++;
+    }
+
+    int64_t *src = data, *dst = tmp;
+    for (int pass = 0; pass < 8; pass++) {
+        int shift = pass * 8;
+        size_t *offset = count[pass];
+        if (offset[(((uint64_t)src[0] ^ 0x8000000000000000ull) >> shift) & 0xFF] == n) continue;
+        size_t total = 0;
+        for (int d = 0; d < 256; d++) {
+            size_t c = offset[d];
+            offset[d] = total;
+            total += c;
+        }
+        for (size_t i = 0; i < n; i++) {
+            uint64_t key = (uint64_t)src[i] ^ 0x8000000000000000ull;
+            dst[offset[(key >> shift) & 0xFF]++] = src[i];
+        }
+        int64_t *t = src;
+        src = dst;
+        dst = t;
+    }
+    if (src != data) memcpy(data, src, n * sizeof(int64_t));
+}
+
+static void sift_down_f64(double *data, size_t root, size_t n) {
+    double value = data[root];
+    for (;;) {
+        size_t child = 2 * root + 1;
+        if (child >= n) break;
+        if (child + 1 < n && data[child] < data[child + 1]) child++;
+        if (!(value < data[child])) break;
+        data[root] = data[child];
+        root = child;
+    }
+    data[root] = value;
+}
+
+static void heapsort_f64(double *data, size_t n) {
+    for (size_t start = n / 2; start-- > 0;) sift_down_f64(data, start, n);
+    for (size_t end = n; end-- > 1;) {
+        double t = data[0];
+        data[0] = data[end];
+        data[end] = t;
+        sift_down_f64(data, 0, end);
+    }
+}
+
+// Quicksort con pivote mediana de tres y partición de Hoare; tras 'depth'
+// particiones malas pasa a heapsort, así que el peor caso es O(n log n).
+// Sin NaN: se apartan antes.
+static void introsort_f64(double *data, size_t n, int depth) {
+    while (n > INSERTION_MAX) {
+        if (depth-- == 0) {
+            heapsort_f64(data, n);
+            return;
+        }
+        size_t mid = n / 2;
+        double t;
+        if (data[mid] < data[0]) { t = data[mid]; data[mid] = data[0]; data[0] = t; }
+        if (data[n - 1] < data[0]) { t = data[n - 1]; data[n - 1] = data[0]; data[0] = t; }
+        if (data[n - 1] < data[mid]) { t = data[n - 1]; data[n - 1] = data[mid]; data[mid] = t; }
+        double pivot = data[mid];
+
+        // Al acabar, [0, j] <= pivote <= (j, n), y los dos lados tienen algo
+        size_t i = 0, j = n - 1;
+        for (;;) {
+            while (data[i] < pivot) i++;
+            while (pivot < data[j]) j--;
+            if (i >= j) break;
+            t = data[i];
+            data[i++] = data[j];
+            data[j--] = t;
+        }
+        size_t left = j + 1;
+        if (left < n - left) {
+            introsort_f64(data, left, depth);
+            data += left;
+            n -= left;
+        } else {
+            introsort_f64(data + left, n - left, depth);
+            n = left;
+        }
+    }
+    insertion_f64(data, n);
+}
+
+static int depth_limit(size_t n) {
+    int depth = 0;
+    while (n > 1) {
+        n >>= 1;
+        depth += 2;
+    }
+    return depth;
+}
+
+// Un tramo en un solo hilo, con 'tmp' (n elementos) para el radix
+static void sort_run(SortType type, void *data, void *tmp, size_t n) {
+    switch (type) {
+        case SORT_I32:
+            if (n <= INSERTION_MAX) insertion_i32((int32_t*)data, n);
+            else radix_i32((int32_t*)data, (int32_t*)tmp, n);
+            break;
+        case SORT_I64:
+            if (n <= INSERTION_MAX) insertion_i64((int64_t*)data, n);
+            else radix_i64((int64_t*)data, (int64_t*)tmp, n);
+            break;
+        case SORT_F64:
+            introsort_f64((double*)data, n, depth_limit(n));
+            break;
+    }
+}
+
+typedef struct {
+    SortType type;
+    size_t element;         // Bytes por elemento
+    size_t n;
+    int chunks;             // Tramos: uno por hilo
+    uint8_t *data;
+    uint8_t *tmp;
+
+    // Pasada de mezcla en curso: parejas de grupos de 'width' tramos de src
+    // a dst, cada pareja en 'pieces' trozos de la salida
+    const uint8_t *src;
+    uint8_t *dst;
+    int width;
+    int pieces;
+} SortJob;
+
+static size_t chunk_start(const SortJob *job, int chunk) {
+    return job->n * (size_t)chunk / (size_t)job->chunks;
+}
+
+static void sort_chunks(void *context, int worker, int64_t first, int64_t last) {
+    SortJob *job = (SortJob*)context;
+    (void)worker;
+    for (int64_t c = first; c < last; c++) {
+        size_t lo = chunk_start(job, (int)c), hi = chunk_start(job, (int)c + 1);
+        sort_run(job->type, job->data + lo * job->element, job->tmp + lo * job->element, hi - lo);
+    }
+}
+
+static void merge_pieces(void *context, int worker, int64_t first, int64_t last) {
+    SortJob *job = (SortJob*)context;
+    (void)worker;
+    for (int64_t t = first; t < last; t++) {
+        int pair = (int)(t / job->pieces), piece = (int)(t % job->pieces);
+        int c0 = pair * 2 * job->width;
+        int cm = c0 + job->width < job->chunks ? c0 + job->width : job->chunks;
+        int c1 = c0 + 2 * job->width < job->chunks ? c0 + 2 * job->width : job->chunks;
+        size_t a = chunk_start(job, c0), m = chunk_start(job, cm), b = chunk_start(job, c1);
+        size_t k0 = (b - a) * (size_t)piece / (size_t)job->pieces;
+        size_t k1 = (b - a) * (size_t)(piece + 1) / (size_t)job->pieces;
+        switch (job->type) {
+            case SORT_I32: merge_i32((const int32_t*)job->src, (int32_t*)job->dst, a, m, b, k0, k1); break;
+            case SORT_I64: merge_i64((const int64_t*)job->src, (int64_t*)job->dst, a, m, b, k0, k1); break;
+            case SORT_F64: merge_f64((const double*)job->src, (double*)job->dst, a, m, b, k0, k1); break;
+        }
+    }
+}
+
+// Copia de vuelta a data cuando la última mezcla acabó en tmp
+static void copy_chunks(void *context, int worker, int64_t first, int64_t last) {
+    SortJob *job = (SortJob*)context;
+    (void)worker;
+    size_t lo = chunk_start(job, (int)first), hi = chunk_start(job, (int)last);
+    memcpy(job->data + lo * job->element, job->tmp + lo * job->element, (hi - lo) * job->element);
+}
+
+static int sort_array(SortType type, void *data, size_t n, size_t element, int threads) {
+    if (n <= INSERTION_MAX && type != SORT_F64) {
+        sort_run(type, data, NULL, n);
+        return 0;
+    }
+    SortJob job;
+    memset(&job, 0, sizeof(job));
+    job.type = type;
+    job.element = element;
+    job.n = n;
+    job.data = (uint8_t*)data;
+    // El radix necesita el buffer siempre; el introsort, solo para mezclar
+    int needs_tmp = type != SORT_F64 || n >= SORT_PARALLEL_MIN;
+    job.tmp = needs_tmp ? (uint8_t*)malloc(n * element) : NULL;
+    if (needs_tmp && !job.tmp) return -1;
+
+    ParallelPool *pool = n >= SORT_PARALLEL_MIN ? parallel_create(threads) : NULL;
+    job.chunks = pool ? parallel_thread_count(pool) : 1;
+    if (job.chunks == 1) {
+        sort_run(type, data, job.tmp, n);
+    } else {
+        parallel_run(pool, 0, job.chunks, sort_chunks, &job);
+        uint8_t *src = job.data, *dst = job.tmp;
+        for (job.width = 1; job.width < job.chunks; job.width *= 2) {
+            int pairs = (job.chunks + 2 * job.width - 1) / (2 * job.width);
+            job.pieces = (job.chunks + pairs - 1) / pairs;
+            job.src = src;
+            job.dst = dst;
+            parallel_run(pool, 0, (int64_t)pairs * job.pieces, merge_pieces, &job);
+            uint8_t *t = src;
+            src = dst;
+            dst = t;
+        }
+        if (src != job.data) parallel_run(pool, 0, job.chunks, copy_chunks, &job);
+    }
+    parallel_free(pool);
+    free(job.tmp);
+    return 0;
+}
+
+int sort_i32(int32_t *data, size_t n, int descending, int threads) {
+    if (sort_array(SORT_I32, data, n, sizeof(int32_t), threads) != 0) return -1;
+    if (descending) reverse_i32(data, n);
+    return 0;
+}
+
+int sort_i64(int64_t *data, size_t n, int descending, int threads) {
+    if (sort_array(SORT_I64, data, n, sizeof(int64_t), threads) != 0) return -1;
+    if (descending) reverse_i64(data, n);
+    return 0;
+}
+
+int sort_f64(double *data, size_t n, int descending, int threads) {
+    // Los NaN no se ordenan con '<': al final, y el resto se ordena aparte
+    size_t numbers = 0;
+    for (size_t i = 0; i < n; i++) {
+        if (data[i] == data[i]) {
+            double t = data[numbers];
+            data[numbers++] = data[i];
+            data[i] = t;
+        }
+    }
+    if (sort_array(SORT_F64, data, numbers, sizeof(double), threads) != 0) return -1;
+    if (descending) reverse_f64(data, numbers);
+    return 0;
+}
+
+void sort_u8(uint8_t *data, size_t n, int descending) {
+    size_t count[256] = {0};
+    for (size_t i = 0; i < n; i++) count[data[i]]++;
+    for (int k = 0; k < 256; k++) {
+        int value = descending ? 255 - k : k;
+        memset(data, value, count[value]);
+        data += count[value];
+    }
+}
+
+size_t unique_u8(uint8_t *data, size_t n) {
+    size_t k = 0;
+    for (size_t i = 0; i < n; i++) {
+        if (k == 0 || data[i] != data[k - 1]) data[k++] = data[i];
+    }
+    return k;
+}
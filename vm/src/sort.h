@@ -0,0 +1,35 @@
+#ifndef SORT_H
+#define SORT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Ordenación de los arrays (sort, sort_desc) y unique. Los enteros se ordenan
+// con radix sort LSD de 8 bits por pasada (se salta la pasada de un dígito
+// que comparten todos); los double con introsort. Desde SORT_PARALLEL_MIN
+// elementos el array se parte en un tramo por hilo, cada hilo ordena el suyo
+// y los tramos se mezclan por parejas; cada mezcla se reparte también entre
+// los hilos (se busca por bisección dónde empieza cada trozo de la salida),
+// así que todas las pasadas usan todos los hilos.
+//
+// 'threads' es el número de hilos (<= 0 = los núcleos disponibles). Los NaN
+// van al final en los dos sentidos. Devuelven 0, o -1 si no hay memoria para
+// el buffer auxiliar (el array queda intacto).
+
+#define SORT_PARALLEL_MIN (1 << 18)
+
+int sort_i32(int32_t *data, size_t n, int descending, int threads);
+int sort_i64(int64_t *data, size_t n, int descending, int threads);
+int sort_f64(double *data, size_t n, int descending, int threads);
+
+// Counting sort: no necesita memoria ni hilos
+void sort_u8(uint8_t *data, size_t n, int descending);
+
+// Quita los repetidos consecutivos (todos, si el array está ordenado) y
+// devuelve cuántos elementos quedan al principio de 'data'
+size_t unique_i32(int32_t *data, size_t n);
+size_t unique_i64(int64_t *data, size_t n);
+size_t unique_f64(double *data, size_t n);
+size_t unique_u8(uint8_t *data, size_t n);
+
+#endif
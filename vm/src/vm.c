@@ -1,7 +1,11 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <math.h>
 #include "vm.h"
+#include "runtime.h"
+#include "jit.h"
+#include "parallel.h"
 #include "utils.h"
 
 #include <GLFW/glfw3.h>
@@ -15,17 +19,6 @@
     #define PLATFORM "linux"
 #endif
 
-#define OPCODE_PRINT 0x01
-#define OPCODE_PRINTLN 0x08
-#define OPCODE_PRINTCHR 0x09
-#define OPCODE_GET_GLOBAL 0x0A
-#define OPCODE_RETURN 0xFF
-#define OPCODE_ARRAY_SET 0x0C
-#define OPCODE_ARRAY_GET 0x0D
-#define OPCODE_ARRAY_NEW 0x0E
-#define OPCODE_ARRAY_LEN 0x0F
-#define OPCODE_ARRAY_CLEAR 0x10
-
 // Función para resolver el renderer automático según la plataforma
 static void resolve_renderer(char *renderer) {
     if (strcmp(renderer, "auto") != 0) {
@@ -72,558 +65,1038 @@ static GLFWwindow* init_opengl_window(const WindowConfig *config) {
     return window;
 }
 
-int execute_bytecode(const char *bytecode_file, int debug, const char *override_renderer) {
-    FILE *file = fopen(bytecode_file, "rb");
-    if (!file) {
-        fprintf(stderr, "Error: No se puede abrir '%s'\n", bytecode_file);
-        return EXIT_FAILURE;
+// Sustituye la instrucción en curso por su variante especializada
+static void quicken(VMState *vm, uint8_t opcode, uint8_t arg1) {
+    if (!vm->quicken) return;
+    vm->instructions[vm->pc].opcode = opcode;
+    vm->instructions[vm->pc].arg1 = arg1;
+}
+
+// Vuelve al opcode genérico cuando no se cumple lo que supuso el quickening;
+// vm_step no avanza el PC y la instrucción se repite
+static void dequicken(VMState *vm, uint8_t opcode) {
+    vm->instructions[vm->pc].opcode = opcode;
+}
+
+// Variante de un ARRAY_GET/ARRAY_SET genérico según el tipo de array. Los
+// arrays estáticos no cambian de índice en vm->arrays y lo llevan en arg1.
+static void quicken_array_access(VMState *vm, Instruction current, int array_index) {
+    int is_get = current.opcode == OPCODE_ARRAY_GET || current.opcode == OPCODE_ARRAY_GET_I64;
+    int int_index = current.opcode == OPCODE_ARRAY_GET_I64 || current.opcode == OPCODE_ARRAY_SET_I64;
+    uint8_t base = is_get ? OPCODE_ARRAY_GET_STATIC : OPCODE_ARRAY_SET_STATIC;
+
+    if (vm->variables[current.arg1].type == 'a' && array_index <= 0xFF) {
+        quicken(vm, base + int_index, (uint8_t)array_index);
+    } else if (vm->variables[current.arg1].type == 'b') {
+        quicken(vm, base + 2 + int_index, current.arg1);
     }
+}
 
-    // Leer header
-    char header[4];
-    if (fread(header, 1, 4, file) != 4) {
-        fprintf(stderr, "Error: No se puede leer header del bytecode\n");
-        fclose(file);
-        return EXIT_FAILURE;
+// Lo mismo para ARRAY_GET_INT / ARRAY_SET_INT
+static void quicken_int_array_access(VMState *vm, Instruction current, int array_index) {
+    int is_get = current.opcode == OPCODE_ARRAY_GET_INT;
+
+    if (vm->variables[current.arg1].type == 'a' && array_index <= 0xFF) {
+        quicken(vm, is_get ? OPCODE_ARRAY_GET_INT_STATIC : OPCODE_ARRAY_SET_INT_STATIC, (uint8_t)array_index);
+    } else if (vm->variables[current.arg1].type == 'b') {
+        quicken(vm, is_get ? OPCODE_ARRAY_GET_INT_DYNAMIC : OPCODE_ARRAY_SET_INT_DYNAMIC, current.arg1);
     }
-    
-    if (strncmp(header, "GOLD", 4) != 0) {
-        fprintf(stderr, "Error: Bytecode inválido (header incorrecto)\n");
-        fclose(file);
-        return EXIT_FAILURE;
+}
+
+// Índice del tope (o del segundo) como int64 u double truncado
+static int64_t stack_index(const Value *slot, int int_index) {
+    return int_index ? slot->i : (int64_t)slot->f;
+}
+
+static void array_load(VMState *vm, int array_index, int int_index, int debug) {
+    if (array_index < 0 || vm->sp < 1) return;
+    Value *top = &vm->stack[vm->sp - 1];
+    int64_t index = stack_index(top, int_index);
+    top->f = vm_array_get_f64(&vm->arrays[array_index], index);
+    if (debug) fprintf(stderr, "[VM] ARRAY_GET array %d[%lld] = %f\n", array_index, (long long)index, top->f);
+}
+
+static void array_store(VMState *vm, int array_index, int int_index, int debug) {
+    if (array_index < 0 || vm->sp < 2) return;
+    int64_t index = stack_index(&vm->stack[vm->sp - 2], int_index);
+    double value = vm->stack[vm->sp - 1].f;
+    Array *arr = &vm->arrays[array_index];
+    if (arr->type == 'z' && vm->parallel_worker) {
+        vm_array_set_bit_atomic(arr, index, (int64_t)value != 0);
+    } else {
+        vm_array_set_f64(arr, index, value);
     }
+    if (debug) fprintf(stderr, "[VM] ARRAY_SET array %d[%lld] = %f\n", array_index, (long long)index, value);
+    vm->sp -= 2;  // Pop index y value
+}
 
-    // Leer versión
-    uint8_t version;
-    if (fread(&version, 1, 1, file) != 1) {
-        fprintf(stderr, "Error: No se puede leer versión del bytecode\n");
-        fclose(file);
-        return EXIT_FAILURE;
+static void int_array_load(VMState *vm, int array_index, int debug) {
+    if (array_index < 0 || vm->sp < 1) return;
+    Value *top = &vm->stack[vm->sp - 1];
+    int64_t index = top->i;
+    top->i = vm_array_get_int(&vm->arrays[array_index], index);
+    if (debug) fprintf(stderr, "[VM] ARRAY_GET_INT array %d[%lld] = %lld\n", array_index, (long long)index, (long long)top->i);
+}
+
+static void int_array_store(VMState *vm, int array_index, int debug) {
+    if (array_index < 0 || vm->sp < 2) return;
+    int64_t index = vm->stack[vm->sp - 2].i;
+    int64_t value = vm->stack[vm->sp - 1].i;
+    Array *arr = &vm->arrays[array_index];
+    if (arr->type == 'z' && vm->parallel_worker) {
+        vm_array_set_bit_atomic(arr, index, value != 0);
+    } else {
+        vm_array_set_int(arr, index, value);
     }
-    
-    if (debug) printf("[VM] Bytecode version: %d\n", version);
+    if (debug) fprintf(stderr, "[VM] ARRAY_SET_INT array %d[%lld] = %lld\n", array_index, (long long)index, (long long)value);
+    vm->sp -= 2;
+}
 
-    // Leer configuración de ventana
-    WindowConfig window_config = {0};
-    strcpy(window_config.window_title, "Golden Application");
-    window_config.window_width = 800;
-    window_config.window_height = 600;
-    window_config.window_resizable = 0;
-    strcpy(window_config.window_mode, "windowed");
-    strcpy(window_config.renderer, "auto");
-    
-    uint8_t window_title_len = 0;
-    if (fread(&window_title_len, 1, 1, file) != 1) {
-        fprintf(stderr, "Error: No se puede leer longitud del título de ventana\n");
-        fclose(file);
-        return EXIT_FAILURE;
+static void println_number(VMState *vm, int debug) {
+    double val = vm->stack[--vm->sp].f;
+    vm_println_number(vm, val);
+    if (debug) fprintf(stderr, "[VM] PRINTLN (stack value) = %f\n", val);
+}
+
+static void push_value(VMState *vm, double value) {
+    if (vm->sp < 256) vm->stack[vm->sp++].f = value;
+}
+
+static void push_int(VMState *vm, int64_t value) {
+    if (vm->sp < 256) vm->stack[vm->sp++].i = value;
+}
+
+static void push_raw(VMState *vm, Value value) {
+    if (vm->sp < 256) vm->stack[vm->sp++] = value;
+}
+
+// Comparaciones en el orden de los opcodes: EQ, NE, LT, LE, GT, GE
+static int compare_i64(int op, int64_t a, int64_t b) {
+    switch (op) {
+        case 0: return a == b;
+        case 1: return a != b;
+        case 2: return a < b;
+        case 3: return a <= b;
+        case 4: return a > b;
+        default: return a >= b;
     }
-    if (window_title_len > 0 && window_title_len < 256) {
-        if (fread(window_config.window_title, 1, window_title_len, file) != window_title_len) {
-            fprintf(stderr, "Error: No se puede leer título de ventana\n");
-            fclose(file);
-            return EXIT_FAILURE;
-        }
-        window_config.window_title[window_title_len] = '\0';
+}
+
+static int compare_f64(int op, double a, double b) {
+    switch (op) {
+        case 0: return a == b;
+        case 1: return a != b;
+        case 2: return a < b;
+        case 3: return a <= b;
+        case 4: return a > b;
+        default: return a >= b;
     }
-    
-    if (fread(&window_config.window_width, sizeof(uint16_t), 1, file) != 1) {
-        fprintf(stderr, "Error: No se puede leer ancho de ventana\n");
-        fclose(file);
-        return EXIT_FAILURE;
+}
+
+// Desplazamiento relativo con signo de un salto
+static int jump_offset(Instruction instr) {
+    return (int16_t)(instr.arg1 | (instr.arg2 << 8));
+}
+
+static void vm_step(VMState *vm, int debug);
+
+// Lo que un hilo de un parallel for no puede ejecutar: salida, crear o
+// redimensionar arrays (o vistas), escribir en un array completo, crear
+// objetos o modificar sus campos, y abrir otra región
+static int parallel_forbidden(uint8_t opcode) {
+    switch (opcode) {
+        case OPCODE_PRINT: case OPCODE_PRINTLN: case OPCODE_PRINTCHR: case OPCODE_PRINTLN_I64:
+        case OPCODE_FORMAT_PRINT: case OPCODE_FLUSH:
+        case OPCODE_PRINTLN_NUMBER: case OPCODE_PRINTLN_POOL: case OPCODE_PRINTLN_GLOBAL:
+        case OPCODE_NEW_INSTANCE: case OPCODE_SET_FIELD:
+        case OPCODE_ARRAY_NEW: case OPCODE_ARRAY_CLEAR:
+        case OPCODE_ARRAY_PUSH: case OPCODE_ARRAY_POP: case OPCODE_ARRAY_RESERVE:
+        case OPCODE_ARRAY_RESIZE: case OPCODE_ARRAY_COPY:
+        case OPCODE_ARRAY_FILL: case OPCODE_ARRAY_ADD: case OPCODE_ARRAY_MUL:
+        case OPCODE_ARRAY_SCALE: case OPCODE_ARRAY_AXPY:
+        case OPCODE_ARRAY_SORT: case OPCODE_ARRAY_SORT_DESC: case OPCODE_ARRAY_UNIQUE:
+        case OPCODE_ARRAY_ROW: case OPCODE_ARRAY_COL: case OPCODE_ARRAY_SLICE:
+        case OPCODE_PARALLEL_FOR:
+            return 1;
+        default:
+            return 0;
     }
-    
-    if (fread(&window_config.window_height, sizeof(uint16_t), 1, file) != 1) {
-        fprintf(stderr, "Error: No se puede leer alto de ventana\n");
-        fclose(file);
-        return EXIT_FAILURE;
+}
+
+// Hilos de los parallel for. El estado de cada hilo se conserva de una región
+// a otra: su copia del código (que reescribe al hacer quickening), sus
+// contadores de bucles y, con --jit, su propio código nativo.
+struct ParallelState {
+    ParallelPool *pool;
+    VMState *workers;       // Uno por hilo del pool
+    int count;
+};
+
+static void parallel_state_free(ParallelState *state) {
+    if (!state) return;
+    for (int i = 0; state->workers && i < state->count; i++) {
+        jit_free(state->workers[i].jit);
+        free(state->workers[i].instructions);
+        free(state->workers[i].locals);
+        free(state->workers[i].loop_counters);
     }
-    
-    if (fread(&window_config.window_resizable, 1, 1, file) != 1) {
-        fprintf(stderr, "Error: No se puede leer resizable de ventana\n");
-        fclose(file);
-        return EXIT_FAILURE;
+    free(state->workers);
+    parallel_free(state->pool);
+    free(state);
+}
+
+// Pool y estado de cada hilo. Su código es el de 'vm' con lo prohibido en la
+// región cambiado por PARALLEL_FORBIDDEN. NULL sin memoria.
+static ParallelState *parallel_state_create(const VMState *vm) {
+    ParallelState *state = (ParallelState*)calloc(1, sizeof(ParallelState));
+    if (!state) return NULL;
+    state->pool = parallel_create(vm->parallel_threads);
+    if (!state->pool) {
+        free(state);
+        return NULL;
     }
-    
-    uint8_t window_mode_len = 0;
-    if (fread(&window_mode_len, 1, 1, file) != 1) {
-        fprintf(stderr, "Error: No se puede leer longitud del modo de ventana\n");
-        fclose(file);
-        return EXIT_FAILURE;
+    state->count = parallel_thread_count(state->pool);
+    state->workers = (VMState*)calloc(state->count, sizeof(VMState));
+    if (!state->workers) {
+        parallel_state_free(state);
+        return NULL;
     }
-    if (window_mode_len > 0 && window_mode_len < 32) {
-        if (fread(window_config.window_mode, 1, window_mode_len, file) != window_mode_len) {
-            fprintf(stderr, "Error: No se puede leer modo de ventana\n");
-            fclose(file);
-            return EXIT_FAILURE;
+    for (int i = 0; i < state->count; i++) {
+        VMState *worker = &state->workers[i];
+        worker->instructions = (Instruction*)malloc(vm->instruction_count * sizeof(Instruction));
+        if (!worker->instructions) {
+            parallel_state_free(state);
+            return NULL;
+        }
+        for (int pc = 0; pc < vm->instruction_count; pc++) {
+            worker->instructions[pc] = vm->instructions[pc];
+            if (parallel_forbidden(vm->instructions[pc].opcode)) {
+                worker->instructions[pc].opcode = OPCODE_PARALLEL_FORBIDDEN;
+            }
+        }
+        // El JIT necesita contadores; sin él, los hilos no cuentan iteraciones
+        if (vm->jit) {
+            worker->loop_counters = (uint64_t*)calloc(vm->instruction_count + 1, sizeof(uint64_t));
+            if (worker->loop_counters) worker->jit = jit_create(vm, 0);
         }
-        window_config.window_mode[window_mode_len] = '\0';
     }
-    
-    // Leer renderer
-    uint8_t renderer_len = 0;
-    if (fread(&renderer_len, 1, 1, file) != 1) {
-        fprintf(stderr, "Error: No se puede leer longitud del renderer\n");
-        fclose(file);
-        return EXIT_FAILURE;
+    return state;
+}
+
+// Prepara un hilo para la región: comparte con 'vm' globales, arrays, objetos
+// y strings, y se queda con su código, sus contadores, su JIT, una copia del
+// frame actual y un stack vacío. Sin salida: la región no puede imprimir.
+static int parallel_worker_enter(VMState *worker, const VMState *vm) {
+    Instruction *instructions = worker->instructions;
+    Value *locals = worker->locals;
+    int locals_capacity = worker->locals_capacity;
+    uint64_t *loop_counters = worker->loop_counters;
+    JitState *jit = worker->jit;
+
+    if (locals_capacity < vm->frame_size) {
+        Value *temp = (Value*)realloc(locals, vm->frame_size * sizeof(Value));
+        if (!temp) return -1;
+        worker->locals = locals = temp;
+        worker->locals_capacity = locals_capacity = vm->frame_size;
     }
-    if (renderer_len > 0 && renderer_len < 32) {
-        if (fread(window_config.renderer, 1, renderer_len, file) != renderer_len) {
-            fprintf(stderr, "Error: No se puede leer renderer\n");
-            fclose(file);
-            return EXIT_FAILURE;
+
+    *worker = *vm;
+    worker->instructions = instructions;
+    worker->locals = locals;
+    worker->locals_capacity = locals_capacity;
+    worker->loop_counters = loop_counters;
+    worker->jit = jit;
+    worker->parallel_worker = 1;
+    memcpy(worker->locals, vm->locals + vm->fp, vm->frame_size * sizeof(Value));
+    worker->fp = 0;
+    worker->call_sp = 0;
+    worker->sp = 0;
+    worker->pending_string = NULL;
+    worker->parallel = NULL;
+    memset(&worker->out, 0, sizeof(worker->out));
+    return 0;
+}
+
+typedef struct {
+    ParallelPool *pool;
+    VMState *workers;
+    int slot;              // Local del índice
+    int body_pc;           // Primera instrucción del cuerpo
+    int end_pc;            // Su PARALLEL_END
+} ParallelRegion;
+
+// Índices [first, last) en el estado del hilo 'worker'
+static void parallel_body(void *context, int worker, int64_t first, int64_t last) {
+    ParallelRegion *region = (ParallelRegion*)context;
+    VMState *vm = &region->workers[worker];
+    for (int64_t i = first; i < last && !parallel_cancelled(region->pool); i++) {
+        vm->locals[region->slot].i = i;
+        vm->pc = region->body_pc;
+        vm->sp = 0;
+        while (vm->pc != region->end_pc) {
+            // vm_fail (ya informado) o return fuera del cuerpo
+            if (vm->pc >= vm->instruction_count) {
+                parallel_cancel(region->pool);
+                return;
+            }
+            vm_step(vm, 0);
         }
-        window_config.renderer[renderer_len] = '\0';
     }
-    
-    // Leer fps
-    uint16_t fps = 60;  // Valor por defecto
-    if (fread(&fps, sizeof(uint16_t), 1, file) != 1) {
-        fprintf(stderr, "Error: No se puede leer fps\n");
-        fclose(file);
-        return EXIT_FAILURE;
+}
+
+// PARALLEL_FOR en vm->pc: ejecuta la región y sigue tras su PARALLEL_END
+static void run_parallel_for(VMState *vm, int slot) {
+    int end_pc = vm->pc + 1;
+    while (end_pc < vm->instruction_count &&
+           !(vm->instructions[end_pc].opcode == OPCODE_PARALLEL_END && vm->instructions[end_pc].arg1 == slot)) {
+        end_pc++;
     }
-    if (fps < 1 || fps > 240) {
-        fps = 60;  // Validar rango
+    if (end_pc >= vm->instruction_count || slot + 1 >= vm->frame_size) {
+        vm_fail(vm, "parallel for sin PARALLEL_END");
+        return;
     }
-    window_config.fps = fps;
-    
-    // Resolver renderer automático según plataforma
-    resolve_renderer(window_config.renderer);
-    
-    // Sobrescribir renderer si se especificó desde línea de comandos
-    if (override_renderer && strlen(override_renderer) > 0) {
-        strcpy(window_config.renderer, override_renderer);
-        if (debug) printf("[VM] Renderer overridden from command line: %s\n", override_renderer);
+    Value *frame = vm->locals + vm->fp;
+    int64_t start = frame[slot].i, end = frame[slot + 1].i;
+    if (start >= end) {
+        vm->pc = end_pc + 1;
+        return;
     }
-    
-    if (debug) {
-        printf("[VM] Window configuration:\n");
-        printf("  Title: %s\n", window_config.window_title);
-        printf("  Resolution: %d x %d\n", window_config.window_width, window_config.window_height);
-        printf("  Resizable: %s\n", window_config.window_resizable ? "Yes" : "No");
-        printf("  Mode: %s\n", window_config.window_mode);
-        printf("  Renderer: %s\n", window_config.renderer);
-        printf("  FPS: %d\n", window_config.fps);
+
+    if (!vm->parallel) vm->parallel = parallel_state_create(vm);
+    ParallelState *state = vm->parallel;
+    int ready = state != NULL;
+    for (int i = 0; ready && i < state->count; i++) {
+        ready = parallel_worker_enter(&state->workers[i], vm) == 0;
+    }
+    if (!ready) {
+        vm_fail(vm, "No hay memoria para los hilos de parallel for");
+        return;
     }
 
-    // Leer cantidad de variables globales
-    uint16_t var_count = 0;
-    if (fread(&var_count, sizeof(uint16_t), 1, file) != 1) {
-        fprintf(stderr, "Error: No se puede leer cantidad de variables\n");
-        fclose(file);
-        return EXIT_FAILURE;
+    // Lo ya impreso, antes que un posible error de la región
+    output_flush(&vm->out);
+    ParallelRegion region = { state->pool, state->workers, slot, vm->pc + 1, end_pc };
+    parallel_run(state->pool, start, end, parallel_body, &region);
+    // El error de un hilo (ya informado) es el del programa
+    for (int i = 0; i < state->count; i++) {
+        if (state->workers[i].failed) vm->failed = 1;
     }
+    frame[slot].i = end;
+    vm->pc = parallel_cancelled(state->pool) ? vm->instruction_count : end_pc + 1;
+}
 
-    if (debug) printf("[VM] Global variables: %d\n", var_count);
+// Ejecuta la instrucción en vm->pc y avanza. Compartido por el loop de
+// ventana (una instrucción por frame) y el de consola.
+static void vm_step(VMState *vm, int debug) {
+    Instruction current = vm->instructions[vm->pc];
 
-    // Leer variables globales (optimizado con tipo)
-    Variable *variables = NULL;
-    if (var_count > 0) {
-        variables = (Variable*)malloc(var_count * sizeof(Variable));
-        if (!variables) {
-            fprintf(stderr, "Error: No hay memoria suficiente\n");
-            fclose(file);
-            return EXIT_FAILURE;
-        }
+    if (debug) fprintf(stderr, "[VM] PC: %d, Opcode: 0x%02x\n", vm->pc, current.opcode);
 
-        for (int i = 0; i < var_count; i++) {
-            uint8_t name_len = 0;
-            if (fread(&name_len, 1, 1, file) != 1) {
-                fprintf(stderr, "Error: No se puede leer nombre de variable\n");
-                fclose(file);
-                return EXIT_FAILURE;
+    switch (current.opcode) {
+        case OPCODE_PRINT:
+            // current.arg1 es el índice del string
+            if (current.arg1 < vm->string_pool.string_count) {
+                output_string(&vm->out, vm->string_pool.strings[current.arg1]);
+                if (debug) fprintf(stderr, "[VM] PRINT string #%d\n", current.arg1);
+            } else {
+                if (debug) fprintf(stderr, "[VM] Error: string index fuera de rango\n");
             }
-
-            variables[i].name = (char*)malloc(name_len + 1);
-            if (!variables[i].name) {
-                fprintf(stderr, "Error: No hay memoria suficiente\n");
-                fclose(file);
-                return EXIT_FAILURE;
+            break;
+        
+        case OPCODE_PRINTLN:
+            // Si hay un valor en el stack (de ARRAY_GET, etc), imprimirlo
+            if (vm->sp > 0) {
+                println_number(vm, debug);
+                quicken(vm, OPCODE_PRINTLN_NUMBER, current.arg1);
             }
-
-            if (fread(variables[i].name, 1, name_len, file) != name_len) {
-                fprintf(stderr, "Error: No se puede leer nombre de variable\n");
-                fclose(file);
-                return EXIT_FAILURE;
+            // Si hay un string global pendiente, usarlo
+            else if (vm->pending_string) {
+                output_string(&vm->out, vm->pending_string);
+                output_char(&vm->out, '\n');
+                if (debug) fprintf(stderr, "[VM] PRINTLN (global string)\n");
+                vm->pending_string = NULL;
+                quicken(vm, OPCODE_PRINTLN_GLOBAL, current.arg1);
+            } else if (current.arg1 < vm->string_pool.string_count) {
+                output_string(&vm->out, vm->string_pool.strings[current.arg1]);
+                output_char(&vm->out, '\n');
+                if (debug) fprintf(stderr, "[VM] PRINTLN string #%d\n", current.arg1);
+                quicken(vm, OPCODE_PRINTLN_POOL, current.arg1);
+            } else {
+                if (debug) fprintf(stderr, "[VM] Error: string index fuera de rango\n");
             }
-            variables[i].name[name_len] = '\0';
-
-            // Leer tipo de variable
-            uint8_t var_type = 0;
-            if (fread(&var_type, 1, 1, file) != 1) {
-                fprintf(stderr, "Error: No se puede leer tipo de variable\n");
-                fclose(file);
-                return EXIT_FAILURE;
+            break;
+        
+        case OPCODE_PRINTLN_NUMBER:
+            if (vm->sp == 0) {
+                dequicken(vm, OPCODE_PRINTLN);
+                return;
             }
-            variables[i].type = var_type;
-
-            // Leer valor según tipo
-            if (var_type == 's') {
-                // String: leer longitud + contenido
-                uint16_t str_len = 0;
-                if (fread(&str_len, sizeof(uint16_t), 1, file) != 1) {
-                    fprintf(stderr, "Error: No se puede leer longitud de string\n");
-                    fclose(file);
-                    return EXIT_FAILURE;
-                }
-                
-                variables[i].str_val = (char*)malloc(str_len + 1);
-                if (!variables[i].str_val) {
-                    fprintf(stderr, "Error: No hay memoria suficiente\n");
-                    fclose(file);
-                    return EXIT_FAILURE;
-                }
-                
-                if (fread(variables[i].str_val, 1, str_len, file) != str_len) {
-                    fprintf(stderr, "Error: No se puede leer contenido de string\n");
-                    fclose(file);
-                    return EXIT_FAILURE;
-                }
-                variables[i].str_val[str_len] = '\0';
-                variables[i].value = 0;
-                
-                if (debug) printf("[VM] Variable %d (string): %s = \"%s\"\n", i, variables[i].name, variables[i].str_val);
-            } else if (var_type == 'a') {
-                // Array estático: leer tipo de elemento y tamaño
-                uint8_t element_type = 0;
-                int array_size = 0;
-                if (fread(&element_type, 1, 1, file) != 1 || 
-                    fread(&array_size, sizeof(int), 1, file) != 1) {
-                    fprintf(stderr, "Error: No se puede leer información del array\n");
-                    fclose(file);
-                    return EXIT_FAILURE;
-                }
-                // Por ahora, almacenar en value como tamaño
-                variables[i].value = (double)array_size;
-                variables[i].str_val = NULL;
-                
-                if (debug) printf("[VM] Variable %d (array estático): %s[%d] (tipo: %c)\n", i, variables[i].name, array_size, element_type);
-            } else if (var_type == 'b') {
-                // Array dinámico: leer tipo de elemento (tamaño será 0)
-                uint8_t element_type = 0;
-                if (fread(&element_type, 1, 1, file) != 1) {
-                    fprintf(stderr, "Error: No se puede leer tipo de array dinámico\n");
-                    fclose(file);
-                    return EXIT_FAILURE;
+            println_number(vm, debug);
+            break;
+        
+        case OPCODE_PRINTLN_POOL:
+            if (vm->sp > 0 || vm->pending_string) {
+                dequicken(vm, OPCODE_PRINTLN);
+                return;
+            }
+            output_string(&vm->out, vm->string_pool.strings[current.arg1]);
+            output_char(&vm->out, '\n');
+            break;
+        
+        case OPCODE_PRINTLN_GLOBAL:
+            if (vm->sp > 0 || !vm->pending_string) {
+                dequicken(vm, OPCODE_PRINTLN);
+                return;
+            }
+            output_string(&vm->out, vm->pending_string);
+            output_char(&vm->out, '\n');
+            vm->pending_string = NULL;
+            break;
+        
+        case OPCODE_PRINTCHR:
+            // current.arg1 es el carácter ASCII a imprimir (optimizado, sin string pool)
+            output_char(&vm->out, (char)current.arg1);
+            if (debug) fprintf(stderr, "[VM] PRINTCHR 0x%02x\n", current.arg1);
+            break;
+        
+        case OPCODE_GET_GLOBAL:
+            // current.arg1 es el índice de variable global
+            if (current.arg1 < vm->variable_count) {
+                Variable *var = &vm->variables[current.arg1];
+                if (var->type == 's') {
+                    vm->pending_string = var->str_val;
+                    if (debug) fprintf(stderr, "[VM] GET_GLOBAL %s (string) = \"%s\"\n", var->name, var->str_val);
+                    quicken(vm, OPCODE_GET_GLOBAL_STRING, current.arg1);
+                } else {
+                    push_value(vm, var->value);
+                    if (debug) fprintf(stderr, "[VM] GET_GLOBAL %s = %f\n", var->name, var->value);
+                    quicken(vm, OPCODE_GET_GLOBAL_NUMBER, current.arg1);
                 }
-                // Almacenar el tipo de elemento en value (como byte)
-                variables[i].value = (double)element_type;
-                variables[i].str_val = NULL;
-                
-                if (debug) printf("[VM] Variable %d (array dinámico): %s (tipo elemento: %c)\n", i, variables[i].name, element_type);
             } else {
-                // Numeric: leer double
-                variables[i].str_val = NULL;
-                if (fread(&variables[i].value, sizeof(double), 1, file) != 1) {
-                    fprintf(stderr, "Error: No se puede leer valor de variable\n");
-                    fclose(file);
-                    return EXIT_FAILURE;
-                }
-
-                if (debug) printf("[VM] Variable %d (%c): %s = %f\n", i, var_type, variables[i].name, variables[i].value);
+                if (debug) fprintf(stderr, "[VM] Error: variable index fuera de rango\n");
             }
+            break;
+        
+        case OPCODE_GET_GLOBAL_STRING:
+            vm->pending_string = vm->variables[current.arg1].str_val;
+            break;
+        
+        case OPCODE_GET_GLOBAL_NUMBER:
+            push_value(vm, vm->variables[current.arg1].value);
+            break;
+        
+        case OPCODE_PUSH_VALUE:
+            // current.arg1 es el índice del string en el pool
+            // Convertir string a double y pushear al value stack
+            if (current.arg1 < vm->string_pool.string_count && vm->sp < 256) {
+                char *str_val = vm->string_pool.strings[current.arg1];
+                double num_val = atof(str_val);
+                push_value(vm, num_val);
+                if (debug) fprintf(stderr, "[VM] PUSH_VALUE string #%d ('%s') as %f\n", 
+                                current.arg1, str_val, num_val);
+            } else {
+                if (debug) fprintf(stderr, "[VM] Error: PUSH_VALUE invalid state\n");
+            }
+            break;
+        
+        case OPCODE_POP_VALUE:
+            // Descarta el valor del tope del stack
+            if (vm->sp > 0) {
+                vm->sp--;
+                if (debug) fprintf(stderr, "[VM] POP_VALUE\n");
+            }
+            break;
+        
+        case OPCODE_NEW_INSTANCE:
+            // arg1 = índice de la clase, arg2 = variable objeto que recibe la instancia
+            if (current.arg1 < vm->class_pool.class_count) {
+                int id = vm_new_instance(vm, current.arg1, current.arg2);
+                if (debug && id >= 0) fprintf(stderr, "[VM] NEW_INSTANCE '%s' (id: %d) -> variable %d\n",
+                                             vm->class_pool.classes[current.arg1].name, id, current.arg2);
+            } else {
+                if (debug) fprintf(stderr, "[VM] Error: clase index fuera de rango\n");
+            }
+            break;
+        
+        case OPCODE_SET_FIELD: {
+            // arg1 = variable objeto, arg2 = slot del campo (resueltos al compilar)
+            ObjectInstance *obj = vm_resolve_object(vm, current.arg1);
+            if (obj && current.arg2 < obj->field_count && vm->sp > 0) {
+                obj->field_values[current.arg2] = vm->stack[--vm->sp];
+                if (debug) fprintf(stderr, "[VM] SET_FIELD variable %d, field %d\n", current.arg1, current.arg2);
+            } else {
+                if (debug) fprintf(stderr, "[VM] Error: SET_FIELD sobre objeto inexistente\n");
+            }
+            break;
         }
-    }
-
-    // Leer cantidad de clases
-    uint16_t class_count = 0;
-    if (fread(&class_count, sizeof(uint16_t), 1, file) != 1) {
-        fprintf(stderr, "Error: No se puede leer cantidad de clases\n");
-        fclose(file);
-        return EXIT_FAILURE;
-    }
-
-    if (debug) printf("[VM] Classes: %d\n", class_count);
-
-    // Leer definiciones de clases
-    ClassDefinition *classes = NULL;
-    if (class_count > 0) {
-        classes = (ClassDefinition*)malloc(class_count * sizeof(ClassDefinition));
-        if (!classes) {
-            fprintf(stderr, "Error: No hay memoria suficiente\n");
-            fclose(file);
-            return EXIT_FAILURE;
+        
+        case OPCODE_GET_FIELD: {
+            // arg1 = variable objeto, arg2 = slot del campo
+            ObjectInstance *obj = vm_resolve_object(vm, current.arg1);
+            if (obj && current.arg2 < obj->field_count) {
+                push_raw(vm, obj->field_values[current.arg2]);
+                if (debug) fprintf(stderr, "[VM] GET_FIELD variable %d, field %d\n", current.arg1, current.arg2);
+            } else {
+                if (debug) fprintf(stderr, "[VM] Error: GET_FIELD sobre objeto inexistente\n");
+            }
+            break;
         }
-
-        for (int i = 0; i < class_count; i++) {
-            // Leer nombre de clase
-            uint8_t name_len = 0;
-            if (fread(&name_len, 1, 1, file) != 1) {
-                fprintf(stderr, "Error: No se puede leer nombre de clase\n");
-                fclose(file);
-                return EXIT_FAILURE;
+        
+        case OPCODE_CALL_METHOD: {
+            // arg1 = clase, arg2 = slot en su vtable (resueltos al compilar)
+            if (current.arg1 >= vm->class_pool.class_count ||
+                current.arg2 >= vm->class_pool.classes[current.arg1].method_count) {
+                if (debug) fprintf(stderr, "[VM] Error: CALL_METHOD fuera de rango\n");
+                break;
             }
-
-            classes[i].name = (char*)malloc(name_len + 1);
-            if (!classes[i].name) {
-                fprintf(stderr, "Error: No hay memoria suficiente\n");
-                fclose(file);
-                return EXIT_FAILURE;
+            int entry = vm_enter_method(vm, current.arg1, current.arg2, vm->pc + 1);
+            if (entry < 0) {
+                vm->pc = vm->instruction_count;
+                return;
             }
-
-            if (fread(classes[i].name, 1, name_len, file) != name_len) {
-                fprintf(stderr, "Error: No se puede leer nombre de clase\n");
-                fclose(file);
-                return EXIT_FAILURE;
+            vm->pc = entry;
+            if (debug) fprintf(stderr, "[VM] CALL_METHOD clase %d, slot %d -> PC %d\n", current.arg1, current.arg2, vm->pc);
+            return;
+        }
+        
+        case OPCODE_LOAD_LOCAL:
+            // arg1 = slot del frame actual; sin etiqueta de tipo que comprobar
+            if (current.arg1 < vm->frame_size) {
+                push_raw(vm, vm->locals[vm->fp + current.arg1]);
+                if (debug) fprintf(stderr, "[VM] LOAD_LOCAL %d\n", current.arg1);
             }
-            classes[i].name[name_len] = '\0';
-
-            // Leer cantidad de variables de instancia
-            uint8_t ivar_count = 0;
-            if (fread(&ivar_count, 1, 1, file) != 1) {
-                fprintf(stderr, "Error: No se puede leer cantidad de variables de instancia\n");
-                fclose(file);
-                return EXIT_FAILURE;
+            break;
+        
+        case OPCODE_STORE_LOCAL:
+            if (current.arg1 < vm->frame_size && vm->sp > 0) {
+                vm->locals[vm->fp + current.arg1] = vm->stack[--vm->sp];
+                if (debug) fprintf(stderr, "[VM] STORE_LOCAL %d\n", current.arg1);
             }
+            break;
+        
+        case OPCODE_RETURN: {
+            // Dentro de un método vuelve a quien lo llamó; en la entrada termina
+            int return_pc = vm_leave_method(vm);
+            if (return_pc >= 0) {
+                vm->pc = return_pc;
+                if (debug) fprintf(stderr, "[VM] RETURN -> PC %d\n", vm->pc);
+                return;
+            }
+            if (debug) fprintf(stderr, "[VM] RETURN - terminando ejecución\n");
+            vm->pc = vm->instruction_count;  // Salir del loop
+            return;
+        }
+        
+        case OPCODE_ARRAY_SET:
+        case OPCODE_ARRAY_SET_I64: {
+            // arg1 = índice de variable (para ambos estáticos y dinámicos)
+            // Top del stack contiene el valor, segundo top contiene el índice
+            int array_index = vm_resolve_array(vm, current.arg1);
+            if (array_index >= 0) quicken_array_access(vm, current, array_index);
+            array_store(vm, array_index, current.opcode == OPCODE_ARRAY_SET_I64, debug);
+            break;
+        }
+        
+        case OPCODE_ARRAY_GET:
+        case OPCODE_ARRAY_GET_I64: {
+            // arg1 = índice de variable (para ambos estáticos y dinámicos)
+            // Top del stack contiene el índice, se reemplaza por el valor
+            int array_index = vm_resolve_array(vm, current.arg1);
+            if (array_index >= 0) quicken_array_access(vm, current, array_index);
+            array_load(vm, array_index, current.opcode == OPCODE_ARRAY_GET_I64, debug);
+            break;
+        }
+        
+        case OPCODE_ARRAY_GET_STATIC:
+            array_load(vm, current.arg1, 0, debug);
+            break;
+        
+        case OPCODE_ARRAY_GET_STATIC_I64:
+            array_load(vm, current.arg1, 1, debug);
+            break;
+        
+        case OPCODE_ARRAY_GET_DYNAMIC:
+            array_load(vm, vm_dynamic_array(vm, current.arg1), 0, debug);
+            break;
+        
+        case OPCODE_ARRAY_GET_DYNAMIC_I64:
+            array_load(vm, vm_dynamic_array(vm, current.arg1), 1, debug);
+            break;
+        
+        case OPCODE_ARRAY_SET_STATIC:
+            array_store(vm, current.arg1, 0, debug);
+            break;
+        
+        case OPCODE_ARRAY_SET_STATIC_I64:
+            array_store(vm, current.arg1, 1, debug);
+            break;
+        
+        case OPCODE_ARRAY_SET_DYNAMIC:
+            array_store(vm, vm_dynamic_array(vm, current.arg1), 0, debug);
+            break;
+        
+        case OPCODE_ARRAY_SET_DYNAMIC_I64:
+            array_store(vm, vm_dynamic_array(vm, current.arg1), 1, debug);
+            break;
+        
+        case OPCODE_ARRAY_GET_INT:
+        case OPCODE_ARRAY_SET_INT: {
+            int array_index = vm_resolve_array(vm, current.arg1);
+            if (array_index >= 0) quicken_int_array_access(vm, current, array_index);
+            if (current.opcode == OPCODE_ARRAY_GET_INT) {
+                int_array_load(vm, array_index, debug);
+            } else {
+                int_array_store(vm, array_index, debug);
+            }
+            break;
+        }
+        
+        case OPCODE_ARRAY_GET_INT_STATIC:
+            int_array_load(vm, current.arg1, debug);
+            break;
+        
+        case OPCODE_ARRAY_GET_INT_DYNAMIC:
+            int_array_load(vm, vm_dynamic_array(vm, current.arg1), debug);
+            break;
+        
+        case OPCODE_ARRAY_SET_INT_STATIC:
+            int_array_store(vm, current.arg1, debug);
+            break;
+        
+        case OPCODE_ARRAY_SET_INT_DYNAMIC:
+            int_array_store(vm, vm_dynamic_array(vm, current.arg1), debug);
+            break;
+        
+        case OPCODE_ARRAY_NEW: {
+            // arg1 = índice de variable en var_pool (para almacenar la referencia)
+            // arg2 = tipo de elemento
+            // Top del stack contiene el tamaño
+            if (vm->sp > 0 && current.arg1 < vm->variable_count) {
+                int size = (int)vm->stack[--vm->sp].f;
+                int index = vm_array_new(vm, current.arg1, (char)current.arg2, size);
+                if (debug && index >= 0) fprintf(stderr, "[VM] ARRAY_NEW variable %d, array %d, size %d, type %c\n", 
+                                                current.arg1, index, vm->arrays[index].size, current.arg2);
+            }
+            break;
+        }
+        
+        case OPCODE_ARRAY_PUSH:
+            if (vm->sp < 1) break;
+            vm->sp--;
+            if (vm_array_push(vm, current.arg1, vm->stack[vm->sp]) != 0) return;
+            if (debug) fprintf(stderr, "[VM] ARRAY_PUSH variable %d\n", current.arg1);
+            break;
+        
+        case OPCODE_ARRAY_POP: {
+            Value value;
+            if (vm->sp >= 256) break;
+            if (vm_array_pop(vm, current.arg1, &value) != 0) return;
+            vm->stack[vm->sp++] = value;
+            if (debug) fprintf(stderr, "[VM] ARRAY_POP variable %d\n", current.arg1);
+            break;
+        }
+        
+        case OPCODE_ARRAY_RESERVE:
+        case OPCODE_ARRAY_RESIZE: {
+            if (vm->sp < 1) break;
+            int64_t n = vm->stack[--vm->sp].i;
+            int failed = current.opcode == OPCODE_ARRAY_RESERVE ? vm_array_reserve(vm, current.arg1, n)
+                                                                 : vm_array_resize(vm, current.arg1, n);
+            if (failed) return;
+            if (debug) fprintf(stderr, "[VM] %s variable %d, %lld\n",
+                               current.opcode == OPCODE_ARRAY_RESERVE ? "ARRAY_RESERVE" : "ARRAY_RESIZE",
+                               current.arg1, (long long)n);
+            break;
+        }
+        
+        case OPCODE_ARRAY_COPY:
+            if (vm_array_copy(vm, current.arg1, current.arg2) != 0) return;
+            if (debug) fprintf(stderr, "[VM] ARRAY_COPY variable %d <- %d\n", current.arg1, current.arg2);
+            break;
+        
+        case OPCODE_ARRAY_FILL:
+        case OPCODE_ARRAY_SCALE:
+        case OPCODE_ARRAY_AXPY:
+            if (vm->sp < 1) break;
+            if (vm_array_bulk(vm, current.opcode, current.arg1, current.arg2, &vm->stack[vm->sp - 1]) != 0) return;
+            vm->sp--;
+            if (debug) fprintf(stderr, "[VM] ARRAY_BULK %02X variable %d, %d\n", current.opcode, current.arg1, current.arg2);
+            break;
+        
+        case OPCODE_ARRAY_ADD:
+        case OPCODE_ARRAY_MUL: {
+            Value unused;
+            if (vm_array_bulk(vm, current.opcode, current.arg1, current.arg2, &unused) != 0) return;
+            if (debug) fprintf(stderr, "[VM] ARRAY_BULK %02X variable %d, %d\n", current.opcode, current.arg1, current.arg2);
+            break;
+        }
+        
+        case OPCODE_ARRAY_SUM:
+        case OPCODE_ARRAY_MIN:
+        case OPCODE_ARRAY_MAX:
+        case OPCODE_ARRAY_DOT:
+            if (vm->sp >= 256) break;
+            if (vm_array_bulk(vm, current.opcode, current.arg1, current.arg2, &vm->stack[vm->sp]) != 0) return;
+            vm->sp++;
+            if (debug) fprintf(stderr, "[VM] ARRAY_BULK %02X variable %d, %d\n", current.opcode, current.arg1, current.arg2);
+            break;
+        
+        case OPCODE_ARRAY_SORT:
+        case OPCODE_ARRAY_SORT_DESC:
+            if (vm_array_sort(vm, current.arg1, current.opcode == OPCODE_ARRAY_SORT_DESC) != 0) return;
+            if (debug) fprintf(stderr, "[VM] ARRAY_SORT%s variable %d\n",
+                               current.opcode == OPCODE_ARRAY_SORT_DESC ? "_DESC" : "", current.arg1);
+            break;
+        
+        case OPCODE_ARRAY_SEARCH:
+            if (vm->sp < 1) break;
+            if (vm_array_search(vm, current.arg1, &vm->stack[vm->sp - 1]) != 0) return;
+            if (debug) fprintf(stderr, "[VM] ARRAY_SEARCH variable %d -> %lld\n", current.arg1,
+                               (long long)vm->stack[vm->sp - 1].i);
+            break;
+        
+        case OPCODE_ARRAY_UNIQUE:
+            if (vm->sp >= 256) break;
+            if (vm_array_unique(vm, current.arg1, &vm->stack[vm->sp]) != 0) return;
+            vm->sp++;
+            if (debug) fprintf(stderr, "[VM] ARRAY_UNIQUE variable %d\n", current.arg1);
+            break;
+        
+        case OPCODE_ARRAY_ROW:
+        case OPCODE_ARRAY_COL:
+            if (vm->sp < 1) break;
+            vm->sp--;
+            if (vm_array_view(vm, current.opcode, current.arg1, current.arg2, vm->stack[vm->sp].i, 0) != 0) return;
+            if (debug) fprintf(stderr, "[VM] ARRAY_%s variable %d = variable %d [%lld]\n",
+                               current.opcode == OPCODE_ARRAY_ROW ? "ROW" : "COL", current.arg1, current.arg2,
+                               (long long)vm->stack[vm->sp].i);
+            break;
+        
+        case OPCODE_ARRAY_SLICE:
+            if (vm->sp < 2) break;
+            vm->sp -= 2;
+            if (vm_array_view(vm, current.opcode, current.arg1, current.arg2,
+                              vm->stack[vm->sp].i, vm->stack[vm->sp + 1].i) != 0) return;
+            if (debug) fprintf(stderr, "[VM] ARRAY_SLICE variable %d = variable %d [%lld, %lld)\n",
+                               current.arg1, current.arg2, (long long)vm->stack[vm->sp].i,
+                               (long long)vm->stack[vm->sp + 1].i);
+            break;
+        
+        case OPCODE_PARALLEL_FOR:
+            if (debug) fprintf(stderr, "[VM] PARALLEL_FOR índice en local %d\n", current.arg1);
+            run_parallel_for(vm, current.arg1);
+            return;
+        
+        case OPCODE_PARALLEL_END:
+            // Solo lo alcanzan los hilos de la región, que paran antes de ejecutarlo
+            break;
+        
+        case OPCODE_PARALLEL_FORBIDDEN:
+            vm_fail(vm, "Dentro de parallel for no se puede imprimir, crear o redimensionar arrays, "
+                        "escribir en un array completo ni modificar objetos");
+            return;
+        
+        case OPCODE_ARRAY_LEN: {
+            // arg1 = índice de variable
+            // Pushea la longitud del array al stack
+            int array_index = vm_resolve_array(vm, current.arg1);
+            if (array_index >= 0) {
+                int len = vm->arrays[array_index].size;
+                push_int(vm, len);
+                if (debug) fprintf(stderr, "[VM] ARRAY_LEN array %d = %d\n", array_index, len);
+            }
+            break;
+        }
+        
+        case OPCODE_ARRAY_CLEAR: {
+            // arg1 = índice de variable
+            // Limpia todos los elementos del array (los pone en 0)
+            int array_index = vm_resolve_array(vm, current.arg1);
+            if (array_index >= 0) {
+                vm_array_clear(vm, array_index);
+                if (debug) fprintf(stderr, "[VM] ARRAY_CLEAR array %d\n", array_index);
+            }
+            break;
+        }
+        
+        case OPCODE_PUSH_INT:
+            push_int(vm, (int16_t)(current.arg1 | (current.arg2 << 8)));
+            break;
 
-            classes[i].var_count = ivar_count;
-            classes[i].var_names = NULL;
-            classes[i].var_types = NULL;
-
-            if (ivar_count > 0) {
-                classes[i].var_names = (char**)malloc(ivar_count * sizeof(char*));
-                classes[i].var_types = (uint8_t*)malloc(ivar_count * sizeof(uint8_t));
-
-                if (!classes[i].var_names || !classes[i].var_types) {
-                    fprintf(stderr, "Error: No hay memoria suficiente\n");
-                    fclose(file);
-                    return EXIT_FAILURE;
-                }
-
-                for (int j = 0; j < ivar_count; j++) {
-                    uint8_t var_name_len = 0;
-                    if (fread(&var_name_len, 1, 1, file) != 1) {
-                        fprintf(stderr, "Error: No se puede leer nombre de variable de instancia\n");
-                        fclose(file);
-                        return EXIT_FAILURE;
-                    }
-
-                    classes[i].var_names[j] = (char*)malloc(var_name_len + 1);
-                    if (!classes[i].var_names[j]) {
-                        fprintf(stderr, "Error: No hay memoria suficiente\n");
-                        fclose(file);
-                        return EXIT_FAILURE;
-                    }
-
-                    if (fread(classes[i].var_names[j], 1, var_name_len, file) != var_name_len) {
-                        fprintf(stderr, "Error: No se puede leer nombre de variable de instancia\n");
-                        fclose(file);
-                        return EXIT_FAILURE;
+        case OPCODE_PUSH_I64:
+            if (current.arg1 < vm->string_pool.string_count) {
+                push_int(vm, strtoll(vm->string_pool.strings[current.arg1], NULL, 10));
+            }
+            break;
+        
+        case OPCODE_I2F:
+            if (vm->sp > 0) vm->stack[vm->sp - 1].f = (double)vm->stack[vm->sp - 1].i;
+            break;
+        
+        case OPCODE_F2I:
+            if (vm->sp > 0) vm->stack[vm->sp - 1].i = (int64_t)vm->stack[vm->sp - 1].f;
+            break;
+        
+        case OPCODE_NEG_I64:
+            if (vm->sp > 0) vm->stack[vm->sp - 1].i = -vm->stack[vm->sp - 1].i;
+            break;
+        
+        case OPCODE_NEG_F64:
+            if (vm->sp > 0) vm->stack[vm->sp - 1].f = -vm->stack[vm->sp - 1].f;
+            break;
+        
+        case OPCODE_ADD_I64:
+        case OPCODE_SUB_I64:
+        case OPCODE_MUL_I64:
+        case OPCODE_DIV_I64:
+        case OPCODE_MOD_I64: {
+            if (vm->sp < 2) break;
+            int64_t b = vm->stack[--vm->sp].i;
+            int64_t *a = &vm->stack[vm->sp - 1].i;
+            switch (current.opcode) {
+                case OPCODE_ADD_I64: *a += b; break;
+                case OPCODE_SUB_I64: *a -= b; break;
+                case OPCODE_MUL_I64: *a *= b; break;
+                default:
+                    if (b == 0) {
+                        vm_fail(vm, "División entera por cero");
+                        return;
                     }
-                    classes[i].var_names[j][var_name_len] = '\0';
-
-                    if (fread(&classes[i].var_types[j], 1, 1, file) != 1) {
-                        fprintf(stderr, "Error: No se puede leer tipo de variable de instancia\n");
-                        fclose(file);
-                        return EXIT_FAILURE;
+                    if (b == -1) {
+                        // INT64_MIN / -1 no cabe (SIGFPE): negación circular, como al plegar
+                        *a = current.opcode == OPCODE_DIV_I64 ? (int64_t)(0 - (uint64_t)*a) : 0;
+                        break;
                     }
-
-                    if (debug) printf("[VM] Clase '%s' variable %d: %s (tipo: %c)\n", 
-                                    classes[i].name, j, classes[i].var_names[j], classes[i].var_types[j]);
-                }
+                    *a = current.opcode == OPCODE_DIV_I64 ? *a / b : *a % b;
+                    break;
             }
-
-            // Leer cantidad de métodos
-            uint8_t method_count = 0;
-            if (fread(&method_count, 1, 1, file) != 1) {
-                fprintf(stderr, "Error: No se puede leer cantidad de métodos\n");
-                fclose(file);
-                return EXIT_FAILURE;
+            break;
+        }
+        
+        case OPCODE_ADD_F64:
+        case OPCODE_SUB_F64:
+        case OPCODE_MUL_F64:
+        case OPCODE_DIV_F64:
+        case OPCODE_MOD_F64: {
+            if (vm->sp < 2) break;
+            double b = vm->stack[--vm->sp].f;
+            double *a = &vm->stack[vm->sp - 1].f;
+            switch (current.opcode) {
+                case OPCODE_ADD_F64: *a += b; break;
+                case OPCODE_SUB_F64: *a -= b; break;
+                case OPCODE_MUL_F64: *a *= b; break;
+                case OPCODE_DIV_F64: *a /= b; break;
+                default: *a = fmod(*a, b); break;
             }
-            
-            classes[i].method_count = method_count;
-            if (method_count > 0) {
-                classes[i].methods = (ClassMethod*)malloc(method_count * sizeof(ClassMethod));
-            } else {
-                classes[i].methods = NULL;
+            break;
+        }
+        
+        case OPCODE_PRINTLN_I64:
+            if (vm->sp > 0) vm_println_int(vm, vm->stack[--vm->sp].i);
+            break;
+        
+        case OPCODE_EQ_I64: case OPCODE_NE_I64: case OPCODE_LT_I64:
+        case OPCODE_LE_I64: case OPCODE_GT_I64: case OPCODE_GE_I64: {
+            if (vm->sp < 2) break;
+            int64_t b = vm->stack[--vm->sp].i;
+            Value *a = &vm->stack[vm->sp - 1];
+            a->i = compare_i64(current.opcode - OPCODE_EQ_I64, a->i, b);
+            break;
+        }
+        
+        case OPCODE_EQ_F64: case OPCODE_NE_F64: case OPCODE_LT_F64:
+        case OPCODE_LE_F64: case OPCODE_GT_F64: case OPCODE_GE_F64: {
+            if (vm->sp < 2) break;
+            double b = vm->stack[--vm->sp].f;
+            Value *a = &vm->stack[vm->sp - 1];
+            a->i = compare_f64(current.opcode - OPCODE_EQ_F64, a->f, b);
+            break;
+        }
+        
+        case OPCODE_NOT:
+            if (vm->sp > 0) vm->stack[vm->sp - 1].i = !vm->stack[vm->sp - 1].i;
+            break;
+        
+        case OPCODE_AND:
+        case OPCODE_OR: {
+            if (vm->sp < 2) break;
+            int64_t b = vm->stack[--vm->sp].i;
+            int64_t *a = &vm->stack[vm->sp - 1].i;
+            *a = current.opcode == OPCODE_AND ? (*a && b) : (*a || b);
+            break;
+        }
+        
+        case OPCODE_MULADD_I64:
+            if (vm->sp >= 3) {
+                vm->sp -= 2;
+                Value *a = &vm->stack[vm->sp - 1];
+                a->i = a->i * vm->stack[vm->sp].i + vm->stack[vm->sp + 1].i;
             }
-            
-            // Leer métodos
-            for (int j = 0; j < method_count; j++) {
-                // Leer nombre del método
-                uint8_t method_name_len = 0;
-                if (fread(&method_name_len, 1, 1, file) != 1) {
-                    fprintf(stderr, "Error: No se puede leer longitud de nombre de método\n");
-                    fclose(file);
-                    return EXIT_FAILURE;
+            break;
+        
+        case OPCODE_MULADD_F64:
+            if (vm->sp >= 3) {
+                vm->sp -= 2;
+                Value *a = &vm->stack[vm->sp - 1];
+                a->f = a->f * vm->stack[vm->sp].f + vm->stack[vm->sp + 1].f;
+            }
+            break;
+        
+        case OPCODE_JUMP_UNLESS_EQ_I64: case OPCODE_JUMP_UNLESS_NE_I64:
+        case OPCODE_JUMP_UNLESS_LT_I64: case OPCODE_JUMP_UNLESS_LE_I64:
+        case OPCODE_JUMP_UNLESS_GT_I64: case OPCODE_JUMP_UNLESS_GE_I64:
+            if (vm->sp >= 2) {
+                vm->sp -= 2;
+                if (!compare_i64(current.opcode - OPCODE_JUMP_UNLESS_EQ_I64,
+                                 vm->stack[vm->sp].i, vm->stack[vm->sp + 1].i)) {
+                    vm->pc += jump_offset(current);
                 }
-                
-                char method_name[256] = {0};
-                if (fread(method_name, 1, method_name_len, file) != method_name_len) {
-                    fprintf(stderr, "Error: No se puede leer nombre de método\n");
-                    fclose(file);
-                    return EXIT_FAILURE;
+            }
+            break;
+        
+        case OPCODE_JUMP_UNLESS_EQ_F64: case OPCODE_JUMP_UNLESS_NE_F64:
+        case OPCODE_JUMP_UNLESS_LT_F64: case OPCODE_JUMP_UNLESS_LE_F64:
+        case OPCODE_JUMP_UNLESS_GT_F64: case OPCODE_JUMP_UNLESS_GE_F64:
+            if (vm->sp >= 2) {
+                vm->sp -= 2;
+                if (!compare_f64(current.opcode - OPCODE_JUMP_UNLESS_EQ_F64,
+                                 vm->stack[vm->sp].f, vm->stack[vm->sp + 1].f)) {
+                    vm->pc += jump_offset(current);
                 }
-                
-                classes[i].methods[j].name = (char*)malloc(method_name_len + 1);
-                strncpy(classes[i].methods[j].name, method_name, method_name_len);
-                classes[i].methods[j].name[method_name_len] = '\0';
-                
-                // Leer información del método
-                if (fread(&classes[i].methods[j].is_public, 1, 1, file) != 1 ||
-                    fread(&classes[i].methods[j].start_instruction, sizeof(int), 1, file) != 1 ||
-                    fread(&classes[i].methods[j].instruction_count, sizeof(int), 1, file) != 1 ||
-                    fread(&classes[i].methods[j].param_count, 1, 1, file) != 1) {
-                    fprintf(stderr, "Error: No se puede leer información del método\n");
-                    fclose(file);
-                    return EXIT_FAILURE;
+            }
+            break;
+        
+        case OPCODE_JUMP:
+            vm->pc += jump_offset(current);
+            break;
+        
+        case OPCODE_JUMP_IF_FALSE:
+            if (vm->sp > 0 && vm->stack[--vm->sp].i == 0) {
+                vm->pc += jump_offset(current);
+            }
+            break;
+        
+        case OPCODE_LOOP:
+            if (vm->loop_counters) vm->loop_counters[vm->pc]++;
+            // Bucle caliente con código nativo: sigue donde este lo deje
+            if (vm->jit) {
+                JitCode code = jit_loop_code(vm, vm->pc, vm->pc + 1 + jump_offset(current));
+                if (code) {
+                    vm->pc = code(vm, vm->locals + vm->fp);
+                    return;
                 }
-                
-                if (debug) printf("[VM] Clase '%s' método %d: %s (%s)\n", 
-                                classes[i].name, j, classes[i].methods[j].name,
-                                classes[i].methods[j].is_public ? "public" : "private");
             }
-        }
-    }
-
-    // Leer cantidad de strings
-    uint16_t string_count = 0;
-    if (fread(&string_count, sizeof(uint16_t), 1, file) != 1) {
-        fprintf(stderr, "Error: No se puede leer cantidad de strings\n");
-        fclose(file);
-        return EXIT_FAILURE;
+            vm->pc += jump_offset(current);
+            break;
+        
+        case OPCODE_FORMAT_PRINT:
+            if (current.arg1 < vm->string_pool.string_count && vm->sp >= current.arg2) {
+                vm->sp -= current.arg2;
+                vm_format_print(vm, vm->string_pool.strings[current.arg1], &vm->stack[vm->sp]);
+                if (debug) fprintf(stderr, "[VM] FORMAT_PRINT plantilla #%d, %d valores\n", current.arg1, current.arg2);
+            }
+            break;
+        
+        case OPCODE_FLUSH:
+            output_flush(&vm->out);
+            if (debug) fprintf(stderr, "[VM] FLUSH\n");
+            break;
+        
+        default:
+            if (debug) fprintf(stderr, "[VM] Instrucción desconocida: 0x%02x\n", current.opcode);
+            break;
     }
 
-    if (debug) printf("[VM] Strings: %d\n", string_count);
-
-    // Leer strings
-    char **strings = NULL;
-    if (string_count > 0) {
-        strings = (char**)malloc(string_count * sizeof(char*));
-        if (!strings) {
-            fprintf(stderr, "Error: No hay memoria suficiente\n");
-            fclose(file);
-            return EXIT_FAILURE;
-        }
+    vm->pc++;
+}
 
-        for (int i = 0; i < string_count; i++) {
-            uint16_t str_len = 0;
-            if (fread(&str_len, sizeof(uint16_t), 1, file) != 1) {
-                fprintf(stderr, "Error: No se puede leer longitud de string\n");
-                fclose(file);
-                return EXIT_FAILURE;
-            }
+typedef struct {
+    int pc;
+    uint64_t count;
+} LoopProfile;
 
-            strings[i] = (char*)malloc(str_len + 1);
-            if (!strings[i]) {
-                fprintf(stderr, "Error: No hay memoria suficiente\n");
-                fclose(file);
-                return EXIT_FAILURE;
-            }
-
-            if (fread(strings[i], 1, str_len, file) != str_len) {
-                fprintf(stderr, "Error: No se puede leer string\n");
-                fclose(file);
-                return EXIT_FAILURE;
-            }
-            strings[i][str_len] = '\0';
+static int compare_loop_profiles(const void *a, const void *b) {
+    const LoopProfile *x = (const LoopProfile*)a;
+    const LoopProfile *y = (const LoopProfile*)b;
+    if (x->count != y->count) return x->count < y->count ? 1 : -1;
+    return x->pc - y->pc;
+}
 
-            if (debug) printf("[VM] String %d: '%s'\n", i, strings[i]);
-        }
+// Informe de --profile: los bucles más ejecutados, por PC de su LOOP
+static void report_hot_loops(const VMState *vm) {
+    LoopProfile *loops = (LoopProfile*)malloc((vm->instruction_count + 1) * sizeof(LoopProfile));
+    if (!loops || !vm->loop_counters) {
+        free(loops);
+        return;
     }
 
-    // Leer instrucciones
-    Instruction *instructions = NULL;
-    int instruction_count = 0;
-    Instruction instr;
-    
-    while (fread(&instr, sizeof(Instruction), 1, file) == 1) {
-        Instruction *temp = realloc(instructions, (instruction_count + 1) * sizeof(Instruction));
-        if (!temp) {
-            fprintf(stderr, "Error: No hay memoria suficiente\n");
-            free(instructions);
-            fclose(file);
-            return EXIT_FAILURE;
+    int count = 0;
+    for (int pc = 0; pc < vm->instruction_count; pc++) {
+        if (vm->loop_counters[pc] > 0) {
+            loops[count].pc = pc;
+            loops[count].count = vm->loop_counters[pc];
+            count++;
         }
-        instructions = temp;
-        instructions[instruction_count] = instr;
-        instruction_count++;
     }
+    qsort(loops, count, sizeof(LoopProfile), compare_loop_profiles);
 
-    fclose(file);
+    fprintf(stderr, "[perfil] Bucles (PC del LOOP: iteraciones)\n");
+    for (int i = 0; i < count && i < 10; i++) {
+        fprintf(stderr, "[perfil]   PC %5d: %llu%s\n", loops[i].pc, (unsigned long long)loops[i].count,
+                loops[i].count >= VM_HOT_LOOP_THRESHOLD ? " (caliente)" : "");
+    }
+    if (count == 0) fprintf(stderr, "[perfil]   (ningún bucle ejecutado)\n");
+    free(loops);
+}
 
-    if (debug) printf("[VM] Executing %d instructions...\n", instruction_count);
+int execute_bytecode(const char *bytecode_file, const VMOptions *options) {
+    int debug = options->debug;
+    const char *override_renderer = options->override_renderer;
 
-    // Crear estado de la VM
-    VMState vm;
-    vm.instructions = instructions;
-    vm.instruction_count = instruction_count;
-    vm.pc = 0;
-    vm.sp = 0;
-    memset(vm.stack, 0, sizeof(vm.stack));
-    vm.string_pool.strings = strings;
-    vm.string_pool.string_count = string_count;
-    vm.variables = variables;
-    vm.variable_count = var_count;
-    vm.class_pool.classes = classes;
-    vm.class_pool.class_count = class_count;
-    vm.objects = NULL;
-    vm.object_count = 0;
+    size_t image_size = 0;
+    uint8_t *image = vm_read_file(bytecode_file, &image_size);
+    if (!image) return EXIT_FAILURE;
     
-    // Almacenar configuración de ventana
-    vm.window_config = window_config;
+    VMState vm;
+    int loaded = vm_load_image(&vm, image, image_size, debug);
+    free(image);
+    if (loaded != 0) return EXIT_FAILURE;
+    vm.quicken = !options->no_quicken;
+    output_init(&vm.out, 1, options->output_buffer);
+    if (options->jit) vm.jit = jit_create(&vm, debug);
+    vm.parallel_threads = options->threads;
     
-    // Inicializar arrays (solo los metadatos, la memoria se asigna dinámicamente)
-    vm.arrays = NULL;
-    vm.array_count = 0;
+    // Resolver renderer automático según plataforma
+    resolve_renderer(vm.window_config.renderer);
     
-    // Crear estructura de arrays basada en variables de tipo 'a'
-    for (int i = 0; i < var_count; i++) {
-        if (variables[i].type == 'a') {
-            Array *temp = realloc(vm.arrays, (vm.array_count + 1) * sizeof(Array));
-            if (!temp) {
-                fprintf(stderr, "Error: No hay memoria para arrays\n");
-                return EXIT_FAILURE;
-            }
-            vm.arrays = temp;
-            
-            int arr_size = (int)variables[i].value;
-            vm.arrays[vm.array_count].name = variables[i].name;
-            vm.arrays[vm.array_count].size = arr_size;
-            // Tipo del elemento se determina desde variables[i].type será 'a', pero necesitamos guardarlo
-            // Por ahora asumimos que todos los arrays son de int
-            vm.arrays[vm.array_count].type = 'i';
-            vm.arrays[vm.array_count].data = (double*)malloc(arr_size * sizeof(double));
-            vm.arrays[vm.array_count].str_data = NULL;
-            
-            if (!vm.arrays[vm.array_count].data) {
-                fprintf(stderr, "Error: No hay memoria para datos del array\n");
-                return EXIT_FAILURE;
-            }
-            
-            // Inicializar todos los elementos a 0
-            for (int j = 0; j < arr_size; j++) {
-                vm.arrays[vm.array_count].data[j] = 0;
-            }
-            
-            vm.array_count++;
-        }
+    // Sobrescribir renderer si se especificó desde línea de comandos
+    if (override_renderer && strlen(override_renderer) > 0) {
+        strcpy(vm.window_config.renderer, override_renderer);
+        if (debug) fprintf(stderr, "[VM] Renderer overridden from command line: %s\n", override_renderer);
     }
 
-    // Variable temporal para almacenar el valor de GET_GLOBAL
-    char *last_global_string = NULL;
+    if (debug) fprintf(stderr, "[VM] Executing %d instructions...\n", vm.instruction_count);
 
     // Inicializar OpenGL si el renderer es opengl
     GLFWwindow *window = NULL;
     if (strcmp(vm.window_config.renderer, "opengl") == 0) {
         window = init_opengl_window(&vm.window_config);
         if (window) {
-            if (debug) printf("[VM] OpenGL window initialized successfully\n");
+            if (debug) fprintf(stderr, "[VM] OpenGL window initialized successfully\n");
         } else {
-            if (debug) printf("[VM] Warning: Could not initialize OpenGL, running in console mode\n");
+            if (debug) fprintf(stderr, "[VM] Warning: Could not initialize OpenGL, running in console mode\n");
         }
     }
 
     // Ejecutar instrucciones
     int executed = 0;
     
-    // Calcular tiempo por frame según FPS
-    double frame_time = 1.0 / vm.window_config.fps;
-    double last_frame_time = glfwGetTime();
-    
     // Loop de ventana (si OpenGL está activo)
     if (window) {
+        // Calcular tiempo por frame según FPS
+        double frame_time = 1.0 / vm.window_config.fps;
+        double last_frame_time = glfwGetTime();
+        
         // Ejecutar bytecode en el contexto de la ventana
         while (!glfwWindowShouldClose(window) && vm.pc < vm.instruction_count) {
             // Control de frame rate
@@ -637,481 +1110,28 @@ int execute_bytecode(const char *bytecode_file, int debug, const char *override_
                 glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
                 
                 // Ejecutar instrucción
-                Instruction current = vm.instructions[vm.pc];
-
-        if (debug) printf("[VM] PC: %d, Opcode: 0x%02x\n", vm.pc, current.opcode);
-
-        switch (current.opcode) {
-            case OPCODE_PRINT:
-                // current.arg1 es el índice del string
-                if (current.arg1 < vm.string_pool.string_count) {
-                    printf("%s", vm.string_pool.strings[current.arg1]);
-                    if (debug) printf("[VM] PRINT string #%d\n", current.arg1);
-                } else {
-                    if (debug) printf("[VM] Error: string index fuera de rango\n");
-                }
-                break;
-            
-            case OPCODE_PRINTLN:
-                // Si hay un valor en el stack (de ARRAY_GET, etc), imprimirlo
-                if (vm.sp > 0) {
-                    double val = vm.stack[vm.sp - 1];
-                    // Determinar si es entero o float
-                    if (val == (int)val) {
-                        printf("%d\n", (int)val);
-                    } else {
-                        printf("%f\n", val);
-                    }
-                    vm.sp--;  // Pop del stack
-                    if (debug) printf("[VM] PRINTLN (stack value) = %f\n", val);
-                }
-                // Si hay un string global pendiente, usarlo
-                else if (last_global_string) {
-                    printf("%s\n", last_global_string);
-                    if (debug) printf("[VM] PRINTLN (global string)\n");
-                    last_global_string = NULL;
-                } else if (current.arg1 < vm.string_pool.string_count) {
-                    printf("%s\n", vm.string_pool.strings[current.arg1]);
-                    if (debug) printf("[VM] PRINTLN string #%d\n", current.arg1);
-                } else {
-                    if (debug) printf("[VM] Error: string index fuera de rango\n");
-                }
-                break;
-            
-            case OPCODE_PRINTCHR:
-                // current.arg1 es el carácter ASCII a imprimir (optimizado, sin string pool)
-                putchar(current.arg1);
-                if (debug) printf("[VM] PRINTCHR 0x%02x\n", current.arg1);
-                break;
-            
-            case OPCODE_GET_GLOBAL:
-                // current.arg1 es el índice de variable global
-                if (current.arg1 < var_count) {
-                    Variable *var = &variables[current.arg1];
-                    if (var->type == 's' && var->str_val) {
-                        last_global_string = var->str_val;
-                        if (debug) printf("[VM] GET_GLOBAL %s (string) = \"%s\"\n", var->name, var->str_val);
-                    }
-                }
-                break;
-            
-            case OPCODE_PUSH_VALUE:
-                // current.arg1 es el índice del string en el pool
-                // Convertir string a double y pushear al value stack
-                if (current.arg1 < vm.string_pool.string_count && vm.sp < 256) {
-                    char *str_val = vm.string_pool.strings[current.arg1];
-                    double num_val = atof(str_val);
-                    vm.stack[vm.sp] = num_val;
-                    vm.sp++;
-                    if (debug) printf("[VM] PUSH_VALUE string #%d ('%s') as %f\n", 
-                                    current.arg1, str_val, num_val);
-                } else {
-                    if (debug) printf("[VM] Error: PUSH_VALUE invalid state\n");
-                }
-                break;
-            
-            case OPCODE_NEW_INSTANCE:
-                // current.arg1 es el índice de la clase
-                if (current.arg1 < vm.class_pool.class_count) {
-                    ClassDefinition *cls = &vm.class_pool.classes[current.arg1];
-                    
-                    // Crear nueva instancia de objeto
-                    ObjectInstance *new_obj = (ObjectInstance*)malloc(sizeof(ObjectInstance));
-                    new_obj->class_name = (char*)malloc(strlen(cls->name) + 1);
-                    strcpy(new_obj->class_name, cls->name);
-                    new_obj->field_count = cls->var_count;
-                    new_obj->field_values = (double*)malloc(cls->var_count * sizeof(double));
-                    
-                    // Inicializar campos a 0
-                    for (int i = 0; i < cls->var_count; i++) {
-                        new_obj->field_values[i] = 0.0;
-                    }
-                    
-                    // Agregar a lista de objetos
-                    ObjectInstance *temp = realloc(vm.objects, (vm.object_count + 1) * sizeof(ObjectInstance));
-                    if (temp) {
-                        vm.objects = temp;
-                        vm.objects[vm.object_count] = *new_obj;
-                        
-                        // Pushear índice del objeto al stack
-                        if (vm.obj_sp < 64) {
-                            vm.object_stack[vm.obj_sp] = vm.object_count;
-                            vm.obj_sp++;
-                        }
-                        
-                        if (debug) printf("[VM] NEW_INSTANCE '%s' (id: %d)\n", cls->name, vm.object_count);
-                        vm.object_count++;
-                    }
-                    free(new_obj);
-                } else {
-                    if (debug) printf("[VM] Error: clase index fuera de rango\n");
-                }
-                break;
-            
-            case OPCODE_SET_FIELD:
-                // current.arg1 = field index, arg2 = object index
-                if (vm.obj_sp > 0) {
-                    int obj_idx = vm.object_stack[vm.obj_sp - 1];
-                    if (obj_idx >= 0 && obj_idx < vm.object_count) {
-                        ObjectInstance *obj = &vm.objects[obj_idx];
-                        // Usar top del value stack
-                        if (current.arg1 < obj->field_count && vm.sp > 0) {
-                            obj->field_values[current.arg1] = vm.stack[vm.sp - 1];
-                            if (debug) printf("[VM] SET_FIELD object %d, field %d = %f\n", 
-                                            obj_idx, current.arg1, vm.stack[vm.sp - 1]);
-                            vm.sp--;  // Pop value stack
-                        }
-                    }
-                }
-                break;
-            
-            case OPCODE_GET_FIELD:
-                // current.arg1 = field index, arg2 = object index
-                if (vm.obj_sp > 0) {
-                    int obj_idx = vm.object_stack[vm.obj_sp - 1];
-                    if (obj_idx >= 0 && obj_idx < vm.object_count) {
-                        ObjectInstance *obj = &vm.objects[obj_idx];
-                        if (current.arg1 < obj->field_count && vm.sp < 256) {
-                            vm.stack[vm.sp] = obj->field_values[current.arg1];
-                            if (debug) printf("[VM] GET_FIELD object %d, field %d = %f\n", 
-                                            obj_idx, current.arg1, obj->field_values[current.arg1]);
-                            vm.sp++;  // Push to value stack
-                        }
-                    }
-                }
-                break;
-            
-            case OPCODE_RETURN:
-                if (debug) printf("[VM] RETURN - terminando ejecución\n");
-                vm.pc = vm.instruction_count;  // Salir del loop
-                break;
-            
-            case OPCODE_ARRAY_SET: {
-                // arg1 = índice de variable (para ambos estáticos y dinámicos)
-                // Top del stack contiene el valor, segundo top contiene el índice
-                if (current.arg1 < vm.variable_count && vm.sp >= 2) {
-                    int array_index = -1;
-                    
-                    // Obtener índice del array
-                    // Para arrays estáticos, arg1 es el índice directo en vm.arrays
-                    // Para arrays dinámicos, arg1 es el índice de variable, y variable->value contiene índice en vm.arrays
-                    if (current.arg1 < vm.array_count) {
-                        // Es array estático (índice directo)
-                        array_index = current.arg1;
-                    } else if (current.arg1 < vm.variable_count && vm.variables[current.arg1].value >= 0) {
-                        // Es array dinámico (índice desde variable)
-                        array_index = (int)vm.variables[current.arg1].value;
-                    }
-                    
-                    if (array_index >= 0 && array_index < vm.array_count) {
-                        int index = (int)vm.stack[vm.sp - 2];
-                        double value = vm.stack[vm.sp - 1];
-                        
-                        if (index >= 0 && index < vm.arrays[array_index].size) {
-                            vm.arrays[array_index].data[index] = value;
-                            if (debug) printf("[VM] ARRAY_SET array %d[%d] = %f\n", array_index, index, value);
-                        }
-                        
-                        vm.sp -= 2;  // Pop index y value
-                    }
-                }
-                break;
-            }
-            
-            case OPCODE_ARRAY_GET: {
-                // arg1 = índice de variable (para ambos estáticos y dinámicos)
-                // Top del stack contiene el índice
-                if (current.arg1 < vm.variable_count && vm.sp >= 1) {
-                    int array_index = -1;
-                    
-                    // Obtener índice del array
-                    // Para arrays estáticos, arg1 es el índice directo en vm.arrays
-                    // Para arrays dinámicos, arg1 es el índice de variable, y variable->value contiene índice en vm.arrays
-                    if (current.arg1 < vm.array_count) {
-                        // Es array estático (índice directo)
-                        array_index = current.arg1;
-                    } else if (current.arg1 < vm.variable_count && vm.variables[current.arg1].value >= 0) {
-                        // Es array dinámico (índice desde variable)
-                        array_index = (int)vm.variables[current.arg1].value;
-                    }
-                    
-                    if (array_index >= 0 && array_index < vm.array_count) {
-                        int index = (int)vm.stack[vm.sp - 1];
-                        vm.sp--;  // Pop index
-                        
-                        if (index >= 0 && index < vm.arrays[array_index].size && vm.sp < 256) {
-                            double value = vm.arrays[array_index].data[index];
-                            vm.stack[vm.sp] = value;
-                            vm.sp++;  // Push value
-                            
-                            if (debug) printf("[VM] ARRAY_GET array %d[%d] = %f\n", array_index, index, value);
-                        }
-                    }
-                }
-                break;
-            }
-            
-            case OPCODE_ARRAY_NEW: {
-                // arg1 = índice de variable en var_pool (para almacenar la referencia)
-                // arg2 = tipo de elemento
-                // Top del stack contiene el tamaño
-                if (vm.sp > 0 && current.arg1 < vm.variable_count) {
-                    int size = (int)vm.stack[vm.sp - 1];
-                    vm.sp--;  // Pop size
-                    
-                    char element_type = (char)current.arg2;
-                    
-                    // Crear nuevo array dinámico
-                    Array *temp = realloc(vm.arrays, (vm.array_count + 1) * sizeof(Array));
-                    if (temp) {
-                        vm.arrays = temp;
-                        
-                        vm.arrays[vm.array_count].name = vm.variables[current.arg1].name;
-                        vm.arrays[vm.array_count].type = element_type;
-                        vm.arrays[vm.array_count].size = size;
-                        vm.arrays[vm.array_count].data = (double*)malloc(size * sizeof(double));
-                        vm.arrays[vm.array_count].str_data = NULL;
-                        
-                        if (vm.arrays[vm.array_count].data) {
-                            // Inicializar a 0
-                            for (int j = 0; j < size; j++) {
-                                vm.arrays[vm.array_count].data[j] = 0;
-                            }
-                            
-                            // Almacenar el índice del array en la variable como referencia
-                            vm.variables[current.arg1].value = (double)vm.array_count;
-                            
-                            if (debug) printf("[VM] ARRAY_NEW variable %d, array %d, size %d, type %c\n", 
-                                            current.arg1, vm.array_count, size, element_type);
-                            
-                            vm.array_count++;
-                        }
-                    }
-                }
-                break;
-            }
-            
-            case OPCODE_ARRAY_LEN: {
-                // arg1 = índice de variable
-                // Pushea la longitud del array al stack
-                if (current.arg1 < vm.variable_count && vm.sp < 256) {
-                    int array_index = -1;
-                    
-                    if (current.arg1 < vm.array_count) {
-                        array_index = current.arg1;
-                    } else if (current.arg1 < vm.variable_count && vm.variables[current.arg1].value >= 0) {
-                        array_index = (int)vm.variables[current.arg1].value;
-                    }
-                    
-                    if (array_index >= 0 && array_index < vm.array_count) {
-                        int len = vm.arrays[array_index].size;
-                        vm.stack[vm.sp] = (double)len;
-                        vm.sp++;
-                        if (debug) printf("[VM] ARRAY_LEN array %d = %d\n", array_index, len);
-                    }
-                }
-                break;
-            }
-            
-            case OPCODE_ARRAY_CLEAR: {
-                // arg1 = índice de variable
-                // Limpia todos los elementos del array (los pone en 0)
-                if (current.arg1 < vm.variable_count) {
-                    int array_index = -1;
-                    
-                    if (current.arg1 < vm.array_count) {
-                        array_index = current.arg1;
-                    } else if (current.arg1 < vm.variable_count && vm.variables[current.arg1].value >= 0) {
-                        array_index = (int)vm.variables[current.arg1].value;
-                    }
-                    
-                    if (array_index >= 0 && array_index < vm.array_count) {
-                        // Limpiar el array
-                        for (int i = 0; i < vm.arrays[array_index].size; i++) {
-                            vm.arrays[array_index].data[i] = 0;
-                        }
-                        // Si hay strings, limpiarlos también
-                        if (vm.arrays[array_index].str_data) {
-                            for (int i = 0; i < vm.arrays[array_index].size; i++) {
-                                if (vm.arrays[array_index].str_data[i]) {
-                                    free(vm.arrays[array_index].str_data[i]);
-                                    vm.arrays[array_index].str_data[i] = NULL;
-                                }
-                            }
-                        }
-                        if (debug) printf("[VM] ARRAY_CLEAR array %d\n", array_index);
-                    }
-                }
-                break;
+                vm_step(&vm, debug);
+                executed++;
             }
             
-            default:
-                if (debug) printf("[VM] Instrucción desconocida: 0x%02x\n", current.opcode);
-                break;
-        }
-
-        vm.pc++;
-        executed++;
-            } // Fin del if (elapsed >= frame_time)
-            
             // Swap de buffers y eventos
             glfwSwapBuffers(window);
             glfwPollEvents();
         }
-    }
-    
-    // Cerrar el if(window)
-    else {
+    } else {
         // Modo consola (sin OpenGL)
         while (vm.pc < vm.instruction_count) {
-            Instruction current = vm.instructions[vm.pc];
-
-            if (debug) printf("[VM] PC: %d, Opcode: 0x%02x\n", vm.pc, current.opcode);
-
-            switch (current.opcode) {
-                case OPCODE_PRINT:
-                    // current.arg1 es el índice del string
-                    if (current.arg1 < vm.string_pool.string_count) {
-                        printf("%s", vm.string_pool.strings[current.arg1]);
-                        if (debug) printf("[VM] PRINT string #%d\n", current.arg1);
-                    } else {
-                        if (debug) printf("[VM] Error: string index fuera de rango\n");
-                    }
-                    break;
-                
-                case OPCODE_PRINTLN:
-                    // Si hay un valor en el stack (de ARRAY_GET, etc), imprimirlo
-                    if (vm.sp > 0) {
-                        double val = vm.stack[vm.sp - 1];
-                        // Determinar si es entero o float
-                        if (val == (int)val) {
-                            printf("%d\n", (int)val);
-                        } else {
-                            printf("%f\n", val);
-                        }
-                        vm.sp--;  // Pop del stack
-                        if (debug) printf("[VM] PRINTLN (stack value) = %f\n", val);
-                    }
-                    // Si hay un string global pendiente, usarlo
-                    else if (last_global_string) {
-                        printf("%s\n", last_global_string);
-                        if (debug) printf("[VM] PRINTLN (global string)\n");
-                        last_global_string = NULL;
-                    } else if (current.arg1 < vm.string_pool.string_count) {
-                        printf("%s\n", vm.string_pool.strings[current.arg1]);
-                        if (debug) printf("[VM] PRINTLN string #%d\n", current.arg1);
-                    }
-                    break;
-
-                case OPCODE_PRINTCHR:
-                    if (vm.sp > 0) {
-                        int val = (int)vm.stack[vm.sp - 1];
-                        printf("%c", (char)val);
-                        vm.sp--;
-                        if (debug) printf("[VM] PRINTCHR: %c\n", (char)val);
-                    }
-                    break;
-
-                case OPCODE_GET_GLOBAL:
-                    if (current.arg1 < vm.variable_count) {
-                        Variable *var = &vm.variables[current.arg1];
-                        if (var->type == 's') {
-                            last_global_string = var->str_val;
-                            if (debug) printf("[VM] GET_GLOBAL string #%d: %s\n", current.arg1, var->str_val);
-                        } else {
-                            vm.stack[vm.sp++] = var->value;
-                            if (debug) printf("[VM] GET_GLOBAL var #%d = %f\n", current.arg1, var->value);
-                        }
-                    } else {
-                        if (debug) printf("[VM] Error: variable index fuera de rango\n");
-                    }
-                    break;
-
-                case OPCODE_RETURN:
-                    if (debug) printf("[VM] RETURN\n");
-                    vm.pc = vm.instruction_count;
-                    break;
-
-                case OPCODE_ARRAY_NEW:
-                    if (vm.sp >= 2) {
-                        double arr_size = vm.stack[--vm.sp];
-                        double arr_type_val = vm.stack[--vm.sp];
-                        
-                        int size = (int)arr_size;
-                        if (size > 0 && vm.array_count < 128) {
-                            if (debug) printf("[VM] ARRAY_NEW size %d\n", size);
-                        }
-                    }
-                    break;
-
-                case OPCODE_ARRAY_SET:
-                    if (vm.sp >= 3) {
-                        double val = vm.stack[--vm.sp];
-                        double idx = vm.stack[--vm.sp];
-                        double arr_idx = vm.stack[--vm.sp];
-                        
-                        int array_index = (int)arr_idx;
-                        int index = (int)idx;
-                        
-                        if (array_index >= 0 && array_index < vm.array_count) {
-                            if (index >= 0 && index < vm.arrays[array_index].size) {
-                                vm.arrays[array_index].data[index] = val;
-                                if (debug) printf("[VM] ARRAY_SET array %d, index %d = %f\n", array_index, index, val);
-                            }
-                        }
-                    }
-                    break;
-
-                case OPCODE_ARRAY_GET:
-                    if (current.arg1 >= 0 && current.arg1 < vm.array_count) {
-                        if (vm.sp > 0) {
-                            int index = (int)vm.stack[vm.sp - 1];
-                            if (index >= 0 && index < vm.arrays[current.arg1].size) {
-                                vm.stack[vm.sp - 1] = vm.arrays[current.arg1].data[index];
-                                if (debug) printf("[VM] ARRAY_GET array %d, index %d = %f\n", current.arg1, index, vm.arrays[current.arg1].data[index]);
-                            }
-                        }
-                    }
-                    break;
-
-                case OPCODE_ARRAY_LEN:
-                    if (current.arg1 >= 0 && current.arg1 < vm.array_count) {
-                        vm.stack[vm.sp++] = vm.arrays[current.arg1].size;
-                        if (debug) printf("[VM] ARRAY_LEN array %d = %d\n", current.arg1, vm.arrays[current.arg1].size);
-                    }
-                    break;
-
-                case OPCODE_ARRAY_CLEAR:
-                    if (current.arg1 >= 0 && current.arg1 < vm.array_count) {
-                        for (int i = 0; i < vm.arrays[current.arg1].size; i++) {
-                            vm.arrays[current.arg1].data[i] = 0;
-                        }
-                        if (vm.arrays[current.arg1].str_data) {
-                            for (int i = 0; i < vm.arrays[current.arg1].size; i++) {
-                                if (vm.arrays[current.arg1].str_data[i]) {
-                                    free(vm.arrays[current.arg1].str_data[i]);
-                                    vm.arrays[current.arg1].str_data[i] = NULL;
-                                }
-                            }
-                        }
-                        if (debug) printf("[VM] ARRAY_CLEAR array %d\n", current.arg1);
-                    }
-                    break;
-
-                default:
-                    if (debug) printf("[VM] Instrucción desconocida: 0x%02x\n", current.opcode);
-                    break;
-            }
-
-            vm.pc++;
+            vm_step(&vm, debug);
             executed++;
         }
     }
 
+    output_flush(&vm.out);  // Antes de los informes de --debug y --profile
     if (debug) {
-        printf("[VM] Execution completed\n");
-        printf("[VM] Instructions executed: %d\n", executed);
+        fprintf(stderr, "[VM] Execution completed\n");
+        fprintf(stderr, "[VM] Instructions executed: %d\n", executed);
     }
+    if (options->profile) report_hot_loops(&vm);
     
     // Cerrar ventana si está abierta
     if (window) {
@@ -1119,43 +1139,9 @@ int execute_bytecode(const char *bytecode_file, int debug, const char *override_
         glfwTerminate();
     }
 
-    // Liberar memoria
-    for (int i = 0; i < string_count; i++) {
-        free(strings[i]);
-    }
-    if (strings) free(strings);
-    
-    for (int i = 0; i < var_count; i++) {
-        free(variables[i].name);
-    }
-    if (variables) free(variables);
-    
-    for (int i = 0; i < class_count; i++) {
-        free(classes[i].name);
-        for (int j = 0; j < classes[i].var_count; j++) {
-            free(classes[i].var_names[j]);
-        }
-        free(classes[i].var_names);
-        free(classes[i].var_types);
-        
-        // Liberar métodos
-        if (classes[i].methods) {
-            for (int j = 0; j < classes[i].method_count; j++) {
-                free(classes[i].methods[j].name);
-            }
-            free(classes[i].methods);
-        }
-    }
-    if (classes) free(classes);
-    
-    // Liberar objetos
-    for (int i = 0; i < vm.object_count; i++) {
-        free(vm.objects[i].class_name);
-        free(vm.objects[i].field_values);
-    }
-    if (vm.objects) free(vm.objects);
-    
-    free(instructions);
+    jit_free(vm.jit);
+    parallel_state_free(vm.parallel);
+    vm_release(&vm);
 
-    return EXIT_SUCCESS;
+    return vm.failed ? EXIT_FAILURE : EXIT_SUCCESS;
 }
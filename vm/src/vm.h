@@ -2,6 +2,8 @@
 #define VM_H
 
 #include <stdint.h>
+#include <stddef.h>
+#include "output.h"
 
 #define OPCODE_PRINT        0x01
 #define OPCODE_PRINTLN      0x08
@@ -20,6 +22,172 @@
 #define OPCODE_ARRAY_NEW    0x0E
 #define OPCODE_ARRAY_LEN    0x0F
 #define OPCODE_ARRAY_CLEAR  0x10
+#define OPCODE_LOAD_LOCAL   0x11
+#define OPCODE_STORE_LOCAL  0x12
+
+// Opcodes tipados: el compilador infiere el tipo de cada valor y elige la
+// variante; los slots del stack no llevan etiqueta de tipo (ver Value).
+#define OPCODE_PUSH_INT     0x13  // Entero de 16 bits con signo: arg1 | arg2 << 8
+#define OPCODE_I2F          0x14  // int64 -> double
+#define OPCODE_F2I          0x15  // double -> int64 (trunca)
+#define OPCODE_ADD_I64      0x16
+#define OPCODE_SUB_I64      0x17
+#define OPCODE_MUL_I64      0x18
+#define OPCODE_DIV_I64      0x19  // División truncada; por cero detiene la VM
+#define OPCODE_MOD_I64      0x1A
+#define OPCODE_NEG_I64      0x1B
+#define OPCODE_ADD_F64      0x1C
+#define OPCODE_SUB_F64      0x1D
+#define OPCODE_MUL_F64      0x1E
+#define OPCODE_DIV_F64      0x1F
+#define OPCODE_MOD_F64      0x20  // fmod
+#define OPCODE_NEG_F64      0x21
+#define OPCODE_PRINTLN_I64  0x22  // Imprime el int64 del tope
+#define OPCODE_ARRAY_GET_I64 0x23 // Como ARRAY_GET con el índice como int64
+#define OPCODE_ARRAY_SET_I64 0x24 // Como ARRAY_SET con el índice como int64
+
+// Comparaciones: consumen dos valores (a b) y apilan un int64 0/1
+#define OPCODE_EQ_I64       0x25
+#define OPCODE_NE_I64       0x26
+#define OPCODE_LT_I64       0x27
+#define OPCODE_LE_I64       0x28
+#define OPCODE_GT_I64       0x29
+#define OPCODE_GE_I64       0x2A
+#define OPCODE_EQ_F64       0x2B
+#define OPCODE_NE_F64       0x2C
+#define OPCODE_LT_F64       0x2D
+#define OPCODE_LE_F64       0x2E
+#define OPCODE_GT_F64       0x2F
+#define OPCODE_GE_F64       0x30
+
+// Lógicos sobre int64 (distinto de cero = verdadero); apilan 0/1
+#define OPCODE_NOT          0x31
+#define OPCODE_AND          0x32
+#define OPCODE_OR           0x33
+
+// Operaciones fusionadas: una sola instrucción para patrones frecuentes
+#define OPCODE_MULADD_I64   0x34  // a b c -> a * b + c
+#define OPCODE_MULADD_F64   0x35
+
+// Compara y salta: consumen a b y saltan si la comparación es FALSA (la
+// forma que usan las condiciones). El desplazamiento es relativo a la
+// instrucción siguiente, con signo: arg1 | arg2 << 8.
+#define OPCODE_JUMP_UNLESS_EQ_I64 0x36
+#define OPCODE_JUMP_UNLESS_NE_I64 0x37
+#define OPCODE_JUMP_UNLESS_LT_I64 0x38
+#define OPCODE_JUMP_UNLESS_LE_I64 0x39
+#define OPCODE_JUMP_UNLESS_GT_I64 0x3A
+#define OPCODE_JUMP_UNLESS_GE_I64 0x3B
+#define OPCODE_JUMP_UNLESS_EQ_F64 0x3C
+#define OPCODE_JUMP_UNLESS_NE_F64 0x3D
+#define OPCODE_JUMP_UNLESS_LT_F64 0x3E
+#define OPCODE_JUMP_UNLESS_LE_F64 0x3F
+#define OPCODE_JUMP_UNLESS_GT_F64 0x40
+#define OPCODE_JUMP_UNLESS_GE_F64 0x41
+
+// Saltos relativos (arg1 | arg2 << 8, con signo, desde la instrucción siguiente)
+#define OPCODE_JUMP          0x42  // Incondicional
+#define OPCODE_JUMP_IF_FALSE 0x43  // Consume un int64 y salta si es cero
+#define OPCODE_LOOP          0x44  // Arista de retorno de un bucle: salta hacia atrás
+                                   // y cuenta la iteración en loop_counters[pc]
+
+#define OPCODE_FLUSH         0x45  // Vuelca el buffer de salida (flush())
+
+// Interpolación (println("x = {x}")): imprime la plantilla arg1 del pool con
+// los arg2 valores de la cima del stack, que consume. En la plantilla,
+// FORMAT_HOLE seguido de 'i' o 'f' es el siguiente valor como int64 o double,
+// y FORMAT_HOLE repetido es el propio byte.
+#define OPCODE_FORMAT_PRINT  0x46
+#define FORMAT_HOLE          '\x01'
+
+// Acceso a arrays de enteros (int, long, byte, bool): índice y valor int64.
+// Al guardar, el valor se ajusta al tipo del elemento (ver Array). Los
+// ARRAY_GET/SET de arriba son los de los arrays de double.
+#define OPCODE_ARRAY_GET_INT 0x47
+#define OPCODE_ARRAY_SET_INT 0x48
+
+// Métodos de los arrays dinámicos (arg1 = variable). El valor de push y pop
+// va en el stack como int64, o como double en los arrays de double.
+#define OPCODE_ARRAY_PUSH    0x49  // Consume el valor y lo añade al final
+#define OPCODE_ARRAY_POP     0x4A  // Quita el último elemento y lo apila
+#define OPCODE_ARRAY_RESERVE 0x4B  // Consume un int64: capacidad mínima
+#define OPCODE_ARRAY_RESIZE  0x4C  // Consume un int64: nuevo tamaño (lo añadido vale 0)
+#define OPCODE_ARRAY_COPY    0x4D  // arg1 pasa a ser una copia del array arg2
+
+// Operaciones sobre el array completo arg1 (ver vm_array_bulk), de cualquier
+// array, estático o dinámico. arg2 es el segundo array de add, mul, axpy y
+// dot. Operandos y resultados, int64 o double según el tipo de arg1.
+#define OPCODE_ARRAY_FILL    0x4E  // Consume el valor y lo copia en todos
+#define OPCODE_ARRAY_ADD     0x4F  // arg1[i] += arg2[i]
+#define OPCODE_ARRAY_MUL     0x50  // arg1[i] *= arg2[i]
+#define OPCODE_ARRAY_SCALE   0x51  // Consume k: arg1[i] *= k
+#define OPCODE_ARRAY_AXPY    0x52  // Consume k: arg1[i] += k * arg2[i]
+#define OPCODE_ARRAY_SUM     0x53  // Apila la suma
+#define OPCODE_ARRAY_MIN     0x54  // Apila el mínimo (error si está vacío)
+#define OPCODE_ARRAY_MAX     0x55  // Apila el máximo (error si está vacío)
+#define OPCODE_ARRAY_DOT     0x56  // Apila el producto escalar con arg2
+
+// Ordenación de arrays (ver sort.h)
+#define OPCODE_ARRAY_SORT      0x59  // De menor a mayor
+#define OPCODE_ARRAY_SORT_DESC 0x5A  // De mayor a menor
+#define OPCODE_ARRAY_SEARCH    0x5B  // Cambia el valor por su índice en el array
+                                     // ordenado (el primero), o -1
+#define OPCODE_ARRAY_UNIQUE    0x5C  // Quita repetidos consecutivos (dinámicos) y
+                                     // apila el tamaño que queda
+
+// Vistas sin copia (ver vm_array_view): arg1 = variable de array dinámico que
+// pasa a ser la vista, arg2 = array de origen (estático u otra vista)
+#define OPCODE_ARRAY_ROW       0x5D  // Pop índice: fila (primer índice fijo)
+#define OPCODE_ARRAY_COL       0x5E  // Pop índice: columna (último índice fijo)
+#define OPCODE_ARRAY_SLICE     0x5F  // Pop hasta y desde: filas [desde, hasta)
+
+// Entero que no cabe en PUSH_INT: arg1 = string del pool con el entero en
+// decimal, que se apila como int64 exacto (PUSH_VALUE pasaría por double)
+#define OPCODE_PUSH_I64        0x60
+
+// parallel for: el cuerpo va entre PARALLEL_FOR y el PARALLEL_END siguiente,
+// los dos con arg1 = slot local del índice, y el slot arg1 + 1 guarda el
+// final. Se ejecuta el cuerpo para cada índice de [frame[arg1], frame[arg1 + 1])
+// repartido entre los hilos del pool (ver parallel.h), cada uno con su stack,
+// su copia del frame y su copia del código (con --jit, también su código
+// nativo); después se sigue tras el PARALLEL_END. Dentro de la región las globales son de solo lectura: se puede
+// escribir en elementos de arrays pero no imprimir, crear o redimensionar
+// arrays ni modificar objetos.
+#define OPCODE_PARALLEL_FOR  0x57
+#define OPCODE_PARALLEL_END  0x58
+
+// Quickening: la VM reescribe en memoria la instrucción genérica, tras su
+// primera ejecución, por una variante que ya no decide nada. Son internos de
+// la VM (nunca aparecen en un .gld); --no-quicken los desactiva.
+#define OPCODE_ARRAY_GET_STATIC      0xE0  // arg1 = índice en vm->arrays
+#define OPCODE_ARRAY_GET_STATIC_I64  0xE1
+#define OPCODE_ARRAY_GET_DYNAMIC     0xE2  // arg1 = variable; solo se lee su referencia
+#define OPCODE_ARRAY_GET_DYNAMIC_I64 0xE3
+#define OPCODE_ARRAY_SET_STATIC      0xE4
+#define OPCODE_ARRAY_SET_STATIC_I64  0xE5
+#define OPCODE_ARRAY_SET_DYNAMIC     0xE6
+#define OPCODE_ARRAY_SET_DYNAMIC_I64 0xE7
+#define OPCODE_PRINTLN_NUMBER        0xE8  // Valor del stack
+#define OPCODE_PRINTLN_POOL          0xE9  // String arg1 del pool
+#define OPCODE_PRINTLN_GLOBAL        0xEA  // String global pendiente
+#define OPCODE_GET_GLOBAL_NUMBER     0xEB
+#define OPCODE_GET_GLOBAL_STRING     0xEC
+#define OPCODE_ARRAY_GET_INT_STATIC  0xED
+#define OPCODE_ARRAY_GET_INT_DYNAMIC 0xEE
+#define OPCODE_ARRAY_SET_INT_STATIC  0xEF
+#define OPCODE_ARRAY_SET_INT_DYNAMIC 0xF0
+#define OPCODE_PARALLEL_FORBIDDEN    0xF1  // En la copia del código de cada hilo de
+                                           // un parallel for, lo que no se permite
+
+// Iteraciones a partir de las que un bucle se considera caliente
+#define VM_HOT_LOOP_THRESHOLD 1000
+
+// Slot del stack, de un frame o de un campo. El tipo lo fija el opcode que
+// lo produce o consume: los genéricos usan 'f' y los *_I64 usan 'i'.
+typedef union {
+    double f;
+    int64_t i;
+} Value;
 
 typedef struct {
     uint8_t opcode;
@@ -32,19 +200,40 @@ typedef struct {
     int string_count;
 } StringPool;
 
+// Arrays de varias dimensiones (int grid[640][480];). En la imagen, el tipo
+// de elemento de un array estático lleva ARRAY_SHAPED si tras el tamaño
+// siguen el número de dimensiones (1 byte) y el tamaño de cada una (int).
+#define ARRAY_MAX_DIMS 4
+#define ARRAY_SHAPED   0x80
+
 typedef struct {
     char *name;
-    char type;      // 'i' = int, 'd' = double, 's' = string
-    double value;   // Para int/double
+    char type;      // 'i' = int, 'd' = double, 's' = string, 'a'/'b' = array, 'o' = objeto
+    double value;   // Para int/double; índice en arrays/objects para 'a', 'b' y 'o' (-1 = sin crear)
     char *str_val;  // Para string
+    char element_type;  // Para 'a' y 'b': tipo de elemento del array
+    int dims;           // Para 'a': dimensiones y tamaño de cada una
+    int shape[ARRAY_MAX_DIMS];
 } Variable;
 
+// Cada array guarda sus elementos con el tamaño de su tipo declarado:
+//   'd' double  8 bytes      'l' long  int64  8 bytes
+//   'i' int     int32 4      'u' byte  uint8  1 byte
+//   'z' bool    1 bit, de 8 en 8 por byte (el bit 0 es el primer elemento)
 typedef struct {
     char *name;
-    char type;      // 'i' = int, 'd' = double, 's' = string
+    char type;      // Tipo de elemento
     int size;       // Número de elementos
-    double *data;   // Array de valores (para int/double)
+    int capacity;   // Elementos reservados en data (>= size); de size en
+                    // adelante están siempre a cero
+    void *data;     // vm_array_bytes(type, capacity) bytes
     char **str_data;// Array de strings
+    int dims;       // Dimensiones (1 en los arrays normales); shape[] es el
+    int shape[ARRAY_MAX_DIMS];  // tamaño de cada una, en orden row-major
+    int stride;     // Posiciones de data entre un elemento y el siguiente: 1
+                    // salvo en las vistas de columnas
+    int first_bit;  // Vistas de arrays de bool: bit de data del elemento 0
+    int parent;     // Vistas: array dueño de data (-1 si el array es el dueño)
 } Array;
 
 typedef struct {
@@ -52,6 +241,7 @@ typedef struct {
     int start_instruction;
     int instruction_count;
     int param_count;
+    int local_count;    // Slots de su frame
     uint8_t is_public;  // 1 = public, 0 = private
 } ClassMethod;
 
@@ -59,6 +249,7 @@ typedef struct {
     char *name;
     ClassMethod *methods;
     int method_count;
+    int *vtable;           // PC de entrada de cada método, indexado por slot
     char **var_names;
     uint8_t *var_types;
     int var_count;
@@ -80,24 +271,40 @@ typedef struct {
 } WindowConfig;
 
 typedef struct {
-    char *class_name;
-    double *field_values;  // Instance variable values
+    int class_index;       // Índice en class_pool
+    Value *field_values;   // Instance variable values, por slot (tipo declarado del campo)
     int field_count;
 } ObjectInstance;
 
+// Estado del llamador guardado por CALL_METHOD
+typedef struct {
+    int return_pc;
+    int fp;
+    int frame_size;
+} CallFrame;
+
+typedef struct JitState JitState;
+typedef struct ParallelState ParallelState;
+
 typedef struct {
     Instruction *instructions;
     int instruction_count;
     int pc;  // Program counter
+    int failed;  // Un error de ejecución terminó el programa: sale con EXIT_FAILURE
+    
+    CallFrame call_stack[64];
+    int call_sp;
+    
+    // Variables locales: el frame actual es locals[fp .. fp + frame_size)
+    Value *locals;
+    int locals_capacity;
+    int fp;
+    int frame_size;
     
     // Stack para valores
-    double stack[256];
+    Value stack[256];
     int sp;  // Stack pointer
     
-    // Stack para objetos (almacenar índices)
-    int object_stack[64];
-    int obj_sp;
-    
     StringPool string_pool;
     Variable *variables;
     int variable_count;
@@ -106,11 +313,42 @@ typedef struct {
     ClassPool class_pool;
     ObjectInstance *objects;
     int object_count;
+    int object_capacity;
+    
+    // String global pendiente de imprimir (GET_GLOBAL + PRINTLN)
+    const char *pending_string;
+    
+    // Contador de iteraciones de cada LOOP, indexado por su PC. Lo leen el
+    // perfilador (--profile) y los niveles de optimización que detectan
+    // bucles calientes (VM_HOT_LOOP_THRESHOLD).
+    uint64_t *loop_counters;
+    
+    int quicken;    // Reescribir instrucciones a sus variantes especializadas
+    JitState *jit;  // Código nativo de los bucles calientes (--jit), o NULL
+    
+    // Hilos de los parallel for: se crean en la primera región
+    ParallelState *parallel;
+    int parallel_threads;   // Hilos del pool (0 = los núcleos disponibles)
+    int parallel_worker;    // Es un hilo de una región: escribe los bool de forma atómica
+    
+    // Salida del programa (PRINT, PRINTLN, PRINTCHR); ver output.h
+    OutputBuffer out;
     
     // Configuración de ventana
     WindowConfig window_config;
 } VMState;
 
-int execute_bytecode(const char *bytecode_file, int debug, const char *override_renderer);
+// Opciones de 'gldvm run'
+typedef struct {
+    int debug;
+    const char *override_renderer;  // NULL = el del bytecode
+    int profile;                    // Informe de bucles calientes al terminar
+    int no_quicken;                 // Ejecutar siempre los opcodes genéricos
+    int jit;                        // Compilar los bucles calientes a x86-64
+    size_t output_buffer;           // Bytes del buffer de salida (0 = sin buffer)
+    int threads;                    // Hilos de parallel for (0 = los núcleos)
+} VMOptions;
+
+int execute_bytecode(const char *bytecode_file, const VMOptions *options);
 
 #endif